@@ -0,0 +1,294 @@
+/*
+ * Headless render benchmark.
+ *
+ * Runs scripted stress scenes for a fixed number of frames and writes the results as JSON.
+ * The scenes are drawn into a render target, since the pixels of a hidden window are not owned
+ * by it and the fill and overdraw numbers would depend on the driver. Each scene targets a different part of the render backend:
+ *
+ * - small_triangles: many tiny triangles, which stresses the per-shape batching overhead
+ * - quads: many quads, which stresses the vertex and index writes
+ * - transform_switching: a custom transform and a draw call per small group of shapes
+ * - transparent_layers: overlapping transparent quads, where batch regrouping is disabled
+ *
+ * The CPU time of a frame covers the scene submission and EndFrame, including the buffer swap.
+ * Vsync is turned off, so that the swap does not clamp the frame time to the refresh rate.
+ * The submit time covers only the scene drawing and the draw calls.
+ *
+ * Usage: render_benchmark [output.json] [frames]
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define WARMUP_FRAMES 10
+#define DEFAULT_FRAMES 300
+#define MAX_FRAMES 10000
+
+#define SMALL_TRIANGLE_COUNT 20000
+#define QUAD_COUNT 10000
+#define TRANSFORM_GROUP_COUNT 500
+#define TRANSFORM_GROUP_SIZE 8
+#define TRANSPARENT_LAYER_COUNT 40
+#define TRANSPARENT_QUADS_PER_LAYER 100
+#define OPAQUE_LAYER_COUNT 40
+#define OPAQUE_QUADS_PER_LAYER 100
+
+// sized for the largest scene, so that no scene flushes the buffers partway through
+#define LARGER(a, b) ((a) > (b) ? (a) : (b))
+#define MAX_VERTICES (LARGER(SMALL_TRIANGLE_COUNT * 3, QUAD_COUNT * 4) + 1000)
+#define MAX_INDICES (LARGER(SMALL_TRIANGLE_COUNT * 3, QUAD_COUNT * 6) + 1000)
+
+typedef void (*DrawSceneFn)(int frame);
+
+typedef struct {
+    const char* name;
+    DrawSceneFn draw;
+    bool isTransparent;
+    TransparencyMethod transparencyMethod;
+    bool isDepthPrepass;
+} Scene;
+
+typedef struct {
+    double mean;
+    double median;
+    double p95;
+    double max;
+} Summary;
+
+// -- Scenes --
+
+static float Random01() {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static Color RandomColor(float alpha) {
+    return (Color){ Random01(), Random01(), Random01(), alpha };
+}
+
+static void DrawSmallTriangles(int frame) {
+    srand(1);
+    for (int i = 0; i < SMALL_TRIANGLE_COUNT; i++) {
+        Vec2 a = { Random01() * WIDTH, Random01() * HEIGHT };
+        Vec2 b = { a.x + 4, a.y };
+        Vec2 c = { a.x, a.y + 4 };
+        DrawTriangle2D(a, b, c, RandomColor(1));
+    }
+    MakeDrawCall();
+}
+
+static void DrawQuads(int frame) {
+    srand(2);
+    for (int i = 0; i < QUAD_COUNT; i++) {
+        float x = Random01() * WIDTH;
+        float y = Random01() * HEIGHT;
+        float size = 2 + Random01() * 10;
+        Vec3 topLeft = { x, y + size, 0 };
+        Vec3 topRight = { x + size, y + size, 0 };
+        Vec3 bottomLeft = { x, y, 0 };
+        Vec3 bottomRight = { x + size, y, 0 };
+        DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, RandomColor(1));
+    }
+    MakeDrawCall();
+}
+
+static void DrawTransformSwitching(int frame) {
+    srand(3);
+    for (int i = 0; i < TRANSFORM_GROUP_COUNT; i++) {
+        Vec2 offset = { Random01() * WIDTH, Random01() * HEIGHT };
+        Mat4 transforms[2] = { Mat4Translate2D(offset), Mat4Rotate2D(frame * 0.01f + i) };
+        SetTransform(Mat4MultiplyAll(transforms, 2));
+
+        for (int j = 0; j < TRANSFORM_GROUP_SIZE; j++) {
+            Vec2 a = { j * 6.0f, 0 };
+            DrawTriangle2D(a, (Vec2){ a.x + 5, 0 }, (Vec2){ a.x, 5 }, RandomColor(1));
+        }
+        // the custom transform applies to one draw call
+        MakeDrawCall();
+    }
+}
+
+static void DrawTransparentLayers(int frame) {
+    srand(4);
+    for (int layer = 0; layer < TRANSPARENT_LAYER_COUNT; layer++) {
+        for (int i = 0; i < TRANSPARENT_QUADS_PER_LAYER; i++) {
+            float x = Random01() * WIDTH;
+            float y = Random01() * HEIGHT;
+            float size = 50 + Random01() * 150;
+            Vec3 topLeft = { x, y + size, 0 };
+            Vec3 topRight = { x + size, y + size, 0 };
+            Vec3 bottomLeft = { x, y, 0 };
+            Vec3 bottomRight = { x + size, y, 0 };
+            DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, RandomColor(0.2f));
+        }
+    }
+    MakeDrawCall();
+}
+
+// back to front, the worst case for overdraw
+static void DrawOpaqueLayers(int frame) {
+    srand(5);
+    for (int layer = 0; layer < OPAQUE_LAYER_COUNT; layer++) {
+        // with the 2D camera, a larger z is closer
+        float z = -0.9f + 1.8f * layer / OPAQUE_LAYER_COUNT;
+        for (int i = 0; i < OPAQUE_QUADS_PER_LAYER; i++) {
+            float x = Random01() * WIDTH;
+            float y = Random01() * HEIGHT;
+            float size = 50 + Random01() * 150;
+            Vec3 topLeft = { x, y + size, z };
+            Vec3 topRight = { x + size, y + size, z };
+            Vec3 bottomLeft = { x, y, z };
+            Vec3 bottomRight = { x + size, y, z };
+            DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, RandomColor(1));
+        }
+    }
+    MakeDrawCall();
+}
+
+// -- Measuring --
+
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// sorts the samples
+static Summary Summarize(double* samples, int count) {
+    qsort(samples, count, sizeof(double), CompareDoubles);
+    Summary summary = {0};
+    for (int i = 0; i < count; i++) {
+        summary.mean += samples[i];
+    }
+    summary.mean /= count;
+    summary.median = samples[count / 2];
+    summary.p95 = samples[(int)(count * 0.95)];
+    summary.max = samples[count - 1];
+    return summary;
+}
+
+static void WriteSummary(FILE* file, const char* name, Summary summary) {
+    fprintf(file, "      \"%s\": { \"mean\": %.2f, \"median\": %.2f, \"p95\": %.2f, \"max\": %.2f },\n",
+            name, summary.mean, summary.median, summary.p95, summary.max);
+}
+
+static void RunScene(FILE* file, Scene scene, int frameCount, double* frameMicros, double* submitMicros, bool isLast) {
+    Color backgroundColor = { 1, 1, 1, 1 };
+    SetTransparencyMethod(scene.transparencyMethod);
+    SetTransparencyMode(scene.isTransparent);
+    SetDepthPrepassMode(scene.isDepthPrepass);
+
+    RenderStats totals = {0};
+    double totalFrameMicros = 0;
+    double overdraw = 0;
+    int measuredCount = 0;
+
+    for (int frame = 0; frame < WARMUP_FRAMES + frameCount && IsWindowOpen(); frame++) {
+        uint64_t ticksStart = GetTicks();
+        ProcessInput();
+        ClearScreen(backgroundColor);
+        scene.draw(frame);
+        uint64_t ticksSubmitted = GetTicks();
+        EndFrame();
+        uint64_t ticksEnd = GetTicks();
+
+        if (frame < WARMUP_FRAMES) {
+            continue;
+        }
+
+        int i = measuredCount++;
+        frameMicros[i] = (double)(ticksEnd - ticksStart);
+        submitMicros[i] = (double)(ticksSubmitted - ticksStart);
+        totalFrameMicros += frameMicros[i];
+
+        RenderStats stats = GetRenderStats();
+        totals.drawCalls += stats.drawCalls;
+        totals.vertexCount += stats.vertexCount;
+        totals.indexCount += stats.indexCount;
+        totals.shaderBinds += stats.shaderBinds;
+        totals.textureBinds += stats.textureBinds;
+        totals.bytesUploaded += stats.bytesUploaded;
+        totals.depthPrepassDrawCalls += stats.depthPrepassDrawCalls;
+        overdraw += stats.overdraw;
+    }
+
+    // the window was closed
+    if (measuredCount == 0) {
+        return;
+    }
+    frameCount = measuredCount;
+    double seconds = totalFrameMicros / TICKS_PER_SECOND;
+
+    fprintf(file, "    {\n");
+    fprintf(file, "      \"name\": \"%s\",\n", scene.name);
+    WriteSummary(file, "cpuMicrosPerFrame", Summarize(frameMicros, frameCount));
+    WriteSummary(file, "submitMicrosPerFrame", Summarize(submitMicros, frameCount));
+    fprintf(file, "      \"drawCallsPerFrame\": %.2f,\n", (double)totals.drawCalls / frameCount);
+    fprintf(file, "      \"verticesPerFrame\": %.2f,\n", (double)totals.vertexCount / frameCount);
+    fprintf(file, "      \"indicesPerFrame\": %.2f,\n", (double)totals.indexCount / frameCount);
+    fprintf(file, "      \"shaderBindsPerFrame\": %.2f,\n", (double)totals.shaderBinds / frameCount);
+    fprintf(file, "      \"textureBindsPerFrame\": %.2f,\n", (double)totals.textureBinds / frameCount);
+    fprintf(file, "      \"bytesUploadedPerFrame\": %.2f,\n", (double)totals.bytesUploaded / frameCount);
+    fprintf(file, "      \"depthPrepassDrawCallsPerFrame\": %.2f,\n", (double)totals.depthPrepassDrawCalls / frameCount);
+    fprintf(file, "      \"overdraw\": %.2f,\n", overdraw / frameCount);
+    fprintf(file, "      \"verticesPerSecond\": %.0f\n", seconds > 0 ? totals.vertexCount / seconds : 0);
+    fprintf(file, "    }%s\n", isLast ? "" : ",");
+
+    LogInfo("%s: %.2f us per frame\n", scene.name, totalFrameMicros / frameCount);
+}
+
+int main(int argc, char** argv) {
+    const char* outputPath = argc > 1 ? argv[1] : "render_benchmark.json";
+    int frameCount = argc > 2 ? atoi(argv[2]) : DEFAULT_FRAMES;
+    frameCount = frameCount < 1 ? 1 : (frameCount > MAX_FRAMES ? MAX_FRAMES : frameCount);
+
+    ConfigureWindow((WindowSettings){ .width = WIDTH, .height = HEIGHT, .isHidden = true });
+    ConfigureRender((RenderSettings){ .maxVertices = MAX_VERTICES, .maxVertexIndices = MAX_INDICES });
+    InitWindow("render benchmark");
+    if (!ConfigurePresent((PresentSettings){ .swapInterval = SWAP_INTERVAL_IMMEDIATE })) {
+        LogWarning("Unable to turn off vsync. The frame times may be limited by the refresh rate.\n");
+    }
+    RenderTarget sceneTarget = CreateRenderTarget(WIDTH, HEIGHT);
+    UseRenderTarget(sceneTarget);
+
+    FILE* file = fopen(outputPath, "w");
+    if (file == NULL) {
+        LogError("Unable to open %s\n", outputPath);
+        return 1;
+    }
+
+    Scene scenes[] = {
+        { "small_triangles", DrawSmallTriangles, false },
+        { "quads", DrawQuads, false },
+        { "opaque_layers", DrawOpaqueLayers, false },
+        { "opaque_layers_depth_prepass", DrawOpaqueLayers, false, TRANSPARENCY_SORTED, true },
+        { "transform_switching", DrawTransformSwitching, false },
+        { "transparent_layers", DrawTransparentLayers, true },
+        { "transparent_layers_weighted", DrawTransparentLayers, true, TRANSPARENCY_WEIGHTED },
+    };
+    int sceneCount = sizeof(scenes) / sizeof(scenes[0]);
+
+    double* frameMicros = (double*)malloc(frameCount * sizeof(double));
+    double* submitMicros = (double*)malloc(frameCount * sizeof(double));
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %d,\n", frameCount);
+    fprintf(file, "  \"width\": %d,\n", WIDTH);
+    fprintf(file, "  \"height\": %d,\n", HEIGHT);
+    fprintf(file, "  \"scenes\": [\n");
+    for (int i = 0; i < sceneCount; i++) {
+        RunScene(file, scenes[i], frameCount, frameMicros, submitMicros, i == sceneCount - 1);
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    fclose(file);
+    free(frameMicros);
+    free(submitMicros);
+
+    return 0;
+}
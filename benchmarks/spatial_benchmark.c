@@ -0,0 +1,323 @@
+/*
+ * Spatial index benchmark.
+ *
+ * Fills a cube with small random boxes, from 10k up to 1M of them at the same density, and
+ * measures the loose grid, the BVH and a brute force loop over all the boxes with the same
+ * random queries. The results are written as JSON:
+ *
+ * - grid: inserting all the boxes, moving all of them a little, and each query kind
+ * - bvh: the build, a refit after the same move, each query kind and the nearest hit raycast
+ * - bruteForce: each query kind, with fewer queries since it tests every box
+ *
+ * Usage: spatial_benchmark [output.json] [maxObjects]
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "libgame.h"
+
+#define DEFAULT_MAX_OBJECTS 1000000
+#define MIN_OBJECTS 10000
+// the world grows with the object count to keep one object per cube of this side
+#define OBJECT_SPACING 10.0f
+#define MIN_OBJECT_SIZE 1.0f
+#define MAX_OBJECT_SIZE 4.0f
+#define MOVE_DISTANCE 2.0f
+
+#define CELL_SIZE 16.0f
+#define QUERY_SIZE 32.0f
+#define RAY_LENGTH 200.0f
+#define FRUSTUM_FAR_PLANE 150.0f
+
+#define QUERY_COUNT 1000
+#define BRUTE_FORCE_QUERY_COUNT 20
+
+typedef enum {
+    QUERY_AABB,
+    QUERY_SPHERE,
+    QUERY_RAY,
+    QUERY_FRUSTUM,
+    QUERY_KIND_COUNT,
+} QueryKind;
+
+static const char* queryNames[QUERY_KIND_COUNT] = { "aabb", "sphere", "ray", "frustum" };
+
+typedef struct {
+    Aabb box;
+    Vec3 center;
+    Vec3 direction;
+    Frustum frustum;
+} QueryInput;
+
+typedef struct {
+    Aabb* boxes;
+    int count;
+} BruteForce;
+
+typedef int (*RunQueryFn)(void* index, QueryKind kind, const QueryInput* input, int* ids, int maxIds);
+
+// -- Scene --
+
+static float MinFloat(float a, float b) {
+    return a < b ? a : b;
+}
+
+static float MaxFloat(float a, float b) {
+    return a > b ? a : b;
+}
+
+static float Random01() {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static Vec3 RandomPoint(float worldSize) {
+    return (Vec3){ Random01() * worldSize, Random01() * worldSize, Random01() * worldSize };
+}
+
+static Aabb MakeBox(Vec3 center, float halfSize) {
+    return (Aabb){ { center.x - halfSize, center.y - halfSize, center.z - halfSize },
+        { center.x + halfSize, center.y + halfSize, center.z + halfSize } };
+}
+
+static void MoveBoxes(Aabb* boxes, int count) {
+    for (int i = 0; i < count; i++) {
+        Vec3 offset = { (Random01() - 0.5f) * MOVE_DISTANCE, (Random01() - 0.5f) * MOVE_DISTANCE, (Random01() - 0.5f) * MOVE_DISTANCE };
+        boxes[i].min = Vec3Add(boxes[i].min, offset);
+        boxes[i].max = Vec3Add(boxes[i].max, offset);
+    }
+}
+
+static void CreateQueries(QueryInput* queries, float worldSize) {
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        QueryInput* query = &queries[i];
+        query->center = RandomPoint(worldSize);
+        query->box = MakeBox(query->center, QUERY_SIZE / 2);
+        query->direction = Vec3Normalize((Vec3){ Random01() - 0.5f, Random01() - 0.5f, Random01() - 0.5f });
+
+        Camera3D camera = GetDefaultCamera3D();
+        camera.position = query->center;
+        camera.target = Vec3Add(query->center, query->direction);
+        camera.farPlane = FRUSTUM_FAR_PLANE;
+        camera.aspectRatio = 16 / 9.0f;
+        query->frustum = GetCameraFrustum(&camera);
+    }
+}
+
+// -- Indexes --
+
+static int RunGridQuery(void* index, QueryKind kind, const QueryInput* input, int* ids, int maxIds) {
+    SpatialGrid* grid = (SpatialGrid*)index;
+    switch (kind) {
+        case QUERY_AABB:
+            return QueryGridAabb(grid, input->box, ids, maxIds);
+        case QUERY_SPHERE:
+            return QueryGridSphere(grid, input->center, QUERY_SIZE / 2, ids, maxIds);
+        case QUERY_RAY:
+            return QueryGridRay(grid, input->center, input->direction, RAY_LENGTH, ids, maxIds);
+        default:
+            return QueryGridFrustum(grid, &input->frustum, ids, maxIds);
+    }
+}
+
+static int RunBvhQuery(void* index, QueryKind kind, const QueryInput* input, int* ids, int maxIds) {
+    SpatialBvh* bvh = (SpatialBvh*)index;
+    switch (kind) {
+        case QUERY_AABB:
+            return QueryBvhAabb(bvh, input->box, ids, maxIds);
+        case QUERY_SPHERE:
+            return QueryBvhSphere(bvh, input->center, QUERY_SIZE / 2, ids, maxIds);
+        case QUERY_RAY:
+            return QueryBvhRay(bvh, input->center, input->direction, RAY_LENGTH, ids, maxIds);
+        default:
+            return QueryBvhFrustum(bvh, &input->frustum, ids, maxIds);
+    }
+}
+
+static bool BruteForceOverlaps(QueryKind kind, const QueryInput* input, const Aabb* box) {
+    switch (kind) {
+        case QUERY_AABB:
+            return box->min.x <= input->box.max.x && box->max.x >= input->box.min.x
+                && box->min.y <= input->box.max.y && box->max.y >= input->box.min.y
+                && box->min.z <= input->box.max.z && box->max.z >= input->box.min.z;
+        case QUERY_SPHERE: {
+            float dx = input->center.x - MaxFloat(box->min.x, MinFloat(input->center.x, box->max.x));
+            float dy = input->center.y - MaxFloat(box->min.y, MinFloat(input->center.y, box->max.y));
+            float dz = input->center.z - MaxFloat(box->min.z, MinFloat(input->center.z, box->max.z));
+            return dx * dx + dy * dy + dz * dz <= QUERY_SIZE * QUERY_SIZE / 4;
+        }
+        case QUERY_RAY: {
+            float entry = 0;
+            float exit = RAY_LENGTH;
+            float origins[3] = { input->center.x, input->center.y, input->center.z };
+            float directions[3] = { input->direction.x, input->direction.y, input->direction.z };
+            float mins[3] = { box->min.x, box->min.y, box->min.z };
+            float maxs[3] = { box->max.x, box->max.y, box->max.z };
+            for (int axis = 0; axis < 3; axis++) {
+                float inverse = directions[axis] != 0 ? 1 / directions[axis] : FLT_MAX;
+                float t1 = (mins[axis] - origins[axis]) * inverse;
+                float t2 = (maxs[axis] - origins[axis]) * inverse;
+                entry = MaxFloat(entry, MinFloat(t1, t2));
+                exit = MinFloat(exit, MaxFloat(t1, t2));
+            }
+            return entry <= exit;
+        }
+        default:
+            if (box->min.x > input->frustum.bounds.max.x || box->max.x < input->frustum.bounds.min.x
+                    || box->min.y > input->frustum.bounds.max.y || box->max.y < input->frustum.bounds.min.y
+                    || box->min.z > input->frustum.bounds.max.z || box->max.z < input->frustum.bounds.min.z) {
+                return false;
+            }
+            for (int i = 0; i < 6; i++) {
+                Vec4 plane = input->frustum.planes[i];
+                float x = plane.x >= 0 ? box->max.x : box->min.x;
+                float y = plane.y >= 0 ? box->max.y : box->min.y;
+                float z = plane.z >= 0 ? box->max.z : box->min.z;
+                if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0) {
+                    return false;
+                }
+            }
+            return true;
+    }
+}
+
+static int RunBruteForceQuery(void* index, QueryKind kind, const QueryInput* input, int* ids, int maxIds) {
+    BruteForce* bruteForce = (BruteForce*)index;
+    int count = 0;
+    for (int i = 0; i < bruteForce->count; i++) {
+        if (BruteForceOverlaps(kind, input, &bruteForce->boxes[i])) {
+            if (count < maxIds) {
+                ids[count] = i;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+// -- Measuring --
+
+static void WriteQueries(FILE* file, void* index, RunQueryFn run, const QueryInput* queries, int queryCount,
+        int* ids, int maxIds, bool isLast) {
+    fprintf(file, "        \"queries\": {\n");
+    for (int kind = 0; kind < QUERY_KIND_COUNT; kind++) {
+        uint64_t resultCount = 0;
+        uint64_t ticksStart = GetTicks();
+        for (int i = 0; i < queryCount; i++) {
+            resultCount += run(index, (QueryKind)kind, &queries[i], ids, maxIds);
+        }
+        double micros = (double)(GetTicks() - ticksStart);
+        fprintf(file, "          \"%s\": { \"microsPerQuery\": %.3f, \"resultsPerQuery\": %.2f }%s\n", queryNames[kind],
+                micros / queryCount, (double)resultCount / queryCount, kind == QUERY_KIND_COUNT - 1 ? "" : ",");
+    }
+    fprintf(file, "        }%s\n", isLast ? "" : ",");
+}
+
+static void RunSize(FILE* file, int objectCount, int* ids, int maxIds, bool isLast) {
+    srand(objectCount);
+    float worldSize = OBJECT_SPACING * cbrtf((float)objectCount);
+    Aabb* boxes = (Aabb*)malloc(objectCount * sizeof(Aabb));
+    QueryInput* queries = (QueryInput*)malloc(QUERY_COUNT * sizeof(QueryInput));
+    SpatialGrid* grid = CreateSpatialGrid(CELL_SIZE, objectCount);
+    if (boxes == NULL || queries == NULL || grid == NULL) {
+        LogError("Unable to allocate the benchmark of %d objects\n", objectCount);
+        exit(1);
+    }
+    for (int i = 0; i < objectCount; i++) {
+        float size = MIN_OBJECT_SIZE + Random01() * (MAX_OBJECT_SIZE - MIN_OBJECT_SIZE);
+        boxes[i] = MakeBox(RandomPoint(worldSize), size / 2);
+    }
+    CreateQueries(queries, worldSize);
+
+    fprintf(file, "    {\n");
+    fprintf(file, "      \"objects\": %d,\n", objectCount);
+
+    // the grid
+    uint64_t ticksStart = GetTicks();
+    for (int i = 0; i < objectCount; i++) {
+        InsertGridObject(grid, i, boxes[i]);
+    }
+    double insertMicros = (double)(GetTicks() - ticksStart);
+    MoveBoxes(boxes, objectCount);
+    ticksStart = GetTicks();
+    for (int i = 0; i < objectCount; i++) {
+        UpdateGridObject(grid, i, boxes[i]);
+    }
+    double updateMicros = (double)(GetTicks() - ticksStart);
+    fprintf(file, "      \"grid\": {\n");
+    fprintf(file, "        \"insertMicros\": %.0f,\n", insertMicros);
+    fprintf(file, "        \"updateMicros\": %.0f,\n", updateMicros);
+    WriteQueries(file, grid, RunGridQuery, queries, QUERY_COUNT, ids, maxIds, true);
+    fprintf(file, "      },\n");
+    FreeSpatialGrid(grid);
+
+    // the BVH, built before the move and refitted after it
+    MoveBoxes(boxes, objectCount);
+    ticksStart = GetTicks();
+    SpatialBvh* bvh = BuildSpatialBvh(boxes, objectCount);
+    double buildMicros = (double)(GetTicks() - ticksStart);
+    if (bvh == NULL) {
+        LogError("Unable to build the BVH of %d objects\n", objectCount);
+        exit(1);
+    }
+    MoveBoxes(boxes, objectCount);
+    ticksStart = GetTicks();
+    RefitSpatialBvh(bvh, boxes);
+    double refitMicros = (double)(GetTicks() - ticksStart);
+
+    int hitCount = 0;
+    ticksStart = GetTicks();
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        hitCount += RaycastBvh(bvh, queries[i].center, queries[i].direction, RAY_LENGTH, NULL) >= 0;
+    }
+    double raycastMicros = (double)(GetTicks() - ticksStart);
+    fprintf(file, "      \"bvh\": {\n");
+    fprintf(file, "        \"buildMicros\": %.0f,\n", buildMicros);
+    fprintf(file, "        \"refitMicros\": %.0f,\n", refitMicros);
+    fprintf(file, "        \"raycast\": { \"microsPerQuery\": %.3f, \"hitRatio\": %.2f },\n",
+            raycastMicros / QUERY_COUNT, (double)hitCount / QUERY_COUNT);
+    WriteQueries(file, bvh, RunBvhQuery, queries, QUERY_COUNT, ids, maxIds, true);
+    fprintf(file, "      },\n");
+    FreeSpatialBvh(bvh);
+
+    BruteForce bruteForce = { boxes, objectCount };
+    fprintf(file, "      \"bruteForce\": {\n");
+    WriteQueries(file, &bruteForce, RunBruteForceQuery, queries, BRUTE_FORCE_QUERY_COUNT, ids, maxIds, true);
+    fprintf(file, "      }\n");
+    fprintf(file, "    }%s\n", isLast ? "" : ",");
+
+    LogInfo("%d objects: grid insert %.0f us, BVH build %.0f us\n", objectCount, insertMicros, buildMicros);
+    free(boxes);
+    free(queries);
+}
+
+int main(int argc, char** argv) {
+    const char* outputPath = argc > 1 ? argv[1] : "spatial_benchmark.json";
+    int maxObjects = argc > 2 ? atoi(argv[2]) : DEFAULT_MAX_OBJECTS;
+    maxObjects = maxObjects < MIN_OBJECTS ? MIN_OBJECTS : maxObjects;
+
+    FILE* file = fopen(outputPath, "w");
+    if (file == NULL) {
+        LogError("Unable to open %s\n", outputPath);
+        return 1;
+    }
+
+    // the ids of one query, a frustum query finds the most
+    int maxIds = maxObjects;
+    int* ids = (int*)malloc(maxIds * sizeof(int));
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"cellSize\": %.1f,\n", CELL_SIZE);
+    fprintf(file, "  \"sizes\": [\n");
+    for (int objectCount = MIN_OBJECTS; objectCount <= maxObjects; objectCount *= 10) {
+        RunSize(file, objectCount, ids, maxIds, objectCount * 10 > maxObjects);
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    fclose(file);
+    free(ids);
+    return 0;
+}
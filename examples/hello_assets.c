@@ -0,0 +1,77 @@
+/*
+ * Load textures in the background while the frame loop keeps running.
+ *
+ * A few TGA images are generated and written to disk first, since there
+ * are no bundled assets. They are then loaded with LoadTextureAsync, which
+ * reads and decodes them on worker threads. The textures are created at the
+ * end of a frame, within the per frame upload budget.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include "libgame.h"
+
+#define IMAGE_COUNT 32
+#define IMAGE_SIZE 64
+
+static void WriteGradientTga(const char* path, int seed) {
+    uint8_t header[18] = {0};
+    header[2] = 2; // uncompressed true color
+    header[12] = IMAGE_SIZE;
+    header[14] = IMAGE_SIZE;
+    header[16] = 32;
+    header[17] = 0x20; // top-down
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(header, 1, sizeof(header), file);
+    for (int y = 0; y < IMAGE_SIZE; y++) {
+        for (int x = 0; x < IMAGE_SIZE; x++) {
+            // BGRA
+            uint8_t pixel[4] = { (seed * 37) % 256, y * 4, x * 4, 255 };
+            fwrite(pixel, 1, sizeof(pixel), file);
+        }
+    }
+    fclose(file);
+}
+
+int main(int argc, char** argv) {
+    InitWindow("hello assets");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color tint = { 1, 1, 1, 1 };
+    Color loadingColor = { 0.8, 0.8, 0.8, 1 };
+
+    Texture textures[IMAGE_COUNT] = {0};
+    AssetHandle assets[IMAGE_COUNT];
+    for (int i = 0; i < IMAGE_COUNT; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "hello_assets_%d.tga", i);
+        WriteGradientTga(path, i);
+        assets[i] = LoadTextureAsync(path, &textures[i]);
+    }
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        ClearScreen(backgroundColor);
+
+        for (int i = 0; i < IMAGE_COUNT; i++) {
+            Vec2 position = { 10 + (i % 8) * (IMAGE_SIZE + 10), 10 + (i / 8) * (IMAGE_SIZE + 10) };
+            Vec2 size = { IMAGE_SIZE, IMAGE_SIZE };
+
+            // the zero texture is white, so a tinted quad works as a placeholder
+            bool isReady = GetAssetState(assets[i]) == ASSET_READY;
+            DrawSprite2D(GetTextureSprite(textures[i]), position, size, isReady ? tint : loadingColor);
+        }
+        MakeDrawCall();
+
+        EndFrame();
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Use two cameras at the same time. A 3D world camera orbits a quad,
+ * while a 2D UI camera keeps a triangle fixed in the corner of the screen.
+ *
+ * Each camera is stored in its own slot. Select a slot with UseCameraSlot
+ * before drawing. Cameras that don't change between frames are not recalculated.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include "libgame.h"
+
+#define CAMERA_SLOT_WORLD 0
+#define CAMERA_SLOT_UI 1
+
+int main(int argc, char** argv) {
+    InitWindow("hello camera slots");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color quadColor = { 1, 0, 0, 1 };
+    Color uiColor = { 0, 0, 1, 1 };
+
+    Vec3 topLeft = { 50, 250, 0 };
+    Vec3 topRight = { 250, 250, 0 };
+    Vec3 bottomLeft = { 50, 50, 0 };
+    Vec3 bottomRight = { 250, 50, 0 };
+
+    Camera3D worldCamera = GetDefaultCamera3D();
+    worldCamera.target = Vec3Lerp(topLeft, bottomRight, 0.5);
+    float angleSpeed = 0.01;
+
+    Camera2D uiCamera = {0};
+    SetCameraSlot2D(CAMERA_SLOT_UI, &uiCamera);
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        OrbitCameraAboutTarget(&worldCamera, angleSpeed, 0);
+        SetCameraSlot3D(CAMERA_SLOT_WORLD, &worldCamera);
+
+        ClearScreen(backgroundColor);
+
+        UseCameraSlot(CAMERA_SLOT_WORLD);
+        DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, quadColor);
+        MakeDrawCall();
+
+        UseCameraSlot(CAMERA_SLOT_UI);
+        DrawTriangle2D((Vec2){ 10, 10 }, (Vec2){ 60, 10 }, (Vec2){ 10, 60 }, uiColor);
+        MakeDrawCall();
+
+        EndFrame();
+    }
+
+    return 0;
+}
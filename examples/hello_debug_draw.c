@@ -0,0 +1,65 @@
+/*
+ * Debug drawing with lines. A box and a sphere are drawn around a quad,
+ * depth tested so that the quad hides parts of them, while the axes are drawn as an overlay.
+ *
+ * A point moves in a circle and leaves a trail of lines that are kept for one second.
+ *
+ * Define LIBGAME_NO_DEBUG_DRAW to remove all of the debug drawing.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include "libgame.h"
+
+int main(int argc, char** argv) {
+    InitWindow("hello debug draw");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color quadColor = { 0.8, 0.8, 0.8, 1 };
+    Color boxColor = { 0, 0, 1, 1 };
+    Color sphereColor = { 0, 0.6, 0, 1 };
+    Color trailColor = { 1, 0, 1, 1 };
+
+    Vec3 topLeft = { -100, 100, 0 };
+    Vec3 topRight = { 100, 100, 0 };
+    Vec3 bottomLeft = { -100, -100, 0 };
+    Vec3 bottomRight = { 100, -100, 0 };
+    Vec3 origin = { 0, 0, 0 };
+
+    Camera3D camera = GetDefaultCamera3D();
+    camera.position = (Vec3){ 0, 150, 400 };
+    camera.target = origin;
+
+    float time = 0;
+    Vec3 previousPoint = { 150, 0, 0 };
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        time += 1.0 / 60;
+        OrbitCameraAboutTarget(&camera, 0.005, 0);
+        SetCamera3D(&camera);
+
+        ClearScreen(backgroundColor);
+        DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, quadColor);
+        MakeDrawCall();
+
+        DebugDrawBox((Vec3){ -100, -100, -100 }, (Vec3){ 100, 100, 100 }, boxColor, DEBUG_DRAW_DEPTH_TESTED, 1);
+        DebugDrawSphere(origin, 120, sphereColor, DEBUG_DRAW_DEPTH_TESTED, 1);
+
+        DebugDrawLine(origin, (Vec3){ 50, 0, 0 }, (Color){ 1, 0, 0, 1 }, DEBUG_DRAW_OVERLAY, 1);
+        DebugDrawLine(origin, (Vec3){ 0, 50, 0 }, (Color){ 0, 1, 0, 1 }, DEBUG_DRAW_OVERLAY, 1);
+        DebugDrawLine(origin, (Vec3){ 0, 0, 50 }, (Color){ 0, 0, 1, 1 }, DEBUG_DRAW_OVERLAY, 1);
+
+        Vec3 point = { 150 * cosf(time), 30 * sinf(time * 3), 150 * sinf(time) };
+        DebugDrawLine(previousPoint, point, trailColor, DEBUG_DRAW_DEPTH_TESTED, 60);
+        previousPoint = point;
+
+        // debug lines are drawn at the end of the frame
+        EndFrame();
+    }
+
+    return 0;
+}
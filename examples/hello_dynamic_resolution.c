@@ -0,0 +1,84 @@
+/*
+ * Render a heavy 3D scene at a resolution that follows the GPU time.
+ *
+ * The quads are drawn between BeginDynamicResolution and EndDynamicResolution, so they are rendered
+ * into a smaller image when they take too long. The text is drawn afterwards at the full resolution.
+ *
+ * Keys:
+ * - Up and down: more or fewer layers of overlapping quads
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include "libgame.h"
+
+#define CAMERA_SLOT_WORLD 0
+#define CAMERA_SLOT_UI 1
+#define QUADS_PER_LAYER 64
+
+int main(int argc, char** argv) {
+    InitWindow("hello dynamic resolution");
+    SetTargetFps(60);
+    SetTransparencyMode(true);
+
+    Font* font = LoadFont((FontSettings){ .faceName = "Arial", .cacheDirectory = "." });
+    if (font == NULL) {
+        LogError("Unable to load the font\n");
+        return 1;
+    }
+
+    ConfigureDynamicResolution((DynamicResolutionSettings){ .gpuBudgetMs = 8, .minScale = 0.4f });
+
+    Color backgroundColor = { 0.1, 0.1, 0.15, 1 };
+    Color textColor = { 1, 1, 1, 1 };
+
+    Camera3D worldCamera = GetDefaultCamera3D();
+    worldCamera.target = (Vec3){ 0, 0, 0 };
+    Camera2D uiCamera = {0};
+    SetCameraSlot2D(CAMERA_SLOT_UI, &uiCamera);
+
+    int layerCount = 16;
+    char text[256];
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        if (IsKeyPressed(KeyUp)) {
+            layerCount *= 2;
+        }
+        if (IsKeyPressed(KeyDown) && layerCount > 1) {
+            layerCount /= 2;
+        }
+
+        OrbitCameraAboutTarget(&worldCamera, 0.005, 0);
+        SetCameraSlot3D(CAMERA_SLOT_WORLD, &worldCamera);
+
+        BeginDynamicResolution();
+        ClearScreen(backgroundColor);
+        UseCameraSlot(CAMERA_SLOT_WORLD);
+        // large translucent quads, so that the cost is mostly in the pixels
+        for (int layer = 0; layer < layerCount; layer++) {
+            for (int i = 0; i < QUADS_PER_LAYER; i++) {
+                float x = (i % 8 - 4) * 40.0f;
+                float y = (i / 8 - 4) * 40.0f;
+                float z = layer * 0.5f;
+                Color color = { (i % 8) / 8.0f, (i / 8) / 8.0f, 0.5f, 0.05f };
+                DrawQuad3D((Vec3){ x, y + 200, z }, (Vec3){ x + 200, y + 200, z },
+                        (Vec3){ x, y, z }, (Vec3){ x + 200, y, z }, color);
+            }
+        }
+        EndDynamicResolution();
+
+        UseCameraSlot(CAMERA_SLOT_UI);
+        snprintf(text, sizeof(text), "%d layers, scale %.2f, GPU %.2f ms", layerCount, GetResolutionScale(),
+                GetDynamicResolutionGpuMs());
+        DrawText2D(font, text, (Vec2){ 10, GetClientHeight() - 30 }, 18, textColor);
+        MakeDrawCall();
+
+        EndFrame();
+    }
+
+    FreeFont(font);
+    return 0;
+}
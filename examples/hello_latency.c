@@ -0,0 +1,70 @@
+/*
+ * Compare swap intervals and the low latency mode.
+ *
+ * A square follows the mouse, which makes the latency visible. The current latency is printed on top.
+ *
+ * Keys:
+ * - 1: driver default, 2: immediate, 3: vsync, 4: adaptive vsync
+ * - 0 to 4 with shift held: max frames in flight (0 lets the driver decide)
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include "libgame.h"
+
+static const char* swapIntervalNames[] = { "default", "immediate", "vsync", "adaptive" };
+
+int main(int argc, char** argv) {
+    InitWindow("hello latency");
+    SetTransparencyMode(true);
+
+    Font* font = LoadFont((FontSettings){ .faceName = "Arial", .cacheDirectory = "." });
+    if (font == NULL) {
+        LogError("Unable to load the font\n");
+        return 1;
+    }
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color textColor = { 0, 0, 0, 1 };
+    Color squareColor = { 0.9, 0.3, 0.2, 1 };
+
+    PresentSettings settings = { SWAP_INTERVAL_VSYNC, 0 };
+    bool isSupported = ConfigurePresent(settings);
+    char text[256];
+
+    // no sleeping, the swap interval and the fences do the pacing
+    while (IsWindowOpen()) {
+        ProcessInput();
+
+        bool isShiftDown = IsKeyDown(KeyLeftShift) || IsKeyDown(KeyRightShift);
+        for (int i = 0; i <= LIBGAME_MAX_FRAMES_IN_FLIGHT; i++) {
+            if (!IsKeyPressed(Key0 + i)) {
+                continue;
+            }
+            if (isShiftDown) {
+                settings.maxFramesInFlight = i;
+            } else if (i >= 1) {
+                settings.swapInterval = (SwapInterval)(i - 1);
+            }
+            isSupported = ConfigurePresent(settings);
+        }
+
+        ClearScreen(backgroundColor);
+
+        // the mouse position is from the top left, the 2D camera from the bottom left
+        Vec2 mouse = { GetMouseInputX(), GetClientHeight() - GetMouseInputY() };
+        DrawRect2D((Vec2){ mouse.x - 20, mouse.y - 20 }, (Vec2){ 40, 40 }, squareColor);
+
+        FrameLatency latency = GetFrameLatency();
+        snprintf(text, sizeof(text), "%s%s, %d frames in flight: input to present %.2f ms, to GPU done %.2f ms, waited %.2f ms",
+                swapIntervalNames[settings.swapInterval], isSupported ? "" : " (unsupported)", settings.maxFramesInFlight,
+                latency.inputToPresentMicros / 1000.0, latency.inputToGpuDoneMicros / 1000.0, latency.fenceWaitMicros / 1000.0);
+        DrawText2D(font, text, (Vec2){ 10, GetClientHeight() - 30 }, 18, textColor);
+
+        MakeDrawCall();
+        EndFrame();
+    }
+
+    FreeFont(font);
+    return 0;
+}
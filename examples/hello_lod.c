@@ -0,0 +1,114 @@
+/*
+ * Draw a large field of spheres with three levels of detail.
+ *
+ * Far spheres use coarser meshes and the farthest ones are not drawn, so the vertices per frame
+ * grow much slower than the number of spheres. The level counts are logged once per second.
+ *
+ * Keys:
+ * - Up and down: move the camera closer or further
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include <stdlib.h>
+#include "libgame.h"
+
+#define GRID_SIZE 60
+#define SPACING 40.0f
+#define RADIUS 10.0f
+
+// an indexed UV sphere, the caller frees the arrays
+static Mesh CreateSphereMesh(int rings, int segments, Color color) {
+    int vertexCount = (rings + 1) * (segments + 1);
+    int indexCount = rings * segments * 6;
+    Vec3* positions = (Vec3*)malloc(vertexCount * sizeof(Vec3));
+    uint32_t* indices = (uint32_t*)malloc(indexCount * sizeof(uint32_t));
+
+    for (int ring = 0; ring <= rings; ring++) {
+        for (int segment = 0; segment <= segments; segment++) {
+            float polar = 3.14159265f * ring / rings;
+            float azimuth = 2 * 3.14159265f * segment / segments;
+            positions[ring * (segments + 1) + segment] = (Vec3){ RADIUS * sinf(polar) * cosf(azimuth),
+                RADIUS * cosf(polar), RADIUS * sinf(polar) * sinf(azimuth) };
+        }
+    }
+    int count = 0;
+    for (int ring = 0; ring < rings; ring++) {
+        for (int segment = 0; segment < segments; segment++) {
+            uint32_t a = ring * (segments + 1) + segment;
+            uint32_t c = a + segments + 1;
+            uint32_t quad[6] = { a, c, a + 1, a + 1, c, c + 1 };
+            for (int i = 0; i < 6; i++) {
+                indices[count++] = quad[i];
+            }
+        }
+    }
+
+    return (Mesh){ .positions = positions, .color = color, .vertexCount = vertexCount, .indices = indices, .indexCount = indexCount };
+}
+
+int main(int argc, char** argv) {
+    ConfigureRender((RenderSettings){ .maxVertices = 1000000, .maxVertexIndices = 4000000 });
+    InitWindow("hello LOD");
+    SetTargetFps(60);
+
+    LodGroup sphereGroup = {
+        .levels = {
+            CreateSphereMesh(24, 48, (Color){ 0.9, 0.3, 0.2, 1 }),
+            CreateSphereMesh(10, 20, (Color){ 0.9, 0.7, 0.2, 1 }),
+            CreateSphereMesh(4, 8, (Color){ 0.2, 0.7, 0.9, 1 }),
+        },
+        .levelCount = 3,
+        .screenHeights = { 60, 20 },
+        .cullScreenHeight = 3,
+        .radius = RADIUS,
+    };
+
+    LodObject* spheres = (LodObject*)malloc(GRID_SIZE * GRID_SIZE * sizeof(LodObject));
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        Vec3 position = { (i % GRID_SIZE - GRID_SIZE / 2) * SPACING, 0, (i / GRID_SIZE - GRID_SIZE / 2) * SPACING };
+        spheres[i] = (LodObject){ .group = &sphereGroup, .transform = Mat4Translate(position), .level = LIBGAME_LOD_UNSELECTED };
+    }
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Camera3D camera = GetDefaultCamera3D();
+    camera.position = (Vec3){ 0, 150, -400 };
+    camera.farPlane = 5000;
+    int frame = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        if (IsKeyDown(KeyUp)) {
+            MoveCameraTowardsTarget(&camera, 5);
+        }
+        if (IsKeyDown(KeyDown)) {
+            MoveCameraTowardsTarget(&camera, -5);
+        }
+        OrbitCameraAboutTarget(&camera, 0.003, 0);
+        SetCamera3D(&camera);
+
+        SelectLodLevels(&camera, spheres, GRID_SIZE * GRID_SIZE);
+        ClearScreen(backgroundColor);
+        DrawLodObjects(spheres, GRID_SIZE * GRID_SIZE);
+        MakeDrawCall();
+        EndFrame();
+
+        if (++frame % 60 == 0) {
+            int levelCounts[LIBGAME_MAX_LOD_LEVELS + 1] = {0};
+            for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                levelCounts[spheres[i].level]++;
+            }
+            LogInfo("Levels %d %d %d, culled %d, %d vertices\n", levelCounts[0], levelCounts[1], levelCounts[2],
+                    levelCounts[3], GetRenderStats().vertexCount);
+        }
+    }
+
+    for (int i = 0; i < sphereGroup.levelCount; i++) {
+        free((void*)sphereGroup.levels[i].positions);
+        free((void*)sphereGroup.levels[i].indices);
+    }
+    free(spheres);
+    return 0;
+}
@@ -2,6 +2,9 @@
  * Use the Log functions to output to an attached console.
  * In this example, press tab to rotate log levels and see which logs appear.
  *
+ * Logs can also be categorized by subsystem, each with its own minimum level.
+ * Here the render category logs debug messages, regardless of the global level.
+ *
  * Why not printf? You can use printf in some cases, but if you link dynamically
  * you need to set it up by calling freopen from the game code.
  */
@@ -14,6 +17,7 @@ int main(int argc, char** argv) {
 
     SetTargetFps(60);
     LogLevel level = LOG_INFO;
+    SetLogCategoryLevel(LOG_CATEGORY_RENDER, LOG_DEBUG);
 
     while (IsWindowOpen()) {
         ProcessInput();
@@ -25,11 +29,13 @@ int main(int argc, char** argv) {
             Log(LOG_INFO, "hello info with parameter\n");
             LogWarning("hello warning\n");
             LogError("hello error\n");
+            LogDebugIn(LOG_CATEGORY_RENDER, "hello render debug\n");
 
             LogError("=============================\n");
 
             level = (level + 1) % (LOG_ERROR + 1);
             SetLogLevel(level);
+            SetLogCategoryLevel(LOG_CATEGORY_RENDER, LOG_DEBUG);
         }
     }
 
@@ -0,0 +1,76 @@
+/*
+ * Draw with a custom shader. Two materials share the shader but have
+ * different parameters, one pulsing over time and one fixed.
+ *
+ * Triangles are drawn in an interleaved order, but the library merges
+ * graphics with the same material, so each material is drawn once.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include "libgame.h"
+
+// matches MaterialBlock in the shader, using the std140 layout
+typedef struct {
+    Color tint;
+    float pulse;
+    float padding[3];
+} TintParams;
+
+static const char* tintVertexSrc =
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    gl_Position = TransformPosition(position);\n"
+    "    fragColor = color;\n"
+    "}";
+
+static const char* tintFragmentSrc =
+    "layout(std140) uniform MaterialBlock {\n"
+    "    vec4 tint;\n"
+    "    float pulse;\n"
+    "};\n"
+    "in vec4 fragColor;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = mix(fragColor, tint, pulse);\n"
+    "}";
+
+int main(int argc, char** argv) {
+    InitWindow("hello material");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color triangleColor = { 0, 0, 0, 1 };
+
+    Shader tintShader = CreateShader(tintVertexSrc, tintFragmentSrc);
+    Material pulsingMaterial = CreateMaterial(tintShader);
+    Material fixedMaterial = CreateMaterial(tintShader);
+
+    TintParams fixedParams = { .tint = { 0, 0, 1, 1 }, .pulse = 0.5 };
+    SetMaterialParams(fixedMaterial, &fixedParams, sizeof(fixedParams));
+
+    TintParams pulsingParams = { .tint = { 1, 0, 0, 1 } };
+    float time = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        time += 1.0 / 60;
+        pulsingParams.pulse = (sinf(time * 3) + 1) / 2;
+        SetMaterialParams(pulsingMaterial, &pulsingParams, sizeof(pulsingParams));
+
+        ClearScreen(backgroundColor);
+
+        for (int i = 0; i < 8; i++) {
+            UseMaterial(i % 2 == 0 ? pulsingMaterial : fixedMaterial);
+            float x = 20 + i * 60;
+            DrawTriangle2D((Vec2){ x, 100 }, (Vec2){ x + 50, 100 }, (Vec2){ x, 150 }, triangleColor);
+        }
+        MakeDrawCall();
+
+        EndFrame();
+    }
+
+    return 0;
+}
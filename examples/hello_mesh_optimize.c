@@ -0,0 +1,79 @@
+/*
+ * Optimize a mesh once at load time, and draw the optimized mesh.
+ *
+ * The sphere is generated as separate triangles with their own vertices, like a mesh exported without
+ * an index buffer. OptimizeMesh merges the shared vertices and orders the triangles for the vertex cache.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include <stdlib.h>
+#include "libgame.h"
+
+#define RINGS 32
+#define SEGMENTS 64
+#define RADIUS 100.0f
+
+static Vec3 GetSpherePoint(int ring, int segment) {
+    float polar = 3.14159265f * ring / RINGS;
+    float azimuth = 2 * 3.14159265f * segment / SEGMENTS;
+    return (Vec3){ RADIUS * sinf(polar) * cosf(azimuth), RADIUS * cosf(polar), RADIUS * sinf(polar) * sinf(azimuth) };
+}
+
+static Color GetSphereColor(Vec3 p) {
+    return (Color){ 0.5f + p.x / (2 * RADIUS), 0.5f + p.y / (2 * RADIUS), 0.5f + p.z / (2 * RADIUS), 1 };
+}
+
+int main(int argc, char** argv) {
+    InitWindow("hello mesh optimize");
+    SetTargetFps(60);
+
+    int vertexCount = RINGS * SEGMENTS * 6;
+    Vec3* positions = (Vec3*)malloc(vertexCount * sizeof(Vec3));
+    Color* colors = (Color*)malloc(vertexCount * sizeof(Color));
+    uint32_t* indices = (uint32_t*)malloc(vertexCount * sizeof(uint32_t));
+    int count = 0;
+    for (int ring = 0; ring < RINGS; ring++) {
+        for (int segment = 0; segment < SEGMENTS; segment++) {
+            Vec3 a = GetSpherePoint(ring, segment);
+            Vec3 b = GetSpherePoint(ring, segment + 1);
+            Vec3 c = GetSpherePoint(ring + 1, segment);
+            Vec3 d = GetSpherePoint(ring + 1, segment + 1);
+            Vec3 corners[6] = { a, c, b, b, c, d };
+            for (int i = 0; i < 6; i++) {
+                positions[count] = corners[i];
+                colors[count] = GetSphereColor(corners[i]);
+                indices[count] = count;
+                count++;
+            }
+        }
+    }
+
+    Mesh source = { .positions = positions, .colors = colors, .vertexCount = vertexCount, .indices = indices, .indexCount = vertexCount };
+    Mesh sphere = OptimizeMesh(source);
+    LogInfo("%d vertices, %.2f cache misses per triangle, optimized to %d vertices, %.2f cache misses per triangle\n",
+            source.vertexCount, GetMeshCacheMissRatio(source), sphere.vertexCount, GetMeshCacheMissRatio(sphere));
+    free(positions);
+    free(colors);
+    free(indices);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Camera3D camera = GetDefaultCamera3D();
+    camera.target = (Vec3){ 0, 0, 0 };
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        OrbitCameraAboutTarget(&camera, 0.01, 0.005);
+        SetCamera3D(&camera);
+
+        ClearScreen(backgroundColor);
+        DrawMesh(sphere);
+        MakeDrawCall();
+        EndFrame();
+    }
+
+    FreeOptimizedMesh(sphere);
+    return 0;
+}
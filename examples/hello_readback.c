@@ -0,0 +1,65 @@
+/*
+ * Take screenshots and record frames without stalling the frame rate.
+ *
+ * The pixels are read back a couple of frames after they are drawn, and written on a background thread.
+ *
+ * Keys:
+ * - F12: save screenshot.png
+ * - R: start or stop recording the frames to recording.raw,
+ *   play it with ffplay -f rawvideo -pixel_format rgba -video_size WxH recording.raw
+ * - C: print the average color of the frame from a callback
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include "libgame.h"
+
+static void PrintAverageColor(const uint8_t* pixels, int width, int height, uint64_t frame, void* userData) {
+    uint64_t sums[3] = {0};
+    int pixelCount = width * height;
+    for (int i = 0; i < pixelCount; i++) {
+        sums[0] += pixels[i * 4];
+        sums[1] += pixels[i * 4 + 1];
+        sums[2] += pixels[i * 4 + 2];
+    }
+    LogInfo("Frame %llu average color: %d %d %d\n", (unsigned long long)frame,
+            (int)(sums[0] / pixelCount), (int)(sums[1] / pixelCount), (int)(sums[2] / pixelCount));
+}
+
+int main(int argc, char** argv) {
+    InitWindow("hello readback");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color squareColor = { 0.2, 0.4, 0.9, 1 };
+    float x = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        if (IsKeyPressed(KeyF12)) {
+            SaveScreenshot("screenshot.png");
+        }
+        if (IsKeyPressed(KeyR)) {
+            if (IsFrameRecordingActive()) {
+                EndFrameRecording();
+            } else {
+                BeginFrameRecording("recording.raw", FRAME_RECORDING_RAW);
+            }
+        }
+        if (IsKeyPressed(KeyC)) {
+            ReadbackFrame(PrintAverageColor, NULL);
+        }
+
+        x = x > GetClientWidth() ? -100 : x + 4;
+
+        ClearScreen(backgroundColor);
+        DrawRect2D((Vec2){ x, GetClientHeight() / 2 - 50 }, (Vec2){ 100, 100 }, squareColor);
+        MakeDrawCall();
+        EndFrame();
+    }
+
+    FlushFrameReadbacks();
+    return 0;
+}
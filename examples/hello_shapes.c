@@ -0,0 +1,70 @@
+/*
+ * Draw shapes with the shape generators: rectangles, circles, thick lines,
+ * a concave polygon and a mesh with per-vertex colors.
+ *
+ * Each shape writes its vertices straight into the batch, so drawing
+ * a circle costs about as much as drawing its triangles.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include "libgame.h"
+
+int main(int argc, char** argv) {
+    InitWindow("hello shapes");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color rectColor = { 0.9, 0.6, 0.1, 1 };
+    Color circleColor = { 0.1, 0.5, 0.9, 1 };
+    Color lineColor = { 0.2, 0.2, 0.2, 1 };
+    Color polygonColor = { 0.5, 0.1, 0.6, 1 };
+
+    // a star, which is concave
+    Vec2 star[10];
+    for (int i = 0; i < 10; i++) {
+        float angle = i * 3.14159f / 5;
+        float radius = i % 2 == 0 ? 80 : 35;
+        star[i] = (Vec2){ 500 + radius * cosf(angle), 400 + radius * sinf(angle) };
+    }
+
+    Vec3 meshPositions[4] = { { 400, 50, 0 }, { 600, 50, 0 }, { 600, 200, 0 }, { 400, 200, 0 } };
+    Color meshColors[4] = { { 1, 0, 0, 1 }, { 0, 1, 0, 1 }, { 0, 0, 1, 1 }, { 1, 1, 0, 1 } };
+    uint32_t meshIndices[6] = { 0, 1, 2, 0, 2, 3 };
+    Mesh mesh = {
+        .positions = meshPositions,
+        .colors = meshColors,
+        .vertexCount = 4,
+        .indices = meshIndices,
+        .indexCount = 6,
+    };
+
+    float time = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        time += 1.0 / 60;
+        ClearScreen(backgroundColor);
+
+        DrawRect2D((Vec2){ 50, 50 }, (Vec2){ 200, 100 }, rectColor);
+
+        // the segment count follows the radius
+        float radius = 20 + 60 * (sinf(time) + 1) / 2;
+        DrawCircle2D((Vec2){ 150, 350 }, radius, 0, circleColor);
+        DrawCircle2D((Vec2){ 300, 350 }, 40, 6, circleColor);
+
+        for (int i = 0; i < 5; i++) {
+            DrawLine2D((Vec2){ 50, 200 + i * 20 }, (Vec2){ 350, 220 + i * 20 }, 1 + i * 2, lineColor);
+        }
+
+        DrawPolygon2D(star, 10, polygonColor);
+        DrawMesh(mesh);
+
+        MakeDrawCall();
+        EndFrame();
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Cull thousands of moving boxes with a loose grid.
+ *
+ * Each frame the boxes move and are updated in the grid, then a frustum query finds the ones
+ * in view, so only those are drawn. The boxes near the camera target are found with a sphere
+ * query and drawn in another color. The visible and total counts are logged once per second.
+ *
+ * Keys:
+ * - Left and right: orbit the camera
+ * - Up and down: move the camera closer or further
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdlib.h>
+#include "libgame.h"
+
+#define BOX_COUNT 20000
+#define WORLD_SIZE 2000.0f
+#define BOX_SIZE 6.0f
+#define CELL_SIZE 40.0f
+#define NEAR_RADIUS 100.0f
+
+typedef struct {
+    Vec3 position;
+    Vec3 velocity;
+} Box;
+
+static float Random01() {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static Aabb GetBoxBounds(const Box* box) {
+    Vec3 half = { BOX_SIZE / 2, BOX_SIZE / 2, BOX_SIZE / 2 };
+    return (Aabb){ Vec3Sub(box->position, half), Vec3Add(box->position, half) };
+}
+
+// the top face, which is all the camera sees from above
+static void DrawBox(const Box* box, Color color) {
+    Aabb bounds = GetBoxBounds(box);
+    Vec3 topLeft = { bounds.min.x, bounds.max.y, bounds.max.z };
+    Vec3 topRight = { bounds.max.x, bounds.max.y, bounds.max.z };
+    Vec3 bottomLeft = { bounds.min.x, bounds.max.y, bounds.min.z };
+    Vec3 bottomRight = { bounds.max.x, bounds.max.y, bounds.min.z };
+    DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, color);
+}
+
+int main(int argc, char** argv) {
+    ConfigureRender((RenderSettings){ .maxVertices = BOX_COUNT * 4, .maxVertexIndices = BOX_COUNT * 6 });
+    InitWindow("hello spatial");
+    SetTargetFps(60);
+
+    Box* boxes = (Box*)malloc(BOX_COUNT * sizeof(Box));
+    int* visibleIds = (int*)malloc(BOX_COUNT * sizeof(int));
+    int* nearIds = (int*)malloc(BOX_COUNT * sizeof(int));
+    bool* isNear = (bool*)calloc(BOX_COUNT, sizeof(bool));
+    SpatialGrid* grid = CreateSpatialGrid(CELL_SIZE, BOX_COUNT);
+    for (int i = 0; i < BOX_COUNT; i++) {
+        boxes[i].position = (Vec3){ (Random01() - 0.5f) * WORLD_SIZE, 0, (Random01() - 0.5f) * WORLD_SIZE };
+        boxes[i].velocity = (Vec3){ Random01() - 0.5f, 0, Random01() - 0.5f };
+        InsertGridObject(grid, i, GetBoxBounds(&boxes[i]));
+    }
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color boxColor = { 0.2, 0.5, 0.9, 1 };
+    Color nearColor = { 0.9, 0.3, 0.2, 1 };
+    Camera3D camera = GetDefaultCamera3D();
+    camera.position = (Vec3){ 0, 300, -600 };
+    camera.farPlane = 1500;
+    int frame = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        if (IsKeyDown(KeyLeft)) {
+            OrbitCameraAboutTarget(&camera, 0.02, 0);
+        }
+        if (IsKeyDown(KeyRight)) {
+            OrbitCameraAboutTarget(&camera, -0.02, 0);
+        }
+        if (IsKeyDown(KeyUp)) {
+            MoveCameraTowardsTarget(&camera, 5);
+        }
+        if (IsKeyDown(KeyDown)) {
+            MoveCameraTowardsTarget(&camera, -5);
+        }
+        SetCamera3D(&camera);
+
+        for (int i = 0; i < BOX_COUNT; i++) {
+            Box* box = &boxes[i];
+            box->position = Vec3Add(box->position, box->velocity);
+            if (box->position.x < -WORLD_SIZE / 2 || box->position.x > WORLD_SIZE / 2) {
+                box->velocity.x = -box->velocity.x;
+            }
+            if (box->position.z < -WORLD_SIZE / 2 || box->position.z > WORLD_SIZE / 2) {
+                box->velocity.z = -box->velocity.z;
+            }
+            UpdateGridObject(grid, i, GetBoxBounds(box));
+        }
+
+        Frustum frustum = GetCameraFrustum(&camera);
+        int visibleCount = QueryGridFrustum(grid, &frustum, visibleIds, BOX_COUNT);
+        int nearCount = QueryGridSphere(grid, camera.target, NEAR_RADIUS, nearIds, BOX_COUNT);
+        for (int i = 0; i < nearCount; i++) {
+            isNear[nearIds[i]] = true;
+        }
+
+        ClearScreen(backgroundColor);
+        for (int i = 0; i < visibleCount; i++) {
+            int id = visibleIds[i];
+            DrawBox(&boxes[id], isNear[id] ? nearColor : boxColor);
+        }
+        MakeDrawCall();
+        EndFrame();
+
+        for (int i = 0; i < nearCount; i++) {
+            isNear[nearIds[i]] = false;
+        }
+        if (++frame % 60 == 0) {
+            LogInfo("%d of %d boxes visible, %d near the target\n", visibleCount, BOX_COUNT, nearCount);
+        }
+    }
+
+    FreeSpatialGrid(grid);
+    free(boxes);
+    free(visibleIds);
+    free(nearIds);
+    free(isNear);
+    return 0;
+}
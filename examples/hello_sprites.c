@@ -0,0 +1,84 @@
+/*
+ * Draw thousands of sprites from a texture atlas.
+ *
+ * The images are generated at startup and packed into atlas pages.
+ * Sprites on the same page share a texture, so all of the sprites
+ * are drawn with one draw per atlas page.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdlib.h>
+#include "libgame.h"
+
+#define IMAGE_COUNT 64
+#define SPRITE_COUNT 5000
+
+// a checkerboard with a random size and color
+static void GenerateImage(uint8_t* pixels, int width, int height) {
+    uint8_t r = rand() % 256;
+    uint8_t g = rand() % 256;
+    uint8_t b = rand() % 256;
+    int cellSize = 2 + rand() % 6;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool isDark = ((x / cellSize) + (y / cellSize)) % 2 == 0;
+            uint8_t* pixel = &pixels[(y * width + x) * 4];
+            pixel[0] = isDark ? r / 2 : r;
+            pixel[1] = isDark ? g / 2 : g;
+            pixel[2] = isDark ? b / 2 : b;
+            pixel[3] = 255;
+        }
+    }
+}
+
+typedef struct {
+    int spriteIndex;
+    Vec2 position;
+} SpriteInstance;
+
+int main(int argc, char** argv) {
+    // the batch buffers are allocated when the window is created
+    ConfigureRender((RenderSettings){ .maxVertices = SPRITE_COUNT * 4, .maxVertexIndices = SPRITE_COUNT * 6 });
+    InitWindow("hello sprites");
+    SetTargetFps(60);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color tint = { 1, 1, 1, 1 };
+
+    TextureAtlas* atlas = CreateTextureAtlas(512, 512);
+    Sprite sprites[IMAGE_COUNT];
+    uint8_t pixels[48 * 48 * 4];
+    for (int i = 0; i < IMAGE_COUNT; i++) {
+        int width = 16 + rand() % 32;
+        int height = 16 + rand() % 32;
+        GenerateImage(pixels, width, height);
+        AddAtlasImage(atlas, pixels, width, height, &sprites[i]);
+    }
+    LogInfo("Packed %d images into %d atlas pages\n", IMAGE_COUNT, GetAtlasPageCount(atlas));
+    DestroyTextureAtlas(atlas);
+
+    static SpriteInstance instances[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        instances[i].spriteIndex = rand() % IMAGE_COUNT;
+        instances[i].position = (Vec2){ rand() % 800, rand() % 600 };
+    }
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        ClearScreen(backgroundColor);
+
+        for (int i = 0; i < SPRITE_COUNT; i++) {
+            Sprite sprite = sprites[instances[i].spriteIndex];
+            Vec2 size = { sprite.width, sprite.height };
+            DrawSprite2D(sprite, instances[i].position, size, tint);
+        }
+        MakeDrawCall();
+
+        EndFrame();
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Draw text with a signed distance field font.
+ *
+ * A thousand labels are drawn below an FPS counter. The labels use
+ * the same font atlas and material, so they are drawn in one draw call.
+ * The glyph distance fields are cached in the working directory after the first run.
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include <stdio.h>
+#include "libgame.h"
+
+#define LABEL_COUNT 1000
+#define LABEL_COLUMNS 25
+
+int main(int argc, char** argv) {
+    // each glyph is a quad
+    ConfigureRender((RenderSettings){ .maxVertices = LABEL_COUNT * 8 * 4, .maxVertexIndices = LABEL_COUNT * 8 * 6 });
+    InitWindow("hello text");
+    SetTargetFps(60);
+    SetTransparencyMode(true);
+
+    Color backgroundColor = { 1, 1, 1, 1 };
+    Color textColor = { 0, 0, 0, 1 };
+    Color labelColor = { 0.2, 0.3, 0.8, 1 };
+
+    Font* font = LoadFont((FontSettings){ .faceName = "Arial", .cacheDirectory = "." });
+    if (font == NULL) {
+        LogError("Unable to load the font\n");
+        return 1;
+    }
+
+    char fpsText[64];
+    char labels[LABEL_COUNT][8];
+    for (int i = 0; i < LABEL_COUNT; i++) {
+        snprintf(labels[i], sizeof(labels[i]), "#%d", i);
+    }
+    float time = 0;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        time += 1.0 / 60;
+        ClearScreen(backgroundColor);
+
+        snprintf(fpsText, sizeof(fpsText), "FPS: %d", GetFps());
+        DrawText2D(font, fpsText, (Vec2){ 10, 560 }, 32, textColor);
+
+        // labels scale with time, the edges stay sharp
+        float size = 12 + 4 * sinf(time);
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            Vec2 position = { 10 + (i % LABEL_COLUMNS) * 40, 520 - (i / LABEL_COLUMNS) * 13 };
+            DrawText2D(font, labels[i], position, size, labelColor);
+        }
+
+        MakeDrawCall();
+        EndFrame();
+    }
+
+    FreeFont(font);
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Draw thousands of overlapping transparent particles without sorting them.
+ *
+ * With the weighted transparency method, the particles are submitted in any order and composited
+ * when transparency mode is disabled. The opaque cube hides the particles behind it.
+ *
+ * Keys:
+ * - Space: switch between the weighted and sorted methods, the sorted one shows the wrong order
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <math.h>
+#include <stdlib.h>
+#include "libgame.h"
+
+#define PARTICLE_COUNT 4000
+#define PARTICLE_SIZE 6.0f
+
+typedef struct {
+    Vec3 position;
+    Vec3 velocity;
+    Color color;
+} Particle;
+
+static float Random01() {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static void ResetParticle(Particle* particle) {
+    float angle = Random01() * 6.2832f;
+    float speed = 0.5f + Random01();
+    particle->position = (Vec3){ 0, 0, 0 };
+    particle->velocity = (Vec3){ cosf(angle) * speed, 1.5f + Random01() * 1.5f, sinf(angle) * speed };
+    particle->color = (Color){ 0.9f + Random01() * 0.1f, 0.3f + Random01() * 0.5f, 0.1f, 0.1f + Random01() * 0.3f };
+}
+
+int main(int argc, char** argv) {
+    InitWindow("hello weighted transparency");
+    SetTargetFps(60);
+
+    Particle* particles = (Particle*)malloc(PARTICLE_COUNT * sizeof(Particle));
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        ResetParticle(&particles[i]);
+        // spread the particles over their lifetime
+        int steps = rand() % 100;
+        for (int step = 0; step < steps; step++) {
+            particles[i].position.x += particles[i].velocity.x;
+            particles[i].position.y += particles[i].velocity.y;
+            particles[i].position.z += particles[i].velocity.z;
+        }
+    }
+
+    Color backgroundColor = { 0.05, 0.05, 0.1, 1 };
+    Color cubeColor = { 0.3, 0.6, 0.9, 1 };
+    Camera3D camera = GetDefaultCamera3D();
+    camera.target = (Vec3){ 0, 100, 0 };
+    TransparencyMethod method = TRANSPARENCY_WEIGHTED;
+
+    while (IsWindowOpen()) {
+        ProcessInput();
+        SleepUntilNextFrame();
+
+        if (IsKeyPressed(KeySpace)) {
+            method = method == TRANSPARENCY_WEIGHTED ? TRANSPARENCY_SORTED : TRANSPARENCY_WEIGHTED;
+        }
+
+        OrbitCameraAboutTarget(&camera, 0.005, 0);
+        SetCamera3D(&camera);
+        ClearScreen(backgroundColor);
+
+        // opaque graphics first, they write the depth that hides the particles behind them
+        Vec3 a = { -40, 60, -40 };
+        Vec3 b = { 40, 140, 40 };
+        DrawQuad3D((Vec3){ a.x, b.y, a.z }, (Vec3){ b.x, b.y, a.z }, (Vec3){ a.x, a.y, a.z }, (Vec3){ b.x, a.y, a.z }, cubeColor);
+        DrawQuad3D((Vec3){ a.x, b.y, b.z }, (Vec3){ b.x, b.y, b.z }, (Vec3){ a.x, a.y, b.z }, (Vec3){ b.x, a.y, b.z }, cubeColor);
+        DrawQuad3D((Vec3){ a.x, b.y, a.z }, (Vec3){ a.x, b.y, b.z }, (Vec3){ a.x, a.y, a.z }, (Vec3){ a.x, a.y, b.z }, cubeColor);
+        DrawQuad3D((Vec3){ b.x, b.y, a.z }, (Vec3){ b.x, b.y, b.z }, (Vec3){ b.x, a.y, a.z }, (Vec3){ b.x, a.y, b.z }, cubeColor);
+        MakeDrawCall();
+
+        // the particles are drawn in the order of the array, not sorted by depth
+        SetTransparencyMethod(method);
+        SetTransparencyMode(true);
+        for (int i = 0; i < PARTICLE_COUNT; i++) {
+            Particle* particle = &particles[i];
+            particle->position.x += particle->velocity.x;
+            particle->position.y += particle->velocity.y;
+            particle->position.z += particle->velocity.z;
+            if (particle->position.y > 250) {
+                ResetParticle(particle);
+            }
+
+            Vec3 p = particle->position;
+            float s = PARTICLE_SIZE;
+            DrawQuad3D((Vec3){ p.x - s, p.y + s, p.z }, (Vec3){ p.x + s, p.y + s, p.z },
+                    (Vec3){ p.x - s, p.y - s, p.z }, (Vec3){ p.x + s, p.y - s, p.z }, particle->color);
+        }
+        MakeDrawCall();
+        SetTransparencyMode(false);
+
+        EndFrame();
+    }
+
+    free(particles);
+    return 0;
+}
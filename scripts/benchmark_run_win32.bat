@@ -0,0 +1,18 @@
+@echo off
+
+pushd "%~dp0\.."
+
+set output=%1
+set frames=%2
+
+if "%output%" == "" (
+    set output=bin\render_benchmark.json
+)
+
+call .\scripts\tool_build_win32.bat benchmarks\render_benchmark.c windows
+
+.\bin\render_benchmark.exe %output% %frames%
+
+echo Wrote benchmark results to %output%
+
+popd
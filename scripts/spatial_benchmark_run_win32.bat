@@ -0,0 +1,18 @@
+@echo off
+
+pushd "%~dp0\.."
+
+set output=%1
+set max_objects=%2
+
+if "%output%" == "" (
+    set output=bin\spatial_benchmark.json
+)
+
+call .\scripts\tool_build_win32.bat benchmarks\spatial_benchmark.c windows
+
+.\bin\spatial_benchmark.exe %output% %max_objects%
+
+echo Wrote benchmark results to %output%
+
+popd
@@ -0,0 +1,47 @@
+@echo off
+
+pushd "%~dp0\.."
+
+mkdir bin > NUL 2>&1
+
+set tool=%1
+set help_text=Usage: .\tool_build_win32.bat tool subsystem
+set subsystem=%2
+
+if not exist %tool% (
+    echo Unable to find tool %tool%
+    echo %help_text%
+    exit 1
+)
+
+if "%subsystem%" == "" (
+    set subsystem=console
+)
+
+if not "%subsystem%" == "console" (
+    if not "%subsystem%" == "windows" (
+        echo Unknown subsystem "%subsystem%". Please set either console or windows.
+        echo %help_text%
+        exit 1
+    )
+)
+
+for %%f in (%tool%) do set tool_name=%%~nf
+
+echo Building tool %tool% as bin\%tool_name%.exe
+
+cl %tool% ^
+    /Fe: bin\%tool_name%.exe ^
+    /Fo: bin\ ^
+    /Fd: bin\ ^
+    /Zi ^
+    /O2 ^
+    /I"src\include" ^
+    /I"src" ^
+    /link ^
+        /LIBPATH:bin ^
+        libgamedll.lib ^
+        /SUBSYSTEM:%subsystem% ^
+    /nologo
+
+popd
@@ -0,0 +1,210 @@
+/*
+ * Asset pack loading.
+ *
+ * The pack file is memory-mapped and the index is used in place, so opening a pack
+ * only validates the header and the entry bounds and sizes. Uncompressed blobs are returned as pointers into the mapping,
+ * for example mesh vertices are copied straight from the mapping into the vertex buffer.
+ * Compressed blobs are decompressed on first use and kept until the pack is closed.
+ *
+ * See asset_pack.h for the file format and tools/asset_pack.c for the packer.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "assets.h"
+#include "asset_pack.h"
+#include "lz4.h"
+
+struct AssetPack {
+    const uint8_t* data;
+    uint64_t size;
+    void* fileHandle;
+    const AssetPackEntry* entries;
+    int entryCount;
+    uint8_t** decompressed; // per entry, NULL until used
+};
+
+// checked once on open, so that blobs can be used without checking them again
+static bool IsValidPackEntry(const AssetPackEntry* entry, uint64_t fileSize) {
+    if (entry->offset > fileSize || entry->size > fileSize - entry->offset) {
+        return false;
+    }
+    switch (entry->compression) {
+        case AssetPackUncompressed:
+            return entry->rawSize == entry->size;
+        case AssetPackLz4:
+            return entry->rawSize <= ASSET_PACK_MAX_COMPRESSED_SIZE && entry->size <= ASSET_PACK_MAX_COMPRESSED_SIZE;
+        default:
+            return false;
+    }
+}
+
+AssetPack* OpenAssetPack(const char* path) {
+    uint64_t size = 0;
+    void* fileHandle = NULL;
+    const uint8_t* data = ReadFileData(path, &size, &fileHandle);
+    if (data == NULL) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Unable to read asset pack %s\n", path);
+        return NULL;
+    }
+
+    const AssetPackHeader* header = (const AssetPackHeader*)data;
+    bool isValid = size >= sizeof(AssetPackHeader)
+        && header->magic == ASSET_PACK_MAGIC
+        && header->version == ASSET_PACK_VERSION
+        && header->indexOffset <= size
+        && header->entryCount <= (size - header->indexOffset) / sizeof(AssetPackEntry);
+    const AssetPackEntry* entries = isValid ? (const AssetPackEntry*)(data + header->indexOffset) : NULL;
+    for (uint32_t i = 0; isValid && i < header->entryCount; i++) {
+        isValid = IsValidPackEntry(&entries[i], size);
+    }
+    if (!isValid) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Invalid asset pack %s\n", path);
+        FreeFileData(data, fileHandle);
+        return NULL;
+    }
+
+    AssetPack* pack = (AssetPack*)calloc(1, sizeof(AssetPack));
+    Assert(pack != NULL, "Failed to allocate asset pack");
+    pack->data = data;
+    pack->size = size;
+    pack->fileHandle = fileHandle;
+    pack->entries = entries;
+    pack->entryCount = header->entryCount;
+    pack->decompressed = (uint8_t**)calloc(pack->entryCount > 0 ? pack->entryCount : 1, sizeof(uint8_t*));
+    Assert(pack->decompressed != NULL, "Failed to allocate asset pack");
+
+    LogDebugIn(LOG_CATEGORY_LOADER, "Opened asset pack %s with %d entries\n", path, pack->entryCount);
+    return pack;
+}
+
+void CloseAssetPack(AssetPack* pack) {
+    for (int i = 0; i < pack->entryCount; i++) {
+        free(pack->decompressed[i]);
+    }
+    free(pack->decompressed);
+    FreeFileData(pack->data, pack->fileHandle);
+    free(pack);
+}
+
+// binary search, since the index is sorted by name
+static int FindPackEntry(AssetPack* pack, const char* name, AssetPackType type) {
+    int low = 0;
+    int high = pack->entryCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = strncmp(name, pack->entries[mid].name, ASSET_PACK_MAX_NAME);
+        if (cmp == 0) {
+            return pack->entries[mid].type == (uint32_t)type ? mid : -1;
+        }
+        if (cmp < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return -1;
+}
+
+// returns the uncompressed blob of rawSize bytes, or NULL if it fails to decompress
+static const uint8_t* GetPackBlob(AssetPack* pack, int index) {
+    const AssetPackEntry* entry = &pack->entries[index];
+    const uint8_t* blob = pack->data + entry->offset;
+    if (entry->compression == AssetPackUncompressed) {
+        return blob;
+    }
+
+    if (pack->decompressed[index] == NULL) {
+        uint8_t* decompressed = (uint8_t*)malloc(entry->rawSize > 0 ? entry->rawSize : 1);
+        if (decompressed == NULL) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Unable to allocate %llu bytes for asset %s\n", entry->rawSize, entry->name);
+            return NULL;
+        }
+
+        int size = Lz4Decompress(blob, (int)entry->size, decompressed, (int)entry->rawSize);
+        if (size != (int)entry->rawSize) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Unable to decompress asset %s\n", entry->name);
+            free(decompressed);
+            return NULL;
+        }
+        pack->decompressed[index] = decompressed;
+    }
+
+    return pack->decompressed[index];
+}
+
+static const uint8_t* FindPackBlob(AssetPack* pack, const char* name, AssetPackType type, uint64_t* size) {
+    int index = FindPackEntry(pack, name, type);
+    if (index < 0) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Asset %s was not found in the pack\n", name);
+        return NULL;
+    }
+
+    *size = pack->entries[index].rawSize;
+    return GetPackBlob(pack, index);
+}
+
+bool LoadPackedTexture(AssetPack* pack, const char* name, Texture* texture) {
+    uint64_t size = 0;
+    const uint8_t* blob = FindPackBlob(pack, name, AssetPackTexture, &size);
+    if (blob == NULL || size < sizeof(AssetPackTextureHeader)) {
+        return false;
+    }
+
+    const AssetPackTextureHeader* header = (const AssetPackTextureHeader*)blob;
+    if ((uint64_t)header->width * header->height * 4 > size - sizeof(AssetPackTextureHeader)) {
+        return false;
+    }
+
+    *texture = CreateTexture(blob + sizeof(AssetPackTextureHeader), header->width, header->height);
+    return true;
+}
+
+bool LoadPackedShader(AssetPack* pack, const char* name, Shader* shader) {
+    uint64_t size = 0;
+    const uint8_t* blob = FindPackBlob(pack, name, AssetPackShader, &size);
+    if (blob == NULL || size < sizeof(AssetPackShaderHeader)) {
+        return false;
+    }
+
+    const AssetPackShaderHeader* header = (const AssetPackShaderHeader*)blob;
+    uint64_t sourceSize = (uint64_t)header->vertexLength + header->fragmentLength;
+    if (header->vertexLength == 0 || header->fragmentLength == 0 || sourceSize > size - sizeof(AssetPackShaderHeader)) {
+        return false;
+    }
+
+    const char* vertexSrc = (const char*)(blob + sizeof(AssetPackShaderHeader));
+    const char* fragmentSrc = vertexSrc + header->vertexLength;
+    if (vertexSrc[header->vertexLength - 1] != '\0' || fragmentSrc[header->fragmentLength - 1] != '\0') {
+        return false;
+    }
+
+    *shader = CreateShader(vertexSrc, fragmentSrc);
+    return true;
+}
+
+bool GetPackedMesh(AssetPack* pack, const char* name, PackedMesh* mesh) {
+    uint64_t size = 0;
+    const uint8_t* blob = FindPackBlob(pack, name, AssetPackMesh, &size);
+    if (blob == NULL || size < sizeof(AssetPackMeshHeader)) {
+        return false;
+    }
+
+    const AssetPackMeshHeader* header = (const AssetPackMeshHeader*)blob;
+    uint64_t vertexSize = (uint64_t)header->vertexCount * ASSET_PACK_FLOATS_PER_VERTEX * sizeof(float);
+    uint64_t indexSize = (uint64_t)header->indexCount * sizeof(uint32_t);
+    if (header->floatsPerVertex != ASSET_PACK_FLOATS_PER_VERTEX || vertexSize + indexSize > size - sizeof(AssetPackMeshHeader)) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Mesh %s has an unsupported vertex layout\n", name);
+        return false;
+    }
+
+    PackedMesh result = {0};
+    result.vertices = (const float*)(blob + sizeof(AssetPackMeshHeader));
+    result.vertexCount = header->vertexCount;
+    result.indices = (const uint32_t*)(blob + sizeof(AssetPackMeshHeader) + vertexSize);
+    result.indexCount = header->indexCount;
+    *mesh = result;
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef asset_pack_h
+#define asset_pack_h
+
+/*
+ * Asset pack format. Shared by the pack loader and the packer tool.
+ *
+ * A pack is a single file that is memory-mapped and used in place:
+ *
+ *   AssetPackHeader
+ *   blobs, each aligned to ASSET_PACK_ALIGNMENT
+ *   AssetPackEntry[entryCount] at indexOffset, sorted by name
+ *
+ * Each blob starts with a header for its type:
+ * - mesh: AssetPackMeshHeader, float vertices[vertexCount * floatsPerVertex], uint32_t indices[indexCount]
+ * - texture: AssetPackTextureHeader, RGBA pixels with the top row first
+ * - shader: AssetPackShaderHeader, the vertex source and the fragment source, each null terminated
+ *
+ * Mesh vertices use the same layout as the render backend vertex buffer, so they can be copied as is.
+ * A blob can be LZ4 compressed as a whole, in which case size is the compressed size.
+ *
+ * All values are little-endian.
+ */
+
+#include <stdint.h>
+
+#define ASSET_PACK_MAGIC 0x4b50474c // "LGPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 64
+#define ASSET_PACK_MAX_NAME 48
+// the largest blob that is compressed, larger blobs are stored as is
+#define ASSET_PACK_MAX_COMPRESSED_SIZE (1 << 30)
+// position (3), color (4), texture coordinates (2), must match the render backend
+#define ASSET_PACK_FLOATS_PER_VERTEX 9
+
+typedef enum {
+    AssetPackMesh = 1,
+    AssetPackTexture,
+    AssetPackShader,
+} AssetPackType;
+
+typedef enum {
+    AssetPackUncompressed = 0,
+    AssetPackLz4,
+} AssetPackCompression;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t reserved2;
+} AssetPackHeader;
+
+typedef struct {
+    char name[ASSET_PACK_MAX_NAME]; // null terminated
+    uint32_t type;
+    uint32_t compression;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t rawSize;
+} AssetPackEntry;
+
+typedef struct {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t floatsPerVertex;
+    uint32_t reserved;
+} AssetPackMeshHeader;
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved[2];
+} AssetPackTextureHeader;
+
+typedef struct {
+    uint32_t vertexLength; // including the null terminator
+    uint32_t fragmentLength;
+    uint32_t reserved[2];
+} AssetPackShaderHeader;
+
+#endif
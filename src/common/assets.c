@@ -0,0 +1,311 @@
+/*
+ * Asynchronous asset loading.
+ *
+ * WORKERS
+ *
+ * Loading an asset pushes its id to a job queue. A pool of worker threads pops jobs,
+ * reads the file and decodes it. A worker that pops a job while there are more jobs
+ * in the queue wakes up another worker, so a burst of loads spreads over the whole pool.
+ *
+ * UPLOADS
+ *
+ * Decoded assets are pushed to an upload queue, which is drained on the main thread
+ * at the end of each frame. The upload stops when the time budget is spent,
+ * and continues in the next frame.
+ *
+ * Both queues are rings protected by a lock. The lock is only held while pushing or popping,
+ * so contention is low compared to the time spent reading and decoding. Every asset id
+ * is queued at most once per queue, so the rings can't overflow.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "platform_setup.h"
+#include "asserts.h"
+#include "atomics.h"
+#include "threading.h"
+#include "assets.h"
+#include "image_tga.h"
+
+#define ASSET_MAX_WORKERS 16
+#define ASSET_WORKER_WAIT_MS 100
+
+PlatformFiles platformFiles = {};
+
+void InitPlatformFiles(PlatformFiles pf) {
+    platformFiles = pf;
+}
+
+typedef struct {
+    char path[LIBGAME_MAX_ASSET_PATH];
+    AssetDecodeFn decode;
+    AssetUploadFn upload;
+    void* userData;
+    void* decoded;
+    volatile uint32_t state;
+} Asset;
+
+typedef struct {
+    int ids[LIBGAME_MAX_ASSETS];
+    int head;
+    int tail;
+    void* lock;
+} AssetQueue;
+
+static AssetSettings assetSettings = {
+    .workerCount = 0,
+    .uploadBudgetMicros = LIBGAME_DEFAULT_ASSET_UPLOAD_BUDGET_MICROS,
+};
+
+static Asset assets[LIBGAME_MAX_ASSETS];
+static int assetCount = 0;
+static int pendingAssetCount = 0;
+
+static AssetQueue jobQueue = {0};
+static AssetQueue uploadQueue = {0};
+static void* jobSignal = NULL;
+static void* workers[ASSET_MAX_WORKERS];
+static int workerCount = 0;
+
+void ConfigureAssets(AssetSettings settings) {
+    Assert(workerCount == 0, "Unable to configure assets. The asset workers have already been started.");
+    assetSettings = settings;
+}
+
+// -- Queues --
+
+static void PushAssetQueue(AssetQueue* queue, int id) {
+    AcquireLock(queue->lock);
+    queue->ids[queue->tail % LIBGAME_MAX_ASSETS] = id;
+    queue->tail++;
+    ReleaseLock(queue->lock);
+}
+
+// returns -1 if the queue is empty, and optionally whether more ids remain
+static int PopAssetQueue(AssetQueue* queue, bool* hasMore) {
+    int id = -1;
+
+    AcquireLock(queue->lock);
+    if (queue->head != queue->tail) {
+        id = queue->ids[queue->head % LIBGAME_MAX_ASSETS];
+        queue->head++;
+    }
+    if (hasMore != NULL) {
+        *hasMore = queue->head != queue->tail;
+    }
+    ReleaseLock(queue->lock);
+
+    return id;
+}
+
+// -- Files --
+
+const uint8_t* ReadFileData(const char* path, uint64_t* size, void** handle) {
+    void* mapping = NULL;
+    void* data = platformFiles.MapFile(path, size, &mapping);
+    if (data != NULL) {
+        *handle = mapping;
+        return (const uint8_t*)data;
+    }
+
+    // fall back to a regular read, for example for empty files
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* buffer = (uint8_t*)malloc(fileSize > 0 ? fileSize : 1);
+    bool isRead = buffer != NULL && fread(buffer, 1, fileSize, file) == (size_t)fileSize;
+    fclose(file);
+
+    if (!isRead) {
+        free(buffer);
+        return NULL;
+    }
+
+    *size = fileSize;
+    *handle = NULL;
+    return buffer;
+}
+
+void FreeFileData(const uint8_t* data, void* handle) {
+    if (handle != NULL) {
+        platformFiles.UnmapFile((void*)data, handle);
+    } else {
+        free((void*)data);
+    }
+}
+
+// -- Workers --
+
+static void LoadAsset(int id) {
+    Asset* asset = &assets[id];
+
+    uint64_t size = 0;
+    void* handle = NULL;
+    const uint8_t* data = ReadFileData(asset->path, &size, &handle);
+    if (data == NULL) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Unable to read asset %s\n", asset->path);
+        AtomicStore(&asset->state, ASSET_FAILED);
+        return;
+    }
+
+    bool isDecoded = asset->decode(data, size, asset->userData, &asset->decoded);
+    FreeFileData(data, handle);
+
+    if (!isDecoded) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Unable to decode asset %s\n", asset->path);
+        AtomicStore(&asset->state, ASSET_FAILED);
+        return;
+    }
+
+    PushAssetQueue(&uploadQueue, id);
+}
+
+static void RunAssetWorker(void* arg) {
+    while (true) {
+        bool hasMore = false;
+        int id = PopAssetQueue(&jobQueue, &hasMore);
+        if (id < 0) {
+            WaitSignal(jobSignal, ASSET_WORKER_WAIT_MS);
+            continue;
+        }
+
+        if (hasMore) {
+            SetSignal(jobSignal);
+        }
+        LoadAsset(id);
+    }
+}
+
+static void StartAssetWorkers() {
+    jobQueue.lock = CreateLock();
+    uploadQueue.lock = CreateLock();
+    jobSignal = CreateSignal();
+
+    int count = assetSettings.workerCount;
+    if (count <= 0) {
+        count = GetProcessorCount() - 1;
+    }
+    count = count < 1 ? 1 : (count > ASSET_MAX_WORKERS ? ASSET_MAX_WORKERS : count);
+
+    for (int i = 0; i < count; i++) {
+        workers[i] = StartThread(RunAssetWorker, NULL);
+    }
+    workerCount = count;
+
+    LogDebugIn(LOG_CATEGORY_LOADER, "Started %d asset workers\n", workerCount);
+}
+
+// -- Public API --
+
+AssetHandle LoadAssetAsync(const char* path, AssetDecodeFn decode, AssetUploadFn upload, void* userData) {
+    Assert(assetCount < LIBGAME_MAX_ASSETS, "Too many assets. Max is %d.", LIBGAME_MAX_ASSETS);
+    Assert(strlen(path) < LIBGAME_MAX_ASSET_PATH, "Asset path is too long: %s", path);
+
+    if (workerCount == 0) {
+        StartAssetWorkers();
+    }
+
+    int id = assetCount++;
+    Asset* asset = &assets[id];
+    strcpy(asset->path, path);
+    asset->decode = decode;
+    asset->upload = upload;
+    asset->userData = userData;
+    asset->decoded = NULL;
+    AtomicStore(&asset->state, ASSET_LOADING);
+    pendingAssetCount++;
+
+    PushAssetQueue(&jobQueue, id);
+    SetSignal(jobSignal);
+
+    AssetHandle handle = {0};
+    handle.id = id;
+    return handle;
+}
+
+AssetState GetAssetState(AssetHandle handle) {
+    Assert(handle.id >= 0 && handle.id < assetCount, "Invalid asset %d", handle.id);
+    return (AssetState)AtomicLoad(&assets[handle.id].state);
+}
+
+int GetPendingAssetCount() {
+    return pendingAssetCount;
+}
+
+void ProcessAssetUploads() {
+    if (workerCount == 0) {
+        return;
+    }
+
+    uint64_t ticksStart = GetTicks();
+    while (true) {
+        int id = PopAssetQueue(&uploadQueue, NULL);
+        if (id < 0) {
+            break;
+        }
+
+        Asset* asset = &assets[id];
+        asset->upload(asset->decoded, asset->userData);
+        asset->decoded = NULL;
+        AtomicStore(&asset->state, ASSET_READY);
+
+        if (GetTicks() - ticksStart >= (uint64_t)assetSettings.uploadBudgetMicros) {
+            break;
+        }
+    }
+
+    // failed assets are never uploaded, so count them here
+    int pendingCount = 0;
+    for (int i = 0; i < assetCount; i++) {
+        pendingCount += AtomicLoad(&assets[i].state) == ASSET_LOADING;
+    }
+    pendingAssetCount = pendingCount;
+}
+
+// -- Textures --
+
+typedef struct {
+    int width;
+    int height;
+    uint8_t pixels[];
+} DecodedImage;
+
+static bool DecodeTga(const uint8_t* data, uint64_t size, void* userData, void** decoded) {
+    int width;
+    int height;
+    if (!ParseTgaHeader(data, size, &width, &height)) {
+        return false;
+    }
+
+    DecodedImage* image = (DecodedImage*)malloc(sizeof(DecodedImage) + GetTgaPixelsSize(width, height));
+    if (image == NULL) {
+        return false;
+    }
+    image->width = width;
+    image->height = height;
+
+    if (!DecodeTgaPixels(data, size, image->pixels)) {
+        free(image);
+        return false;
+    }
+
+    *decoded = image;
+    return true;
+}
+
+static void UploadTexture(void* decoded, void* userData) {
+    DecodedImage* image = (DecodedImage*)decoded;
+    *(Texture*)userData = CreateTexture(image->pixels, image->width, image->height);
+    free(image);
+}
+
+AssetHandle LoadTextureAsync(const char* path, Texture* texture) {
+    return LoadAssetAsync(path, DecodeTga, UploadTexture, texture);
+}
@@ -0,0 +1,16 @@
+#ifndef assets_h
+#define assets_h
+
+#include <stdint.h>
+
+// call at the end of each frame, on the main thread
+void ProcessAssetUploads();
+
+/*
+ * Read a whole file, memory-mapped if possible. Returns NULL on failure.
+ * Release with FreeFileData, passing the returned handle.
+ */
+const uint8_t* ReadFileData(const char* path, uint64_t* size, void** handle);
+void FreeFileData(const uint8_t* data, void* handle);
+
+#endif
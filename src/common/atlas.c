@@ -0,0 +1,215 @@
+/*
+ * Texture atlas with a skyline packer.
+ *
+ * Each page tracks its skyline, which is the top edge of the packed images
+ * as a list of horizontal segments sorted by x. An image is placed on top of the skyline
+ * at the position where its top edge ends up lowest (bottom-left heuristic), and the
+ * segments it covers are replaced by one segment at its top edge.
+ *
+ * The skyline wastes the space under overhangs, but is fast and packs
+ * images of similar heights well, which is the common case for sprites and glyphs.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "asserts.h"
+
+#define ATLAS_PADDING 1
+
+typedef struct {
+    int x;
+    int y;
+    int width;
+} SkylineSegment;
+
+typedef struct {
+    Texture texture;
+    SkylineSegment* segments;
+    int segmentCount;
+} AtlasPage;
+
+struct TextureAtlas {
+    int pageWidth;
+    int pageHeight;
+    AtlasPage pages[LIBGAME_MAX_ATLAS_PAGES];
+    int pageCount;
+};
+
+TextureAtlas* CreateTextureAtlas(int pageWidth, int pageHeight) {
+    TextureAtlas* atlas = (TextureAtlas*)calloc(1, sizeof(TextureAtlas));
+    Assert(atlas != NULL, "Failed to allocate texture atlas");
+    atlas->pageWidth = pageWidth;
+    atlas->pageHeight = pageHeight;
+    return atlas;
+}
+
+void DestroyTextureAtlas(TextureAtlas* atlas) {
+    for (int i = 0; i < atlas->pageCount; i++) {
+        free(atlas->pages[i].segments);
+    }
+    free(atlas);
+}
+
+int GetAtlasPageCount(TextureAtlas* atlas) {
+    return atlas->pageCount;
+}
+
+static AtlasPage* AddAtlasPage(TextureAtlas* atlas) {
+    if (atlas->pageCount == LIBGAME_MAX_ATLAS_PAGES) {
+        return NULL;
+    }
+
+    AtlasPage* page = &atlas->pages[atlas->pageCount++];
+    page->texture = CreateTexture(NULL, atlas->pageWidth, atlas->pageHeight);
+    // every segment is at least 1 pixel wide
+    page->segments = (SkylineSegment*)malloc(atlas->pageWidth * sizeof(SkylineSegment));
+    Assert(page->segments != NULL, "Failed to allocate atlas page");
+    page->segments[0] = (SkylineSegment){ 0, 0, atlas->pageWidth };
+    page->segmentCount = 1;
+
+    return page;
+}
+
+// returns the y coordinate of an image placed at the given segment, or -1 if it doesn't fit
+static int FitSkyline(TextureAtlas* atlas, AtlasPage* page, int segmentIndex, int width, int height) {
+    int x = page->segments[segmentIndex].x;
+    if (x + width > atlas->pageWidth) {
+        return -1;
+    }
+
+    int y = 0;
+    int remainingWidth = width;
+    for (int i = segmentIndex; remainingWidth > 0; i++) {
+        SkylineSegment segment = page->segments[i];
+        y = segment.y > y ? segment.y : y;
+        if (y + height > atlas->pageHeight) {
+            return -1;
+        }
+        remainingWidth -= segment.width;
+    }
+
+    return y;
+}
+
+static void AddSkylineSegment(AtlasPage* page, int segmentIndex, int x, int y, int width) {
+    memmove(&page->segments[segmentIndex + 1], &page->segments[segmentIndex],
+            (page->segmentCount - segmentIndex) * sizeof(SkylineSegment));
+    page->segments[segmentIndex] = (SkylineSegment){ x, y, width };
+    page->segmentCount++;
+
+    // shrink or remove the segments covered by the new one
+    for (int i = segmentIndex + 1; i < page->segmentCount; i++) {
+        SkylineSegment* previous = &page->segments[i - 1];
+        SkylineSegment* segment = &page->segments[i];
+        int overlap = previous->x + previous->width - segment->x;
+        if (overlap <= 0) {
+            break;
+        }
+
+        segment->x += overlap;
+        segment->width -= overlap;
+        if (segment->width > 0) {
+            break;
+        }
+
+        memmove(segment, segment + 1, (page->segmentCount - i - 1) * sizeof(SkylineSegment));
+        page->segmentCount--;
+        i--;
+    }
+
+    // merge neighbors at the same height
+    for (int i = 0; i < page->segmentCount - 1; i++) {
+        SkylineSegment* segment = &page->segments[i];
+        SkylineSegment* next = &page->segments[i + 1];
+        if (segment->y == next->y) {
+            segment->width += next->width;
+            memmove(next, next + 1, (page->segmentCount - i - 2) * sizeof(SkylineSegment));
+            page->segmentCount--;
+            i--;
+        }
+    }
+}
+
+static bool PackInPage(TextureAtlas* atlas, AtlasPage* page, int width, int height, int* outX, int* outY) {
+    int bestIndex = -1;
+    int bestTop = atlas->pageHeight + 1;
+    int bestWidth = atlas->pageWidth + 1;
+
+    for (int i = 0; i < page->segmentCount; i++) {
+        int y = FitSkyline(atlas, page, i, width, height);
+        if (y < 0) {
+            continue;
+        }
+
+        int top = y + height;
+        if (top < bestTop || (top == bestTop && page->segments[i].width < bestWidth)) {
+            bestIndex = i;
+            bestTop = top;
+            bestWidth = page->segments[i].width;
+            *outX = page->segments[i].x;
+            *outY = y;
+        }
+    }
+
+    if (bestIndex < 0) {
+        return false;
+    }
+
+    AddSkylineSegment(page, bestIndex, *outX, *outY + height, width);
+    return true;
+}
+
+// copy the image into the middle of a padded buffer and repeat the edge pixels into the padding
+static void CopyWithExtrudedEdges(const uint8_t* pixels, int width, int height, uint8_t* padded) {
+    int paddedWidth = width + 2 * ATLAS_PADDING;
+    int paddedHeight = height + 2 * ATLAS_PADDING;
+
+    for (int y = 0; y < paddedHeight; y++) {
+        int sourceY = y - ATLAS_PADDING;
+        sourceY = sourceY < 0 ? 0 : (sourceY >= height ? height - 1 : sourceY);
+        for (int x = 0; x < paddedWidth; x++) {
+            int sourceX = x - ATLAS_PADDING;
+            sourceX = sourceX < 0 ? 0 : (sourceX >= width ? width - 1 : sourceX);
+            memcpy(&padded[(y * paddedWidth + x) * 4], &pixels[(sourceY * width + sourceX) * 4], 4);
+        }
+    }
+}
+
+bool AddAtlasImage(TextureAtlas* atlas, const uint8_t* pixels, int width, int height, Sprite* sprite) {
+    int paddedWidth = width + 2 * ATLAS_PADDING;
+    int paddedHeight = height + 2 * ATLAS_PADDING;
+    if (paddedWidth > atlas->pageWidth || paddedHeight > atlas->pageHeight) {
+        return false;
+    }
+
+    int x = 0;
+    int y = 0;
+    AtlasPage* page = NULL;
+    for (int i = 0; i < atlas->pageCount && page == NULL; i++) {
+        if (PackInPage(atlas, &atlas->pages[i], paddedWidth, paddedHeight, &x, &y)) {
+            page = &atlas->pages[i];
+        }
+    }
+    if (page == NULL) {
+        page = AddAtlasPage(atlas);
+        if (page == NULL || !PackInPage(atlas, page, paddedWidth, paddedHeight, &x, &y)) {
+            return false;
+        }
+    }
+
+    ScratchArena scratch = BeginScratch();
+    uint8_t* padded = (uint8_t*)ArenaAlloc(scratch.arena, paddedWidth * paddedHeight * 4);
+    CopyWithExtrudedEdges(pixels, width, height, padded);
+    UpdateTexture(page->texture, x, y, paddedWidth, paddedHeight, padded);
+    EndScratch(scratch);
+
+    Sprite result = {0};
+    result.texture = page->texture;
+    result.uvMin = (Vec2){ (float)(x + ATLAS_PADDING) / atlas->pageWidth, (float)(y + ATLAS_PADDING) / atlas->pageHeight };
+    result.uvMax = (Vec2){ (float)(x + ATLAS_PADDING + width) / atlas->pageWidth, (float)(y + ATLAS_PADDING + height) / atlas->pageHeight };
+    result.width = width;
+    result.height = height;
+    *sprite = result;
+
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef atomics_h
+#define atomics_h
+
+/*
+ * Minimal 32-bit atomics for lock-free queues.
+ *
+ * Loads have acquire semantics and stores have release semantics.
+ * The compare exchange and add functions are full barriers.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <intrin.h>
+
+    // x64 is strongly ordered, so a compiler barrier is enough for acquire/release
+    static inline uint32_t AtomicLoad(volatile uint32_t* target) {
+        uint32_t value = *target;
+        _ReadWriteBarrier();
+        return value;
+    }
+
+    static inline void AtomicStore(volatile uint32_t* target, uint32_t value) {
+        _ReadWriteBarrier();
+        *target = value;
+    }
+
+    static inline bool AtomicCompareExchange(volatile uint32_t* target, uint32_t expected, uint32_t desired) {
+        return (uint32_t)_InterlockedCompareExchange((volatile long*)target, (long)desired, (long)expected) == expected;
+    }
+
+    // returns the previous value
+    static inline uint32_t AtomicAdd(volatile uint32_t* target, uint32_t value) {
+        return (uint32_t)_InterlockedExchangeAdd((volatile long*)target, (long)value);
+    }
+#else
+    static inline uint32_t AtomicLoad(volatile uint32_t* target) {
+        return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+    }
+
+    static inline void AtomicStore(volatile uint32_t* target, uint32_t value) {
+        __atomic_store_n(target, value, __ATOMIC_RELEASE);
+    }
+
+    static inline bool AtomicCompareExchange(volatile uint32_t* target, uint32_t expected, uint32_t desired) {
+        return __atomic_compare_exchange_n(target, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    // returns the previous value
+    static inline uint32_t AtomicAdd(volatile uint32_t* target, uint32_t value) {
+        return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+    }
+#endif
+
+#endif
@@ -1,50 +1,200 @@
+/*
+ * Camera transforms are cached per camera slot.
+ *
+ * Setting a camera that is identical to the cached one is a no-op. Otherwise
+ * the slot is marked as dirty and its version is incremented. The transform
+ * is recalculated lazily the next time it is requested, so setting a camera
+ * several times per frame or resizing the window only costs a comparison.
+ *
+ * Slots that have not been set use a fallback 2D camera at the origin.
+ */
+#include <float.h>
+#include <math.h>
+#include <string.h>
 #include "libgame.h"
 #include "camera.h"
 
+typedef enum {
+    CameraKindUnset,
+    CameraKind2D,
+    CameraKind3D,
+} CameraKind;
+
+typedef struct {
+    CameraKind kind;
+    Camera2D camera2D;
+    Camera3D camera3D;
+    Mat4 transform;
+    uint32_t version;
+    bool isDirty;
+} CameraSlot;
+
 static int clientWidth = 0;
 static int clientHeight = 0;
-static Mat4 transform = {};
-static Mat4 fallBackTransform = {};
-static bool didSetCamera = false;
+static CameraSlot cameraSlots[LIBGAME_MAX_CAMERAS] = {0};
 static float dummyAspectRatio = 0;
 
+static void MarkDirty(CameraSlot* slot) {
+    slot->isDirty = true;
+    slot->version++;
+}
+
 // -- Common --
 
+static bool DependsOnClientArea(CameraSlot* slot) {
+    switch (slot->kind) {
+        case CameraKind3D:
+            return slot->camera3D.aspectRatio <= dummyAspectRatio;
+        default:
+            return true;
+    }
+}
+
 void SetCameraClientArea(int width, int height) {
+    if (width == clientWidth && height == clientHeight) {
+        return;
+    }
     clientWidth = width;
     clientHeight = height;
-    fallBackTransform = Mat4Ortho(0, clientWidth, 0, clientHeight, -1, 1);
+
+    for (int i = 0; i < LIBGAME_MAX_CAMERAS; i++) {
+        CameraSlot* slot = &cameraSlots[i];
+        if (DependsOnClientArea(slot)) {
+            MarkDirty(slot);
+        }
+    }
+}
+
+static Mat4 CalculateTransform2D(Camera2D* camera) {
+   Vec2 origin = camera->origin;
+   return Mat4Ortho(origin.x, clientWidth + origin.x, origin.y, clientHeight + origin.y, -1, 1);
+}
+
+static Mat4 CalculateTransform3D(Camera3D* camera) {
+    Mat4 view = Mat4ViewTransform(camera->target, camera->position, camera->up);
+
+    float aspectRatio = camera->aspectRatio > dummyAspectRatio ? camera->aspectRatio : clientWidth / (float) clientHeight;
+    Mat4 perspective = Mat4Perspective(camera->fieldOfViewY, aspectRatio, camera->nearPlane, camera->farPlane);
+
+    return Mat4Multiply(perspective, view);
 }
 
-Mat4 GetCameraTransform() {
-    if (didSetCamera) {
-        return transform;
+Mat4 GetCameraTransform(int slotIndex) {
+    CameraSlot* slot = &cameraSlots[slotIndex];
+    if (!slot->isDirty) {
+        return slot->transform;
+    }
+
+    switch (slot->kind) {
+        case CameraKind2D:
+            slot->transform = CalculateTransform2D(&slot->camera2D);
+            break;
+        case CameraKind3D:
+            slot->transform = CalculateTransform3D(&slot->camera3D);
+            break;
+        default: {
+            Camera2D fallBackCamera = {0};
+            slot->transform = CalculateTransform2D(&fallBackCamera);
+            break;
+        }
     }
-    return fallBackTransform;
+    slot->isDirty = false;
+
+    return slot->transform;
+}
+
+uint32_t GetCameraTransformVersion(int slot) {
+    return cameraSlots[slot].version;
 }
 
 // -- 2D --
 
-void SetCameraTransform2D(Camera2D* camera) {
-   Vec2 origin = camera->origin; 
-   Mat4 ortho = Mat4Ortho(origin.x, clientWidth + origin.x, origin.y, clientHeight + origin.y, -1, 1);
-   transform = ortho;
+void SetCameraTransform2D(int slotIndex, Camera2D* camera) {
+    CameraSlot* slot = &cameraSlots[slotIndex];
+    if (slot->kind == CameraKind2D && memcmp(&slot->camera2D, camera, sizeof(Camera2D)) == 0) {
+        return;
+    }
 
-   didSetCamera = true;
+    slot->kind = CameraKind2D;
+    slot->camera2D = *camera;
+    MarkDirty(slot);
 }
 
 // -- 3D --
 
-void SetCameraTransform3D(Camera3D* camera) {
-    Mat4 view = Mat4ViewTransform(camera->target, camera->position, camera->up);
+void SetCameraTransform3D(int slotIndex, Camera3D* camera) {
+    CameraSlot* slot = &cameraSlots[slotIndex];
+    if (slot->kind == CameraKind3D && memcmp(&slot->camera3D, camera, sizeof(Camera3D)) == 0) {
+        return;
+    }
 
-    float aspectRatio = camera->aspectRatio > dummyAspectRatio ? camera->aspectRatio : clientWidth / (float) clientHeight;
-    Mat4 perspective = Mat4Perspective(camera->fieldOfViewY, aspectRatio, camera->nearPlane, camera->farPlane);
+    slot->kind = CameraKind3D;
+    slot->camera3D = *camera;
+    MarkDirty(slot);
+}
 
-    Mat4 cameraTransform = Mat4Multiply(perspective, view);
-    transform = cameraTransform;
+float GetProjectedSize3D(const Camera3D* camera, Vec3 center, float radius) {
+    float distance = Vec3Magnitude(Vec3Sub(center, camera->position));
+    if (distance <= radius) {
+        return FLT_MAX;
+    }
+    // the view height at the distance is 2 * distance * tan(fov / 2)
+    return radius * clientHeight / (distance * tanf(camera->fieldOfViewY / 2));
+}
 
-    didSetCamera = true;
+// the plane through three points, with the normal towards the inside point
+static Vec4 GetPlaneThroughPoints(Vec3 a, Vec3 b, Vec3 c, Vec3 inside) {
+    Vec3 normal = Vec3Normalize(Vec3Cross(Vec3Sub(b, a), Vec3Sub(c, a)));
+    float offset = -Vec3Dot(normal, a);
+    if (Vec3Dot(normal, inside) + offset < 0) {
+        normal = Vec3Scale(normal, -1);
+        offset = -offset;
+    }
+    return (Vec4){ normal.x, normal.y, normal.z, offset };
+}
+
+Frustum GetCameraFrustum(const Camera3D* camera) {
+    float aspectRatio = camera->aspectRatio > dummyAspectRatio ? camera->aspectRatio
+        : (clientHeight > 0 ? clientWidth / (float) clientHeight : 1);
+    Vec3 forward = Vec3Normalize(Vec3Sub(camera->target, camera->position));
+    Vec3 right = Vec3Normalize(Vec3Cross(camera->up, forward));
+    Vec3 up = Vec3Cross(forward, right);
+
+    // near corners, then far corners: bottom left, bottom right, top right, top left
+    Vec3 corners[8];
+    float distances[2] = { camera->nearPlane, camera->farPlane };
+    for (int i = 0; i < 2; i++) {
+        float halfHeight = distances[i] * tanf(camera->fieldOfViewY / 2);
+        float halfWidth = halfHeight * aspectRatio;
+        Vec3 center = Vec3Add(camera->position, Vec3Scale(forward, distances[i]));
+        Vec3 x = Vec3Scale(right, halfWidth);
+        Vec3 y = Vec3Scale(up, halfHeight);
+        corners[i * 4 + 0] = Vec3Sub(Vec3Sub(center, x), y);
+        corners[i * 4 + 1] = Vec3Sub(Vec3Add(center, x), y);
+        corners[i * 4 + 2] = Vec3Add(Vec3Add(center, x), y);
+        corners[i * 4 + 3] = Vec3Add(Vec3Sub(center, x), y);
+    }
+
+    Frustum frustum = {0};
+    Vec3 inside = Vec3Add(camera->position, Vec3Scale(forward, (camera->nearPlane + camera->farPlane) / 2));
+    frustum.planes[0] = GetPlaneThroughPoints(corners[0], corners[1], corners[2], inside);
+    frustum.planes[1] = GetPlaneThroughPoints(corners[4], corners[5], corners[6], inside);
+    // the side planes use far corners, which stay apart with a tiny near plane
+    for (int i = 0; i < 4; i++) {
+        frustum.planes[2 + i] = GetPlaneThroughPoints(corners[i], corners[4 + i], corners[4 + (i + 1) % 4], inside);
+    }
+
+    frustum.bounds.min = corners[0];
+    frustum.bounds.max = corners[0];
+    for (int i = 1; i < 8; i++) {
+        frustum.bounds.min.x = fminf(frustum.bounds.min.x, corners[i].x);
+        frustum.bounds.min.y = fminf(frustum.bounds.min.y, corners[i].y);
+        frustum.bounds.min.z = fminf(frustum.bounds.min.z, corners[i].z);
+        frustum.bounds.max.x = fmaxf(frustum.bounds.max.x, corners[i].x);
+        frustum.bounds.max.y = fmaxf(frustum.bounds.max.y, corners[i].y);
+        frustum.bounds.max.z = fmaxf(frustum.bounds.max.z, corners[i].z);
+    }
+    return frustum;
 }
 
 Camera3D GetDefaultCamera3D() {
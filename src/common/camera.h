@@ -1,14 +1,20 @@
 #ifndef camera_h
 #define camera_h
 
+#include <stdint.h>
 #include "libgame.h"
 
 // call from render backend SetResolution
 void SetCameraClientArea(int clientWidth, int clientHeight);
 
-// call these in the render backend to set/get the camera transform
-void SetCameraTransform2D(Camera2D* camera);
-void SetCameraTransform3D(Camera3D* camera);
-Mat4 GetCameraTransform();
+// call these in the render backend to set/get the camera transform of a camera slot
+void SetCameraTransform2D(int slot, Camera2D* camera);
+void SetCameraTransform3D(int slot, Camera3D* camera);
+Mat4 GetCameraTransform(int slot);
+/*
+ * Incremented whenever the transform of a slot changes. Compare it with
+ * the last uploaded version to skip redundant uploads.
+ */
+uint32_t GetCameraTransformVersion(int slot);
 
 #endif
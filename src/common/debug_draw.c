@@ -0,0 +1,188 @@
+/*
+ * Immediate mode debug drawing.
+ *
+ * Primitives are split into lines when they are added. Each line stores its two vertices,
+ * a batch key (the mode and the camera slot) and the number of frames left.
+ *
+ * At the end of the frame the lines are sorted into batches with a counting sort,
+ * which writes the vertices into one array with a contiguous range per batch.
+ * Lines with frames left are then compacted to the front of the line array.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "debug_draw.h"
+
+#define DEBUG_BATCH_COUNT (2 * LIBGAME_MAX_CAMERAS)
+#define DEBUG_SPHERE_SEGMENTS 24
+#define DEBUG_PI 3.14159265358979f
+
+typedef struct {
+    DebugLineVertex a;
+    DebugLineVertex b;
+    int batchKey;
+    int framesLeft;
+} DebugLine;
+
+static DebugDrawSettings debugDrawSettings = {
+    .maxLines = LIBGAME_DEFAULT_MAX_DEBUG_LINES,
+};
+
+static DebugLine* lines = NULL;
+static int lineCount = 0;
+static int droppedLineCount = 0;
+static DebugLineVertex* lineVertices = NULL;
+static DebugLineBatch lineBatches[DEBUG_BATCH_COUNT];
+
+// unit circle, computed on first use
+static Vec2 circlePoints[DEBUG_SPHERE_SEGMENTS + 1];
+static bool isCircleInitialized = false;
+
+// parenthesized names, since the public header may replace these with macros (see LIBGAME_NO_DEBUG_DRAW)
+
+void (ConfigureDebugDraw)(DebugDrawSettings settings) {
+    Assert(lines == NULL, "Unable to configure debug drawing. "
+            "The line buffer has already been initialized by a debug primitive.");
+    if (settings.maxLines <= 0) {
+        settings.maxLines = LIBGAME_DEFAULT_MAX_DEBUG_LINES;
+    }
+    debugDrawSettings = settings;
+}
+
+static uint32_t PackColor(Color color) {
+    float channels[4] = { color.r, color.g, color.b, color.a };
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; i++) {
+        float c = channels[i] < 0 ? 0 : (channels[i] > 1 ? 1 : channels[i]);
+        packed |= (uint32_t)(c * 255 + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+static int GetBatchKey(DebugDrawMode mode) {
+    return (mode == DEBUG_DRAW_OVERLAY ? LIBGAME_MAX_CAMERAS : 0) + GetCurrentCameraSlot();
+}
+
+static void AddLine(Vec3 a, Vec3 b, uint32_t color, int batchKey, int frames) {
+    if (lines == NULL) {
+        lines = (DebugLine*)malloc(debugDrawSettings.maxLines * sizeof(DebugLine));
+        lineVertices = (DebugLineVertex*)malloc(debugDrawSettings.maxLines * 2 * sizeof(DebugLineVertex));
+        Assert(lines != NULL && lineVertices != NULL, "Failed to allocate debug lines");
+    }
+
+    if (lineCount == debugDrawSettings.maxLines) {
+        droppedLineCount++;
+        return;
+    }
+
+    DebugLine* line = &lines[lineCount++];
+    line->a = (DebugLineVertex){ a.x, a.y, a.z, color };
+    line->b = (DebugLineVertex){ b.x, b.y, b.z, color };
+    line->batchKey = batchKey;
+    line->framesLeft = frames < 1 ? 1 : frames;
+}
+
+void (DebugDrawLine)(Vec3 a, Vec3 b, Color color, DebugDrawMode mode, int frames) {
+    AddLine(a, b, PackColor(color), GetBatchKey(mode), frames);
+}
+
+void (DebugDrawBox)(Vec3 min, Vec3 max, Color color, DebugDrawMode mode, int frames) {
+    uint32_t packed = PackColor(color);
+    int batchKey = GetBatchKey(mode);
+
+    Vec3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        corners[i] = (Vec3){ (i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z };
+    }
+
+    // corners that differ in exactly one axis are connected
+    for (int i = 0; i < 8; i++) {
+        for (int axis = 1; axis < 8; axis <<= 1) {
+            if ((i & axis) == 0) {
+                AddLine(corners[i], corners[i | axis], packed, batchKey, frames);
+            }
+        }
+    }
+}
+
+void (DebugDrawSphere)(Vec3 center, float radius, Color color, DebugDrawMode mode, int frames) {
+    if (!isCircleInitialized) {
+        for (int i = 0; i <= DEBUG_SPHERE_SEGMENTS; i++) {
+            float angle = 2 * DEBUG_PI * i / DEBUG_SPHERE_SEGMENTS;
+            circlePoints[i] = (Vec2){ cosf(angle), sinf(angle) };
+        }
+        isCircleInitialized = true;
+    }
+
+    uint32_t packed = PackColor(color);
+    int batchKey = GetBatchKey(mode);
+
+    // one circle around each axis
+    for (int i = 0; i < DEBUG_SPHERE_SEGMENTS; i++) {
+        Vec2 p = { circlePoints[i].x * radius, circlePoints[i].y * radius };
+        Vec2 q = { circlePoints[i + 1].x * radius, circlePoints[i + 1].y * radius };
+
+        AddLine((Vec3){ center.x + p.x, center.y + p.y, center.z },
+                (Vec3){ center.x + q.x, center.y + q.y, center.z }, packed, batchKey, frames);
+        AddLine((Vec3){ center.x + p.x, center.y, center.z + p.y },
+                (Vec3){ center.x + q.x, center.y, center.z + q.y }, packed, batchKey, frames);
+        AddLine((Vec3){ center.x, center.y + p.x, center.z + p.y },
+                (Vec3){ center.x, center.y + q.x, center.z + q.y }, packed, batchKey, frames);
+    }
+}
+
+int BuildDebugLines(const DebugLineVertex** vertices, int* vertexCount, const DebugLineBatch** batches) {
+    if (droppedLineCount > 0) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Dropped %d debug lines. Max is %d.\n", droppedLineCount, debugDrawSettings.maxLines);
+        droppedLineCount = 0;
+    }
+
+    if (lineCount == 0) {
+        return 0;
+    }
+
+    int counts[DEBUG_BATCH_COUNT] = {0};
+    for (int i = 0; i < lineCount; i++) {
+        counts[lines[i].batchKey]++;
+    }
+
+    // depth tested batches come first, since their keys are lower
+    int starts[DEBUG_BATCH_COUNT];
+    int batchCount = 0;
+    int vertexStart = 0;
+    for (int key = 0; key < DEBUG_BATCH_COUNT; key++) {
+        starts[key] = vertexStart;
+        if (counts[key] == 0) {
+            continue;
+        }
+
+        DebugLineBatch* batch = &lineBatches[batchCount++];
+        batch->isOverlay = key >= LIBGAME_MAX_CAMERAS;
+        batch->cameraSlot = key % LIBGAME_MAX_CAMERAS;
+        batch->vertexStart = vertexStart;
+        batch->vertexCount = counts[key] * 2;
+        vertexStart += batch->vertexCount;
+    }
+
+    int keptCount = 0;
+    for (int i = 0; i < lineCount; i++) {
+        DebugLine line = lines[i];
+        int v = starts[line.batchKey];
+        lineVertices[v] = line.a;
+        lineVertices[v + 1] = line.b;
+        starts[line.batchKey] = v + 2;
+
+        if (line.framesLeft > 1) {
+            line.framesLeft--;
+            lines[keptCount++] = line;
+        }
+    }
+
+    *vertices = lineVertices;
+    *vertexCount = lineCount * 2;
+    *batches = lineBatches;
+    lineCount = keptCount;
+
+    return batchCount;
+}
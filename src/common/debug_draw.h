@@ -0,0 +1,13 @@
+#ifndef debug_draw_h
+#define debug_draw_h
+
+#include "platform_setup.h"
+
+/*
+ * Call at the end of each frame, after the last draw call. Builds the line vertices of the frame
+ * grouped into batches, and removes expired primitives. Returns the number of batches.
+ * The output stays valid until the next call.
+ */
+int BuildDebugLines(const DebugLineVertex** vertices, int* vertexCount, const DebugLineBatch** batches);
+
+#endif
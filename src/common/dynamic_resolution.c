@@ -0,0 +1,122 @@
+/*
+ * Dynamic resolution.
+ *
+ * The internal target is allocated at the max scale of the client area, and the scaled graphics are
+ * drawn into its bottom left region. Changing the scale only changes the region, so there is
+ * no reallocation unless the window is resized or the settings change.
+ *
+ * The GPU time of each frame is read back a few frames later. The scale then moves towards the
+ * scale that would hit the budget, quickly when over the budget and slowly when under it,
+ * so that a single cheap frame does not bring the resolution back up right before an expensive one.
+ * Small differences are ignored to keep the resolution stable.
+ */
+#include <math.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "render.h"
+
+#define SCALE_DEADBAND 0.03f
+#define SCALE_DOWN_RATE 0.5f
+#define SCALE_UP_RATE 0.1f
+
+static DynamicResolutionSettings dynamicResolutionSettings = {
+    .gpuBudgetMs = LIBGAME_DEFAULT_GPU_BUDGET_MS,
+    .minScale = LIBGAME_DEFAULT_MIN_RESOLUTION_SCALE,
+    .maxScale = LIBGAME_DEFAULT_MAX_RESOLUTION_SCALE,
+};
+
+static RenderTarget sceneTarget = {0};
+static bool hasSceneTarget = false;
+static bool isDynamicResolutionActive = false;
+static float resolutionScale = LIBGAME_DEFAULT_MAX_RESOLUTION_SCALE;
+static float lastGpuMs = 0;
+static int regionWidth = 0;
+static int regionHeight = 0;
+
+void ConfigureDynamicResolution(DynamicResolutionSettings settings) {
+    if (settings.gpuBudgetMs <= 0) {
+        settings.gpuBudgetMs = LIBGAME_DEFAULT_GPU_BUDGET_MS;
+    }
+    if (settings.minScale <= 0) {
+        settings.minScale = LIBGAME_DEFAULT_MIN_RESOLUTION_SCALE;
+    }
+    if (settings.maxScale <= 0) {
+        settings.maxScale = LIBGAME_DEFAULT_MAX_RESOLUTION_SCALE;
+    }
+    Assert(settings.minScale <= settings.maxScale, "Min resolution scale %.2f is above the max %.2f",
+            settings.minScale, settings.maxScale);
+
+    dynamicResolutionSettings = settings;
+    resolutionScale = resolutionScale < settings.minScale ? settings.minScale : resolutionScale;
+    resolutionScale = resolutionScale > settings.maxScale ? settings.maxScale : resolutionScale;
+}
+
+static void UpdateResolutionScale() {
+    uint64_t nanoseconds = 0;
+    if (!ReadGpuTimer(&nanoseconds)) {
+        return;
+    }
+    lastGpuMs = nanoseconds / 1e6f;
+
+    // the cost is roughly proportional to the pixel count, which is the square of the scale
+    float gpuMs = lastGpuMs > 0.01f ? lastGpuMs : 0.01f;
+    float targetScale = resolutionScale * sqrtf(dynamicResolutionSettings.gpuBudgetMs / gpuMs);
+    if (fabsf(targetScale - resolutionScale) < SCALE_DEADBAND) {
+        return;
+    }
+
+    float rate = targetScale < resolutionScale ? SCALE_DOWN_RATE : SCALE_UP_RATE;
+    float scale = resolutionScale + (targetScale - resolutionScale) * rate;
+    scale = scale < dynamicResolutionSettings.minScale ? dynamicResolutionSettings.minScale : scale;
+    resolutionScale = scale > dynamicResolutionSettings.maxScale ? dynamicResolutionSettings.maxScale : scale;
+}
+
+static int ScaleSize(int size, float scale) {
+    int scaled = (int)ceilf(size * scale);
+    return scaled < 1 ? 1 : scaled;
+}
+
+void BeginDynamicResolution() {
+    Assert(!isDynamicResolutionActive, "Dynamic resolution has already begun");
+    isDynamicResolutionActive = true;
+
+    int clientWidth = GetClientWidth();
+    int clientHeight = GetClientHeight();
+    int targetWidth = ScaleSize(clientWidth, dynamicResolutionSettings.maxScale);
+    int targetHeight = ScaleSize(clientHeight, dynamicResolutionSettings.maxScale);
+    if (!hasSceneTarget) {
+        sceneTarget = CreateRenderTarget(targetWidth, targetHeight);
+        hasSceneTarget = true;
+    } else if (sceneTarget.texture.width != targetWidth || sceneTarget.texture.height != targetHeight) {
+        ResizeRenderTarget(&sceneTarget, targetWidth, targetHeight);
+    }
+
+    UpdateResolutionScale();
+    regionWidth = ScaleSize(clientWidth, resolutionScale);
+    regionHeight = ScaleSize(clientHeight, resolutionScale);
+    regionWidth = regionWidth > targetWidth ? targetWidth : regionWidth;
+    regionHeight = regionHeight > targetHeight ? targetHeight : regionHeight;
+
+    UseRenderTargetRegion(sceneTarget, regionWidth, regionHeight);
+    BeginGpuTimer();
+}
+
+void EndDynamicResolution() {
+    Assert(isDynamicResolutionActive, "Dynamic resolution has not begun");
+    isDynamicResolutionActive = false;
+
+    // the pending graphics are part of the measured time
+    MakeDrawCall();
+    EndGpuTimer();
+
+    UseWindowRenderTarget();
+    BlitRenderTarget(sceneTarget, regionWidth, regionHeight);
+}
+
+float GetResolutionScale() {
+    return resolutionScale;
+}
+
+float GetDynamicResolutionGpuMs() {
+    return lastGpuMs;
+}
@@ -0,0 +1,648 @@
+/*
+ * Signed distance field fonts.
+ *
+ * DISTANCE FIELDS
+ *
+ * Glyphs are rasterized by the platform into coverage bitmaps. Each bitmap is padded
+ * by the spread and turned into a signed distance field with an exact Euclidean distance
+ * transform (Felzenszwalb and Huttenlocher), once for the distance to the nearest inside pixel
+ * and once for the distance to the nearest outside pixel. Partially covered edge pixels use
+ * their coverage as a subpixel estimate of the distance to the edge.
+ *
+ * The distance is mapped to 0-255, with the edge at 128, and stored in the alpha channel
+ * of a texture atlas. The font shader finds the edge with a smoothstep over the screen space
+ * derivative of the distance, so the edges stay sharp at any scale.
+ *
+ * CACHE
+ *
+ * The glyph metrics, kerning pairs and distance fields are written to a cache file,
+ * keyed by the font settings. Loading a cached font skips the rasterization and the
+ * distance transforms, and only packs the atlas.
+ *
+ * LAYOUT
+ *
+ * Text is laid out with the glyph advances and the kerning pairs of the font, and each glyph
+ * is drawn as a textured quad. The quads go into the regular vertex buffer with the font material,
+ * so all text that fits in one atlas page is drawn in one draw call.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "platform_setup.h"
+#include "asserts.h"
+
+#define FONT_CACHE_MAGIC 0x46445346 // "FSDF"
+#define FONT_CACHE_VERSION 1
+#define FONT_ATLAS_PAGE_SIZE 1024
+#define FONT_MAX_KERNING_PAIRS 16384
+#define SDF_INF 1e20f
+
+PlatformFonts platformFonts = {};
+
+void InitPlatformFonts(PlatformFonts pf) {
+    platformFonts = pf;
+}
+
+// -- Cache format --
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t glyphCount;
+    int32_t kerningCount;
+    int32_t ascent;
+    int32_t descent;
+    int32_t lineGap;
+    int32_t fieldSize; // total size of the distance fields in bytes
+} FontCacheHeader;
+
+// describes the distance field of a glyph, which includes the padding
+typedef struct {
+    int32_t codepoint;
+    int32_t width;
+    int32_t height;
+    int32_t xOffset;
+    int32_t yOffset;
+    int32_t advance;
+} FontCacheGlyph;
+
+typedef struct {
+    FontCacheHeader header;
+    FontCacheGlyph* glyphs;
+    KerningPair* kerning;
+    uint8_t* fields;
+} FontData;
+
+// -- Font --
+
+typedef struct {
+    bool isLoaded;
+    Sprite sprite;
+    // offset from the pen position to the top left of the distance field, y up
+    float left;
+    float top;
+    int width;
+    int height;
+    float advance;
+} Glyph;
+
+struct Font {
+    int rasterSize;
+    float lineHeight;
+    int firstCodepoint;
+    int lastCodepoint;
+    Glyph* glyphs;
+    KerningPair* kerning; // sorted by first and second
+    int kerningCount;
+    TextureAtlas* atlas;
+};
+
+static Material fontMaterial = {0};
+
+static const char* fontVertexSrc =
+    "out vec4 fragColor;\n"
+    "out vec2 fragTexCoord;\n"
+    "void main() {\n"
+    "    gl_Position = TransformPosition(position);\n"
+    "    fragColor = color;\n"
+    "    fragTexCoord = texCoord;\n"
+    "}";
+
+static const char* fontFragmentSrc =
+    "in vec4 fragColor;\n"
+    "in vec2 fragTexCoord;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    float distance = texture(textureSampler, fragTexCoord).a;\n"
+    "    float width = fwidth(distance);\n"
+    "    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);\n"
+    "    if (alpha <= 0.0) {\n"
+    "        discard;\n"
+    "    }\n"
+    "    FragColor = vec4(fragColor.rgb, fragColor.a * alpha);\n"
+    "}";
+
+// -- Distance fields --
+
+// squared distance transform of a sampled function, in place along a row or column
+static void DistanceTransform1D(float* f, int n, int stride, float* d, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -SDF_INF;
+    z[1] = SDF_INF;
+
+    // lower envelope of the parabolas rooted at each sample. The samples are at most SDF_INF,
+    // so an intersection never goes below z[0] and k stays non-negative.
+    for (int q = 1; q < n; q++) {
+        float s = 0;
+        for (;;) {
+            int p = v[k];
+            s = ((f[q * stride] + q * q) - (f[p * stride] + p * p)) / (2 * q - 2 * p);
+            if (s > z[k]) {
+                break;
+            }
+            k--;
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = SDF_INF;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+            k++;
+        }
+        int p = v[k];
+        d[q] = (q - p) * (q - p) + f[p * stride];
+    }
+    for (int q = 0; q < n; q++) {
+        f[q * stride] = d[q];
+    }
+}
+
+static void DistanceTransform2D(float* grid, int width, int height, float* d, int* v, float* z) {
+    for (int x = 0; x < width; x++) {
+        DistanceTransform1D(&grid[x], height, width, d, v, z);
+    }
+    for (int y = 0; y < height; y++) {
+        DistanceTransform1D(&grid[y * width], width, 1, d, v, z);
+    }
+}
+
+// the field is the bitmap padded by the spread on each side
+static void GenerateDistanceField(const GlyphBitmap* glyph, int spread, uint8_t* field) {
+    int width = glyph->width + 2 * spread;
+    int height = glyph->height + 2 * spread;
+    int maxSide = width > height ? width : height;
+
+    ScratchArena scratch = BeginScratch();
+    float* outside = (float*)ArenaAlloc(scratch.arena, width * height * sizeof(float));
+    float* inside = (float*)ArenaAlloc(scratch.arena, width * height * sizeof(float));
+    float* d = (float*)ArenaAlloc(scratch.arena, maxSide * sizeof(float));
+    float* z = (float*)ArenaAlloc(scratch.arena, (maxSide + 1) * sizeof(float));
+    int* v = (int*)ArenaAlloc(scratch.arena, maxSide * sizeof(int));
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int glyphX = x - spread;
+            int glyphY = y - spread;
+            bool isInBitmap = glyphX >= 0 && glyphX < glyph->width && glyphY >= 0 && glyphY < glyph->height;
+            int coverage = isInBitmap ? glyph->coverage[glyphY * glyph->width + glyphX] : 0;
+            bool isInside = coverage >= 128;
+            outside[y * width + x] = isInside ? 0 : SDF_INF;
+            inside[y * width + x] = isInside ? SDF_INF : 0;
+        }
+    }
+
+    DistanceTransform2D(outside, width, height, d, v, z);
+    DistanceTransform2D(inside, width, height, d, v, z);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int i = y * width + x;
+            // positive outside the glyph
+            float distance = sqrtf(outside[i]) - sqrtf(inside[i]);
+
+            int glyphX = x - spread;
+            int glyphY = y - spread;
+            bool isInBitmap = glyphX >= 0 && glyphX < glyph->width && glyphY >= 0 && glyphY < glyph->height;
+            int coverage = isInBitmap ? glyph->coverage[glyphY * glyph->width + glyphX] : 0;
+            if (coverage > 0 && coverage < 255) {
+                distance = 0.5f - coverage / 255.0f;
+            }
+
+            float value = 0.5f - distance / (2 * spread);
+            value = value < 0 ? 0 : (value > 1 ? 1 : value);
+            field[i] = (uint8_t)(value * 255 + 0.5f);
+        }
+    }
+
+    EndScratch(scratch);
+}
+
+// -- Generating and caching --
+
+static uint64_t HashFontSettings(FontSettings settings) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char* s = settings.faceName; *s != '\0'; s++) {
+        hash ^= (uint8_t)*s;
+        hash *= 0x100000001b3ULL;
+    }
+    int values[] = { settings.rasterSize, settings.firstCodepoint, settings.lastCodepoint, FONT_CACHE_VERSION };
+    for (int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+        hash ^= (uint32_t)values[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void GetFontCachePath(const char* directory, uint64_t key, char* path, int pathSize) {
+    snprintf(path, pathSize, "%s/font_%016llx.bin", directory, (unsigned long long)key);
+}
+
+static void FreeFontData(FontData* data) {
+    free(data->glyphs);
+    free(data->kerning);
+    free(data->fields);
+}
+
+static int CompareKerningPairs(const void* a, const void* b) {
+    const KerningPair* pairA = (const KerningPair*)a;
+    const KerningPair* pairB = (const KerningPair*)b;
+    if (pairA->first != pairB->first) {
+        return pairA->first < pairB->first ? -1 : 1;
+    }
+    return pairA->second < pairB->second ? -1 : (pairA->second > pairB->second ? 1 : 0);
+}
+
+static bool GenerateFontData(FontSettings settings, FontData* data) {
+    void* platformFont = platformFonts.LoadFont(settings.faceName, settings.rasterSize);
+    if (platformFont == NULL) {
+        return false;
+    }
+
+    int spread = settings.rasterSize / 8;
+    spread = spread < 2 ? 2 : spread;
+
+    int maxGlyphs = settings.lastCodepoint - settings.firstCodepoint + 1;
+    data->glyphs = (FontCacheGlyph*)malloc(maxGlyphs * sizeof(FontCacheGlyph));
+    Assert(data->glyphs != NULL, "Failed to allocate font glyphs");
+    int fieldCapacity = 0;
+
+    int ascent = 0;
+    int descent = 0;
+    int lineGap = 0;
+    platformFonts.GetFontMetrics(platformFont, &ascent, &descent, &lineGap);
+    data->header.ascent = ascent;
+    data->header.descent = descent;
+    data->header.lineGap = lineGap;
+
+    for (int codepoint = settings.firstCodepoint; codepoint <= settings.lastCodepoint; codepoint++) {
+        GlyphBitmap bitmap = {0};
+        if (!platformFonts.RasterizeGlyph(platformFont, codepoint, &bitmap)) {
+            continue;
+        }
+
+        FontCacheGlyph* glyph = &data->glyphs[data->header.glyphCount++];
+        glyph->codepoint = codepoint;
+        glyph->advance = bitmap.advance;
+        glyph->width = 0;
+        glyph->height = 0;
+        glyph->xOffset = 0;
+        glyph->yOffset = 0;
+
+        if (bitmap.width > 0 && bitmap.height > 0) {
+            glyph->width = bitmap.width + 2 * spread;
+            glyph->height = bitmap.height + 2 * spread;
+            glyph->xOffset = bitmap.xOffset - spread;
+            glyph->yOffset = bitmap.yOffset + spread;
+
+            int fieldSize = glyph->width * glyph->height;
+            if (data->header.fieldSize + fieldSize > fieldCapacity) {
+                fieldCapacity = (fieldCapacity + fieldSize) * 2;
+                data->fields = (uint8_t*)realloc(data->fields, fieldCapacity);
+                Assert(data->fields != NULL, "Failed to allocate distance fields");
+            }
+            GenerateDistanceField(&bitmap, spread, &data->fields[data->header.fieldSize]);
+            data->header.fieldSize += fieldSize;
+        }
+
+        free(bitmap.coverage);
+    }
+
+    int kerningCount = platformFonts.GetKerningPairs(platformFont, NULL, 0);
+    kerningCount = kerningCount < FONT_MAX_KERNING_PAIRS ? kerningCount : FONT_MAX_KERNING_PAIRS;
+    if (kerningCount > 0) {
+        data->kerning = (KerningPair*)malloc(kerningCount * sizeof(KerningPair));
+        Assert(data->kerning != NULL, "Failed to allocate kerning pairs");
+        kerningCount = platformFonts.GetKerningPairs(platformFont, data->kerning, kerningCount);
+        qsort(data->kerning, kerningCount, sizeof(KerningPair), CompareKerningPairs);
+    }
+    data->header.kerningCount = kerningCount;
+
+    platformFonts.FreeFont(platformFont);
+    return true;
+}
+
+// the glyph sizes must add up to the stored distance fields, or building the font reads past them
+static bool HasConsistentGlyphSizes(const FontData* data) {
+    int64_t totalArea = 0;
+    for (int i = 0; i < data->header.glyphCount; i++) {
+        const FontCacheGlyph* glyph = &data->glyphs[i];
+        if (glyph->width < 0 || glyph->height < 0) {
+            return false;
+        }
+        totalArea += (int64_t)glyph->width * glyph->height;
+        if (totalArea > data->header.fieldSize) {
+            return false;
+        }
+    }
+    return totalArea == data->header.fieldSize;
+}
+
+static bool LoadCachedFontData(const char* path, uint64_t key, FontData* data) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    FontCacheHeader header = {0};
+    bool isValid = fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == FONT_CACHE_MAGIC
+        && header.version == FONT_CACHE_VERSION
+        && header.key == key
+        && header.glyphCount >= 0
+        && header.kerningCount >= 0
+        && header.fieldSize >= 0;
+
+    if (isValid) {
+        data->header = header;
+        data->glyphs = (FontCacheGlyph*)malloc(header.glyphCount * sizeof(FontCacheGlyph) + 1);
+        data->kerning = (KerningPair*)malloc(header.kerningCount * sizeof(KerningPair) + 1);
+        data->fields = (uint8_t*)malloc(header.fieldSize + 1);
+        Assert(data->glyphs != NULL && data->kerning != NULL && data->fields != NULL, "Failed to allocate font %s", path);
+
+        isValid = fread(data->glyphs, sizeof(FontCacheGlyph), header.glyphCount, file) == (size_t)header.glyphCount
+            && fread(data->kerning, sizeof(KerningPair), header.kerningCount, file) == (size_t)header.kerningCount
+            && fread(data->fields, 1, header.fieldSize, file) == (size_t)header.fieldSize;
+        if (isValid && !HasConsistentGlyphSizes(data)) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Font cache file %s has inconsistent glyph sizes\n", path);
+            isValid = false;
+        }
+        if (!isValid) {
+            FreeFontData(data);
+            memset(data, 0, sizeof(FontData));
+        }
+    }
+
+    fclose(file);
+    return isValid;
+}
+
+static void StoreCachedFontData(const char* path, FontData* data) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        LogWarningIn(LOG_CATEGORY_LOADER, "Unable to write font cache file %s\n", path);
+        return;
+    }
+
+    fwrite(&data->header, sizeof(FontCacheHeader), 1, file);
+    fwrite(data->glyphs, sizeof(FontCacheGlyph), data->header.glyphCount, file);
+    fwrite(data->kerning, sizeof(KerningPair), data->header.kerningCount, file);
+    fwrite(data->fields, 1, data->header.fieldSize, file);
+    fclose(file);
+}
+
+// -- Loading --
+
+static void InitFontMaterial() {
+    if (fontMaterial.id != 0) {
+        return;
+    }
+    Shader shader = CreateShader(fontVertexSrc, fontFragmentSrc);
+    fontMaterial = CreateMaterial(shader);
+}
+
+static void BuildFont(Font* font, FontData* data) {
+    ScratchArena scratch = BeginScratch();
+    int maxArea = 0;
+    for (int i = 0; i < data->header.glyphCount; i++) {
+        int area = data->glyphs[i].width * data->glyphs[i].height;
+        maxArea = area > maxArea ? area : maxArea;
+    }
+    uint8_t* pixels = (uint8_t*)ArenaAlloc(scratch.arena, maxArea * 4 + 1);
+
+    const uint8_t* field = data->fields;
+    for (int i = 0; i < data->header.glyphCount; i++) {
+        FontCacheGlyph* cached = &data->glyphs[i];
+        int area = cached->width * cached->height;
+        if (cached->codepoint < font->firstCodepoint || cached->codepoint > font->lastCodepoint) {
+            field += area;
+            continue;
+        }
+
+        Glyph* glyph = &font->glyphs[cached->codepoint - font->firstCodepoint];
+        glyph->isLoaded = true;
+        glyph->left = cached->xOffset;
+        glyph->top = cached->yOffset;
+        glyph->width = cached->width;
+        glyph->height = cached->height;
+        glyph->advance = cached->advance;
+
+        if (area == 0) {
+            continue;
+        }
+
+        // white with the distance in alpha, so that the default shader shows the glyph shapes
+        for (int j = 0; j < area; j++) {
+            pixels[j * 4 + 0] = 255;
+            pixels[j * 4 + 1] = 255;
+            pixels[j * 4 + 2] = 255;
+            pixels[j * 4 + 3] = field[j];
+        }
+        field += area;
+
+        bool isAdded = AddAtlasImage(font->atlas, pixels, cached->width, cached->height, &glyph->sprite);
+        Assert(isAdded, "Font glyph %d does not fit in the atlas", cached->codepoint);
+    }
+
+    EndScratch(scratch);
+
+    font->lineHeight = data->header.ascent + data->header.descent + data->header.lineGap;
+    font->kerningCount = data->header.kerningCount;
+    if (font->kerningCount > 0) {
+        font->kerning = (KerningPair*)malloc(font->kerningCount * sizeof(KerningPair));
+        Assert(font->kerning != NULL, "Failed to allocate kerning pairs");
+        memcpy(font->kerning, data->kerning, font->kerningCount * sizeof(KerningPair));
+    }
+}
+
+Font* LoadFont(FontSettings settings) {
+    Assert(settings.faceName != NULL, "Missing font face name");
+    if (settings.rasterSize <= 0) {
+        settings.rasterSize = LIBGAME_DEFAULT_FONT_RASTER_SIZE;
+    }
+    if (settings.firstCodepoint == 0 && settings.lastCodepoint == 0) {
+        settings.firstCodepoint = 32;
+        settings.lastCodepoint = 255;
+    }
+    Assert(settings.firstCodepoint >= 0 && settings.firstCodepoint <= settings.lastCodepoint,
+            "Invalid font codepoint range %d to %d", settings.firstCodepoint, settings.lastCodepoint);
+
+    uint64_t ticksStart = GetTicks();
+    uint64_t key = HashFontSettings(settings);
+    char path[512];
+    bool isCacheEnabled = settings.cacheDirectory != NULL;
+    if (isCacheEnabled) {
+        GetFontCachePath(settings.cacheDirectory, key, path, sizeof(path));
+    }
+
+    FontData data = {0};
+    bool isCached = isCacheEnabled && LoadCachedFontData(path, key, &data);
+    if (!isCached) {
+        if (!GenerateFontData(settings, &data)) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Font %s was not found\n", settings.faceName);
+            return NULL;
+        }
+        data.header.magic = FONT_CACHE_MAGIC;
+        data.header.version = FONT_CACHE_VERSION;
+        data.header.key = key;
+        if (isCacheEnabled) {
+            StoreCachedFontData(path, &data);
+        }
+    }
+
+    InitFontMaterial();
+
+    Font* font = (Font*)calloc(1, sizeof(Font));
+    Assert(font != NULL, "Failed to allocate font");
+    font->rasterSize = settings.rasterSize;
+    font->firstCodepoint = settings.firstCodepoint;
+    font->lastCodepoint = settings.lastCodepoint;
+    font->glyphs = (Glyph*)calloc(settings.lastCodepoint - settings.firstCodepoint + 1, sizeof(Glyph));
+    Assert(font->glyphs != NULL, "Failed to allocate font glyphs");
+    font->atlas = CreateTextureAtlas(FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE);
+
+    BuildFont(font, &data);
+    FreeFontData(&data);
+
+    LogDebugIn(LOG_CATEGORY_LOADER, "Loaded font %s (%d px) %s in %.2f ms, %d atlas page(s)\n",
+            settings.faceName, settings.rasterSize, isCached ? "from cache" : "", (GetTicks() - ticksStart) / 1000.0,
+            GetAtlasPageCount(font->atlas));
+
+    return font;
+}
+
+void FreeFont(Font* font) {
+    DestroyTextureAtlas(font->atlas);
+    free(font->glyphs);
+    free(font->kerning);
+    free(font);
+}
+
+// -- Layout --
+
+// returns false at the end of the string. Invalid bytes decode to U+FFFD.
+static bool DecodeUtf8(const char** text, int* codepoint) {
+    const uint8_t* s = (const uint8_t*)*text;
+    if (s[0] == 0) {
+        return false;
+    }
+
+    int length = 1;
+    int value = 0xfffd;
+    if (s[0] < 0x80) {
+        value = s[0];
+    } else if ((s[0] & 0xe0) == 0xc0 && (s[1] & 0xc0) == 0x80) {
+        value = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+        length = 2;
+    } else if ((s[0] & 0xf0) == 0xe0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80) {
+        value = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+        length = 3;
+    } else if ((s[0] & 0xf8) == 0xf0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80) {
+        value = ((s[0] & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+        length = 4;
+    }
+
+    *codepoint = value;
+    *text += length;
+    return true;
+}
+
+static Glyph* GetGlyph(Font* font, int codepoint) {
+    if (codepoint < font->firstCodepoint || codepoint > font->lastCodepoint) {
+        return NULL;
+    }
+    Glyph* glyph = &font->glyphs[codepoint - font->firstCodepoint];
+    return glyph->isLoaded ? glyph : NULL;
+}
+
+static int GetKerning(Font* font, int first, int second) {
+    int low = 0;
+    int high = font->kerningCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        KerningPair pair = font->kerning[mid];
+        if (pair.first == first && pair.second == second) {
+            return pair.amount;
+        }
+        if (pair.first < first || (pair.first == first && pair.second < second)) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return 0;
+}
+
+// returns the size of the text, and draws it if shouldDraw is set
+static Vec2 LayoutText(Font* font, const char* text, Vec2 position, float size, Color color, bool shouldDraw) {
+    float scale = size / font->rasterSize;
+    float lineHeight = font->lineHeight * scale;
+    float penX = position.x;
+    float penY = position.y;
+    float maxWidth = 0;
+    int lineCount = 1;
+    int previous = 0;
+
+    int codepoint = 0;
+    while (DecodeUtf8(&text, &codepoint)) {
+        if (codepoint == '\n') {
+            maxWidth = penX - position.x > maxWidth ? penX - position.x : maxWidth;
+            penX = position.x;
+            penY -= lineHeight;
+            lineCount++;
+            previous = 0;
+            continue;
+        }
+
+        Glyph* glyph = GetGlyph(font, codepoint);
+        if (glyph == NULL) {
+            glyph = GetGlyph(font, '?');
+            codepoint = '?';
+        }
+        if (glyph == NULL) {
+            previous = 0;
+            continue;
+        }
+
+        if (previous != 0 && font->kerningCount > 0) {
+            penX += GetKerning(font, previous, codepoint) * scale;
+        }
+
+        if (shouldDraw && glyph->width > 0) {
+            float left = penX + glyph->left * scale;
+            float top = penY + glyph->top * scale;
+            float right = left + glyph->width * scale;
+            float bottom = top - glyph->height * scale;
+            Vec3 topLeft = { left, top, 0 };
+            Vec3 topRight = { right, top, 0 };
+            Vec3 bottomLeft = { left, bottom, 0 };
+            Vec3 bottomRight = { right, bottom, 0 };
+            DrawSprite3D(glyph->sprite, topLeft, topRight, bottomLeft, bottomRight, color);
+        }
+
+        penX += glyph->advance * scale;
+        previous = codepoint;
+    }
+
+    maxWidth = penX - position.x > maxWidth ? penX - position.x : maxWidth;
+    return (Vec2){ maxWidth, lineCount * lineHeight };
+}
+
+void DrawText2D(Font* font, const char* text, Vec2 position, float size, Color color) {
+    Material previousMaterial = GetCurrentMaterial();
+    UseMaterial(fontMaterial);
+    LayoutText(font, text, position, size, color, true);
+    UseMaterial(previousMaterial);
+}
+
+Vec2 MeasureText(Font* font, const char* text, float size) {
+    return LayoutText(font, text, (Vec2){0}, size, (Color){0}, false);
+}
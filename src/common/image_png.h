@@ -0,0 +1,159 @@
+#ifndef image_png_h
+#define image_png_h
+
+/*
+ * PNG image encoding, for screenshots.
+ *
+ * The input is RGBA with the top row first. The image data is stored without compression (deflate stored blocks),
+ * which is larger than a compressed PNG but fast and simple, and any PNG reader opens it.
+ *
+ * Layout: signature, IHDR, one IDAT with a zlib stream, IEND. Every chunk is
+ * u32 length, 4 byte type, data, u32 CRC of the type and data, big-endian.
+ * Each row starts with a filter byte (0, none).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PNG_MAX_STORED_BLOCK 65535
+
+static inline uint32_t UpdatePngCrc(uint32_t crc, const uint8_t* data, uint64_t size) {
+    static uint32_t table[256];
+    static bool isTableReady = false;
+    if (!isTableReady) {
+        // the result is the same in every thread, so racing writes are harmless
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        isTableReady = true;
+    }
+
+    crc = ~crc;
+    for (uint64_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static inline uint8_t* WritePngU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+    return out + 4;
+}
+
+// the chunk data must already be written after the 8 bytes of length and type
+static inline uint8_t* FinishPngChunk(uint8_t* chunk, const char* type, uint32_t dataSize) {
+    WritePngU32(chunk, dataSize);
+    memcpy(chunk + 4, type, 4);
+    uint32_t crc = UpdatePngCrc(0, chunk + 4, 4 + (uint64_t)dataSize);
+    return WritePngU32(chunk + 8 + dataSize, crc);
+}
+
+static inline uint64_t GetPngImageDataSize(int width, int height) {
+    return (uint64_t)height * (1 + (uint64_t)width * 4);
+}
+
+static inline uint64_t GetPngEncodedSize(int width, int height) {
+    uint64_t dataSize = GetPngImageDataSize(width, height);
+    uint64_t blockCount = (dataSize + PNG_MAX_STORED_BLOCK - 1) / PNG_MAX_STORED_BLOCK;
+    uint64_t zlibSize = 2 + dataSize + blockCount * 5 + 4;
+    return 8 + (12 + 13) + (12 + zlibSize) + 12;
+}
+
+typedef struct {
+    uint8_t* out;
+    uint64_t remaining; // bytes of image data not written yet
+    uint64_t blockRemaining;
+    uint32_t adlerA;
+    uint32_t adlerB;
+} PngStoredWriter;
+
+// appends image data, split into stored blocks with a 5 byte header each
+static inline void WritePngStored(PngStoredWriter* writer, const uint8_t* data, uint64_t size) {
+    while (size > 0) {
+        if (writer->blockRemaining == 0) {
+            uint64_t block = writer->remaining < PNG_MAX_STORED_BLOCK ? writer->remaining : PNG_MAX_STORED_BLOCK;
+            uint8_t* header = writer->out;
+            header[0] = block == writer->remaining ? 1 : 0; // final block flag
+            header[1] = (uint8_t)block;
+            header[2] = (uint8_t)(block >> 8);
+            header[3] = (uint8_t)~block;
+            header[4] = (uint8_t)(~block >> 8);
+            writer->out += 5;
+            writer->blockRemaining = block;
+        }
+
+        uint64_t count = size < writer->blockRemaining ? size : writer->blockRemaining;
+        memcpy(writer->out, data, count);
+
+        // adler32, with the modulo deferred as long as the sums can't overflow
+        uint32_t a = writer->adlerA;
+        uint32_t b = writer->adlerB;
+        for (uint64_t i = 0; i < count; ) {
+            uint64_t end = i + 5552 < count ? i + 5552 : count;
+            for (; i < end; i++) {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        writer->adlerA = a;
+        writer->adlerB = b;
+
+        writer->out += count;
+        writer->remaining -= count;
+        writer->blockRemaining -= count;
+        data += count;
+        size -= count;
+    }
+}
+
+// out must have room for GetPngEncodedSize bytes, returns the encoded size
+static inline uint64_t EncodePng(const uint8_t* pixels, int width, int height, uint8_t* out) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint8_t* p = out;
+    memcpy(p, signature, sizeof(signature));
+    p += sizeof(signature);
+
+    uint8_t* chunk = p;
+    p = WritePngU32(chunk + 8, (uint32_t)width);
+    p = WritePngU32(p, (uint32_t)height);
+    p[0] = 8; // bits per channel
+    p[1] = 6; // RGBA
+    p[2] = 0; // deflate
+    p[3] = 0; // adaptive filters
+    p[4] = 0; // not interlaced
+    p = FinishPngChunk(chunk, "IHDR", 13);
+
+    chunk = p;
+    p = chunk + 8;
+    *p++ = 0x78; // deflate with a 32K window
+    *p++ = 0x01; // no preset dictionary, fastest level, checksum of the two bytes
+
+    PngStoredWriter writer = { p, GetPngImageDataSize(width, height), 0, 1, 0 };
+    static const uint8_t filter = 0;
+    uint64_t rowSize = (uint64_t)width * 4;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + (uint64_t)y * rowSize;
+        WritePngStored(&writer, &filter, 1);
+        WritePngStored(&writer, row, rowSize);
+    }
+    p = WritePngU32(writer.out, (writer.adlerB << 16) | writer.adlerA);
+
+    uint32_t zlibSize = (uint32_t)(p - (chunk + 8));
+    p = FinishPngChunk(chunk, "IDAT", zlibSize);
+
+    chunk = p;
+    p = FinishPngChunk(chunk, "IEND", 0);
+    return (uint64_t)(p - out);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef image_tga_h
+#define image_tga_h
+
+/*
+ * TGA image decoding. Shared by the asset loader and the packer tool.
+ *
+ * Supports uncompressed (type 2) and run-length encoded (type 10) true color
+ * images with 24 or 32 bits per pixel. The output is RGBA with the top row first.
+ *
+ * Header (18 bytes, little-endian):
+ *   u8 idLength, u8 colorMapType, u8 imageType, u8 colorMapSpec[5],
+ *   u16 xOrigin, u16 yOrigin, u16 width, u16 height, u8 bitsPerPixel, u8 descriptor
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TGA_HEADER_SIZE 18
+// the smallest GL_MAX_TEXTURE_SIZE that OpenGL 4 guarantees, which also bounds the decoded size to 1 GB
+#define TGA_MAX_DIMENSION 16384
+
+static inline bool ParseTgaHeader(const uint8_t* data, uint64_t size, int* width, int* height) {
+    if (size < TGA_HEADER_SIZE) {
+        return false;
+    }
+
+    int colorMapType = data[1];
+    int imageType = data[2];
+    int bytesPerPixel = data[16] / 8;
+    *width = data[12] | (data[13] << 8);
+    *height = data[14] | (data[15] << 8);
+
+    return colorMapType == 0 && (imageType == 2 || imageType == 10)
+        && (bytesPerPixel == 3 || bytesPerPixel == 4) && *width > 0 && *height > 0
+        && *width <= TGA_MAX_DIMENSION && *height <= TGA_MAX_DIMENSION;
+}
+
+static inline uint64_t GetTgaPixelsSize(int width, int height) {
+    return (uint64_t)width * (uint64_t)height * 4;
+}
+
+// pixels must have room for GetTgaPixelsSize(width, height) bytes
+static inline bool DecodeTgaPixels(const uint8_t* data, uint64_t size, uint8_t* pixels) {
+    int width;
+    int height;
+    if (!ParseTgaHeader(data, size, &width, &height)) {
+        return false;
+    }
+
+    int idLength = data[0];
+    int bytesPerPixel = data[16] / 8;
+    bool isTopDown = (data[17] & 0x20) != 0;
+    bool isRunLength = data[2] == 10;
+
+    const uint8_t* src = data + TGA_HEADER_SIZE + idLength;
+    const uint8_t* end = data + size;
+    uint64_t pixelCount = (uint64_t)width * (uint64_t)height;
+    uint64_t i = 0;
+    while (i < pixelCount) {
+        // a run-length packet repeats one pixel, a raw packet has count pixels
+        int count = 1;
+        bool isRepeat = false;
+        if (isRunLength) {
+            if (src >= end) {
+                return false;
+            }
+            count = (*src & 0x7f) + 1;
+            isRepeat = (*src & 0x80) != 0;
+            src++;
+        }
+
+        for (int j = 0; j < count && i < pixelCount; j++, i++) {
+            const uint8_t* pixel = isRepeat ? src : src + j * bytesPerPixel;
+            if (pixel + bytesPerPixel > end) {
+                return false;
+            }
+
+            // flip bottom-up images, so that the top row is first
+            uint64_t x = i % width;
+            uint64_t y = isTopDown ? i / width : height - 1 - i / width;
+            uint8_t* target = &pixels[(y * width + x) * 4];
+            target[0] = pixel[2];
+            target[1] = pixel[1];
+            target[2] = pixel[0];
+            target[3] = bytesPerPixel == 4 ? pixel[3] : 255;
+        }
+        src += isRepeat ? bytesPerPixel : count * bytesPerPixel;
+    }
+
+    return true;
+}
+
+#endif
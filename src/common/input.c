@@ -23,6 +23,9 @@ typedef struct {
 } InputState;
 InputState inputState = {};
 
+// when the input of the current frame was received, for measuring latency
+static uint64_t inputTicks = 0;
+
 void InitPlatformInput(PlatformInput plin) {
     platformInput = plin;
 }
@@ -114,6 +117,11 @@ void SetMouseEnteredWindow() {
 
 void ProcessInput() {
     platformInput.ProcessInput();
+    inputTicks = GetTicks();
+}
+
+uint64_t GetInputTicks() {
+    return inputTicks;
 }
 
 void WarpMousePosition(int x, int y) {
@@ -13,5 +13,7 @@ void SetMouseDown(InputMouseButton btn);
 void SetMouseUp(InputMouseButton btn);
 // call after mouse enters the window and the position has been set
 void SetMouseEnteredWindow();
+// ticks at the end of the last ProcessInput, 0 before the first one
+uint64_t GetInputTicks();
 
 #endif
@@ -0,0 +1,75 @@
+/*
+ * Level of detail selection.
+ *
+ * The bounding sphere of an object is its group's sphere moved by the transform, with the radius
+ * scaled by the largest axis scale of the transform. Its projected height decides the level.
+ *
+ * HYSTERESIS
+ *
+ * Starting from the level of the previous frame, the object moves to a coarser level while it is
+ * smaller than that level's threshold by more than the hysteresis fraction, and to a finer level
+ * while it is larger than the finer level's threshold by more than the fraction. Between the two,
+ * it keeps its level. Culling is the level after the last one, with the cull height as its threshold.
+ * The first selection of an object has no previous level, so it uses the thresholds as they are.
+ */
+#include <math.h>
+#include "libgame.h"
+#include "asserts.h"
+
+static float GetMaxAxisScale(const Mat4* transform) {
+    float maxSquared = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float x = transform->m[0][axis];
+        float y = transform->m[1][axis];
+        float z = transform->m[2][axis];
+        float squared = x * x + y * y + z * z;
+        maxSquared = squared > maxSquared ? squared : maxSquared;
+    }
+    return sqrtf(maxSquared);
+}
+
+// the height below which the level after the given one is used
+static float GetLodThreshold(const LodGroup* group, int level) {
+    return level < group->levelCount - 1 ? group->screenHeights[level] : group->cullScreenHeight;
+}
+
+static int SelectLodLevel(const LodGroup* group, int level, float size) {
+    float hysteresis = group->hysteresis > 0 ? group->hysteresis : LIBGAME_DEFAULT_LOD_HYSTERESIS;
+    if (level == LIBGAME_LOD_UNSELECTED) {
+        level = 0;
+        hysteresis = 0;
+    }
+    level = level > group->levelCount ? group->levelCount : level;
+
+    while (level < group->levelCount && size < GetLodThreshold(group, level) * (1 - hysteresis)) {
+        level++;
+    }
+    while (level > 0 && size > GetLodThreshold(group, level - 1) * (1 + hysteresis)) {
+        level--;
+    }
+    return level;
+}
+
+void SelectLodLevels(const Camera3D* camera, LodObject* objects, int objectCount) {
+    for (int i = 0; i < objectCount; i++) {
+        LodObject* object = &objects[i];
+        const LodGroup* group = object->group;
+        Assert(group->levelCount > 0 && group->levelCount <= LIBGAME_MAX_LOD_LEVELS, "Invalid LOD group with %d levels",
+                group->levelCount);
+
+        Vec3 center = { object->transform.m[0][3], object->transform.m[1][3], object->transform.m[2][3] };
+        float radius = group->radius * GetMaxAxisScale(&object->transform);
+        float size = GetProjectedSize3D(camera, center, radius);
+        object->level = SelectLodLevel(group, object->level, size);
+    }
+}
+
+void DrawLodObjects(const LodObject* objects, int objectCount) {
+    for (int i = 0; i < objectCount; i++) {
+        const LodObject* object = &objects[i];
+        Assert(object->level != LIBGAME_LOD_UNSELECTED, "LOD object %d is drawn before its level is selected", i);
+        if (object->level < object->group->levelCount) {
+            DrawMeshTransformed(object->group->levels[object->level], object->transform);
+        }
+    }
+}
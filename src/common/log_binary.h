@@ -0,0 +1,128 @@
+#ifndef log_binary_h
+#define log_binary_h
+
+/*
+ * Binary log format for deferred logging. Shared by the logger and the decoder tool.
+ *
+ * The file starts with a LogBinaryHeader followed by a stream of entries.
+ * Each entry starts with a LogBinaryEntryHeader:
+ * - format entries register a format string and its argument types
+ * - record entries reference a format id and contain the raw arguments
+ *
+ * A format entry is always written before the first record that uses it.
+ *
+ * Format entry payload:
+ *   u8 level, u8 argCount, u8 argTypes[argCount], format string (payloadSize - 2 - argCount bytes, not null terminated)
+ *
+ * Record entry payload:
+ *   u64 ticks (microseconds), then each argument in order:
+ *   - int32: 4 bytes
+ *   - int64, double, pointer: 8 bytes
+ *   - string: u16 length followed by the bytes (not null terminated)
+ *
+ * All values are little-endian.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_BINARY_MAGIC 0x474c424c // "LBLG"
+#define LOG_BINARY_VERSION 1
+#define LOG_BINARY_MAX_ARGS 16
+#define LOG_BINARY_MAX_STRING 128
+
+typedef enum {
+    LogArgInt32 = 1,
+    LogArgInt64,
+    LogArgDouble,
+    LogArgString,
+    LogArgPointer,
+} LogArgType;
+
+typedef enum {
+    LogEntryFormat = 1,
+    LogEntryRecord,
+} LogEntryType;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} LogBinaryHeader;
+
+typedef struct {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t formatId;
+    uint16_t payloadSize;
+} LogBinaryEntryHeader;
+
+typedef struct {
+    int length; // number of characters in the specification, including the %
+    char conversion;
+    LogArgType argType; // 0 if no argument is consumed (%%)
+    bool isLong; // at least 64-bit integer length modifier
+    bool hasStar; // width or precision given as argument, which is not supported
+} LogFormatSpec;
+
+/*
+ * Parse a printf style conversion specification starting at the %.
+ * Returns false if the specification is incomplete.
+ */
+static inline bool ParseLogFormatSpec(const char* s, LogFormatSpec* spec) {
+    const char* start = s;
+    memset(spec, 0, sizeof(LogFormatSpec));
+    s++;
+
+    if (*s == '%') {
+        spec->length = 2;
+        spec->conversion = '%';
+        return true;
+    }
+
+    // flags, width and precision
+    while (*s != '\0' && strchr("-+ #0123456789.*", *s) != NULL) {
+        spec->hasStar |= *s == '*';
+        s++;
+    }
+
+    // length modifiers
+    int longCount = 0;
+    while (*s != '\0' && strchr("hlLqjzt", *s) != NULL) {
+        longCount += *s == 'l' || *s == 'q' || *s == 'j';
+        spec->isLong |= *s == 'z' || *s == 't';
+        s++;
+    }
+    if (s[0] == 'I' && s[1] == '6' && s[2] == '4') {
+        spec->isLong = true;
+        s += 3;
+    }
+    spec->isLong |= longCount >= 2 || (longCount == 1 && sizeof(long) == 8);
+
+    if (*s == '\0') {
+        return false;
+    }
+
+    spec->conversion = *s;
+    switch (*s) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec->argType = spec->isLong ? LogArgInt64 : LogArgInt32;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->argType = LogArgDouble;
+            break;
+        case 's':
+            spec->argType = LogArgString;
+            break;
+        case 'p':
+            spec->argType = LogArgPointer;
+            break;
+        default:
+            return false;
+    }
+
+    spec->length = (int)(s - start) + 1;
+    return true;
+}
+
+#endif
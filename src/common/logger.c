@@ -6,19 +6,562 @@
  * The issue is that the freopen state is not global across binaries. When we call
  * it here, that doesn't set up printf to work in the game code. However if we do
  * the printf statements within the scope of this library, then they use the correct state.
+ *
+ * ASYNC MODE
+ *
+ * Console I/O is slow, so logging from within a frame can stall the game loop.
+ * In async mode the caller formats a record into a bounded lock-free queue
+ * and a background thread writes the records to the sink.
+ *
+ * The queue is a ring buffer of fixed size records where each record has a sequence number
+ * (see Dmitry Vyukov's bounded MPMC queue). Producers claim a position with a compare exchange
+ * and publish the record by bumping its sequence number. There is a single consumer, the flush thread,
+ * which releases records back to the producers in the same way.
+ *
+ * DEFERRED LOGGING
+ *
+ * Formatting is slow compared to copying a few bytes, so LogDeferred only stores a format id
+ * and the raw arguments in a binary log (see log_binary.h). The binary entries go through
+ * the same queue as the text records and are decoded offline.
  */
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "libgame.h"
 #include "asserts.h"
+#include "atomics.h"
+#include "threading.h"
+#include "log_binary.h"
 
-// -- Logging --
+static const char* MapLevelToString(LogLevel level);
+static void LogV(LogCategory category, LogLevel level, const char* format, va_list args);
+
+// -- Sinks --
+
+static LogSettings logSettings = {0};
+static FILE* logFile = NULL;
+static FILE* binaryLogFile = NULL;
+static LogLevel categoryLevels[LOG_CATEGORY_COUNT] = {
+    LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO,
+};
+
+static FILE* MapLevelToStream(LogLevel level) {
+    switch(logSettings.sink) {
+        case LOG_SINK_STDOUT:
+            return stdout;
+        case LOG_SINK_STDERR:
+            return stderr;
+        case LOG_SINK_FILE:
+            return logFile;
+        default:
+            return level >= LOG_ERROR ? stderr : stdout;
+    }
+}
+
+static void FlushStreams() {
+    fflush(stdout);
+    fflush(stderr);
+    if (logFile != NULL) {
+        fflush(logFile);
+    }
+    if (binaryLogFile != NULL) {
+        fflush(binaryLogFile);
+    }
+}
+
+// -- Async queue --
+
+#define LOG_QUEUE_CAPACITY 1024 // must be a power of two
+#define LOG_RECORD_SIZE 512
+#define LOG_FLUSH_INTERVAL_MS 10
+#define LOG_FLUSH_STALL_MS 100
+
+typedef struct {
+    volatile uint32_t sequence;
+    LogLevel level;
+    bool isBinary;
+    int length;
+    char text[LOG_RECORD_SIZE];
+} LogRecord;
+
+static LogRecord logQueue[LOG_QUEUE_CAPACITY];
+static volatile uint32_t enqueuePos = 0;
+static volatile uint32_t dequeuePos = 0; // only written by the flush thread
+static volatile uint32_t droppedCount = 0;
+static uint32_t reportedDroppedCount = 0;
+
+static bool isAsync = false;
+static volatile uint32_t shouldStopFlushThread = 0;
+static void* flushThread = NULL;
+static void* flushSignal = NULL;
+
+static void DrainQueue() {
+    for (;;) {
+        uint32_t pos = dequeuePos;
+        LogRecord* record = &logQueue[pos & (LOG_QUEUE_CAPACITY - 1)];
+        uint32_t sequence = AtomicLoad(&record->sequence);
+
+        // not yet published
+        if ((int32_t)(sequence - (pos + 1)) < 0) {
+            break;
+        }
+
+        FILE* stream = record->isBinary ? binaryLogFile : MapLevelToStream(record->level);
+        fwrite(record->text, 1, record->length, stream);
+
+        AtomicStore(&record->sequence, pos + LOG_QUEUE_CAPACITY);
+        AtomicStore(&dequeuePos, pos + 1);
+    }
+
+    uint32_t dropped = AtomicLoad(&droppedCount);
+    if (dropped != reportedDroppedCount) {
+        fprintf(MapLevelToStream(LOG_WARNING), "WARNING: Log queue overflow. Dropped %u records.\n", dropped - reportedDroppedCount);
+        reportedDroppedCount = dropped;
+    }
+
+    FlushStreams();
+}
+
+static void RunFlushThread(void* arg) {
+    while (!AtomicLoad(&shouldStopFlushThread)) {
+        WaitSignal(flushSignal, LOG_FLUSH_INTERVAL_MS);
+        DrainQueue();
+    }
+    DrainQueue();
+}
+
+// records that must not be lost, like format definitions, wait for space even with LOG_OVERFLOW_DROP
+static LogRecord* ClaimRecord(bool canDrop) {
+    uint32_t pos = AtomicLoad(&enqueuePos);
+
+    for (;;) {
+        LogRecord* record = &logQueue[pos & (LOG_QUEUE_CAPACITY - 1)];
+        uint32_t sequence = AtomicLoad(&record->sequence);
+        int32_t diff = (int32_t)(sequence - pos);
+
+        if (diff == 0) {
+            if (AtomicCompareExchange(&enqueuePos, pos, pos + 1)) {
+                return record;
+            }
+        } else if (diff < 0) {
+            // the queue is full
+            if (canDrop && logSettings.overflowPolicy == LOG_OVERFLOW_DROP) {
+                AtomicAdd(&droppedCount, 1);
+                return NULL;
+            }
+            SetSignal(flushSignal);
+            SleepThread(0);
+        }
+
+        pos = AtomicLoad(&enqueuePos);
+    }
+}
+
+static void EnqueueRecord(LogLevel level, const char* prefix, const char* format, va_list args) {
+    LogRecord* record = ClaimRecord(true);
+    if (record == NULL) {
+        return;
+    }
+
+    int prefixLength = snprintf(record->text, LOG_RECORD_SIZE, "%s", prefix);
+    int length = vsnprintf(record->text + prefixLength, LOG_RECORD_SIZE - prefixLength, format, args);
+    length = length < 0 ? 0 : prefixLength + length;
+    length = length < LOG_RECORD_SIZE ? length : LOG_RECORD_SIZE - 1; // truncated
+
+    record->level = level;
+    record->isBinary = false;
+    record->length = length;
+
+    uint32_t pos = record->sequence;
+    AtomicStore(&record->sequence, pos + 1);
+
+    // wake up the flush thread early for errors, so they are visible right away
+    if (level >= LOG_ERROR) {
+        SetSignal(flushSignal);
+    }
+}
+
+static void StopAsyncLogging() {
+    if (!isAsync) {
+        return;
+    }
+
+    AtomicStore(&shouldStopFlushThread, 1);
+    SetSignal(flushSignal);
+    JoinThread(flushThread);
+
+    flushThread = NULL;
+    isAsync = false;
+}
+
+static void StartAsyncLogging() {
+    for (uint32_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+        logQueue[i].sequence = i;
+    }
+    enqueuePos = 0;
+    dequeuePos = 0;
+    shouldStopFlushThread = 0;
+
+    if (flushSignal == NULL) {
+        flushSignal = CreateSignal();
+    }
+    flushThread = StartThread(RunFlushThread, NULL);
+    isAsync = true;
+}
+
+// -- Deferred logging --
+
+#define LOG_MAX_FORMATS 1024
+#define LOG_MAX_FORMAT_LENGTH 256
+
+typedef struct {
+    LogLevel level;
+    uint8_t argCount;
+    uint8_t argTypes[LOG_BINARY_MAX_ARGS];
+    // copied, because the original string may be unloaded with a reloaded game library
+    char format[LOG_MAX_FORMAT_LENGTH];
+} LogFormat;
+
+static LogFormat logFormats[LOG_MAX_FORMATS];
+static volatile uint32_t logFormatCount = 0;
+static volatile uint32_t logFormatLock = 0;
+
+static void WriteBinaryEntry(LogLevel level, const uint8_t* entry, int size, bool canDrop) {
+    if (!isAsync) {
+        fwrite(entry, 1, size, binaryLogFile);
+        return;
+    }
+
+    LogRecord* record = ClaimRecord(canDrop);
+    if (record == NULL) {
+        return;
+    }
+
+    memcpy(record->text, entry, size);
+    record->level = level;
+    record->isBinary = true;
+    record->length = size;
+
+    uint32_t pos = record->sequence;
+    AtomicStore(&record->sequence, pos + 1);
+}
 
-LogLevel logLevel = LOG_INFO;
+static int BeginBinaryEntry(uint8_t* buffer, LogEntryType type, int formatId) {
+    LogBinaryEntryHeader header = {0};
+    header.type = type;
+    header.formatId = formatId;
+    memcpy(buffer, &header, sizeof(header));
+    return sizeof(header);
+}
+
+static void EndBinaryEntry(uint8_t* buffer, int size) {
+    LogBinaryEntryHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    header.payloadSize = size - sizeof(header);
+    memcpy(buffer, &header, sizeof(header));
+}
+
+static void WriteFormatEntry(int formatId) {
+    LogFormat* logFormat = &logFormats[formatId - 1];
+    uint8_t buffer[LOG_RECORD_SIZE];
+
+    int offset = BeginBinaryEntry(buffer, LogEntryFormat, formatId);
+    buffer[offset++] = (uint8_t)logFormat->level;
+    buffer[offset++] = logFormat->argCount;
+    memcpy(buffer + offset, logFormat->argTypes, logFormat->argCount);
+    offset += logFormat->argCount;
+
+    int length = strlen(logFormat->format);
+    memcpy(buffer + offset, logFormat->format, length);
+    offset += length;
+
+    // a dropped format would leave every record that uses it undecodable
+    EndBinaryEntry(buffer, offset);
+    WriteBinaryEntry(logFormat->level, buffer, offset, false);
+}
+
+static int FindLogFormat(LogLevel level, const char* format) {
+    uint32_t count = AtomicLoad(&logFormatCount);
+    for (uint32_t i = 0; i < count && i < LOG_MAX_FORMATS; i++) {
+        if (logFormats[i].level == level && strcmp(logFormats[i].format, format) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static void AcquireFormatLock() {
+    while (!AtomicCompareExchange(&logFormatLock, 0, 1)) {
+        SleepThread(0);
+    }
+}
+
+static void ReleaseFormatLock() {
+    AtomicStore(&logFormatLock, 0);
+}
+
+static void ParseLogFormat(LogFormat* logFormat, LogLevel level, const char* format) {
+    int length = strlen(format);
+    Assert(length < LOG_MAX_FORMAT_LENGTH, "Deferred log format is too long (%d). Max is %d.", length, LOG_MAX_FORMAT_LENGTH - 1);
+
+    logFormat->level = level;
+    logFormat->argCount = 0;
+    memcpy(logFormat->format, format, length + 1);
+
+    const char* s = format;
+    while (*s != '\0') {
+        if (*s != '%') {
+            s++;
+            continue;
+        }
+
+        LogFormatSpec spec;
+        bool didParse = ParseLogFormatSpec(s, &spec);
+        Assert(didParse && !spec.hasStar, "Unsupported deferred log format \"%s\"", format);
+
+        if (spec.argType != 0) {
+            Assert(logFormat->argCount < LOG_BINARY_MAX_ARGS, "Too many deferred log arguments in \"%s\". Max is %d.", format, LOG_BINARY_MAX_ARGS);
+            logFormat->argTypes[logFormat->argCount++] = spec.argType;
+        }
+        s += spec.length;
+    }
+}
+
+/*
+ * Registration is rare, once per call site, so it takes a spin lock. The entry is filled and its
+ * format definition is queued before the count is published, so FindLogFormat and the writers never
+ * see a half-filled entry without taking the lock, and no record can reach the file before its format.
+ * Looking up the format again under the lock registers it only once.
+ */
+static int RegisterLogFormat(LogLevel level, const char* format) {
+    // reuse the id if the call site was registered before a library reload
+    int existingId = FindLogFormat(level, format);
+    if (existingId != 0) {
+        return existingId;
+    }
+
+    AcquireFormatLock();
+    int formatId = FindLogFormat(level, format);
+    if (formatId == 0) {
+        uint32_t index = AtomicLoad(&logFormatCount);
+        Assert(index < LOG_MAX_FORMATS, "Too many deferred log formats. Max is %d.", LOG_MAX_FORMATS);
+        ParseLogFormat(&logFormats[index], level, format);
+
+        // queued before it is published, so no record that uses it can be queued ahead of it
+        formatId = index + 1;
+        WriteFormatEntry(formatId);
+        AtomicStore(&logFormatCount, index + 1);
+    }
+    ReleaseFormatLock();
+
+    return formatId;
+}
+
+static int WriteDeferredArg(uint8_t* buffer, int offset, LogArgType type, va_list* args) {
+    switch (type) {
+        case LogArgInt32: {
+            int32_t value = va_arg(*args, int32_t);
+            memcpy(buffer + offset, &value, sizeof(value));
+            return offset + sizeof(value);
+        }
+        case LogArgInt64: {
+            int64_t value = va_arg(*args, int64_t);
+            memcpy(buffer + offset, &value, sizeof(value));
+            return offset + sizeof(value);
+        }
+        case LogArgDouble: {
+            double value = va_arg(*args, double);
+            memcpy(buffer + offset, &value, sizeof(value));
+            return offset + sizeof(value);
+        }
+        case LogArgPointer: {
+            uint64_t value = (uintptr_t)va_arg(*args, void*);
+            memcpy(buffer + offset, &value, sizeof(value));
+            return offset + sizeof(value);
+        }
+        case LogArgString: {
+            const char* str = va_arg(*args, const char*);
+            str = str != NULL ? str : "(null)";
+
+            // leave room for the remaining fixed size arguments
+            int maxLength = LOG_RECORD_SIZE - offset - sizeof(uint16_t) - LOG_BINARY_MAX_ARGS * sizeof(uint64_t);
+            maxLength = maxLength < LOG_BINARY_MAX_STRING ? maxLength : LOG_BINARY_MAX_STRING;
+
+            uint16_t length = 0;
+            while (length < maxLength && str[length] != '\0') {
+                length++;
+            }
+            memcpy(buffer + offset, &length, sizeof(length));
+            memcpy(buffer + offset + sizeof(length), str, length);
+            return offset + sizeof(length) + length;
+        }
+        default:
+            AssertFail("Unknown deferred log argument type %d", type);
+            return offset;
+    }
+}
+
+void LogDeferredWithId(int* formatId, LogLevel level, const char* format, ...) {
+    if (level < categoryLevels[LOG_CATEGORY_GENERAL]) {
+       return;
+    }
+
+    va_list args;
+    va_start(args, format);
+
+    if (binaryLogFile == NULL) {
+        LogV(LOG_CATEGORY_GENERAL, level, format, args);
+        va_end(args);
+        return;
+    }
+
+    if (*formatId == 0) {
+        *formatId = RegisterLogFormat(level, format);
+    }
+    LogFormat* logFormat = &logFormats[*formatId - 1];
+
+    uint8_t buffer[LOG_RECORD_SIZE];
+    int offset = BeginBinaryEntry(buffer, LogEntryRecord, *formatId);
+
+    uint64_t ticks = GetTicks();
+    memcpy(buffer + offset, &ticks, sizeof(ticks));
+    offset += sizeof(ticks);
+
+    for (int i = 0; i < logFormat->argCount; i++) {
+        offset = WriteDeferredArg(buffer, offset, logFormat->argTypes[i], &args);
+    }
+    va_end(args);
+
+    EndBinaryEntry(buffer, offset);
+    WriteBinaryEntry(level, buffer, offset, true);
+}
+
+static void OpenBinaryLog(const char* path) {
+    binaryLogFile = fopen(path, "wb");
+    Assert(binaryLogFile != NULL, "Unable to open binary log file %s", path);
+
+    LogBinaryHeader header = {0};
+    header.magic = LOG_BINARY_MAGIC;
+    header.version = LOG_BINARY_VERSION;
+    fwrite(&header, sizeof(header), 1, binaryLogFile);
+
+    // formats registered before the file was opened
+    uint32_t count = AtomicLoad(&logFormatCount);
+    for (uint32_t i = 0; i < count && i < LOG_MAX_FORMATS; i++) {
+        WriteFormatEntry(i + 1);
+    }
+}
+
+// -- Configuration --
+
+static bool didRegisterAtExit = false;
+
+void ConfigureLogger(LogSettings settings) {
+    StopAsyncLogging();
+
+    if (logFile != NULL) {
+        fclose(logFile);
+        logFile = NULL;
+    }
+    if (binaryLogFile != NULL) {
+        fclose(binaryLogFile);
+        binaryLogFile = NULL;
+    }
+
+    logSettings = settings;
+
+    if (settings.sink == LOG_SINK_FILE) {
+        Assert(settings.filePath != NULL, "Unable to configure file logging. No file path was provided.");
+        logFile = fopen(settings.filePath, "w");
+        Assert(logFile != NULL, "Unable to open log file %s", settings.filePath);
+    }
+
+    if (settings.binaryFilePath != NULL) {
+        OpenBinaryLog(settings.binaryFilePath);
+    }
+
+    if (settings.isAsync) {
+        StartAsyncLogging();
+    }
+
+    if (!didRegisterAtExit) {
+        atexit(FlushLog);
+        didRegisterAtExit = true;
+    }
+}
+
+void FlushLog() {
+    if (!isAsync) {
+        FlushStreams();
+        return;
+    }
+
+    uint32_t target = AtomicLoad(&enqueuePos);
+    SetSignal(flushSignal);
+
+    uint32_t lastPos = AtomicLoad(&dequeuePos);
+    int stalledMs = 0;
+
+    while ((int32_t)(lastPos - target) < 0) {
+        SleepThread(1);
+
+        uint32_t pos = AtomicLoad(&dequeuePos);
+        stalledMs = pos == lastPos ? stalledMs + 1 : 0;
+        lastPos = pos;
+
+        /*
+         * At process exit the flush thread may already have been terminated
+         * (for example when the atexit handlers run at DLL detach). Once it is
+         * gone, drain the queue from this thread instead. A thread that is only
+         * slow, for example blocked in console output, keeps the queue to itself,
+         * since the queue has a single consumer.
+         */
+        if (stalledMs >= LOG_FLUSH_STALL_MS) {
+            if (HasThreadExited(flushThread)) {
+                DrainQueue();
+                return;
+            }
+            stalledMs = 0;
+            SetSignal(flushSignal);
+        }
+    }
+}
+
+// -- Logging --
 
 void SetLogLevel(LogLevel level) {
-    logLevel = level;
+    for (int i = 0; i < LOG_CATEGORY_COUNT; i++) {
+        categoryLevels[i] = level;
+    }
+}
+
+void SetLogCategoryLevel(LogCategory category, LogLevel level) {
+    Assert(category >= 0 && category < LOG_CATEGORY_COUNT, "Unknown log category %d", category);
+    categoryLevels[category] = level;
+}
+
+bool IsLogEnabled(LogCategory category, LogLevel level) {
+    return level >= categoryLevels[category];
+}
+
+static const char* MapCategoryToString(LogCategory category) {
+    switch(category) {
+        case LOG_CATEGORY_GENERAL:
+            return "general";
+        case LOG_CATEGORY_RENDER:
+            return "render";
+        case LOG_CATEGORY_INPUT:
+            return "input";
+        case LOG_CATEGORY_TIMING:
+            return "timing";
+        case LOG_CATEGORY_LOADER:
+            return "loader";
+        default:
+            AssertFail("Failed to map log category to string. Unknown log category %d", category);
+            return "unknown";
+    }
 }
 
 static const char* MapLevelToString(LogLevel level) {
@@ -37,32 +580,48 @@ static const char* MapLevelToString(LogLevel level) {
     }
 }
 
-void Log(LogLevel level, const char* format, ...) {
-    if (level < logLevel) {
+static void LogV(LogCategory category, LogLevel level, const char* format, va_list args) {
+    if (level < categoryLevels[category]) {
        return;
     }
 
-    const char* levelPrefix = MapLevelToString(level);
+    char prefix[32];
+    if (category == LOG_CATEGORY_GENERAL) {
+        snprintf(prefix, sizeof(prefix), "%s: ", MapLevelToString(level));
+    } else {
+        snprintf(prefix, sizeof(prefix), "%s: [%s] ", MapLevelToString(level), MapCategoryToString(category));
+    }
 
+    if (isAsync) {
+        EnqueueRecord(level, prefix, format, args);
+        return;
+    }
+
+    FILE* stream = MapLevelToStream(level);
+    fputs(prefix, stream);
+    vfprintf(stream, format, args);
+}
+
+// parenthesized names, since the public header may replace these with macros (see LIBGAME_LOG_MIN_LEVEL)
+void (Log)(LogLevel level, const char* format, ...) {
     va_list args;
     va_start(args, format);
+    LogV(LOG_CATEGORY_GENERAL, level, format, args);
+    va_end(args);
+}
 
-    if (level >= LOG_ERROR) {
-        fprintf(stderr, "%s: ", levelPrefix);
-        vfprintf(stderr, format, args);
-    } else {
-        fprintf(stdout, "%s: ", levelPrefix);
-        vfprintf(stdout, format, args);
-    }
-
+void LogCategorized(LogCategory category, LogLevel level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    LogV(category, level, format, args);
     va_end(args);
 }
 
  #define DECLARE_LOG_FN(name, level) \
-     void name(const char* format, ...) { \
+     void (name)(const char* format, ...) { \
          va_list args; \
          va_start(args, format); \
-         Log(level, format, args); \
+         LogV(LOG_CATEGORY_GENERAL, level, format, args); \
          va_end(args); \
      }
 
@@ -71,11 +630,12 @@ DECLARE_LOG_FN(LogInfo, LOG_INFO)
 DECLARE_LOG_FN(LogWarning, LOG_WARNING)
 DECLARE_LOG_FN(LogError, LOG_ERROR)
 
-void LogAssert(const char* file, int line, const char* format, ...) {
-    va_list args;
-    va_start(args, format);
+void LogAssert(const char* file, int line, const char* format, va_list args) {
+    // make sure that the records leading up to the assert are visible
+    FlushLog();
+
     fprintf(stderr, "ASSERT: ");
     vfprintf(stderr, format, args);
     fprintf(stderr, "\n    at %s:%d\n", file, line);
-    va_end(args);
+    fflush(stderr);
 }
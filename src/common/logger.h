@@ -1,7 +1,9 @@
 #ifndef logger_h
 #define logger_h
 
+#include <stdarg.h>
+
 // internal util for asserts
-void LogAssert(const char* file, int line, const char* format, ...);
+void LogAssert(const char* file, int line, const char* format, va_list args);
 
 #endif
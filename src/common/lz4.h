@@ -0,0 +1,194 @@
+#ifndef lz4_h
+#define lz4_h
+
+/*
+ * LZ4 block compression. Shared by the asset pack loader and the packer tool.
+ *
+ * A block is a sequence of (literals, match) pairs. Each starts with a token,
+ * with the literal length in the high 4 bits and the match length minus 4 in the low 4 bits.
+ * Lengths of 15 continue in the following bytes, adding 255 per byte until a byte is below 255.
+ * The literals follow, then the match offset as a little-endian u16. The last
+ * sequence only has literals.
+ *
+ * The compressor is a simple greedy one with a single hash table, which is fast
+ * and good enough for offline packing. Decompression is compatible with any LZ4 block.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5 // the last bytes of a block are always literals
+#define LZ4_MATCH_SAFE_DISTANCE 12 // a match can't start within this distance from the end
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 12
+
+static inline int Lz4CompressBound(int size) {
+    return size + size / 255 + 16;
+}
+
+static inline uint32_t Lz4Read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline bool Lz4WriteLength(uint8_t* dst, int* offset, int capacity, int length) {
+    for (; length >= 255; length -= 255) {
+        if (*offset >= capacity) {
+            return false;
+        }
+        dst[(*offset)++] = 255;
+    }
+    if (*offset >= capacity) {
+        return false;
+    }
+    dst[(*offset)++] = (uint8_t)length;
+    return true;
+}
+
+static inline bool Lz4WriteSequence(uint8_t* dst, int* offset, int capacity,
+        const uint8_t* literals, int literalLength, int matchOffset, int matchLength) {
+    if (*offset >= capacity) {
+        return false;
+    }
+
+    int tokenOffset = (*offset)++;
+    uint8_t token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15 && !Lz4WriteLength(dst, offset, capacity, literalLength - 15)) {
+        return false;
+    }
+
+    if (*offset + literalLength > capacity) {
+        return false;
+    }
+    memcpy(dst + *offset, literals, literalLength);
+    *offset += literalLength;
+
+    if (matchLength > 0) {
+        if (*offset + 2 > capacity) {
+            return false;
+        }
+        dst[(*offset)++] = (uint8_t)(matchOffset & 0xff);
+        dst[(*offset)++] = (uint8_t)(matchOffset >> 8);
+
+        int extraLength = matchLength - LZ4_MIN_MATCH;
+        token |= extraLength >= 15 ? 15 : extraLength;
+        if (extraLength >= 15 && !Lz4WriteLength(dst, offset, capacity, extraLength - 15)) {
+            return false;
+        }
+    }
+
+    dst[tokenOffset] = token;
+    return true;
+}
+
+// returns the compressed size, or 0 if it doesn't fit in the destination
+static inline int Lz4Compress(const uint8_t* src, int srcSize, uint8_t* dst, int dstCapacity) {
+    int table[1 << LZ4_HASH_BITS];
+    memset(table, -1, sizeof(table));
+
+    int o = 0;
+    int anchor = 0;
+    int i = 0;
+    int matchLimit = srcSize - LZ4_MATCH_SAFE_DISTANCE;
+
+    while (i < matchLimit) {
+        uint32_t sequence = Lz4Read32(src + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        int candidate = table[hash];
+        table[hash] = i;
+
+        if (candidate < 0 || i - candidate > LZ4_MAX_OFFSET || Lz4Read32(src + candidate) != sequence) {
+            i++;
+            continue;
+        }
+
+        int matchLength = LZ4_MIN_MATCH;
+        int maxMatchLength = srcSize - LZ4_LAST_LITERALS - i;
+        while (matchLength < maxMatchLength && src[candidate + matchLength] == src[i + matchLength]) {
+            matchLength++;
+        }
+
+        if (!Lz4WriteSequence(dst, &o, dstCapacity, src + anchor, i - anchor, i - candidate, matchLength)) {
+            return 0;
+        }
+        i += matchLength;
+        anchor = i;
+    }
+
+    if (!Lz4WriteSequence(dst, &o, dstCapacity, src + anchor, srcSize - anchor, 0, 0)) {
+        return 0;
+    }
+    return o;
+}
+
+// returns the decompressed size, or -1 if the block is malformed or doesn't fit in the destination
+static inline int Lz4Decompress(const uint8_t* src, int srcSize, uint8_t* dst, int dstCapacity) {
+    int i = 0;
+    int o = 0;
+
+    while (i < srcSize) {
+        uint8_t token = src[i++];
+
+        int literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint8_t b;
+            do {
+                if (i >= srcSize) {
+                    return -1;
+                }
+                b = src[i++];
+                literalLength += b;
+            } while (b == 255);
+        }
+
+        if (i + literalLength > srcSize || o + literalLength > dstCapacity) {
+            return -1;
+        }
+        memcpy(dst + o, src + i, literalLength);
+        i += literalLength;
+        o += literalLength;
+
+        // the last sequence has no match
+        if (i == srcSize) {
+            break;
+        }
+
+        if (i + 2 > srcSize) {
+            return -1;
+        }
+        int matchOffset = src[i] | (src[i + 1] << 8);
+        i += 2;
+        if (matchOffset == 0 || matchOffset > o) {
+            return -1;
+        }
+
+        int matchLength = token & 15;
+        if (matchLength == 15) {
+            uint8_t b;
+            do {
+                if (i >= srcSize) {
+                    return -1;
+                }
+                b = src[i++];
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += LZ4_MIN_MATCH;
+
+        if (o + matchLength > dstCapacity) {
+            return -1;
+        }
+        // byte by byte, since the match can overlap the output
+        for (int k = 0; k < matchLength; k++) {
+            dst[o + k] = dst[o - matchOffset + k];
+        }
+        o += matchLength;
+    }
+
+    return o;
+}
+
+#endif
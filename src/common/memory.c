@@ -0,0 +1,251 @@
+/*
+ * Library owned memory and allocators.
+ *
+ * PERSISTENT MEMORY
+ *
+ * The persistent memory block lives in this library, so it is unaffected by
+ * reloads of the game library. The game library gets a pointer handoff instead
+ * of having to serialize and deserialize its state.
+ *
+ * ARENAS AND POOLS
+ *
+ * Arenas and pools are backed by pages from the platform layer, so they never call malloc.
+ * The frame arena is reset from EndFrame (see render.c). Both keep a few counters
+ * such as the high-water mark, which are cheap to update and useful for sizing.
+ */
+#include <string.h>
+#include "libgame.h"
+#include "platform_setup.h"
+#include "asserts.h"
+#include "memory.h"
+
+PlatformMemory platformMemory = {};
+
+void InitPlatformMemory(PlatformMemory pm) {
+    platformMemory = pm;
+}
+
+// -- Persistent memory --
+
+static void* persistentMemory = NULL;
+static uint64_t persistentMemorySize = 0;
+static uint32_t persistentLayoutVersion = 0;
+
+PersistentMemory GetPersistentMemory(uint64_t size, uint32_t layoutVersion) {
+    PersistentMemory result = {0};
+
+    if (persistentMemory == NULL) {
+        persistentMemory = platformMemory.AllocatePages(LIBGAME_PERSISTENT_MEMORY_BASE, size);
+        Assert(persistentMemory != NULL, "Failed to allocate %llu bytes of persistent memory", size);
+
+        if (persistentMemory != LIBGAME_PERSISTENT_MEMORY_BASE) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Persistent memory was not allocated at the requested base address %p. Using %p instead.\n",
+                    LIBGAME_PERSISTENT_MEMORY_BASE, persistentMemory);
+        }
+
+        persistentMemorySize = size;
+        persistentLayoutVersion = layoutVersion;
+        result.isFresh = true;
+    } else {
+        Assert(size <= persistentMemorySize, "Unable to grow persistent memory from %llu to %llu bytes", persistentMemorySize, size);
+
+        if (layoutVersion != persistentLayoutVersion) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Persistent memory layout changed (0x%x to 0x%x). Clearing the memory.\n",
+                    persistentLayoutVersion, layoutVersion);
+            memset(persistentMemory, 0, persistentMemorySize);
+            persistentLayoutVersion = layoutVersion;
+            result.isFresh = true;
+        }
+    }
+
+    result.memory = persistentMemory;
+    result.size = persistentMemorySize;
+
+    return result;
+}
+
+// -- Arenas --
+
+static AllocationHook allocationHook = NULL;
+
+void SetAllocationHook(AllocationHook hook) {
+    allocationHook = hook;
+}
+
+static inline void NotifyAllocationHook(AllocationEvent event, const char* name, void* memory, uint64_t size) {
+    if (allocationHook != NULL) {
+        allocationHook(event, name, memory, size);
+    }
+}
+
+Arena CreateArenaFromMemory(const char* name, void* memory, uint64_t capacity) {
+    Arena arena = {0};
+    arena.base = (uint8_t*)memory;
+    arena.capacity = capacity;
+    arena.name = name;
+    return arena;
+}
+
+Arena CreateArena(const char* name, uint64_t capacity) {
+    void* memory = platformMemory.AllocatePages(NULL, capacity);
+    Assert(memory != NULL, "Failed to allocate %llu bytes for arena %s", capacity, name);
+
+    Arena arena = CreateArenaFromMemory(name, memory, capacity);
+    arena.isOwned = true;
+    return arena;
+}
+
+void DestroyArena(Arena* arena) {
+    if (arena->isOwned) {
+        platformMemory.FreePages(arena->base, arena->capacity);
+    }
+    *arena = (Arena){0};
+}
+
+void* ArenaAllocAligned(Arena* arena, uint64_t size, uint64_t alignment) {
+    Assert(alignment != 0 && (alignment & (alignment - 1)) == 0, "Arena alignment must be a power of two. Got %llu.", alignment);
+
+    // align the address rather than the offset, since the base may be less aligned than requested
+    uintptr_t address = (uintptr_t)(arena->base + arena->used);
+    uint64_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    uint64_t start = arena->used + padding;
+    Assert(start + size <= arena->capacity, "Arena %s is out of memory. Requested %llu bytes with %llu of %llu used.",
+            arena->name, size, arena->used, arena->capacity);
+
+    arena->used = start + size;
+    arena->allocationCount++;
+    if (arena->used > arena->highWaterMark) {
+        arena->highWaterMark = arena->used;
+    }
+
+    void* memory = arena->base + start;
+    NotifyAllocationHook(ALLOCATION_ALLOC, arena->name, memory, size);
+
+    return memory;
+}
+
+void* ArenaAlloc(Arena* arena, uint64_t size) {
+    return ArenaAllocAligned(arena, size, 16);
+}
+
+void ResetArena(Arena* arena) {
+    NotifyAllocationHook(ALLOCATION_RESET, arena->name, arena->base, arena->used);
+    arena->used = 0;
+}
+
+// -- Frame and scratch arenas --
+
+static MemorySettings memorySettings = {
+    .frameArenaSize = LIBGAME_DEFAULT_FRAME_ARENA_SIZE,
+    .scratchArenaSize = LIBGAME_DEFAULT_SCRATCH_ARENA_SIZE,
+};
+static Arena frameArena = {0};
+static Arena scratchArena = {0};
+static int scratchDepth = 0;
+
+void ConfigureMemory(MemorySettings settings) {
+    Assert(frameArena.base == NULL && scratchArena.base == NULL, "Unable to configure memory. "
+            "The frame or scratch arena has already been allocated.");
+    memorySettings = settings;
+}
+
+Arena* GetFrameArena() {
+    if (frameArena.base == NULL) {
+        frameArena = CreateArena("frame", memorySettings.frameArenaSize);
+    }
+    return &frameArena;
+}
+
+void* FrameAlloc(uint64_t size) {
+    return ArenaAlloc(GetFrameArena(), size);
+}
+
+void ResetFrameArena() {
+    if (frameArena.base != NULL) {
+        ResetArena(&frameArena);
+    }
+}
+
+ScratchArena BeginScratch() {
+    if (scratchArena.base == NULL) {
+        scratchArena = CreateArena("scratch", memorySettings.scratchArenaSize);
+    }
+
+    ScratchArena scratch = {0};
+    scratch.arena = &scratchArena;
+    scratch.mark = scratchArena.used;
+    scratch.depth = ++scratchDepth;
+
+    return scratch;
+}
+
+void EndScratch(ScratchArena scratch) {
+    Assert(scratch.depth == scratchDepth, "Scratch arenas must be ended in reverse order. Expected depth %d, got %d.",
+            scratchDepth, scratch.depth);
+
+    NotifyAllocationHook(ALLOCATION_FREE, scratchArena.name, scratchArena.base + scratch.mark, scratchArena.used - scratch.mark);
+    scratchArena.used = scratch.mark;
+    scratchDepth--;
+}
+
+// -- Pools --
+
+/*
+ * Free blocks form an intrusive linked list, where the first bytes of
+ * each free block point to the next free block.
+ */
+Pool CreatePool(const char* name, uint64_t blockSize, int blockCount) {
+    // blocks need room for the free list pointer and should keep 16-byte alignment
+    blockSize = blockSize < sizeof(void*) ? sizeof(void*) : blockSize;
+    blockSize = (blockSize + 15) & ~(uint64_t)15;
+
+    Pool pool = {0};
+    pool.name = name;
+    pool.blockSize = blockSize;
+    pool.blockCount = blockCount;
+    pool.base = (uint8_t*)platformMemory.AllocatePages(NULL, blockSize * blockCount);
+    Assert(pool.base != NULL, "Failed to allocate %d blocks of %llu bytes for pool %s", blockCount, blockSize, name);
+
+    for (int i = blockCount - 1; i >= 0; i--) {
+        void* block = pool.base + i * blockSize;
+        *(void**)block = pool.freeList;
+        pool.freeList = block;
+    }
+
+    return pool;
+}
+
+void DestroyPool(Pool* pool) {
+    platformMemory.FreePages(pool->base, pool->blockSize * pool->blockCount);
+    *pool = (Pool){0};
+}
+
+void* PoolAlloc(Pool* pool) {
+    void* block = pool->freeList;
+    if (block == NULL) {
+        NotifyAllocationHook(ALLOCATION_ALLOC, pool->name, NULL, pool->blockSize);
+        return NULL;
+    }
+
+    pool->freeList = *(void**)block;
+    pool->usedCount++;
+    pool->allocationCount++;
+    if (pool->usedCount > pool->highWaterMark) {
+        pool->highWaterMark = pool->usedCount;
+    }
+
+    NotifyAllocationHook(ALLOCATION_ALLOC, pool->name, block, pool->blockSize);
+    return block;
+}
+
+void PoolFree(Pool* pool, void* block) {
+    uint8_t* blockBytes = (uint8_t*)block;
+    Assert(blockBytes >= pool->base && blockBytes < pool->base + pool->blockSize * pool->blockCount
+            && (blockBytes - pool->base) % pool->blockSize == 0, "Block %p does not belong to pool %s", block, pool->name);
+
+    NotifyAllocationHook(ALLOCATION_FREE, pool->name, block, pool->blockSize);
+
+    *(void**)block = pool->freeList;
+    pool->freeList = block;
+    pool->usedCount--;
+}
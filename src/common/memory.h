@@ -0,0 +1,7 @@
+#ifndef memory_h
+#define memory_h
+
+// call at the end of each frame
+void ResetFrameArena();
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Mesh optimization for retained meshes.
+ *
+ * The attributes are interleaved into one vertex for welding, with the missing ones left at zero,
+ * so that only vertices that draw the same are merged. The algorithms are in mesh_optimize.h.
+ * The result is one allocation: positions, then the optional colors and texture coordinates, then the indices.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "mesh_optimize.h"
+
+typedef struct {
+    Vec3 position;
+    Color color;
+    Vec2 texCoord;
+} WeldVertex;
+
+typedef struct {
+    WeldVertex* vertices;
+    WeldVertex* weldedVertices;
+    uint32_t* remap;
+    uint32_t* weldedIndices;
+    uint32_t* cacheIndices;
+} MeshScratch;
+
+// returns false if an allocation fails
+static bool BuildOptimizedMesh(Mesh mesh, MeshScratch* scratch, Mesh* optimized) {
+    int vertexCount = mesh.vertexCount;
+    int indexCount = mesh.indexCount;
+    for (int i = 0; i < vertexCount; i++) {
+        scratch->vertices[i].position = mesh.positions[i];
+        if (mesh.colors != NULL) {
+            scratch->vertices[i].color = mesh.colors[i];
+        }
+        if (mesh.texCoords != NULL) {
+            scratch->vertices[i].texCoord = mesh.texCoords[i];
+        }
+    }
+
+    uint32_t* remap = scratch->remap;
+    int weldedCount = WeldVertices((const uint8_t*)scratch->vertices, vertexCount, sizeof(WeldVertex), remap);
+    if (weldedCount < 0) {
+        return false;
+    }
+    RemapVertices((uint8_t*)scratch->weldedVertices, (const uint8_t*)scratch->vertices, vertexCount, sizeof(WeldVertex), remap);
+    memcpy(scratch->weldedIndices, mesh.indices, indexCount * sizeof(uint32_t));
+    RemapIndices(scratch->weldedIndices, indexCount, remap);
+
+    if (!OptimizeVertexCache(scratch->cacheIndices, scratch->weldedIndices, indexCount, weldedCount)) {
+        return false;
+    }
+    int usedCount = OptimizeVertexFetch(remap, scratch->cacheIndices, indexCount, weldedCount);
+    RemapIndices(scratch->cacheIndices, indexCount, remap);
+
+    uint64_t size = (uint64_t)usedCount * sizeof(Vec3) + (uint64_t)indexCount * sizeof(uint32_t);
+    size += mesh.colors != NULL ? (uint64_t)usedCount * sizeof(Color) : 0;
+    size += mesh.texCoords != NULL ? (uint64_t)usedCount * sizeof(Vec2) : 0;
+    uint8_t* block = (uint8_t*)malloc(size + 1);
+    if (block == NULL) {
+        return false;
+    }
+
+    Vec3* positions = (Vec3*)block;
+    Color* colors = (Color*)(positions + usedCount);
+    Vec2* texCoords = (Vec2*)(mesh.colors != NULL ? (uint8_t*)(colors + usedCount) : (uint8_t*)colors);
+    uint32_t* indices = (uint32_t*)(mesh.texCoords != NULL ? (uint8_t*)(texCoords + usedCount) : (uint8_t*)texCoords);
+    for (int i = 0; i < weldedCount; i++) {
+        uint32_t v = remap[i];
+        if (v == MESH_UNUSED_VERTEX) {
+            continue;
+        }
+        positions[v] = scratch->weldedVertices[i].position;
+        if (mesh.colors != NULL) {
+            colors[v] = scratch->weldedVertices[i].color;
+        }
+        if (mesh.texCoords != NULL) {
+            texCoords[v] = scratch->weldedVertices[i].texCoord;
+        }
+    }
+    memcpy(indices, scratch->cacheIndices, indexCount * sizeof(uint32_t));
+
+    optimized->positions = positions;
+    optimized->colors = mesh.colors != NULL ? colors : NULL;
+    optimized->texCoords = mesh.texCoords != NULL ? texCoords : NULL;
+    optimized->indices = indices;
+    optimized->vertexCount = usedCount;
+    optimized->indexCount = indexCount;
+    return true;
+}
+
+Mesh OptimizeMesh(Mesh mesh) {
+    Assert(mesh.vertexCount >= 0 && mesh.indexCount >= 0, "Invalid mesh with %d vertices and %d indices",
+            mesh.vertexCount, mesh.indexCount);
+    for (int i = 0; i < mesh.indexCount; i++) {
+        Assert(mesh.indices[i] < (uint32_t)mesh.vertexCount, "Mesh index %u is out of range (%d vertices)",
+                mesh.indices[i], mesh.vertexCount);
+    }
+
+    Mesh optimized = mesh;
+    optimized.positions = NULL;
+    optimized.colors = NULL;
+    optimized.texCoords = NULL;
+    optimized.indices = NULL;
+    optimized.vertexCount = 0;
+    optimized.indexCount = 0;
+
+    // the scratch vertices start zeroed, for the missing attributes
+    MeshScratch scratch = {0};
+    scratch.vertices = (WeldVertex*)calloc(mesh.vertexCount + 1, sizeof(WeldVertex));
+    scratch.weldedVertices = (WeldVertex*)calloc(mesh.vertexCount + 1, sizeof(WeldVertex));
+    scratch.remap = (uint32_t*)malloc((mesh.vertexCount + 1) * sizeof(uint32_t));
+    scratch.weldedIndices = (uint32_t*)malloc((mesh.indexCount + 1) * sizeof(uint32_t));
+    scratch.cacheIndices = (uint32_t*)malloc((mesh.indexCount + 1) * sizeof(uint32_t));
+    bool isAllocated = scratch.vertices != NULL && scratch.weldedVertices != NULL && scratch.remap != NULL
+        && scratch.weldedIndices != NULL && scratch.cacheIndices != NULL;
+
+    if (isAllocated && BuildOptimizedMesh(mesh, &scratch, &optimized)) {
+        LogDebugIn(LOG_CATEGORY_RENDER, "Optimized a mesh from %d to %d vertices\n", mesh.vertexCount, optimized.vertexCount);
+    } else {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to allocate the optimization of a mesh with %d vertices\n", mesh.vertexCount);
+    }
+
+    free(scratch.vertices);
+    free(scratch.weldedVertices);
+    free(scratch.remap);
+    free(scratch.weldedIndices);
+    free(scratch.cacheIndices);
+    return optimized;
+}
+
+void FreeOptimizedMesh(Mesh mesh) {
+    // the positions start the allocation
+    free((void*)mesh.positions);
+}
+
+float GetMeshCacheMissRatio(Mesh mesh) {
+    return GetVertexCacheMissRatio(mesh.indices, mesh.indexCount, mesh.vertexCount, MESH_VERTEX_CACHE_SIZE);
+}
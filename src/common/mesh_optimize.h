@@ -0,0 +1,233 @@
+#ifndef mesh_optimize_h
+#define mesh_optimize_h
+
+/*
+ * Mesh optimization for indexed triangles. Shared by OptimizeMesh and the packer tool.
+ * Vertices are opaque byte strings of a fixed stride, so any vertex layout works.
+ *
+ * WELDING
+ *
+ * Vertices with the same bytes are merged with an open addressing hash table of vertex indices.
+ * The remap table gives the new index of each vertex, in order of first appearance.
+ *
+ * VERTEX CACHE
+ *
+ * Triangles are reordered with Tipsify (Sander, Nehab and Barczak 2007), so that consecutive
+ * triangles share vertices that are still in the post-transform cache. It fans around a vertex,
+ * then picks the next fanning vertex among the ones just emitted, preferring vertices that are
+ * still in the cache and won't leave it while their remaining triangles are emitted. When none is
+ * left, it goes back to the most recent vertex with triangles left, then to the next vertex in order.
+ * It is linear in the triangle count.
+ *
+ * VERTEX FETCH
+ *
+ * Vertices are renumbered in the order the triangles first use them, so the vertex fetches of
+ * consecutive triangles are close in memory. Vertices that no triangle uses are dropped.
+ *
+ * Functions that allocate return -1 (or a negative ratio) when the allocation fails.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_UNUSED_VERTEX 0xffffffffu
+#define MESH_VERTEX_CACHE_SIZE 16
+
+static inline uint32_t HashVertexBytes(const uint8_t* vertex, int stride) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < stride; i++) {
+        hash = (hash ^ vertex[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// fills remap with the welded index of each vertex, returns the welded vertex count
+static inline int WeldVertices(const uint8_t* vertices, int vertexCount, int stride, uint32_t* remap) {
+    int capacity = 16;
+    while (capacity < vertexCount * 2) {
+        capacity *= 2;
+    }
+    int32_t* slots = (int32_t*)malloc(capacity * sizeof(int32_t));
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, 0xff, capacity * sizeof(int32_t));
+
+    int weldedCount = 0;
+    for (int i = 0; i < vertexCount; i++) {
+        const uint8_t* vertex = vertices + (uint64_t)i * stride;
+        int slot = (int)(HashVertexBytes(vertex, stride) & (capacity - 1));
+        while (slots[slot] >= 0 && memcmp(vertices + (uint64_t)slots[slot] * stride, vertex, stride) != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (slots[slot] < 0) {
+            slots[slot] = i;
+            remap[i] = (uint32_t)weldedCount++;
+        } else {
+            remap[i] = remap[slots[slot]];
+        }
+    }
+
+    free(slots);
+    return weldedCount;
+}
+
+// copies each vertex to its remapped index, skipping unused vertices
+static inline void RemapVertices(uint8_t* destination, const uint8_t* vertices, int vertexCount, int stride, const uint32_t* remap) {
+    for (int i = 0; i < vertexCount; i++) {
+        if (remap[i] != MESH_UNUSED_VERTEX) {
+            memcpy(destination + (uint64_t)remap[i] * stride, vertices + (uint64_t)i * stride, stride);
+        }
+    }
+}
+
+static inline void RemapIndices(uint32_t* indices, int indexCount, const uint32_t* remap) {
+    for (int i = 0; i < indexCount; i++) {
+        indices[i] = remap[indices[i]];
+    }
+}
+
+// pops the most recent vertex that still has triangles, or continues the scan in vertex order
+static inline int SkipDeadEnd(const int* liveCounts, int* deadEnds, int* deadEndCount, int* cursor, int vertexCount) {
+    while (*deadEndCount > 0) {
+        int vertex = deadEnds[--*deadEndCount];
+        if (liveCounts[vertex] > 0) {
+            return vertex;
+        }
+    }
+    while (*cursor < vertexCount) {
+        if (liveCounts[*cursor] > 0) {
+            return *cursor;
+        }
+        (*cursor)++;
+    }
+    return -1;
+}
+
+// destination must not overlap the indices, returns false if the allocation fails
+static inline bool OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, int indexCount, int vertexCount) {
+    int triangleCount = indexCount / 3;
+    // triangles of each vertex, as ranges in one array
+    int* triangleStarts = (int*)calloc(vertexCount + 1, sizeof(int));
+    int* liveCounts = (int*)calloc(vertexCount, sizeof(int));
+    int* cacheTimes = (int*)calloc(vertexCount, sizeof(int));
+    int* vertexTriangles = (int*)malloc((triangleCount * 3 + 1) * sizeof(int));
+    int* deadEnds = (int*)malloc((triangleCount * 3 + 1) * sizeof(int));
+    int* candidates = (int*)malloc((triangleCount * 3 + 1) * sizeof(int));
+    bool* isEmitted = (bool*)calloc(triangleCount + 1, sizeof(bool));
+    bool isAllocated = triangleStarts != NULL && liveCounts != NULL && cacheTimes != NULL && vertexTriangles != NULL
+        && deadEnds != NULL && candidates != NULL && isEmitted != NULL;
+
+    if (isAllocated) {
+        for (int i = 0; i < triangleCount * 3; i++) {
+            liveCounts[indices[i]]++;
+        }
+        for (int v = 0; v < vertexCount; v++) {
+            triangleStarts[v + 1] = triangleStarts[v] + liveCounts[v];
+        }
+        // fill from the end of each range, leaving the starts in place
+        int* fills = cacheTimes;
+        for (int v = 0; v < vertexCount; v++) {
+            fills[v] = triangleStarts[v + 1];
+        }
+        for (int i = triangleCount * 3 - 1; i >= 0; i--) {
+            vertexTriangles[--fills[indices[i]]] = i / 3;
+        }
+        memset(cacheTimes, 0, vertexCount * sizeof(int));
+
+        int emittedCount = 0;
+        int deadEndCount = 0;
+        int cursor = 0;
+        int time = MESH_VERTEX_CACHE_SIZE + 1;
+        int fanVertex = SkipDeadEnd(liveCounts, deadEnds, &deadEndCount, &cursor, vertexCount);
+        while (fanVertex >= 0) {
+            int candidateCount = 0;
+            for (int i = triangleStarts[fanVertex]; i < triangleStarts[fanVertex + 1]; i++) {
+                int triangle = vertexTriangles[i];
+                if (isEmitted[triangle]) {
+                    continue;
+                }
+                isEmitted[triangle] = true;
+                for (int k = 0; k < 3; k++) {
+                    uint32_t v = indices[triangle * 3 + k];
+                    destination[emittedCount++] = v;
+                    deadEnds[deadEndCount++] = (int)v;
+                    candidates[candidateCount++] = (int)v;
+                    liveCounts[v]--;
+                    if (time - cacheTimes[v] > MESH_VERTEX_CACHE_SIZE) {
+                        cacheTimes[v] = time++;
+                    }
+                }
+            }
+
+            // the candidate that stays in the cache the longest while its triangles are emitted
+            int nextVertex = -1;
+            int bestPriority = -1;
+            for (int i = 0; i < candidateCount; i++) {
+                int v = candidates[i];
+                if (liveCounts[v] <= 0) {
+                    continue;
+                }
+                int priority = 0;
+                if (time - cacheTimes[v] + 2 * liveCounts[v] <= MESH_VERTEX_CACHE_SIZE) {
+                    priority = time - cacheTimes[v];
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    nextVertex = v;
+                }
+            }
+            fanVertex = nextVertex >= 0 ? nextVertex : SkipDeadEnd(liveCounts, deadEnds, &deadEndCount, &cursor, vertexCount);
+        }
+
+        // a trailing partial triangle is kept as is
+        memcpy(destination + emittedCount, indices + emittedCount, (indexCount - emittedCount) * sizeof(uint32_t));
+    }
+
+    free(triangleStarts);
+    free(liveCounts);
+    free(cacheTimes);
+    free(vertexTriangles);
+    free(deadEnds);
+    free(candidates);
+    free(isEmitted);
+    return isAllocated;
+}
+
+// fills remap with the new index of each vertex in order of first use, returns the used vertex count
+static inline int OptimizeVertexFetch(uint32_t* remap, const uint32_t* indices, int indexCount, int vertexCount) {
+    memset(remap, 0xff, vertexCount * sizeof(uint32_t));
+    int usedCount = 0;
+    for (int i = 0; i < indexCount; i++) {
+        if (remap[indices[i]] == MESH_UNUSED_VERTEX) {
+            remap[indices[i]] = (uint32_t)usedCount++;
+        }
+    }
+    return usedCount;
+}
+
+// transformed vertices per triangle with a FIFO post-transform cache, from 3 down to about 0.5 for a regular grid
+static inline float GetVertexCacheMissRatio(const uint32_t* indices, int indexCount, int vertexCount, int cacheSize) {
+    if (indexCount < 3) {
+        return 0;
+    }
+    // the miss count when each vertex entered the cache, 0 if never
+    uint32_t* entries = (uint32_t*)calloc(vertexCount, sizeof(uint32_t));
+    if (entries == NULL) {
+        return -1;
+    }
+    uint32_t missCount = 0;
+    for (int i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i];
+        if (entries[v] == 0 || missCount - entries[v] >= (uint32_t)cacheSize) {
+            missCount++;
+            entries[v] = missCount;
+        }
+    }
+    free(entries);
+    return (float)missCount / (indexCount / 3);
+}
+
+#endif
@@ -20,8 +20,123 @@
  * - apply a user defined transform (defaults to the identity matrix)
  * - apply a camera transform (either 2D or 3D)
  * - pass through the given position and color
+ *
+ * All shader programs, including custom ones, share a vertex shader prelude
+ * with the vertex inputs, the camera block and the transform. Uniform locations
+ * are looked up once per program. The transform and camera index are uniforms,
+ * which are program state, so each program tracks what was last uploaded to it.
+ *
+ * Linked shader programs can be cached on disk as program binaries, keyed by a hash
+ * of the shader source and the driver. A cache miss or a rejected binary
+ * falls back to compiling from source, after which the cache entry is rewritten.
+ *
+ * CAMERAS
+ *
+ * The camera transforms of all camera slots are stored in a uniform buffer.
+ * A draw call selects a camera by passing the slot index as a uniform.
+ * Only slots with a changed camera version are uploaded, right before
+ * the next draw call.
+ *
+ * TEXTURES
+ *
+ * Every vertex has texture coordinates, and every triangle samples a texture.
+ * Untextured shapes use texture 0, which is a single white pixel, so they can be
+ * batched together with sprites. Sprites from the same texture atlas page share a texture.
+ *
+ * MATERIALS
+ *
+ * A material is a shader program plus a parameter block. The parameters of all
+ * materials live in one uniform buffer, with one aligned range per material.
+ * The CPU copy is uploaded as a single range covering the changed materials,
+ * and a draw binds the range of its material with glBindBufferRange.
+ *
+ * Every batched triangle belongs to a batch run (a range of vertex indices with the same material and texture).
+ * Before a draw call, the runs are regrouped by material and texture so that each
+ * combination is drawn once. Regrouping only reorders the indices, not the vertices.
+ * It is skipped when blending, since blending depends on the draw order. Opaque triangles
+ * at the same depth can change order, which libgame.h documents as unspecified.
+ *
+ * WEIGHTED TRANSPARENCY
+ *
+ * Weighted blended order independent transparency (McGuire and Bavoil 2013). The transparent draws
+ * of a pass go into two offscreen textures: a sum of the weighted premultiplied colors, with the
+ * product of (1 - alpha) in its alpha channel, and a sum of the weighted alphas. The weight favours
+ * fragments close to the camera. Both sums are independent of the draw order, so the batch runs are
+ * regrouped like opaque ones. When the pass ends, a full screen triangle composites the weighted
+ * average color over the framebuffer. GL 3.3 has no per attachment blending, so one separate
+ * blend function does the sums on the color channels and the product on the alpha channel.
+ *
+ * The pass is depth tested against the opaque depth. A render target's depth buffer is attached
+ * directly, the window's depth is copied. The pass ends when transparency is disabled, and before
+ * anything else reads or writes the framebuffer (end of frame, target switches, clears and so on).
+ *
+ * Shaders are used in the pass through a variant, compiled on first use, that renames their main
+ * and writes the sums from FragColor. The variant needs FragColor to be the only output, declared as
+ * "out vec4 FragColor;" with any spacing, comments or layout qualifier. Other shaders are drawn as is
+ * with a warning, which is not correct but keeps them visible.
+ *
+ * DEBUG LINES
+ *
+ * Debug lines have a separate vertex array with a compact vertex (position and a packed color),
+ * and are drawn with GL_LINES by a minimal shader after the regular draw calls of the frame.
+ * The buffer is orphaned and refilled once per frame. Depth tested lines are tested against
+ * the depth buffer without writing to it, and overlay lines skip the depth test.
+ *
+ * STATS
+ *
+ * Draw calls, binds and uploads are counted as they happen. The counters of a frame
+ * are kept at the end of the frame, so that GetRenderStats reports a whole frame.
+ * The shaded samples are reported for the latest frame that the GPU has finished.
+ *
+ * RENDER TARGETS
+ *
+ * A render target is a framebuffer object with a color texture and a depth renderbuffer.
+ * The color texture is a regular texture, so it can be drawn like any other.
+ * Draw calls can render into a region in the bottom left of the target, which lets dynamic
+ * resolution change the resolution every frame without reallocating. Rows are stored bottom up,
+ * unlike uploaded images. Switching targets issues the pending draw call.
+ *
+ * DEPTH PREPASS
+ *
+ * With the depth prepass mode, the opaque batch runs of a draw call are drawn twice. First only
+ * their depth, with a variant of their shader that has an empty fragment shader, then their color
+ * with GL_EQUAL, so each pixel is shaded once however much the graphics overlap. The vertex prelude
+ * declares gl_Position invariant, so both programs compute the same depth. Shaders that may discard
+ * fragments use their regular program in the depth pass. Overlapping graphics at the same depth
+ * are all shaded, and the last one drawn stays visible.
+ *
+ * OVERDRAW
+ *
+ * The samples passing the depth test during color draws are counted with GL_SAMPLES_PASSED queries,
+ * one per span of color draws, since the depth prepass, debug lines and the weighted composite pass
+ * are excluded. A frame uses at most 64 spans, the last one runs to the end of the frame. The counts
+ * are read a few frames later like the GPU timers. Each span is divided by the pixels of the viewport
+ * it drew into, which is smaller than the window with dynamic resolution, and a render target switch
+ * starts a new span.
+ *
+ * GPU TIMERS
+ *
+ * GPU time is measured with GL_TIME_ELAPSED queries in a small ring, and read back a few
+ * frames later, once available, so the CPU never waits for the result.
+ *
+ * READBACK
+ *
+ * The back buffer is copied into a pixel buffer object in a small ring, with a fence after the copy.
+ * The copy is queued on the GPU like a draw call, so the CPU doesn't wait for it. A buffer is only
+ * mapped once its fence is signaled, usually two frames later. If every buffer is still pending,
+ * the request fails, so the caller can decide to wait.
+ *
+ * FRAME PACING
+ *
+ * A fence is inserted after each presented frame, in a small ring. At the end of a frame the
+ * signaled fences are collected in order, which tells when the GPU finished each frame.
+ * To limit the frames in flight, the CPU waits with glClientWaitSync on the fence of an
+ * older frame, which unlike glFinish does not drain the work of the newer frames.
  */
+#include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #define LIBGAME_WITH_OPENGL_PREREQS
 #define LIBGAME_WITH_OPENGL_330
 #include "opengl_render.h"
@@ -36,7 +151,7 @@ static int clientHeight = 0;
 static GLuint VAO, VBO;
 static GLfloat* vertices = NULL;
 static int maxVertices = LIBGAME_DEFAULT_MAX_VERTICES;
-static int valuesPerVertex = 7; // 3 coordinates + 4 color channels
+static int valuesPerVertex = RENDER_FLOATS_PER_VERTEX;
 static int currentVertexCount = 0;
 static int currentVertexStart = 0;
 
@@ -46,36 +161,195 @@ static int maxVertexIndices = LIBGAME_DEFAULT_MAX_INDICES;
 static int currentVertexIndexCount = 0;
 static int currentVertexIndexStart = 0;
 
-static const char* defaultVertexShaderSrc = "#version 330 core\n"
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+static const char* vertexShaderPrelude = "#version 330 core\n"
     "layout(location = 0) in vec3 position;\n"
     "layout(location = 1) in vec4 color;\n"
-    "uniform mat4 cameraTransform;\n"
+    "layout(location = 2) in vec2 texCoord;\n"
+    "layout(std140) uniform CameraBlock {\n"
+    "    mat4 cameraTransforms[" TO_STRING(LIBGAME_MAX_CAMERAS) "];\n"
+    "};\n"
+    "uniform int cameraIndex;\n"
     "uniform mat4 transform;\n"
+    "// the depth prepass and the color pass must compute the same depth in different programs\n"
+    "invariant gl_Position;\n"
+    "vec4 TransformPosition(vec3 p) {\n"
+    "    return cameraTransforms[cameraIndex] * transform * vec4(p, 1.0);\n"
+    "}\n"
+    "#line 1\n";
+
+static const char* fragmentShaderPrelude = "#version 330 core\n"
+    "uniform sampler2D textureSampler;\n"
+    "#line 1\n";
+
+static const char* defaultVertexShaderSrc =
     "out vec4 fragColor;\n"
+    "out vec2 fragTexCoord;\n"
     "void main() {\n"
-    "    gl_Position = cameraTransform * transform * vec4(position, 1.0);\n"
+    "    gl_Position = TransformPosition(position);\n"
     "    fragColor = color;\n"
+    "    fragTexCoord = texCoord;\n"
     "}";
 
-static const char* defaultFragmentShaderSrc = "#version 330 core\n"
+static const char* defaultFragmentShaderSrc =
     "in vec4 fragColor;\n"
+    "in vec2 fragTexCoord;\n"
     "out vec4 FragColor;\n"
     "void main() {\n"
-    "    FragColor = fragColor;\n"
+    "    FragColor = fragColor * texture(textureSampler, fragTexCoord);\n"
+    "}";
+
+static const char* depthOnlyFragmentShaderSrc =
+    "void main() {\n"
     "}";
-static GLuint defaultShaderProgram;
-static GLint cameraTransformLoc;
-static GLint transformLoc;
+
+static const char* weightedShaderPrologue = "#define main ShadeWeightedFragment\n#line 1\n";
+
+static const char* weightedShaderEpilogue = "\n"
+    "#undef main\n"
+    "layout(location = 0) out vec4 weightedColor;\n"
+    "layout(location = 1) out vec4 weightedAlpha;\n"
+    "void main() {\n"
+    "    ShadeWeightedFragment();\n"
+    "    vec4 color = FragColor;\n"
+    "    float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);\n"
+    "    weightedColor = vec4(color.rgb * color.a * weight, color.a);\n"
+    "    weightedAlpha = vec4(color.a * weight);\n"
+    "}\n";
+
+typedef struct {
+    GLuint program;
+    GLint cameraIndexLoc;
+    GLint transformLoc;
+    int uploadedCameraSlot;
+    uint32_t uploadedTransformVersion;
+} ShaderGl;
+
+// variants of a shader for other passes, created on first use from the kept sources
+typedef struct {
+    char* vertexSrc;
+    char* fragmentSrc;
+    ShaderGl weighted; // program 0 until created
+    ShaderGl depthOnly;
+    bool canBeWeighted; // declares the output the weighted variant needs
+    bool didWarnUnweighted;
+    int weightedQualifierStart; // the output qualifiers that the weighted variant removes
+    int weightedQualifierEnd;
+    bool canDiscard; // the depth only pass needs the regular program and its textures
+} ShaderVariantsGl;
+
+static ShaderGl shaders[LIBGAME_MAX_SHADERS];
+static ShaderVariantsGl shaderVariants[LIBGAME_MAX_SHADERS];
+static int shaderCount = 0;
+static GLuint boundProgram = 0;
+
+static const char* shaderCacheDirectory = NULL;
+static bool isProgramBinarySupported = false;
+
+#define SHADER_CACHE_MAGIC 0x43534c47 // "GLSC"
+#define SHADER_CACHE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+} ShaderCacheHeader;
+
+static const GLuint cameraBlockBinding = 0;
+static GLuint cameraUBO;
+static uint32_t uploadedCameraVersions[LIBGAME_MAX_CAMERAS];
+static int currentCameraSlot = 0;
+
+typedef struct {
+    int shaderId;
+} MaterialGl;
+
+typedef struct {
+    int materialId;
+    int textureId;
+    int indexStart;
+    int indexCount;
+} BatchRun;
+
+static const GLuint materialBlockBinding = 1;
+static GLuint materialUBO;
+static MaterialGl materials[LIBGAME_MAX_MATERIALS];
+static int materialCount = 0;
+static uint8_t* materialParams = NULL; // CPU copy of the uniform buffer
+static int materialParamsStride = 0; // params size rounded up to the uniform buffer offset alignment
+static int dirtyMaterialMin = LIBGAME_MAX_MATERIALS;
+static int dirtyMaterialMax = -1;
+static int currentMaterialId = 0;
+static int boundMaterialId = -1;
+
+typedef struct {
+    GLuint handle;
+    int width;
+    int height;
+} TextureGl;
+
+static TextureGl textures[LIBGAME_MAX_TEXTURES];
+static int textureCount = 0;
+static int boundTextureId = -1;
+
+static BatchRun* batchRuns = NULL;
+static int maxBatchRuns = 0;
+static int batchRunCount = 0;
+static int batchRunStart = 0;
+// the buffers for grouping the pending batch runs, sized like batchRuns and vertexIndices
+static BatchRun* sortedBatchRuns = NULL;
+static BatchRun* sortTempBatchRuns = NULL;
+static GLuint* sortedVertexIndices = NULL;
+
+static bool isTransparencyEnabled = false;
+static TransparencyMethod transparencyMethod = TRANSPARENCY_SORTED;
+static bool isWeightedPassActive = false;
+static bool isDepthPrepassEnabled = false;
+static bool isDepthPrepassActive = false; // drawing the depth of the batch runs
+
+static GLuint debugLineVAO, debugLineVBO;
+static int debugLineShaderId = -1;
+
+static RenderStats frameStats = {0};
+static RenderStats lastFrameStats = {0};
+
+typedef struct {
+    GLuint framebuffer;
+    GLuint depthBuffer;
+    int textureId;
+} RenderTargetGl;
+
+static RenderTargetGl renderTargets[LIBGAME_MAX_RENDER_TARGETS];
+static int renderTargetCount = 0;
+static int currentRenderTargetId = -1; // -1 for the window
+static int viewportWidth = 0;
+static int viewportHeight = 0;
 
 // OpenGL friendly flattened 4x4 matrix
 typedef struct {
     float m[16]; 
 } RenderTransform;
 static RenderTransform defaultTransform = {0};
+static RenderTransform currentTransform = {0};
+static bool isDefaultTransform = true;
+static uint32_t transformVersion = 0;
 
 static RenderTransform Mat4ToRenderTransform(Mat4 mat);
 static void ResetTransform();
-static void UpdateCameraTransform();
+static GLuint CreateShaderProgram(const char* vertexSrc, const char* fragmentSrc);
+static void UploadCameraTransforms();
+static void UploadMaterialParams();
+static void BeginWeightedPass();
+static void EndWeightedPass();
+static void ApplyBlendState();
+static void DrawDepthPrepass();
+static void ResumeOverdrawQuery();
+static void PauseOverdrawQuery();
+static void FinishOverdrawFrame();
 
 static const char* MapOpenGlError(GLenum err) {
     switch(err) {
@@ -120,51 +394,78 @@ void ConfigureRenderGl(RenderSettings settings) {
             "This can happen if you have already created a window.");
     maxVertices = settings.maxVertices;
     maxVertexIndices = settings.maxVertexIndices;
+    shaderCacheDirectory = settings.shaderCacheDirectory;
 }
 
 void SetResolutionGl(int width, int height) {
-    glViewport(0, 0, width, height);
+    if (currentRenderTargetId < 0) {
+        EndWeightedPass();
+        glViewport(0, 0, width, height);
+        viewportWidth = width;
+        viewportHeight = height;
+    }
     clientWidth = width;
     clientHeight = height;
     SetCameraClientArea(width, height);
-    UpdateCameraTransform();
 }
 
 void InitGraphicsGl(OpenGlExt ext) {
     openGlExt = ext;
-    int success;
 
-    // -- Default shaders --
-
-    GLuint vertexShader = openGlExt.glCreateShader(GL_VERTEX_SHADER);
-    openGlExt.glShaderSource(vertexShader, 1, &defaultVertexShaderSrc, NULL);
-    openGlExt.glCompileShader(vertexShader);
-    openGlExt.glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    Assert(success, "Failed to compile vertex shader");
-
-    GLuint fragmentShader = openGlExt.glCreateShader(GL_FRAGMENT_SHADER);
-    openGlExt.glShaderSource(fragmentShader, 1, &defaultFragmentShaderSrc, NULL);
-    openGlExt.glCompileShader(fragmentShader);
-    openGlExt.glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    Assert(success, "Failed to compile fragment shader");
-
-    defaultShaderProgram = openGlExt.glCreateProgram();
-    openGlExt.glAttachShader(defaultShaderProgram, vertexShader);
-    openGlExt.glAttachShader(defaultShaderProgram, fragmentShader);
-    openGlExt.glLinkProgram(defaultShaderProgram);
-    openGlExt.glGetProgramiv(defaultShaderProgram, GL_LINK_STATUS, &success);
-    Assert(success, "Failed to link shader program");
+    LogDebugIn(LOG_CATEGORY_RENDER, "OpenGL %s (%s, %s)\n", glGetString(GL_VERSION), glGetString(GL_VENDOR), glGetString(GL_RENDERER));
 
-    openGlExt.glDeleteShader(vertexShader);
-    openGlExt.glDeleteShader(fragmentShader);
+    // -- Shader cache --
 
-    openGlExt.glUseProgram(defaultShaderProgram);
+    if (openGlExt.glGetProgramBinary != NULL && openGlExt.glProgramBinary != NULL && openGlExt.glProgramParameteri != NULL) {
+        GLint binaryFormatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+        isProgramBinarySupported = binaryFormatCount > 0;
+    }
+    if (shaderCacheDirectory != NULL && !isProgramBinarySupported) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Shader cache disabled. The driver does not support program binaries.\n");
+    }
 
-    cameraTransformLoc = openGlExt.glGetUniformLocation(defaultShaderProgram, "cameraTransform");
-    UpdateCameraTransform();
-    transformLoc = openGlExt.glGetUniformLocation(defaultShaderProgram, "transform");
     defaultTransform = Mat4ToRenderTransform(Mat4Identity());
-    ResetTransform();
+    currentTransform = defaultTransform;
+
+    // -- Camera uniform buffer --
+
+    openGlExt.glGenBuffers(1, &cameraUBO);
+    openGlExt.glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    openGlExt.glBufferData(GL_UNIFORM_BUFFER, LIBGAME_MAX_CAMERAS * sizeof(RenderTransform), NULL, GL_DYNAMIC_DRAW);
+    openGlExt.glBindBufferBase(GL_UNIFORM_BUFFER, cameraBlockBinding, cameraUBO);
+
+    // force an upload of every slot before the first draw call
+    for (int i = 0; i < LIBGAME_MAX_CAMERAS; i++) {
+        uploadedCameraVersions[i] = GetCameraTransformVersion(i) - 1;
+    }
+
+    // -- Material uniform buffer --
+
+    GLint uniformOffsetAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformOffsetAlignment);
+    uniformOffsetAlignment = uniformOffsetAlignment > 0 ? uniformOffsetAlignment : 256;
+    materialParamsStride = (LIBGAME_MAX_MATERIAL_PARAMS_SIZE + uniformOffsetAlignment - 1) / uniformOffsetAlignment * uniformOffsetAlignment;
+
+    int materialBufferSize = LIBGAME_MAX_MATERIALS * materialParamsStride;
+    materialParams = (uint8_t*)calloc(1, materialBufferSize);
+    Assert(materialParams != NULL, "Failed to allocate material parameters");
+
+    openGlExt.glGenBuffers(1, &materialUBO);
+    openGlExt.glBindBuffer(GL_UNIFORM_BUFFER, materialUBO);
+    openGlExt.glBufferData(GL_UNIFORM_BUFFER, materialBufferSize, materialParams, GL_DYNAMIC_DRAW);
+
+    // -- Default shader and material --
+
+    // the default shader and material get id 0
+    CreateShaderGl(defaultVertexShaderSrc, defaultFragmentShaderSrc);
+    CreateMaterialGl(0);
+
+    // -- Default texture --
+
+    // texture 0 is white, so that untextured shapes keep their color
+    uint8_t whitePixel[4] = { 255, 255, 255, 255 };
+    CreateTextureGl(whitePixel, 1, 1);
 
     // -- Vertex buffer for triangles --
 
@@ -190,12 +491,25 @@ void InitGraphicsGl(OpenGlExt ext) {
 
     openGlExt.glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxVertexIndexBufferSize, vertexIndices, GL_DYNAMIC_DRAW);
 
+    // at most one material run per triangle
+    maxBatchRuns = maxVertexIndices / 3 + 1;
+    batchRuns = (BatchRun*)malloc(maxBatchRuns * sizeof(BatchRun));
+    Assert(batchRuns != NULL, "Failed to allocate batch runs");
+
+    sortedBatchRuns = (BatchRun*)malloc(maxBatchRuns * sizeof(BatchRun));
+    sortTempBatchRuns = (BatchRun*)malloc(maxBatchRuns * sizeof(BatchRun));
+    sortedVertexIndices = (GLuint*)malloc(maxVertexIndexBufferSize);
+    Assert(sortedBatchRuns != NULL && sortTempBatchRuns != NULL && sortedVertexIndices != NULL, "Failed to allocate batch run sort buffers");
+
     // position attribute
     openGlExt.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, valuesPerVertex * sizeof(GLfloat), (GLvoid*)0);
     openGlExt.glEnableVertexAttribArray(0);
     // color attribute
     openGlExt.glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, valuesPerVertex * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
     openGlExt.glEnableVertexAttribArray(1);
+    // texture coordinate attribute
+    openGlExt.glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, valuesPerVertex * sizeof(GLfloat), (GLvoid*)(7 * sizeof(GLfloat)));
+    openGlExt.glEnableVertexAttribArray(2);
 
     /*
      * Always enable depth testing, regardless of transparency mode.
@@ -209,162 +523,1495 @@ void InitGraphicsGl(OpenGlExt ext) {
     AssertNoGlError("Failed to initialize OpenGL");
 }
 
-static inline int Mat4PosToIndex(int x, int y) {
-    return x * 4 + y; // transpose, because OpenGL matrices are column-major
+// -- Shader programs --
+
+static GLuint CompileShader(GLenum type, const char* src) {
+    const char* sources[2] = { type == GL_VERTEX_SHADER ? vertexShaderPrelude : fragmentShaderPrelude, src };
+    GLuint shader = openGlExt.glCreateShader(type);
+    openGlExt.glShaderSource(shader, 2, sources, NULL);
+    openGlExt.glCompileShader(shader);
+
+    int success;
+    openGlExt.glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    Assert(success, "Failed to compile %s shader", type == GL_VERTEX_SHADER ? "vertex" : "fragment");
+
+    return shader;
 }
 
-static RenderTransform Mat4ToRenderTransform(Mat4 mat) {
-    RenderTransform trans = {{0}};
-    for (int y = 0; y < 4; y++) {
-        for (int x = 0; x < 4; x++) {
-            trans.m[Mat4PosToIndex(x, y)] = mat.m[y][x];
+static GLuint LinkShaderProgram(const char* vertexSrc, const char* fragmentSrc) {
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSrc);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSrc);
+
+    GLuint program = openGlExt.glCreateProgram();
+    if (isProgramBinarySupported) {
+        openGlExt.glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    openGlExt.glAttachShader(program, vertexShader);
+    openGlExt.glAttachShader(program, fragmentShader);
+    openGlExt.glLinkProgram(program);
+
+    int success;
+    openGlExt.glGetProgramiv(program, GL_LINK_STATUS, &success);
+    Assert(success, "Failed to link shader program");
+
+    openGlExt.glDeleteShader(vertexShader);
+    openGlExt.glDeleteShader(fragmentShader);
+
+    return program;
+}
+
+// FNV-1a
+static uint64_t HashString(uint64_t hash, const char* s) {
+    for (; *s != '\0'; s++) {
+        hash ^= (uint8_t)*s;
+        hash *= 0x100000001b3ULL;
+    }
+    // separator, so that "ab" + "c" and "a" + "bc" differ
+    hash ^= 0xff;
+    hash *= 0x100000001b3ULL;
+    return hash;
+}
+
+static uint64_t GetShaderCacheKey(const char* vertexSrc, const char* fragmentSrc) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = HashString(hash, vertexShaderPrelude);
+    hash = HashString(hash, fragmentShaderPrelude);
+    hash = HashString(hash, vertexSrc);
+    hash = HashString(hash, fragmentSrc);
+    hash = HashString(hash, (const char*)glGetString(GL_VENDOR));
+    hash = HashString(hash, (const char*)glGetString(GL_RENDERER));
+    hash = HashString(hash, (const char*)glGetString(GL_VERSION));
+    return hash;
+}
+
+static void GetShaderCachePath(uint64_t key, char* path, int pathSize) {
+    snprintf(path, pathSize, "%s/shader_%016llx.bin", shaderCacheDirectory, (unsigned long long)key);
+}
+
+// returns 0 on a cache miss or if the driver rejects the binary
+static GLuint LoadCachedShaderProgram(uint64_t key) {
+    char path[512];
+    GetShaderCachePath(key, path, sizeof(path));
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    GLuint program = 0;
+    ShaderCacheHeader header = {0};
+    bool isValid = fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == SHADER_CACHE_MAGIC
+        && header.version == SHADER_CACHE_VERSION
+        && header.key == key
+        && header.binaryLength > 0;
+
+    void* binary = isValid ? malloc(header.binaryLength) : NULL;
+    if (binary != NULL && fread(binary, header.binaryLength, 1, file) == 1) {
+        program = openGlExt.glCreateProgram();
+        openGlExt.glProgramBinary(program, header.binaryFormat, binary, header.binaryLength);
+
+        int success;
+        openGlExt.glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            LogDebugIn(LOG_CATEGORY_RENDER, "Cached shader program %s was rejected by the driver\n", path);
+            openGlExt.glDeleteProgram(program);
+            program = 0;
         }
     }
 
-    return trans;
+    free(binary);
+    fclose(file);
+
+    // clear errors from a rejected binary, so they are not reported later
+    while (glGetError() != GL_NO_ERROR);
+
+    return program;
 }
 
-void SetTransformGl(Mat4 mat) {
-    RenderTransform transform = Mat4ToRenderTransform(mat);
-    openGlExt.glUniformMatrix4fv(transformLoc, 1, false, transform.m);
+static void StoreCachedShaderProgram(uint64_t key, GLuint program) {
+    GLint binaryLength = 0;
+    openGlExt.glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+        return;
+    }
+
+    void* binary = malloc(binaryLength);
+    Assert(binary != NULL, "Failed to allocate shader program binary");
+
+    ShaderCacheHeader header = {0};
+    GLenum binaryFormat = 0;
+    openGlExt.glGetProgramBinary(program, binaryLength, NULL, &binaryFormat, binary);
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = binaryLength;
+
+    char path[512];
+    GetShaderCachePath(key, path, sizeof(path));
+
+    FILE* file = fopen(path, "wb");
+    if (file != NULL) {
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(binary, binaryLength, 1, file);
+        fclose(file);
+    } else {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to write shader cache file %s\n", path);
+    }
+
+    free(binary);
 }
 
-static void ResetTransform() {
-    openGlExt.glUniformMatrix4fv(transformLoc, 1, false, defaultTransform.m);
+static GLuint CreateShaderProgram(const char* vertexSrc, const char* fragmentSrc) {
+    uint64_t ticksStart = GetTicks();
+    bool isCacheEnabled = shaderCacheDirectory != NULL && isProgramBinarySupported;
+    uint64_t key = isCacheEnabled ? GetShaderCacheKey(vertexSrc, fragmentSrc) : 0;
+
+    GLuint program = isCacheEnabled ? LoadCachedShaderProgram(key) : 0;
+    if (program != 0) {
+        LogDebugIn(LOG_CATEGORY_RENDER, "Loaded shader program %016llx from cache in %.2f ms\n",
+                (unsigned long long)key, (GetTicks() - ticksStart) / 1000.0);
+        return program;
+    }
+
+    program = LinkShaderProgram(vertexSrc, fragmentSrc);
+    if (isCacheEnabled) {
+        StoreCachedShaderProgram(key, program);
+    }
+    LogDebugIn(LOG_CATEGORY_RENDER, "Compiled shader program %016llx from source in %.2f ms\n",
+            (unsigned long long)key, (GetTicks() - ticksStart) / 1000.0);
+
+    return program;
 }
 
-void SetCamera2DGl(Camera2D* camera) {
-    SetCameraTransform2D(camera);
-    UpdateCameraTransform();
+static ShaderGl InitShader(const char* vertexSrc, const char* fragmentSrc) {
+    ShaderGl shader = {0};
+    shader.program = CreateShaderProgram(vertexSrc, fragmentSrc);
+    shader.cameraIndexLoc = openGlExt.glGetUniformLocation(shader.program, "cameraIndex");
+    shader.transformLoc = openGlExt.glGetUniformLocation(shader.program, "transform");
+    shader.uploadedCameraSlot = -1;
+    shader.uploadedTransformVersion = transformVersion - 1;
+
+    GLuint cameraBlockIndex = openGlExt.glGetUniformBlockIndex(shader.program, "CameraBlock");
+    if (cameraBlockIndex != GL_INVALID_INDEX) {
+        openGlExt.glUniformBlockBinding(shader.program, cameraBlockIndex, cameraBlockBinding);
+    }
+    GLuint materialBlockIndex = openGlExt.glGetUniformBlockIndex(shader.program, "MaterialBlock");
+    if (materialBlockIndex != GL_INVALID_INDEX) {
+        openGlExt.glUniformBlockBinding(shader.program, materialBlockIndex, materialBlockBinding);
+    }
+
+    // all textures are bound to unit 0
+    openGlExt.glUseProgram(shader.program);
+    boundProgram = shader.program;
+    openGlExt.glUniform1i(openGlExt.glGetUniformLocation(shader.program, "textureSampler"), 0);
+
+    AssertNoGlError("Failed to create shader");
+
+    return shader;
 }
 
-void SetCamera3DGl(Camera3D* camera) {
-    SetCameraTransform3D(camera);
-    UpdateCameraTransform();
+// returns the end of the next GLSL token after whitespace and comments, or NULL at the end
+static const char* NextShaderToken(const char* s, const char** token) {
+    for (;;) {
+        while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r') {
+            s++;
+        }
+        if (s[0] == '/' && s[1] == '/') {
+            while (*s != '\0' && *s != '\n') {
+                s++;
+            }
+        } else if (s[0] == '/' && s[1] == '*') {
+            const char* end = strstr(s + 2, "*/");
+            s = end != NULL ? end + 2 : s + strlen(s);
+        } else {
+            break;
+        }
+    }
+    if (*s == '\0') {
+        return NULL;
+    }
+
+    *token = s;
+    bool isWord = (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z') || *s == '_';
+    if (!isWord) {
+        return s + 1;
+    }
+    while ((*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z') || (*s >= '0' && *s <= '9') || *s == '_') {
+        s++;
+    }
+    return s;
 }
 
-static void UpdateCameraTransform() {
-    Mat4 mat = GetCameraTransform();
-    RenderTransform transform = Mat4ToRenderTransform(mat);
-    openGlExt.glUniformMatrix4fv(cameraTransformLoc, 1, false, transform.m);
+static bool IsShaderToken(const char* token, const char* end, const char* text) {
+    size_t length = strlen(text);
+    return (size_t)(end - token) == length && memcmp(token, text, length) == 0;
 }
 
-void MakeDrawCallGl() {
-    //  update vertices
-    int length = currentVertexCount - currentVertexStart;
-    int offset = currentVertexStart * valuesPerVertex * sizeof(GLfloat);
-    int size = length * valuesPerVertex * sizeof(GLfloat);
-    openGlExt.glBufferSubData(GL_ARRAY_BUFFER, offset, size, &vertices[currentVertexStart * valuesPerVertex]);
+// whole tokens outside of comments, so "discardMask" or "// no discard" don't match
+static bool HasShaderToken(const char* src, const char* text) {
+    const char* token = NULL;
+    const char* s = src;
+    while ((s = NextShaderToken(s, &token)) != NULL) {
+        if (IsShaderToken(token, s, text)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    // update indicies
-    int indexLength = currentVertexIndexCount - currentVertexIndexStart;
-    int indexOffset = currentVertexIndexStart * sizeof(GLuint);
-    int indexSize = indexLength * sizeof(GLuint);
-    openGlExt.glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset, indexSize, &vertexIndices[currentVertexIndexStart]);
+// reads the next token and checks that it is the given text
+static const char* ExpectShaderToken(const char* s, const char* text) {
+    const char* token = NULL;
+    const char* end = s != NULL ? NextShaderToken(s, &token) : NULL;
+    return end != NULL && IsShaderToken(token, end, text) ? end : NULL;
+}
 
-    glDrawElements(GL_TRIANGLES, indexLength, GL_UNSIGNED_INT, (void*)(uintptr_t)(currentVertexIndexStart * sizeof(GLuint)));
+/*
+ * Finds the qualifiers of "[layout(...)] out vec4 FragColor;", which must be the only output
+ * at global scope. Output parameters of functions are inside parentheses, so they are not counted.
+ */
+static bool FindWeightedQualifier(const char* src, int* start, int* end) {
+    int outputCount = 0;
+    bool isFragColor = false;
+    int depth = 0;
+    const char* layout = NULL;
+    const char* token = NULL;
+    const char* s = src;
+    while ((s = NextShaderToken(s, &token)) != NULL) {
+        if (*token == '(' || *token == '{') {
+            depth++;
+        } else if (*token == ')' || *token == '}') {
+            depth--;
+        }
+        if (depth != 0 || *token == ')') {
+            continue;
+        }
 
-    AssertNoGlError("Failed to draw");
-    ResetTransform();
-    currentVertexStart = currentVertexCount;
-    currentVertexIndexStart = currentVertexIndexCount;
+        if (*token == ';' || *token == '}') {
+            layout = NULL;
+        } else if (IsShaderToken(token, s, "layout")) {
+            layout = token;
+        } else if (IsShaderToken(token, s, "out")) {
+            outputCount++;
+            const char* declarationEnd = ExpectShaderToken(ExpectShaderToken(ExpectShaderToken(s, "vec4"), "FragColor"), ";");
+            if (declarationEnd != NULL) {
+                isFragColor = true;
+                *start = (int)((layout != NULL ? layout : token) - src);
+                *end = (int)(s - src);
+            }
+        }
+    }
+    return isFragColor && outputCount == 1;
 }
 
-void EndFrameGl() {
-    currentVertexCount = 0;
-    currentVertexStart = 0;
-    currentVertexIndexCount = 0;
-    currentVertexIndexStart = 0;
+static char* CopyShaderSource(const char* src) {
+    size_t size = strlen(src) + 1;
+    char* copy = (char*)malloc(size);
+    Assert(copy != NULL, "Failed to allocate shader source");
+    memcpy(copy, src, size);
+    return copy;
 }
 
-void ClearScreenGl(Color color) {
-    glClearColor(color.r, color.g, color.b, color.a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+int CreateShaderGl(const char* vertexSrc, const char* fragmentSrc) {
+    Assert(materialParams != NULL, "Unable to create shader. The window has not been created yet.");
+    Assert(shaderCount < LIBGAME_MAX_SHADERS, "Too many shaders. Max is %d.", LIBGAME_MAX_SHADERS);
+
+    int id = shaderCount++;
+    shaders[id] = InitShader(vertexSrc, fragmentSrc);
+
+    ShaderVariantsGl* variants = &shaderVariants[id];
+    *variants = (ShaderVariantsGl){0};
+    variants->vertexSrc = CopyShaderSource(vertexSrc);
+    variants->fragmentSrc = CopyShaderSource(fragmentSrc);
+    variants->canBeWeighted = FindWeightedQualifier(fragmentSrc, &variants->weightedQualifierStart, &variants->weightedQualifierEnd);
+    variants->canDiscard = HasShaderToken(fragmentSrc, "discard");
+
+    return id;
 }
 
-static void AssertCountWithinBounds(int targetVertexCount, int targetVertexIndexCount) {
-    Assert(targetVertexCount <= maxVertices, "Too many vertices (%d). Max is %d.", targetVertexCount, maxVertices);
-    Assert(targetVertexIndexCount <= maxVertexIndices, "Too many vertex indices (%d). Max is %d.", targetVertexIndexCount, maxVertexIndices);
+static ShaderGl* GetWeightedShader(int shaderId) {
+    ShaderVariantsGl* variants = &shaderVariants[shaderId];
+    if (variants->weighted.program != 0) {
+        return &variants->weighted;
+    }
+    if (!variants->canBeWeighted) {
+        if (!variants->didWarnUnweighted) {
+            LogWarningIn(LOG_CATEGORY_RENDER, "Shader %d is drawn without weighted transparency. "
+                    "It needs \"out vec4 FragColor;\" as its only output.\n", shaderId);
+            variants->didWarnUnweighted = true;
+        }
+        return &shaders[shaderId];
+    }
+
+    // FragColor becomes a regular variable, which the epilogue turns into the weighted sums
+    size_t srcLength = strlen(variants->fragmentSrc);
+    size_t size = strlen(weightedShaderPrologue) + srcLength + strlen(weightedShaderEpilogue) + 1;
+    char* fragmentSrc = (char*)malloc(size);
+    Assert(fragmentSrc != NULL, "Failed to allocate shader source");
+    strcpy(fragmentSrc, weightedShaderPrologue);
+    strcat(fragmentSrc, variants->fragmentSrc);
+    strcat(fragmentSrc, weightedShaderEpilogue);
+    // blank the qualifiers, but keep the line breaks for the line numbers of compile errors
+    char* qualifier = fragmentSrc + strlen(weightedShaderPrologue);
+    for (int i = variants->weightedQualifierStart; i < variants->weightedQualifierEnd; i++) {
+        qualifier[i] = qualifier[i] == '\n' ? '\n' : ' ';
+    }
+
+    variants->weighted = InitShader(variants->vertexSrc, fragmentSrc);
+    free(fragmentSrc);
+    return &variants->weighted;
 }
 
-typedef struct {
-   Vec3* positions;
-   Color* colors;
-   int vertexCount;
-   int* indices;
-   int indexCount;
-} Mesh;
-
-static void DrawMesh(Mesh mesh) {
-    int targetVertexCount = currentVertexCount + mesh.vertexCount;
-    int targetVertexIndexCount = currentVertexIndexCount + mesh.indexCount;
-    AssertCountWithinBounds(targetVertexCount, targetVertexIndexCount);
+static ShaderGl* GetDepthOnlyShader(int shaderId) {
+    ShaderVariantsGl* variants = &shaderVariants[shaderId];
+    if (variants->canDiscard) {
+        return &shaders[shaderId];
+    }
+    if (variants->depthOnly.program == 0) {
+        variants->depthOnly = InitShader(variants->vertexSrc, depthOnlyFragmentShaderSrc);
+    }
+    return &variants->depthOnly;
+}
 
-    for (int i = 0; i < mesh.vertexCount; i++) {
-        Vec3 pos = mesh.positions[i];
-        Color color = mesh.colors[i];
-        int iBuffer = (currentVertexCount + i) * valuesPerVertex;
-        vertices[iBuffer] = pos.x;
-        vertices[iBuffer + 1] = pos.y;
-        vertices[iBuffer + 2] = pos.z;
-        vertices[iBuffer + 3] = color.r;
-        vertices[iBuffer + 4] = color.g;
-        vertices[iBuffer + 5] = color.b;
-        vertices[iBuffer + 6] = color.a;
+static void BindShader(int shaderId) {
+    ShaderGl* shader = &shaders[shaderId];
+    if (isWeightedPassActive) {
+        shader = GetWeightedShader(shaderId);
+    } else if (isDepthPrepassActive) {
+        shader = GetDepthOnlyShader(shaderId);
+    }
+    if (shader->program != boundProgram) {
+        openGlExt.glUseProgram(shader->program);
+        boundProgram = shader->program;
+        frameStats.shaderBinds++;
     }
 
-    for (int i = 0; i < mesh.indexCount; i++) {
-        vertexIndices[currentVertexIndexCount + i] = mesh.indices[i] + currentVertexCount;
+    if (shader->uploadedTransformVersion != transformVersion) {
+        openGlExt.glUniformMatrix4fv(shader->transformLoc, 1, false, currentTransform.m);
+        shader->uploadedTransformVersion = transformVersion;
+    }
+    if (shader->uploadedCameraSlot != currentCameraSlot) {
+        openGlExt.glUniform1i(shader->cameraIndexLoc, currentCameraSlot);
+        shader->uploadedCameraSlot = currentCameraSlot;
     }
+}
 
-    currentVertexCount = targetVertexCount;
-    currentVertexIndexCount = targetVertexIndexCount;
+// -- Materials --
+
+int CreateMaterialGl(int shaderId) {
+    Assert(shaderId < shaderCount, "Invalid shader %d", shaderId);
+    Assert(materialCount < LIBGAME_MAX_MATERIALS, "Too many materials. Max is %d.", LIBGAME_MAX_MATERIALS);
+
+    int id = materialCount++;
+    materials[id].shaderId = shaderId;
+    return id;
 }
 
-void DrawTriangle3DGl(Vec3 a, Vec3 b, Vec3 c, Color color) {
-    Vec3 positions[3] = { a, b, c };
-    Color colors[3] = { color, color, color };
-    int indices[3] = { 0, 1, 2 };
+void SetMaterialParamsGl(int materialId, const void* params, int size) {
+    Assert(materialId < materialCount, "Invalid material %d", materialId);
 
-    Mesh mesh = {0};
-    mesh.positions = positions;
-    mesh.colors = colors;
-    mesh.vertexCount = 3;
-    mesh.indices = indices;
-    mesh.indexCount = 3;
+    uint8_t* target = materialParams + materialId * materialParamsStride;
+    if (memcmp(target, params, size) == 0) {
+        return;
+    }
+    memcpy(target, params, size);
 
-    DrawMesh(mesh);
+    dirtyMaterialMin = materialId < dirtyMaterialMin ? materialId : dirtyMaterialMin;
+    dirtyMaterialMax = materialId > dirtyMaterialMax ? materialId : dirtyMaterialMax;
 }
 
-void DrawTriangle2DGl(Vec2 a, Vec2 b, Vec2 c, Color color) {
-    DrawTriangle3DGl((Vec3){ a.x, a.y, 0}, (Vec3){ b.x, b.y, 0}, (Vec3){ c.x, c.y, 0}, color);
+void UseMaterialGl(int materialId) {
+    Assert(materialId < materialCount, "Invalid material %d", materialId);
+    currentMaterialId = materialId;
 }
 
-void DrawQuad3DGl(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color color) {
-    Vec3 positions[4] = { topLeft, topRight, bottomLeft, bottomRight };
-    Color colors[4] = { color, color, color, color };
-    int indices[6] = {
-        0, 1, 2, // upper triangle
-        2, 1, 3, // lower triangle
-    };
+static void UploadMaterialParams() {
+    if (dirtyMaterialMax < dirtyMaterialMin) {
+        return;
+    }
 
-    Mesh mesh = {0};
-    mesh.positions = positions;
-    mesh.colors = colors;
-    mesh.vertexCount = 4;
-    mesh.indices = indices;
-    mesh.indexCount = 6;
+    int offset = dirtyMaterialMin * materialParamsStride;
+    int size = (dirtyMaterialMax - dirtyMaterialMin + 1) * materialParamsStride;
+    openGlExt.glBindBuffer(GL_UNIFORM_BUFFER, materialUBO);
+    openGlExt.glBufferSubData(GL_UNIFORM_BUFFER, offset, size, materialParams + offset);
+    frameStats.bytesUploaded += size;
 
-    DrawMesh(mesh);
+    dirtyMaterialMin = LIBGAME_MAX_MATERIALS;
+    dirtyMaterialMax = -1;
 }
 
-void SetTransparencyModeGl(bool shouldEnable) {
-    if (shouldEnable) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDepthMask(GL_FALSE);
-    } else {
-        glDisable(GL_BLEND);
-        glDepthMask(GL_TRUE);
+static void BindMaterial(int materialId) {
+    BindShader(materials[materialId].shaderId);
+
+    if (materialId != boundMaterialId) {
+        openGlExt.glBindBufferRange(GL_UNIFORM_BUFFER, materialBlockBinding, materialUBO,
+                materialId * materialParamsStride, LIBGAME_MAX_MATERIAL_PARAMS_SIZE);
+        boundMaterialId = materialId;
+    }
+}
+
+// -- Textures --
+
+int CreateTextureGl(const uint8_t* pixels, int width, int height) {
+    Assert(materialParams != NULL, "Unable to create texture. The window has not been created yet.");
+    Assert(textureCount < LIBGAME_MAX_TEXTURES, "Too many textures. Max is %d.", LIBGAME_MAX_TEXTURES);
+
+    TextureGl texture = {0};
+    texture.width = width;
+    texture.height = height;
+
+    glGenTextures(1, &texture.handle);
+    glBindTexture(GL_TEXTURE_2D, texture.handle);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    AssertNoGlError("Failed to create texture");
+    if (pixels != NULL) {
+        frameStats.bytesUploaded += (uint64_t)width * height * 4;
+    }
+
+    int id = textureCount++;
+    textures[id] = texture;
+    boundTextureId = id;
+
+    return id;
+}
+
+void UpdateTextureGl(int textureId, int x, int y, int width, int height, const uint8_t* pixels) {
+    Assert(textureId < textureCount, "Invalid texture %d", textureId);
+
+    TextureGl* texture = &textures[textureId];
+    Assert(x >= 0 && y >= 0 && x + width <= texture->width && y + height <= texture->height,
+            "Texture region (%d, %d, %d, %d) is out of bounds", x, y, width, height);
+
+    glBindTexture(GL_TEXTURE_2D, texture->handle);
+    boundTextureId = textureId;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    AssertNoGlError("Failed to update texture");
+    frameStats.bytesUploaded += (uint64_t)width * height * 4;
+}
+
+static void BindTexture(int textureId) {
+    if (textureId != boundTextureId) {
+        glBindTexture(GL_TEXTURE_2D, textures[textureId].handle);
+        boundTextureId = textureId;
+        frameStats.textureBinds++;
+    }
+}
+
+// -- Batching --
+
+// extends the current run if the material and texture have not changed
+static void AppendBatchRun(int textureId, int indexStart, int indexCount) {
+    if (batchRunCount > batchRunStart) {
+        BatchRun* last = &batchRuns[batchRunCount - 1];
+        if (last->materialId == currentMaterialId && last->textureId == textureId
+                && last->indexStart + last->indexCount == indexStart) {
+            last->indexCount += indexCount;
+            return;
+        }
     }
+
+    Assert(batchRunCount < maxBatchRuns, "Too many batch runs (%d)", batchRunCount);
+    BatchRun* run = &batchRuns[batchRunCount++];
+    run->materialId = currentMaterialId;
+    run->textureId = textureId;
+    run->indexStart = indexStart;
+    run->indexCount = indexCount;
+}
+
+static inline int BatchRunKey(BatchRun run) {
+    return run.materialId * LIBGAME_MAX_TEXTURES + run.textureId;
+}
+
+// bottom-up merge sort, which is stable so the order within a batch is kept
+static void SortBatchRuns(BatchRun* runs, BatchRun* temp, int count) {
+    for (int width = 1; width < count; width *= 2) {
+        for (int left = 0; left < count; left += 2 * width) {
+            int mid = left + width < count ? left + width : count;
+            int right = left + 2 * width < count ? left + 2 * width : count;
+            int i = left;
+            int j = mid;
+            int k = left;
+            while (i < mid && j < right) {
+                temp[k++] = BatchRunKey(runs[j]) < BatchRunKey(runs[i]) ? runs[j++] : runs[i++];
+            }
+            while (i < mid) {
+                temp[k++] = runs[i++];
+            }
+            while (j < right) {
+                temp[k++] = runs[j++];
+            }
+        }
+        memcpy(runs, temp, count * sizeof(BatchRun));
+    }
+}
+
+// reorder the pending vertex indices so that each material and texture combination is one contiguous run
+static void GroupBatchRuns() {
+    int runCount = batchRunCount - batchRunStart;
+    if (runCount <= 1) {
+        return;
+    }
+
+    int indexLength = currentVertexIndexCount - currentVertexIndexStart;
+    memcpy(sortedBatchRuns, &batchRuns[batchRunStart], runCount * sizeof(BatchRun));
+    SortBatchRuns(sortedBatchRuns, sortTempBatchRuns, runCount);
+
+    int offset = 0;
+    batchRunCount = batchRunStart;
+    for (int i = 0; i < runCount; i++) {
+        BatchRun run = sortedBatchRuns[i];
+        memcpy(&sortedVertexIndices[offset], &vertexIndices[run.indexStart], run.indexCount * sizeof(GLuint));
+
+        BatchRun* last = batchRunCount > batchRunStart ? &batchRuns[batchRunCount - 1] : NULL;
+        if (last != NULL && BatchRunKey(*last) == BatchRunKey(run)) {
+            last->indexCount += run.indexCount;
+        } else {
+            run.indexStart = currentVertexIndexStart + offset;
+            batchRuns[batchRunCount++] = run;
+        }
+        offset += run.indexCount;
+    }
+    memcpy(&vertexIndices[currentVertexIndexStart], sortedVertexIndices, indexLength * sizeof(GLuint));
+}
+
+// -- Transforms --
+
+static inline int Mat4PosToIndex(int x, int y) {
+    return x * 4 + y; // transpose, because OpenGL matrices are column-major
+}
+
+static RenderTransform Mat4ToRenderTransform(Mat4 mat) {
+    RenderTransform trans = {{0}};
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            trans.m[Mat4PosToIndex(x, y)] = mat.m[y][x];
+        }
+    }
+
+    return trans;
+}
+
+void SetTransformGl(Mat4 mat) {
+    currentTransform = Mat4ToRenderTransform(mat);
+    isDefaultTransform = false;
+    transformVersion++;
+}
+
+static void ResetTransform() {
+    if (isDefaultTransform) {
+        return;
+    }
+    currentTransform = defaultTransform;
+    isDefaultTransform = true;
+    transformVersion++;
+}
+
+void SetCamera2DGl(int slot, Camera2D* camera) {
+    SetCameraTransform2D(slot, camera);
+}
+
+void SetCamera3DGl(int slot, Camera3D* camera) {
+    SetCameraTransform3D(slot, camera);
+}
+
+void UseCameraSlotGl(int slot) {
+    currentCameraSlot = slot;
+}
+
+static void UploadCameraTransforms() {
+    bool didBind = false;
+
+    for (int i = 0; i < LIBGAME_MAX_CAMERAS; i++) {
+        uint32_t version = GetCameraTransformVersion(i);
+        if (version == uploadedCameraVersions[i]) {
+            continue;
+        }
+
+        if (!didBind) {
+            openGlExt.glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+            didBind = true;
+        }
+
+        RenderTransform transform = Mat4ToRenderTransform(GetCameraTransform(i));
+        openGlExt.glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(RenderTransform), sizeof(RenderTransform), transform.m);
+        frameStats.bytesUploaded += sizeof(RenderTransform);
+        uploadedCameraVersions[i] = version;
+    }
+}
+
+void MakeDrawCallGl() {
+    UploadCameraTransforms();
+    UploadMaterialParams();
+
+    bool isWeighted = isTransparencyEnabled && transparencyMethod == TRANSPARENCY_WEIGHTED;
+    if (isWeighted && batchRunCount > batchRunStart) {
+        BeginWeightedPass();
+    }
+    // the order only matters when blending in draw order
+    if (!isTransparencyEnabled || isWeighted) {
+        GroupBatchRuns();
+    }
+
+    //  update vertices
+    int length = currentVertexCount - currentVertexStart;
+    int offset = currentVertexStart * valuesPerVertex * sizeof(GLfloat);
+    int size = length * valuesPerVertex * sizeof(GLfloat);
+    openGlExt.glBufferSubData(GL_ARRAY_BUFFER, offset, size, &vertices[currentVertexStart * valuesPerVertex]);
+
+    // update indicies
+    int indexLength = currentVertexIndexCount - currentVertexIndexStart;
+    int indexOffset = currentVertexIndexStart * sizeof(GLuint);
+    int indexSize = indexLength * sizeof(GLuint);
+    openGlExt.glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset, indexSize, &vertexIndices[currentVertexIndexStart]);
+
+    bool isDepthPrepass = isDepthPrepassEnabled && !isTransparencyEnabled && batchRunCount > batchRunStart;
+    if (isDepthPrepass) {
+        DrawDepthPrepass();
+        // only the nearest fragment of each pixel is shaded
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    ResumeOverdrawQuery();
+    for (int i = batchRunStart; i < batchRunCount; i++) {
+        BatchRun run = batchRuns[i];
+        BindMaterial(run.materialId);
+        BindTexture(run.textureId);
+        glDrawElements(GL_TRIANGLES, run.indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)(run.indexStart * sizeof(GLuint)));
+        frameStats.drawCalls++;
+    }
+
+    if (isDepthPrepass) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    frameStats.vertexCount += length;
+    frameStats.indexCount += indexLength;
+    frameStats.bytesUploaded += size + indexSize;
+
+    AssertNoGlError("Failed to draw");
+    ResetTransform();
+    currentVertexStart = currentVertexCount;
+    currentVertexIndexStart = currentVertexIndexCount;
+    batchRunStart = batchRunCount;
+}
+
+void EndFrameGl() {
+    EndWeightedPass();
+    FinishOverdrawFrame();
+    lastFrameStats = frameStats;
+    frameStats = (RenderStats){0};
+
+    currentVertexCount = 0;
+    currentVertexStart = 0;
+    currentVertexIndexCount = 0;
+    currentVertexIndexStart = 0;
+    batchRunCount = 0;
+    batchRunStart = 0;
+}
+
+RenderStats GetRenderStatsGl() {
+    return lastFrameStats;
+}
+
+void ClearScreenGl(Color color) {
+    EndWeightedPass();
+    glClearColor(color.r, color.g, color.b, color.a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+static void AssertCountWithinBounds(int targetVertexCount, int targetVertexIndexCount) {
+    Assert(targetVertexCount <= maxVertices, "Too many vertices (%d). Max is %d.", targetVertexCount, maxVertices);
+    Assert(targetVertexIndexCount <= maxVertexIndices, "Too many vertex indices (%d). Max is %d.", targetVertexIndexCount, maxVertexIndices);
+}
+
+// reserves a range of vertices and indices in the batch, which the caller fills in
+ReservedGeometry ReserveGeometryGl(int vertexCount, int indexCount, int textureId) {
+    Assert(textureId < textureCount, "Invalid texture %d", textureId);
+
+    int targetVertexCount = currentVertexCount + vertexCount;
+    int targetVertexIndexCount = currentVertexIndexCount + indexCount;
+    AssertCountWithinBounds(targetVertexCount, targetVertexIndexCount);
+
+    ReservedGeometry geometry = {0};
+    geometry.vertices = &vertices[currentVertexCount * valuesPerVertex];
+    geometry.indices = &vertexIndices[currentVertexIndexCount];
+    geometry.baseVertex = currentVertexCount;
+    AppendBatchRun(textureId, currentVertexIndexCount, indexCount);
+
+    currentVertexCount = targetVertexCount;
+    currentVertexIndexCount = targetVertexIndexCount;
+    return geometry;
+}
+
+static inline void WriteVertex(GLfloat* target, Vec3 position, Color color, Vec2 texCoord) {
+    target[0] = position.x;
+    target[1] = position.y;
+    target[2] = position.z;
+    target[3] = color.r;
+    target[4] = color.g;
+    target[5] = color.b;
+    target[6] = color.a;
+    target[7] = texCoord.x;
+    target[8] = texCoord.y;
+}
+
+void DrawTriangle3DGl(Vec3 a, Vec3 b, Vec3 c, Color color) {
+    ReservedGeometry geometry = ReserveGeometryGl(3, 3, 0);
+    Vec2 texCoord = {0};
+    WriteVertex(&geometry.vertices[0 * valuesPerVertex], a, color, texCoord);
+    WriteVertex(&geometry.vertices[1 * valuesPerVertex], b, color, texCoord);
+    WriteVertex(&geometry.vertices[2 * valuesPerVertex], c, color, texCoord);
+    for (int i = 0; i < 3; i++) {
+        geometry.indices[i] = geometry.baseVertex + i;
+    }
+}
+
+void DrawTriangle2DGl(Vec2 a, Vec2 b, Vec2 c, Color color) {
+    DrawTriangle3DGl((Vec3){ a.x, a.y, 0}, (Vec3){ b.x, b.y, 0}, (Vec3){ c.x, c.y, 0}, color);
+}
+
+void DrawTexturedQuad3DGl(int textureId, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight,
+        Vec2 uvMin, Vec2 uvMax, Color color) {
+    ReservedGeometry geometry = ReserveGeometryGl(4, 6, textureId);
+
+    // the first row of texture pixels is the top of the image
+    WriteVertex(&geometry.vertices[0 * valuesPerVertex], topLeft, color, (Vec2){ uvMin.x, uvMin.y });
+    WriteVertex(&geometry.vertices[1 * valuesPerVertex], topRight, color, (Vec2){ uvMax.x, uvMin.y });
+    WriteVertex(&geometry.vertices[2 * valuesPerVertex], bottomLeft, color, (Vec2){ uvMin.x, uvMax.y });
+    WriteVertex(&geometry.vertices[3 * valuesPerVertex], bottomRight, color, (Vec2){ uvMax.x, uvMax.y });
+
+    static const int quadIndices[6] = {
+        0, 1, 2, // upper triangle
+        2, 1, 3, // lower triangle
+    };
+    for (int i = 0; i < 6; i++) {
+        geometry.indices[i] = geometry.baseVertex + quadIndices[i];
+    }
+}
+
+void DrawQuad3DGl(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color color) {
+    DrawTexturedQuad3DGl(0, topLeft, topRight, bottomLeft, bottomRight, (Vec2){0}, (Vec2){0}, color);
+}
+
+// the vertices already have the layout of the vertex buffer, so they are copied as is
+void DrawVerticesGl(const float* vertexData, int vertexCount, const uint32_t* indices, int indexCount, int textureId) {
+    ReservedGeometry geometry = ReserveGeometryGl(vertexCount, indexCount, textureId);
+    memcpy(geometry.vertices, vertexData, vertexCount * valuesPerVertex * sizeof(GLfloat));
+    for (int i = 0; i < indexCount; i++) {
+        geometry.indices[i] = indices[i] + geometry.baseVertex;
+    }
+}
+
+// -- Debug lines --
+
+static const char* debugLineVertexShaderSrc =
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    gl_Position = TransformPosition(position);\n"
+    "    fragColor = color;\n"
+    "}";
+
+static const char* debugLineFragmentShaderSrc =
+    "in vec4 fragColor;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = fragColor;\n"
+    "}";
+
+// created on first use, so that debug drawing costs nothing when it is not used
+static void InitDebugLines() {
+    debugLineShaderId = CreateShaderGl(debugLineVertexShaderSrc, debugLineFragmentShaderSrc);
+
+    openGlExt.glGenVertexArrays(1, &debugLineVAO);
+    openGlExt.glGenBuffers(1, &debugLineVBO);
+    openGlExt.glBindVertexArray(debugLineVAO);
+    openGlExt.glBindBuffer(GL_ARRAY_BUFFER, debugLineVBO);
+
+    // position attribute
+    openGlExt.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugLineVertex), (GLvoid*)0);
+    openGlExt.glEnableVertexAttribArray(0);
+    // color attribute, normalized from bytes
+    openGlExt.glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugLineVertex), (GLvoid*)offsetof(DebugLineVertex, color));
+    openGlExt.glEnableVertexAttribArray(1);
+    // no texture coordinates, attribute 2 keeps its default value
+
+    AssertNoGlError("Failed to initialize debug lines");
+}
+
+void DrawDebugLinesGl(const DebugLineVertex* lineVertices, int vertexCount, const DebugLineBatch* batches, int batchCount) {
+    if (vertexCount == 0) {
+        return;
+    }
+    if (debugLineShaderId < 0) {
+        InitDebugLines();
+    }
+
+    EndWeightedPass();
+    PauseOverdrawQuery();
+    UploadCameraTransforms();
+
+    openGlExt.glBindVertexArray(debugLineVAO);
+    openGlExt.glBindBuffer(GL_ARRAY_BUFFER, debugLineVBO);
+    // orphan the previous frame's lines instead of waiting for them to be drawn
+    openGlExt.glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(DebugLineVertex), lineVertices, GL_STREAM_DRAW);
+
+    int previousCameraSlot = currentCameraSlot;
+    glDepthMask(GL_FALSE);
+
+    for (int i = 0; i < batchCount; i++) {
+        DebugLineBatch batch = batches[i];
+        if (batch.isOverlay) {
+            glDisable(GL_DEPTH_TEST);
+        } else {
+            glEnable(GL_DEPTH_TEST);
+        }
+        currentCameraSlot = batch.cameraSlot;
+        BindShader(debugLineShaderId);
+        glDrawArrays(GL_LINES, batch.vertexStart, batch.vertexCount);
+        frameStats.drawCalls++;
+    }
+    frameStats.vertexCount += vertexCount;
+    frameStats.bytesUploaded += vertexCount * sizeof(DebugLineVertex);
+
+    // restore the state of the regular draw calls
+    currentCameraSlot = previousCameraSlot;
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(isTransparencyEnabled ? GL_FALSE : GL_TRUE);
+    openGlExt.glBindVertexArray(VAO);
+    openGlExt.glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    AssertNoGlError("Failed to draw debug lines");
+}
+
+// -- Render targets --
+
+static void AllocateRenderTarget(RenderTargetGl* target, int width, int height) {
+    TextureGl* texture = &textures[target->textureId];
+    texture->width = width;
+    texture->height = height;
+    glBindTexture(GL_TEXTURE_2D, texture->handle);
+    boundTextureId = target->textureId;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    openGlExt.glBindRenderbuffer(GL_RENDERBUFFER, target->depthBuffer);
+    openGlExt.glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    AssertNoGlError("Failed to allocate render target");
+}
+
+static void BindFramebuffer(int targetId) {
+    GLuint framebuffer = targetId < 0 ? 0 : renderTargets[targetId].framebuffer;
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+int CreateRenderTargetGl(int width, int height, int* textureId) {
+    Assert(renderTargetCount < LIBGAME_MAX_RENDER_TARGETS, "Too many render targets. Max is %d.", LIBGAME_MAX_RENDER_TARGETS);
+
+    RenderTargetGl target = {0};
+    target.textureId = CreateTextureGl(NULL, width, height);
+    openGlExt.glGenRenderbuffers(1, &target.depthBuffer);
+    AllocateRenderTarget(&target, width, height);
+
+    openGlExt.glGenFramebuffers(1, &target.framebuffer);
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    openGlExt.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[target.textureId].handle, 0);
+    openGlExt.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depthBuffer);
+    GLenum status = openGlExt.glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    Assert(status == GL_FRAMEBUFFER_COMPLETE, "Render target is incomplete (0x%x)", status);
+    BindFramebuffer(currentRenderTargetId);
+
+    int id = renderTargetCount++;
+    renderTargets[id] = target;
+    *textureId = target.textureId;
+    return id;
+}
+
+void ResizeRenderTargetGl(int targetId, int width, int height) {
+    Assert(targetId >= 0 && targetId < renderTargetCount, "Invalid render target %d", targetId);
+    if (targetId == currentRenderTargetId) {
+        MakeDrawCallGl();
+        EndWeightedPass();
+    }
+    AllocateRenderTarget(&renderTargets[targetId], width, height);
+}
+
+void UseRenderTargetGl(int targetId, int width, int height) {
+    Assert(targetId >= -1 && targetId < renderTargetCount, "Invalid render target %d", targetId);
+    MakeDrawCallGl();
+    EndWeightedPass();
+    // the next span counts the samples of the new viewport
+    PauseOverdrawQuery();
+
+    BindFramebuffer(targetId);
+    currentRenderTargetId = targetId;
+    viewportWidth = targetId < 0 ? clientWidth : width;
+    viewportHeight = targetId < 0 ? clientHeight : height;
+    glViewport(0, 0, viewportWidth, viewportHeight);
+}
+
+void BlitRenderTargetGl(int targetId, int width, int height) {
+    Assert(targetId >= 0 && targetId < renderTargetCount, "Invalid render target %d", targetId);
+    MakeDrawCallGl();
+    EndWeightedPass();
+
+    openGlExt.glBindFramebuffer(GL_READ_FRAMEBUFFER, renderTargets[targetId].framebuffer);
+    openGlExt.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    openGlExt.glBlitFramebuffer(0, 0, width, height, 0, 0, clientWidth, clientHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    // the blitted image has no depth, so the graphics drawn over it are not hidden by an old depth
+    BindFramebuffer(-1);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    BindFramebuffer(currentRenderTargetId);
+    AssertNoGlError("Failed to blit render target");
+}
+
+// -- GPU timers --
+
+#define GPU_TIMER_QUERIES 4
+
+static GLuint timerQueries[GPU_TIMER_QUERIES];
+static bool areTimerQueriesCreated = false;
+static int timerQueryStart = 0; // oldest pending query
+static int timerQueryCount = 0; // pending queries
+static bool isTimerRunning = false;
+
+void BeginGpuTimerGl() {
+    if (!areTimerQueriesCreated) {
+        openGlExt.glGenQueries(GPU_TIMER_QUERIES, timerQueries);
+        areTimerQueriesCreated = true;
+    }
+    // skip the measurement if the GPU is too far behind
+    if (timerQueryCount == GPU_TIMER_QUERIES) {
+        return;
+    }
+    int query = (timerQueryStart + timerQueryCount) % GPU_TIMER_QUERIES;
+    openGlExt.glBeginQuery(GL_TIME_ELAPSED, timerQueries[query]);
+    isTimerRunning = true;
+}
+
+void EndGpuTimerGl() {
+    if (!isTimerRunning) {
+        return;
+    }
+    openGlExt.glEndQuery(GL_TIME_ELAPSED);
+    isTimerRunning = false;
+    timerQueryCount++;
+}
+
+bool ReadGpuTimerGl(uint64_t* nanoseconds) {
+    bool hasResult = false;
+    while (timerQueryCount > 0) {
+        GLuint query = timerQueries[timerQueryStart];
+        GLint isAvailable = 0;
+        openGlExt.glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (!isAvailable) {
+            break;
+        }
+
+        GLuint64 elapsed = 0;
+        openGlExt.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        *nanoseconds = elapsed;
+        hasResult = true;
+        timerQueryStart = (timerQueryStart + 1) % GPU_TIMER_QUERIES;
+        timerQueryCount--;
+    }
+    return hasResult;
+}
+
+// -- Readback --
+
+#define READBACK_BUFFERS 3
+#define READBACK_TIMEOUT_NS 1000000000ull
+
+typedef struct {
+    GLuint buffer;
+    GLsync fence;
+    int capacity;
+    int width;
+    int height;
+} ReadbackGl;
+
+static ReadbackGl readbacks[READBACK_BUFFERS] = {0};
+static int readbackStart = 0; // oldest pending readback
+static int readbackCount = 0; // pending readbacks
+static bool isReadbackMapped = false;
+
+bool RequestReadbackGl() {
+    if (readbackCount == READBACK_BUFFERS) {
+        return false;
+    }
+    MakeDrawCallGl();
+    EndWeightedPass();
+
+    ReadbackGl* readback = &readbacks[(readbackStart + readbackCount) % READBACK_BUFFERS];
+    if (readback->buffer == 0) {
+        openGlExt.glGenBuffers(1, &readback->buffer);
+    }
+    // the render target in use, or the region of it that is drawn, so headless scenes can be read back too
+    int width = viewportWidth;
+    int height = viewportHeight;
+    int size = width * height * 4;
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    if (readback->capacity < size) {
+        openGlExt.glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        readback->capacity = size;
+    }
+    readback->width = width;
+    readback->height = height;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    readback->fence = openGlExt.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    AssertNoGlError("Failed to request readback");
+
+    readbackCount++;
+    return true;
+}
+
+const uint8_t* MapReadbackGl(int* width, int* height, bool shouldWait) {
+    Assert(!isReadbackMapped, "The previous readback is still mapped");
+    if (readbackCount == 0) {
+        return NULL;
+    }
+
+    ReadbackGl* readback = &readbacks[readbackStart];
+    GLenum result = openGlExt.glClientWaitSync(readback->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+            shouldWait ? READBACK_TIMEOUT_NS : 0);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        if (shouldWait) {
+            LogWarningIn(LOG_CATEGORY_RENDER, "Failed to wait for a readback (0x%x)\n", result);
+        }
+        return NULL;
+    }
+
+    int size = readback->width * readback->height * 4;
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    const uint8_t* pixels = (const uint8_t*)openGlExt.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    Assert(pixels != NULL, "Failed to map a readback (0x%x)", glGetError());
+
+    isReadbackMapped = true;
+    *width = readback->width;
+    *height = readback->height;
+    return pixels;
+}
+
+void UnmapReadbackGl() {
+    Assert(isReadbackMapped, "No readback is mapped");
+    ReadbackGl* readback = &readbacks[readbackStart];
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    openGlExt.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    openGlExt.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    isReadbackMapped = false;
+
+    openGlExt.glDeleteSync(readback->fence);
+    readback->fence = NULL;
+    readbackStart = (readbackStart + 1) % READBACK_BUFFERS;
+    readbackCount--;
+}
+
+// -- Weighted transparency --
+
+static const char* compositeVertexShaderSrc =
+    "void main() {\n"
+    "    // a triangle that covers the viewport\n"
+    "    vec2 p = vec2((gl_VertexID & 1) * 4.0 - 1.0, (gl_VertexID >> 1) * 4.0 - 1.0);\n"
+    "    gl_Position = vec4(p, 0.0, 1.0);\n"
+    "}";
+
+static const char* compositeFragmentShaderSrc =
+    "uniform sampler2D weightedColorTexture;\n"
+    "uniform sampler2D weightedAlphaTexture;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    vec4 color = texelFetch(weightedColorTexture, p, 0);\n"
+    "    float alpha = texelFetch(weightedAlphaTexture, p, 0).r;\n"
+    "    // the alpha channel is how much of the framebuffer shows through\n"
+    "    FragColor = vec4(color.rgb / max(alpha, 1e-5), color.a);\n"
+    "}";
+
+typedef struct {
+    GLuint framebuffer;
+    GLuint colorTexture;
+    GLuint alphaTexture;
+    int width;
+    int height;
+    // copy of the window depth, in the format of the window
+    GLuint depthBuffer;
+    GLenum depthFormat; // 0 if the window has no depth
+    GLenum depthAttachment;
+    int depthWidth;
+    int depthHeight;
+    int compositeShaderId;
+} WeightedTargetGl;
+
+static WeightedTargetGl weightedTarget = { .compositeShaderId = -1 };
+
+static void InitWeightedTarget() {
+    openGlExt.glGenFramebuffers(1, &weightedTarget.framebuffer);
+    glGenTextures(1, &weightedTarget.colorTexture);
+    glGenTextures(1, &weightedTarget.alphaTexture);
+    openGlExt.glGenRenderbuffers(1, &weightedTarget.depthBuffer);
+
+    // a blit between depth buffers needs matching formats
+    GLint depthBits = 0;
+    GLint stencilBits = 0;
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    openGlExt.glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+    openGlExt.glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_STENCIL, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+    if (stencilBits > 0) {
+        weightedTarget.depthFormat = depthBits == 32 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+        weightedTarget.depthAttachment = GL_DEPTH_STENCIL_ATTACHMENT;
+    } else if (depthBits > 0) {
+        weightedTarget.depthFormat = depthBits == 16 ? GL_DEPTH_COMPONENT16 : (depthBits == 32 ? GL_DEPTH_COMPONENT32 : GL_DEPTH_COMPONENT24);
+        weightedTarget.depthAttachment = GL_DEPTH_ATTACHMENT;
+    }
+
+    weightedTarget.compositeShaderId = CreateShaderGl(compositeVertexShaderSrc, compositeFragmentShaderSrc);
+    GLuint program = shaders[weightedTarget.compositeShaderId].program;
+    openGlExt.glUniform1i(openGlExt.glGetUniformLocation(program, "weightedColorTexture"), 1);
+    openGlExt.glUniform1i(openGlExt.glGetUniformLocation(program, "weightedAlphaTexture"), 2);
+
+    AssertNoGlError("Failed to initialize weighted transparency");
+}
+
+static void AllocateWeightedTexture(GLuint texture, GLint format, GLenum channels, int width, int height) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, channels, GL_HALF_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    boundTextureId = -1;
+}
+
+// the textures only grow, the attachments may be larger than the viewport
+static void ResizeWeightedTarget() {
+    if (viewportWidth <= weightedTarget.width && viewportHeight <= weightedTarget.height) {
+        return;
+    }
+    weightedTarget.width = viewportWidth > weightedTarget.width ? viewportWidth : weightedTarget.width;
+    weightedTarget.height = viewportHeight > weightedTarget.height ? viewportHeight : weightedTarget.height;
+    AllocateWeightedTexture(weightedTarget.colorTexture, GL_RGBA16F, GL_RGBA, weightedTarget.width, weightedTarget.height);
+    AllocateWeightedTexture(weightedTarget.alphaTexture, GL_R16F, GL_RED, weightedTarget.width, weightedTarget.height);
+
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, weightedTarget.framebuffer);
+    openGlExt.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, weightedTarget.colorTexture, 0);
+    openGlExt.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weightedTarget.alphaTexture, 0);
+}
+
+static void AttachWeightedDepth() {
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, weightedTarget.framebuffer);
+    if (currentRenderTargetId >= 0) {
+        // shares the depth of the render target, nothing to copy
+        if (weightedTarget.depthAttachment == GL_DEPTH_STENCIL_ATTACHMENT) {
+            openGlExt.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+        }
+        openGlExt.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                renderTargets[currentRenderTargetId].depthBuffer);
+        return;
+    }
+
+    if (weightedTarget.depthFormat == 0) {
+        openGlExt.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
+        return;
+    }
+    if (weightedTarget.depthWidth != clientWidth || weightedTarget.depthHeight != clientHeight) {
+        openGlExt.glBindRenderbuffer(GL_RENDERBUFFER, weightedTarget.depthBuffer);
+        openGlExt.glRenderbufferStorage(GL_RENDERBUFFER, weightedTarget.depthFormat, clientWidth, clientHeight);
+        weightedTarget.depthWidth = clientWidth;
+        weightedTarget.depthHeight = clientHeight;
+    }
+    openGlExt.glFramebufferRenderbuffer(GL_FRAMEBUFFER, weightedTarget.depthAttachment, GL_RENDERBUFFER, weightedTarget.depthBuffer);
+
+    GLbitfield mask = weightedTarget.depthAttachment == GL_DEPTH_STENCIL_ATTACHMENT
+        ? GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT : GL_DEPTH_BUFFER_BIT;
+    openGlExt.glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    openGlExt.glBlitFramebuffer(0, 0, clientWidth, clientHeight, 0, 0, clientWidth, clientHeight, mask, GL_NEAREST);
+    openGlExt.glBindFramebuffer(GL_FRAMEBUFFER, weightedTarget.framebuffer);
+}
+
+static void BeginWeightedPass() {
+    if (isWeightedPassActive) {
+        return;
+    }
+    if (weightedTarget.framebuffer == 0) {
+        InitWeightedTarget();
+    }
+    ResizeWeightedTarget();
+    AttachWeightedDepth();
+
+    GLenum status = openGlExt.glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    Assert(status == GL_FRAMEBUFFER_COMPLETE, "Weighted transparency target is incomplete (0x%x)", status);
+
+    static const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    static const GLfloat colorClear[4] = { 0, 0, 0, 1 };
+    static const GLfloat alphaClear[4] = { 0, 0, 0, 0 };
+    openGlExt.glDrawBuffers(2, drawBuffers);
+    openGlExt.glClearBufferfv(GL_COLOR, 0, colorClear);
+    openGlExt.glClearBufferfv(GL_COLOR, 1, alphaClear);
+
+    isWeightedPassActive = true;
+    ApplyBlendState();
+    AssertNoGlError("Failed to begin weighted transparency");
+}
+
+static void EndWeightedPass() {
+    if (!isWeightedPassActive) {
+        return;
+    }
+    isWeightedPassActive = false;
+    PauseOverdrawQuery();
+    BindFramebuffer(currentRenderTargetId);
+
+    // color * (1 - revealed) + framebuffer * revealed
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    openGlExt.glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, weightedTarget.colorTexture);
+    openGlExt.glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, weightedTarget.alphaTexture);
+    openGlExt.glActiveTexture(GL_TEXTURE0);
+
+    BindShader(weightedTarget.compositeShaderId);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    frameStats.drawCalls++;
+
+    glEnable(GL_DEPTH_TEST);
+    ApplyBlendState();
+    AssertNoGlError("Failed to composite weighted transparency");
+}
+
+// -- Depth prepass --
+
+static void DrawDepthPrepass() {
+    PauseOverdrawQuery();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    isDepthPrepassActive = true;
+
+    for (int i = batchRunStart; i < batchRunCount; i++) {
+        BatchRun run = batchRuns[i];
+        BindMaterial(run.materialId);
+        // the textures only matter when the fragment shader may discard
+        if (shaderVariants[materials[run.materialId].shaderId].canDiscard) {
+            BindTexture(run.textureId);
+        }
+        glDrawElements(GL_TRIANGLES, run.indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)(run.indexStart * sizeof(GLuint)));
+        frameStats.drawCalls++;
+        frameStats.depthPrepassDrawCalls++;
+    }
+
+    isDepthPrepassActive = false;
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+// -- Overdraw queries --
+
+#define OVERDRAW_QUERY_FRAMES 4
+#define OVERDRAW_MAX_SPANS 64
+
+// the samples of a frame are counted by a query per span of color draws
+typedef struct {
+    GLuint queries[OVERDRAW_MAX_SPANS];
+    int pixelCounts[OVERDRAW_MAX_SPANS]; // the viewport of each span, which is smaller with dynamic resolution
+    int spanCount;
+} OverdrawFrameGl;
+
+static OverdrawFrameGl overdrawFrames[OVERDRAW_QUERY_FRAMES];
+static bool areOverdrawQueriesCreated = false;
+static int overdrawFrameStart = 0; // oldest pending frame
+static int overdrawFrameCount = 0; // pending frames, not counting the current one
+static bool isOverdrawFrameActive = false;
+static bool isOverdrawSpanRunning = false;
+static uint64_t lastSamplesShaded = 0;
+static float lastOverdraw = 0;
+
+static void ResumeOverdrawQuery() {
+    if (isOverdrawSpanRunning) {
+        return;
+    }
+    if (!areOverdrawQueriesCreated) {
+        for (int i = 0; i < OVERDRAW_QUERY_FRAMES; i++) {
+            openGlExt.glGenQueries(OVERDRAW_MAX_SPANS, overdrawFrames[i].queries);
+        }
+        areOverdrawQueriesCreated = true;
+    }
+
+    OverdrawFrameGl* frame = &overdrawFrames[(overdrawFrameStart + overdrawFrameCount) % OVERDRAW_QUERY_FRAMES];
+    if (!isOverdrawFrameActive) {
+        // skip the measurement if the GPU is too far behind
+        if (overdrawFrameCount == OVERDRAW_QUERY_FRAMES) {
+            return;
+        }
+        frame->spanCount = 0;
+        isOverdrawFrameActive = true;
+    }
+    frame->pixelCounts[frame->spanCount] = viewportWidth * viewportHeight;
+    openGlExt.glBeginQuery(GL_SAMPLES_PASSED, frame->queries[frame->spanCount++]);
+    isOverdrawSpanRunning = true;
+}
+
+static void PauseOverdrawQuery() {
+    if (!isOverdrawSpanRunning) {
+        return;
+    }
+    // the last span keeps running until the end of the frame, and also counts the samples it should skip
+    OverdrawFrameGl* frame = &overdrawFrames[(overdrawFrameStart + overdrawFrameCount) % OVERDRAW_QUERY_FRAMES];
+    if (frame->spanCount == OVERDRAW_MAX_SPANS) {
+        return;
+    }
+    openGlExt.glEndQuery(GL_SAMPLES_PASSED);
+    isOverdrawSpanRunning = false;
+}
+
+static void ReadOverdrawQueries() {
+    while (overdrawFrameCount > 0) {
+        OverdrawFrameGl* frame = &overdrawFrames[overdrawFrameStart];
+        // queries finish in order, so the frame is done when its last query is
+        GLint isAvailable = 0;
+        openGlExt.glGetQueryObjectiv(frame->queries[frame->spanCount - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (!isAvailable) {
+            break;
+        }
+
+        // each span is relative to the framebuffer region it drew into
+        uint64_t samples = 0;
+        double overdraw = 0;
+        for (int i = 0; i < frame->spanCount; i++) {
+            GLuint64 spanSamples = 0;
+            openGlExt.glGetQueryObjectui64v(frame->queries[i], GL_QUERY_RESULT, &spanSamples);
+            samples += spanSamples;
+            overdraw += frame->pixelCounts[i] > 0 ? (double)spanSamples / frame->pixelCounts[i] : 0;
+        }
+        lastSamplesShaded = samples;
+        lastOverdraw = (float)overdraw;
+        overdrawFrameStart = (overdrawFrameStart + 1) % OVERDRAW_QUERY_FRAMES;
+        overdrawFrameCount--;
+    }
+}
+
+static void FinishOverdrawFrame() {
+    if (isOverdrawFrameActive) {
+        if (isOverdrawSpanRunning) {
+            openGlExt.glEndQuery(GL_SAMPLES_PASSED);
+            isOverdrawSpanRunning = false;
+        }
+        overdrawFrameCount++;
+        isOverdrawFrameActive = false;
+    }
+
+    ReadOverdrawQueries();
+    frameStats.samplesShaded = lastSamplesShaded;
+    frameStats.overdraw = lastOverdraw;
+}
+
+// -- Frame pacing --
+
+#define MAX_FRAME_FENCES (LIBGAME_MAX_FRAMES_IN_FLIGHT + 1)
+#define FENCE_TIMEOUT_NS 1000000000ull
+
+// fences of presented frames by frame number, oldest first
+static GLsync frameFences[MAX_FRAME_FENCES] = {0};
+static uint64_t oldestFencedFrame = 1;
+static int maxFramesInFlight = 0;
+static FramePresentInfo presentInfo = {0};
+
+void SetMaxFramesInFlightGl(int frameCount) {
+    maxFramesInFlight = frameCount;
+}
+
+FramePresentInfo GetPresentInfoGl() {
+    return presentInfo;
+}
+
+static void WaitForFrameFence(uint64_t frame) {
+    GLsync fence = frameFences[frame % MAX_FRAME_FENCES];
+    if (fence == NULL) {
+        return;
+    }
+    uint64_t waitStart = GetTicks();
+    GLenum result = openGlExt.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Failed to wait for frame %llu (0x%x)\n", (unsigned long long)frame, result);
+    }
+    presentInfo.waitMicros = GetTicks() - waitStart;
+}
+
+// the GPU finishes frames in order, so stop at the first fence that is not signaled yet
+static void CollectFrameFences() {
+    while (oldestFencedFrame <= presentInfo.presentedFrame) {
+        GLsync* fence = &frameFences[oldestFencedFrame % MAX_FRAME_FENCES];
+        if (*fence != NULL) {
+            GLenum result = openGlExt.glClientWaitSync(*fence, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                return;
+            }
+            openGlExt.glDeleteSync(*fence);
+            *fence = NULL;
+            presentInfo.completedFrame = oldestFencedFrame;
+            presentInfo.completedTicks = GetTicks();
+        }
+        oldestFencedFrame++;
+    }
+}
+
+void EndPresentGl() {
+    uint64_t frame = ++presentInfo.presentedFrame;
+    presentInfo.waitMicros = 0;
+
+    // the ring is full when the GPU is more than the ring behind, the oldest fence is then dropped
+    GLsync* fence = &frameFences[frame % MAX_FRAME_FENCES];
+    if (*fence != NULL) {
+        openGlExt.glDeleteSync(*fence);
+        oldestFencedFrame = frame - MAX_FRAME_FENCES + 1;
+    }
+    *fence = openGlExt.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    if (maxFramesInFlight > 0 && frame >= (uint64_t)maxFramesInFlight) {
+        WaitForFrameFence(frame - maxFramesInFlight + 1);
+    }
+    CollectFrameFences();
+}
+
+static void ApplyBlendState() {
+    if (isWeightedPassActive) {
+        glEnable(GL_BLEND);
+        // sums on the color channels, product of (1 - alpha) on the alpha channel
+        openGlExt.glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    } else if (isTransparencyEnabled) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    } else {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+}
+
+void SetTransparencyModeGl(bool shouldEnable) {
+    if (!shouldEnable) {
+        EndWeightedPass();
+    }
+    isTransparencyEnabled = shouldEnable;
+    ApplyBlendState();
+}
+
+void SetTransparencyMethodGl(TransparencyMethod method) {
+    EndWeightedPass();
+    transparencyMethod = method;
+}
+
+void SetDepthPrepassModeGl(bool shouldEnable) {
+    isDepthPrepassEnabled = shouldEnable;
 }
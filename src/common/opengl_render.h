@@ -11,6 +11,7 @@
 #endif
 
 #include "libgame.h"
+#include "platform_setup.h"
 
 // -- OpenGL render backend --
 
@@ -23,12 +24,40 @@ void MakeDrawCallGl();
 void ClearScreenGl(Color color);
 void SetTransformGl(Mat4 mat);
 void EndFrameGl(); // call before swapping buffers
-void SetCamera2DGl(Camera2D* camera);
-void SetCamera3DGl(Camera3D* camera);
+void EndPresentGl(); // call after swapping buffers
+int CreateRenderTargetGl(int width, int height, int* textureId);
+void ResizeRenderTargetGl(int targetId, int width, int height);
+void UseRenderTargetGl(int targetId, int width, int height);
+void BlitRenderTargetGl(int targetId, int width, int height);
+void BeginGpuTimerGl();
+void EndGpuTimerGl();
+bool ReadGpuTimerGl(uint64_t* nanoseconds);
+bool RequestReadbackGl();
+const uint8_t* MapReadbackGl(int* width, int* height, bool shouldWait);
+void UnmapReadbackGl();
+void SetMaxFramesInFlightGl(int frameCount);
+FramePresentInfo GetPresentInfoGl();
+void SetCamera2DGl(int slot, Camera2D* camera);
+void SetCamera3DGl(int slot, Camera3D* camera);
+void UseCameraSlotGl(int slot);
 void DrawTriangle2DGl(Vec2 a, Vec2 b, Vec2 c, Color color);
 void DrawTriangle3DGl(Vec3 a, Vec3 b, Vec3 c, Color color);
 void DrawQuad3DGl(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color color);
 void SetTransparencyModeGl(bool shouldEnable);
+void SetTransparencyMethodGl(TransparencyMethod method);
+void SetDepthPrepassModeGl(bool shouldEnable);
+int CreateShaderGl(const char* vertexSrc, const char* fragmentSrc);
+int CreateMaterialGl(int shaderId);
+void SetMaterialParamsGl(int materialId, const void* params, int size);
+void UseMaterialGl(int materialId);
+int CreateTextureGl(const uint8_t* pixels, int width, int height);
+void UpdateTextureGl(int textureId, int x, int y, int width, int height, const uint8_t* pixels);
+void DrawTexturedQuad3DGl(int textureId, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight,
+        Vec2 uvMin, Vec2 uvMax, Color color);
+void DrawVerticesGl(const float* vertices, int vertexCount, const uint32_t* indices, int indexCount, int textureId);
+ReservedGeometry ReserveGeometryGl(int vertexCount, int indexCount, int textureId);
+RenderStats GetRenderStatsGl();
+void DrawDebugLinesGl(const DebugLineVertex* vertices, int vertexCount, const DebugLineBatch* batches, int batchCount);
 
 // -- OpenGL initialization --
 
@@ -46,6 +75,7 @@ void SetTransparencyModeGl(bool shouldEnable);
         PFNGLATTACHSHADERPROC glAttachShader;
         PFNGLCOMPILESHADERPROC glCompileShader;
         PFNGLCREATEPROGRAMPROC glCreateProgram;
+        PFNGLDELETEPROGRAMPROC glDeleteProgram;
         PFNGLCREATESHADERPROC glCreateShader;
         PFNGLDELETESHADERPROC glDeleteShader;
         PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
@@ -62,6 +92,39 @@ void SetTransparencyModeGl(bool shouldEnable);
         PFNGLBUFFERSUBDATAPROC glBufferSubData;
         PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
         PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
+        PFNGLUNIFORM1IPROC glUniform1i;
+        PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
+        PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
+        PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+        PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
+        PFNGLFENCESYNCPROC glFenceSync;
+        PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+        PFNGLDELETESYNCPROC glDeleteSync;
+        PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
+        PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
+        PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
+        PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus;
+        PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer;
+        PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
+        PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
+        PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
+        PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer;
+        PFNGLGENQUERIESPROC glGenQueries;
+        PFNGLBEGINQUERYPROC glBeginQuery;
+        PFNGLENDQUERYPROC glEndQuery;
+        PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv;
+        PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+        PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+        PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+        PFNGLDRAWBUFFERSPROC glDrawBuffers;
+        PFNGLCLEARBUFFERFVPROC glClearBufferfv;
+        PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
+        PFNGLACTIVETEXTUREPROC glActiveTexture;
+        PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC glGetFramebufferAttachmentParameteriv;
+        // optional, NULL if program binaries are unsupported
+        PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+        PFNGLPROGRAMBINARYPROC glProgramBinary;
+        PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
     } OpenGlExt;
 
     void InitGraphicsGl(OpenGlExt openglExt); // call at window creation
@@ -7,7 +7,7 @@
 // -- Window --
 
 typedef struct {
-    void (*InitWindow)(const char* title);
+    void (*InitWindow)(const char* title, WindowSettings settings);
 } PlatformWindow;
 
 void InitPlatformWindow(PlatformWindow platformWindow);
@@ -49,20 +49,158 @@ typedef struct {
 
 void InitPlatformTiming(PlatformTiming timing);
 
+// -- Threading --
+
+typedef void (*ThreadFn)(void* arg);
+
+typedef struct {
+    void* (*StartThread)(ThreadFn fn, void* arg);
+    void (*JoinThread)(void* thread);
+    // true once the thread has finished or was terminated, without waiting
+    bool (*HasThreadExited)(void* thread);
+    // auto-reset event
+    void* (*CreateSignal)();
+    void (*SetSignal)(void* signal);
+    bool (*WaitSignal)(void* signal, int timeoutMs); // negative timeout waits forever
+    void (*SleepThread)(int ms);
+    // non-recursive mutual exclusion lock
+    void* (*CreateLock)();
+    void (*AcquireLock)(void* lock);
+    void (*ReleaseLock)(void* lock);
+    int (*GetProcessorCount)();
+} PlatformThreading;
+
+void InitPlatformThreading(PlatformThreading threading);
+
+// -- Memory --
+
+typedef struct {
+    // reserve and commit zeroed memory, at the given base address if possible (NULL for any address)
+    void* (*AllocatePages)(void* baseAddress, uint64_t size);
+    void (*FreePages)(void* memory, uint64_t size);
+} PlatformMemory;
+
+void InitPlatformMemory(PlatformMemory memory);
+
+// -- Files --
+
+typedef struct {
+    // map a whole file as read-only memory, returns NULL on failure
+    void* (*MapFile)(const char* path, uint64_t* size, void** mapping);
+    void (*UnmapFile)(void* data, void* mapping);
+} PlatformFiles;
+
+void InitPlatformFiles(PlatformFiles files);
+
+// -- Fonts --
+
+typedef struct {
+    int width;
+    int height;
+    int xOffset; // from the pen position to the left edge
+    int yOffset; // from the baseline up to the top edge
+    int advance;
+    uint8_t* coverage; // width * height, top row first, allocated with malloc
+} GlyphBitmap;
+
+typedef struct {
+    int first;
+    int second;
+    int amount;
+} KerningPair;
+
+typedef struct {
+    void* (*LoadFont)(const char* faceName, int pixelHeight); // returns NULL if the font is not found
+    void (*FreeFont)(void* font);
+    void (*GetFontMetrics)(void* font, int* ascent, int* descent, int* lineGap);
+    bool (*RasterizeGlyph)(void* font, int codepoint, GlyphBitmap* glyph); // returns false if the glyph is missing
+    int (*GetKerningPairs)(void* font, KerningPair* pairs, int maxPairs); // pairs can be NULL to get the count
+} PlatformFonts;
+
+void InitPlatformFonts(PlatformFonts fonts);
+
 // -- Graphics --
 
+// vertex layout of the batch: 3 coordinates + 4 color channels + 2 texture coordinates, see also asset_pack.h
+#define RENDER_FLOATS_PER_VERTEX 9
+
+// a range of the batch, reserved for the caller to fill in
+typedef struct {
+    float* vertices; // vertexCount * RENDER_FLOATS_PER_VERTEX
+    uint32_t* indices;
+    uint32_t baseVertex; // index of the first reserved vertex, to add to each index
+} ReservedGeometry;
+
+// compact vertex for debug lines
+typedef struct {
+    float x;
+    float y;
+    float z;
+    uint32_t color; // RGBA8, red in the lowest byte
+} DebugLineVertex;
+
+// a range of debug line vertices drawn with the same settings
+typedef struct {
+    bool isOverlay;
+    int cameraSlot;
+    int vertexStart;
+    int vertexCount;
+} DebugLineBatch;
+
+// frames are numbered by the backend, counting presented frames from 1
+typedef struct {
+    uint64_t presentedFrame; // the frame that was presented last
+    uint64_t completedFrame; // the latest frame that the GPU was seen finishing, 0 if none
+    uint64_t completedTicks; // when it was seen finishing
+    uint64_t waitMicros; // spent waiting in the last EndFrame to limit the frames in flight
+} FramePresentInfo;
+
 typedef struct {
     void (*Configure)(RenderSettings settings);
     void (*ClearScreen)(Color color);
     void (*MakeDrawCall)();
     void (*EndFrame)();
     void (*SetTransform)(Mat4 mat);
-    void (*SetCamera2D)(Camera2D* camera);
-    void (*SetCamera3D)(Camera3D* camera);
+    void (*SetCamera2D)(int slot, Camera2D* camera);
+    void (*SetCamera3D)(int slot, Camera3D* camera);
+    void (*UseCameraSlot)(int slot);
     void (*DrawTriangle2D)(Vec2 a, Vec2 b, Vec2 c, Color color);
     void (*DrawTriangle3D)(Vec3 a, Vec3 b, Vec3 c, Color color);
     void (*DrawQuad3D)(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color color);
     void (*SetTransparencyMode)(bool shouldEnable);
+    void (*SetTransparencyMethod)(TransparencyMethod method);
+    void (*SetDepthPrepassMode)(bool shouldEnable);
+    int (*CreateShader)(const char* vertexSrc, const char* fragmentSrc);
+    int (*CreateMaterial)(int shaderId);
+    void (*SetMaterialParams)(int materialId, const void* params, int size);
+    void (*UseMaterial)(int materialId);
+    int (*CreateTexture)(const uint8_t* pixels, int width, int height);
+    void (*UpdateTexture)(int textureId, int x, int y, int width, int height, const uint8_t* pixels);
+    void (*DrawTexturedQuad3D)(int textureId, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight,
+            Vec2 uvMin, Vec2 uvMax, Color color);
+    // vertices in the backend vertex layout (position, color, texture coordinates)
+    void (*DrawVertices)(const float* vertices, int vertexCount, const uint32_t* indices, int indexCount, int textureId);
+    ReservedGeometry (*ReserveGeometry)(int vertexCount, int indexCount, int textureId);
+    RenderStats (*GetStats)();
+    void (*DrawDebugLines)(const DebugLineVertex* vertices, int vertexCount, const DebugLineBatch* batches, int batchCount);
+    bool (*SetSwapInterval)(SwapInterval interval); // returns false if unsupported
+    void (*SetMaxFramesInFlight)(int frameCount); // 0 for no limit
+    FramePresentInfo (*GetPresentInfo)();
+    int (*CreateRenderTarget)(int width, int height, int* textureId);
+    void (*ResizeRenderTarget)(int targetId, int width, int height);
+    // -1 for the window, otherwise draws into the bottom left width x height region of the target
+    void (*UseRenderTarget)(int targetId, int width, int height);
+    // stretches the bottom left width x height region of the target over the window
+    void (*BlitRenderTarget)(int targetId, int width, int height);
+    // one timer at a time, read back without waiting
+    void (*BeginGpuTimer)();
+    void (*EndGpuTimer)();
+    bool (*ReadGpuTimer)(uint64_t* nanoseconds); // returns false if no new result is available
+    // copies the window without waiting, returns false if too many readbacks are pending
+    bool (*RequestReadback)();
+    // the oldest readback, rows bottom up, or NULL if not done yet. Unmap after a successful map.
+    const uint8_t* (*MapReadback)(int* width, int* height, bool shouldWait);
+    void (*UnmapReadback)();
 } PlatformRender;
 
 void InitPlatformRender(PlatformRender platformRender);
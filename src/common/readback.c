@@ -0,0 +1,321 @@
+/*
+ * Frame readback.
+ *
+ * REQUESTS
+ *
+ * Screenshots, recordings and callbacks during a frame are combined into one request, so a frame
+ * is copied at most once. At the end of the frame the request is handed to the render backend,
+ * which copies the render target in use into a pixel buffer without waiting for the GPU.
+ * The requests stay in a small ring, in the same order as the backend readbacks.
+ *
+ * COLLECTION
+ *
+ * At the end of each frame, the finished readbacks are mapped, usually two frames after their request.
+ * The rows are flipped into a malloc buffer while copying, since the mapped memory has to be unmapped
+ * on the render thread. If the backend has no free buffer for a new request, the oldest readback
+ * is waited for, which only happens when the GPU is several frames behind.
+ *
+ * WRITER
+ *
+ * One background thread encodes and writes the frames, or calls the callbacks, in request order,
+ * so the frames of a raw recording are appended in order. The job ring is protected by a lock.
+ * When it is full, the render thread waits for the writer, so a slow disk slows the frames
+ * rather than using unbounded memory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "platform_setup.h"
+#include "asserts.h"
+#include "atomics.h"
+#include "threading.h"
+#include "image_png.h"
+#include "render.h"
+#include "readback.h"
+
+#define READBACK_MAX_PENDING 4
+#define READBACK_MAX_JOBS 8
+#define READBACK_WRITER_WAIT_MS 100
+
+typedef struct {
+    uint64_t frame;
+    FrameReadbackFn fn;
+    void* userData;
+    char screenshotPath[LIBGAME_MAX_READBACK_PATH]; // empty for none
+    bool isRecorded;
+    int recordedIndex;
+    uint8_t* pixels; // top row first, set once collected
+    int width;
+    int height;
+} FrameReadback;
+
+typedef struct {
+    FrameReadback jobs[READBACK_MAX_JOBS];
+    int head;
+    int tail;
+    void* lock;
+} ReadbackQueue;
+
+typedef struct {
+    bool isActive;
+    bool isEnding;
+    FrameRecordingFormat format;
+    char path[LIBGAME_MAX_READBACK_PATH];
+    FILE* rawFile;
+    int rawWidth; // size of the first frame, the other frames of a raw file must match
+    int rawHeight;
+    int frameCount;
+} FrameRecording;
+
+static FrameReadback currentRequest = {0};
+static bool hasCurrentRequest = false;
+static uint64_t currentFrame = 1;
+
+// requested from the backend, oldest first
+static FrameReadback pendingReadbacks[READBACK_MAX_PENDING];
+static int pendingStart = 0;
+static int pendingCount = 0;
+
+static FrameRecording recording = {0};
+
+static ReadbackQueue jobQueue = {0};
+static void* jobSignal = NULL;
+static void* writer = NULL;
+static uint32_t pushedJobCount = 0;
+static volatile uint32_t writtenJobCount = 0;
+
+// -- Writer --
+
+static void WritePngFile(const char* path, const uint8_t* pixels, int width, int height) {
+    uint8_t* encoded = (uint8_t*)malloc(GetPngEncodedSize(width, height));
+    if (encoded == NULL) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to allocate the PNG for %s\n", path);
+        return;
+    }
+    uint64_t size = EncodePng(pixels, width, height, encoded);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL || fwrite(encoded, 1, size, file) != size) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to write %s\n", path);
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    free(encoded);
+}
+
+static void WriteRecordedFrame(FrameReadback* readback) {
+    if (recording.format == FRAME_RECORDING_PNG) {
+        char path[LIBGAME_MAX_READBACK_PATH + 16];
+        snprintf(path, sizeof(path), "%s_%06d.png", recording.path, readback->recordedIndex);
+        WritePngFile(path, readback->pixels, readback->width, readback->height);
+        return;
+    }
+
+    if (recording.rawWidth == 0) {
+        recording.rawWidth = readback->width;
+        recording.rawHeight = readback->height;
+        LogInfoIn(LOG_CATEGORY_RENDER, "Recording %dx%d RGBA frames to %s\n", readback->width, readback->height, recording.path);
+    }
+    if (readback->width != recording.rawWidth || readback->height != recording.rawHeight) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Skipped frame %llu of the recording, the size changed to %dx%d\n",
+                (unsigned long long)readback->frame, readback->width, readback->height);
+        return;
+    }
+    fwrite(readback->pixels, 4, (size_t)readback->width * readback->height, recording.rawFile);
+}
+
+static void WriteReadback(FrameReadback* readback) {
+    if (readback->fn != NULL) {
+        readback->fn(readback->pixels, readback->width, readback->height, readback->frame, readback->userData);
+    }
+    if (readback->screenshotPath[0] != '\0') {
+        WritePngFile(readback->screenshotPath, readback->pixels, readback->width, readback->height);
+    }
+    if (readback->isRecorded) {
+        WriteRecordedFrame(readback);
+    }
+    free(readback->pixels);
+}
+
+static void RunReadbackWriter(void* arg) {
+    while (true) {
+        FrameReadback readback;
+        bool hasJob = false;
+
+        AcquireLock(jobQueue.lock);
+        if (jobQueue.head != jobQueue.tail) {
+            readback = jobQueue.jobs[jobQueue.head % READBACK_MAX_JOBS];
+            jobQueue.head++;
+            hasJob = true;
+        }
+        ReleaseLock(jobQueue.lock);
+
+        if (!hasJob) {
+            WaitSignal(jobSignal, READBACK_WRITER_WAIT_MS);
+            continue;
+        }
+        WriteReadback(&readback);
+        AtomicAdd(&writtenJobCount, 1);
+    }
+}
+
+static void PushReadbackJob(FrameReadback* readback) {
+    if (writer == NULL) {
+        jobQueue.lock = CreateLock();
+        jobSignal = CreateSignal();
+        writer = StartThread(RunReadbackWriter, NULL);
+    }
+
+    // wait for the writer while the ring is full
+    while (pushedJobCount - AtomicLoad(&writtenJobCount) >= READBACK_MAX_JOBS) {
+        SleepThread(1);
+    }
+
+    AcquireLock(jobQueue.lock);
+    jobQueue.jobs[jobQueue.tail % READBACK_MAX_JOBS] = *readback;
+    jobQueue.tail++;
+    ReleaseLock(jobQueue.lock);
+
+    pushedJobCount++;
+    SetSignal(jobSignal);
+}
+
+// -- Collection --
+
+// returns false if the oldest readback is not done yet
+static bool CollectReadback(bool shouldWait) {
+    if (pendingCount == 0) {
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    const uint8_t* mapped = MapReadback(&width, &height, shouldWait);
+    if (mapped == NULL) {
+        return false;
+    }
+
+    FrameReadback* readback = &pendingReadbacks[pendingStart];
+    uint64_t rowSize = (uint64_t)width * 4;
+    readback->pixels = (uint8_t*)malloc(rowSize * height);
+    Assert(readback->pixels != NULL, "Failed to allocate a %dx%d readback", width, height);
+    for (int y = 0; y < height; y++) {
+        memcpy(readback->pixels + y * rowSize, mapped + (uint64_t)(height - 1 - y) * rowSize, rowSize);
+    }
+    UnmapReadback();
+
+    readback->width = width;
+    readback->height = height;
+    pendingStart = (pendingStart + 1) % READBACK_MAX_PENDING;
+    pendingCount--;
+    PushReadbackJob(readback);
+    return true;
+}
+
+static void RequestFrameReadback(FrameReadback* request) {
+    if (pendingCount == READBACK_MAX_PENDING) {
+        CollectReadback(true);
+    }
+    while (!RequestReadback()) {
+        if (!CollectReadback(true)) {
+            LogWarningIn(LOG_CATEGORY_RENDER, "Skipped the readback of frame %llu\n", (unsigned long long)request->frame);
+            return;
+        }
+    }
+    pendingReadbacks[(pendingStart + pendingCount) % READBACK_MAX_PENDING] = *request;
+    pendingCount++;
+}
+
+static void WaitForReadbacks() {
+    while (CollectReadback(true)) {
+    }
+    while (AtomicLoad(&writtenJobCount) != pushedJobCount) {
+        SleepThread(1);
+    }
+}
+
+static void FinishFrameRecording() {
+    WaitForReadbacks();
+    if (recording.rawFile != NULL) {
+        fclose(recording.rawFile);
+    }
+    LogInfoIn(LOG_CATEGORY_RENDER, "Recorded %d frames to %s\n", recording.frameCount, recording.path);
+    recording = (FrameRecording){0};
+}
+
+void AdvanceFrameReadback() {
+    while (CollectReadback(false)) {
+    }
+
+    if (recording.isActive) {
+        currentRequest.isRecorded = true;
+        currentRequest.recordedIndex = recording.frameCount++;
+        hasCurrentRequest = true;
+    }
+    if (hasCurrentRequest) {
+        currentRequest.frame = currentFrame;
+        RequestFrameReadback(&currentRequest);
+        currentRequest = (FrameReadback){0};
+        hasCurrentRequest = false;
+    }
+
+    if (recording.isEnding) {
+        FinishFrameRecording();
+    }
+    currentFrame++;
+}
+
+// -- Public API --
+
+void ReadbackFrame(FrameReadbackFn fn, void* userData) {
+    Assert(currentRequest.fn == NULL, "The current frame is already read back by a callback");
+    currentRequest.fn = fn;
+    currentRequest.userData = userData;
+    hasCurrentRequest = true;
+}
+
+void SaveScreenshot(const char* path) {
+    Assert(strlen(path) < LIBGAME_MAX_READBACK_PATH, "Screenshot path is too long. Max is %d.", LIBGAME_MAX_READBACK_PATH - 1);
+    Assert(currentRequest.screenshotPath[0] == '\0', "A screenshot of the current frame is already requested");
+    strcpy(currentRequest.screenshotPath, path);
+    hasCurrentRequest = true;
+}
+
+bool BeginFrameRecording(const char* path, FrameRecordingFormat format) {
+    Assert(strlen(path) < LIBGAME_MAX_READBACK_PATH, "Recording path is too long. Max is %d.", LIBGAME_MAX_READBACK_PATH - 1);
+    if (recording.isActive) {
+        return false;
+    }
+
+    FILE* rawFile = NULL;
+    if (format == FRAME_RECORDING_RAW) {
+        rawFile = fopen(path, "wb");
+        if (rawFile == NULL) {
+            LogWarningIn(LOG_CATEGORY_RENDER, "Unable to open recording %s\n", path);
+            return false;
+        }
+    }
+
+    recording = (FrameRecording){0};
+    recording.isActive = true;
+    recording.format = format;
+    recording.rawFile = rawFile;
+    strcpy(recording.path, path);
+    return true;
+}
+
+void EndFrameRecording() {
+    if (recording.isActive) {
+        recording.isEnding = true;
+    }
+}
+
+bool IsFrameRecordingActive() {
+    return recording.isActive && !recording.isEnding;
+}
+
+void FlushFrameReadbacks() {
+    WaitForReadbacks();
+}
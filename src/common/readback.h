@@ -0,0 +1,7 @@
+#ifndef readback_h
+#define readback_h
+
+// call at the end of a frame, after the last draw and before the buffers are swapped
+void AdvanceFrameReadback();
+
+#endif
@@ -1,21 +1,42 @@
 /*
  * Public API render functions.
  *
- * Delegates to the configured platform render functions.
+ * Delegates to the configured platform render functions,
+ * which are wrapped for render captures (see render_capture.c).
  */
 
+#include <stddef.h>
 #include "platform_setup.h"
+#include "asserts.h"
+#include "memory.h"
+#include "assets.h"
+#include "debug_draw.h"
+#include "input.h"
+#include "render.h"
+#include "render_capture.h"
+#include "readback.h"
 
 PlatformRender render = {};
+static int currentCameraSlot = 0;
+static Material currentMaterial = {0};
+
+// input ticks of the recently presented frames, by frame number
+#define LATENCY_HISTORY 16
+static uint64_t presentedInputTicks[LATENCY_HISTORY] = {0};
+static FrameLatency frameLatency = {0};
 
 void InitPlatformRender(PlatformRender pr) {
-    render = pr;
+    render = InitRenderCapture(pr);
 }
 
 void ConfigureRender(RenderSettings settings) {
    render.Configure(settings);
 }
 
+RenderStats GetRenderStats() {
+    return render.GetStats();
+}
+
 void ClearScreen(Color color) {
    render.ClearScreen(color);
 }
@@ -24,8 +45,52 @@ void MakeDrawCall() {
    render.MakeDrawCall();
 }
 
+bool ConfigurePresent(PresentSettings settings) {
+    Assert(settings.maxFramesInFlight >= 0 && settings.maxFramesInFlight <= LIBGAME_MAX_FRAMES_IN_FLIGHT,
+            "Invalid max frames in flight %d. Max is %d.", settings.maxFramesInFlight, LIBGAME_MAX_FRAMES_IN_FLIGHT);
+    render.SetMaxFramesInFlight(settings.maxFramesInFlight);
+    return render.SetSwapInterval(settings.swapInterval);
+}
+
+FrameLatency GetFrameLatency() {
+    return frameLatency;
+}
+
+static void UpdateFrameLatency() {
+    uint64_t inputTicks = GetInputTicks();
+    if (inputTicks == 0) {
+        return;
+    }
+
+    FramePresentInfo info = render.GetPresentInfo();
+    presentedInputTicks[info.presentedFrame % LATENCY_HISTORY] = inputTicks;
+    frameLatency.inputToPresentMicros = GetTicks() - inputTicks;
+    frameLatency.fenceWaitMicros = info.waitMicros;
+
+    bool isInHistory = info.completedFrame > 0 && info.presentedFrame - info.completedFrame < LATENCY_HISTORY;
+    uint64_t completedInputTicks = isInHistory ? presentedInputTicks[info.completedFrame % LATENCY_HISTORY] : 0;
+    if (completedInputTicks > 0 && info.completedTicks >= completedInputTicks) {
+        frameLatency.inputToGpuDoneMicros = info.completedTicks - completedInputTicks;
+    }
+}
+
 void EndFrame() {
+   ProcessAssetUploads();
+
+   const DebugLineVertex* lineVertices = NULL;
+   const DebugLineBatch* lineBatches = NULL;
+   int lineVertexCount = 0;
+   int lineBatchCount = BuildDebugLines(&lineVertices, &lineVertexCount, &lineBatches);
+   if (lineBatchCount > 0) {
+       render.DrawDebugLines(lineVertices, lineVertexCount, lineBatches, lineBatchCount);
+   }
+
+   // after everything is drawn, before the buffers are swapped
+   AdvanceFrameReadback();
    render.EndFrame();
+   UpdateFrameLatency();
+   AdvanceRenderCapture(&render);
+   ResetFrameArena();
 }
 
 void SetTransform(Mat4 mat) {
@@ -33,11 +98,35 @@ void SetTransform(Mat4 mat) {
 }
 
 void SetCamera2D(Camera2D* camera) {
-   render.SetCamera2D(camera);
+   render.SetCamera2D(currentCameraSlot, camera);
 }
 
 void SetCamera3D(Camera3D* camera) {
-   render.SetCamera3D(camera);
+   render.SetCamera3D(currentCameraSlot, camera);
+}
+
+static void AssertCameraSlot(int slot) {
+    Assert(slot >= 0 && slot < LIBGAME_MAX_CAMERAS, "Invalid camera slot %d. Max is %d.", slot, LIBGAME_MAX_CAMERAS - 1);
+}
+
+void SetCameraSlot2D(int slot, Camera2D* camera) {
+    AssertCameraSlot(slot);
+    render.SetCamera2D(slot, camera);
+}
+
+void SetCameraSlot3D(int slot, Camera3D* camera) {
+    AssertCameraSlot(slot);
+    render.SetCamera3D(slot, camera);
+}
+
+void UseCameraSlot(int slot) {
+    AssertCameraSlot(slot);
+    currentCameraSlot = slot;
+    render.UseCameraSlot(slot);
+}
+
+int GetCurrentCameraSlot() {
+    return currentCameraSlot;
 }
 
 void DrawTriangle2D(Vec2 a, Vec2 b, Vec2 c, Color color) {
@@ -55,3 +144,171 @@ void DrawQuad3D(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight,
 void SetTransparencyMode(bool shouldEnable) {
     render.SetTransparencyMode(shouldEnable);
 }
+
+void SetTransparencyMethod(TransparencyMethod method) {
+    render.SetTransparencyMethod(method);
+}
+
+void SetDepthPrepassMode(bool shouldEnable) {
+    render.SetDepthPrepassMode(shouldEnable);
+}
+
+Shader CreateShader(const char* vertexSrc, const char* fragmentSrc) {
+    Shader shader = {0};
+    shader.id = render.CreateShader(vertexSrc, fragmentSrc);
+    return shader;
+}
+
+static void AssertShader(Shader shader) {
+    Assert(shader.id >= 0 && shader.id < LIBGAME_MAX_SHADERS, "Invalid shader %d", shader.id);
+}
+
+static void AssertMaterial(Material material) {
+    Assert(material.id >= 0 && material.id < LIBGAME_MAX_MATERIALS, "Invalid material %d", material.id);
+}
+
+Material CreateMaterial(Shader shader) {
+    AssertShader(shader);
+    Material material = {0};
+    material.id = render.CreateMaterial(shader.id);
+    return material;
+}
+
+void SetMaterialParams(Material material, const void* params, int size) {
+    AssertMaterial(material);
+    Assert(size >= 0 && size <= LIBGAME_MAX_MATERIAL_PARAMS_SIZE, "Material params are too large (%d bytes). Max is %d.",
+            size, LIBGAME_MAX_MATERIAL_PARAMS_SIZE);
+    render.SetMaterialParams(material.id, params, size);
+}
+
+void UseMaterial(Material material) {
+    AssertMaterial(material);
+    render.UseMaterial(material.id);
+    currentMaterial = material;
+}
+
+Material GetCurrentMaterial() {
+    return currentMaterial;
+}
+
+Texture CreateTexture(const uint8_t* pixels, int width, int height) {
+    Assert(width > 0 && height > 0, "Invalid texture size %dx%d", width, height);
+    Texture texture = {0};
+    texture.id = render.CreateTexture(pixels, width, height);
+    texture.width = width;
+    texture.height = height;
+    return texture;
+}
+
+static void AssertTexture(Texture texture) {
+    Assert(texture.id >= 0 && texture.id < LIBGAME_MAX_TEXTURES, "Invalid texture %d", texture.id);
+}
+
+void UpdateTexture(Texture texture, int x, int y, int width, int height, const uint8_t* pixels) {
+    AssertTexture(texture);
+    render.UpdateTexture(texture.id, x, y, width, height, pixels);
+}
+
+Sprite GetTextureSprite(Texture texture) {
+    Sprite sprite = {0};
+    sprite.texture = texture;
+    sprite.uvMin = (Vec2){ 0, 0 };
+    sprite.uvMax = (Vec2){ 1, 1 };
+    sprite.width = texture.width;
+    sprite.height = texture.height;
+    return sprite;
+}
+
+void DrawSprite2D(Sprite sprite, Vec2 position, Vec2 size, Color tint) {
+    Vec3 topLeft = { position.x, position.y + size.y, 0 };
+    Vec3 topRight = { position.x + size.x, position.y + size.y, 0 };
+    Vec3 bottomLeft = { position.x, position.y, 0 };
+    Vec3 bottomRight = { position.x + size.x, position.y, 0 };
+    DrawSprite3D(sprite, topLeft, topRight, bottomLeft, bottomRight, tint);
+}
+
+void DrawSprite3D(Sprite sprite, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color tint) {
+    AssertTexture(sprite.texture);
+    render.DrawTexturedQuad3D(sprite.texture.id, topLeft, topRight, bottomLeft, bottomRight, sprite.uvMin, sprite.uvMax, tint);
+}
+
+RenderTarget CreateRenderTarget(int width, int height) {
+    Assert(width > 0 && height > 0, "Invalid render target size %dx%d", width, height);
+    RenderTarget target = {0};
+    int textureId = 0;
+    target.id = render.CreateRenderTarget(width, height, &textureId);
+    target.texture = (Texture){ textureId, width, height };
+    return target;
+}
+
+static void AssertRenderTarget(RenderTarget target) {
+    Assert(target.id >= 0 && target.id < LIBGAME_MAX_RENDER_TARGETS, "Invalid render target %d", target.id);
+}
+
+void ResizeRenderTarget(RenderTarget* target, int width, int height) {
+    AssertRenderTarget(*target);
+    Assert(width > 0 && height > 0, "Invalid render target size %dx%d", width, height);
+    render.ResizeRenderTarget(target->id, width, height);
+    target->texture.width = width;
+    target->texture.height = height;
+}
+
+void UseRenderTarget(RenderTarget target) {
+    AssertRenderTarget(target);
+    render.UseRenderTarget(target.id, target.texture.width, target.texture.height);
+}
+
+void UseWindowRenderTarget() {
+    render.UseRenderTarget(-1, 0, 0);
+}
+
+Sprite GetRenderTargetSprite(RenderTarget target) {
+    Sprite sprite = GetTextureSprite(target.texture);
+    sprite.uvMin = (Vec2){ 0, 1 };
+    sprite.uvMax = (Vec2){ 1, 0 };
+    return sprite;
+}
+
+void UseRenderTargetRegion(RenderTarget target, int width, int height) {
+    AssertRenderTarget(target);
+    render.UseRenderTarget(target.id, width, height);
+}
+
+void BlitRenderTarget(RenderTarget target, int width, int height) {
+    AssertRenderTarget(target);
+    render.BlitRenderTarget(target.id, width, height);
+}
+
+void BeginGpuTimer() {
+    render.BeginGpuTimer();
+}
+
+void EndGpuTimer() {
+    render.EndGpuTimer();
+}
+
+bool ReadGpuTimer(uint64_t* nanoseconds) {
+    return render.ReadGpuTimer(nanoseconds);
+}
+
+bool RequestReadback() {
+    return render.RequestReadback();
+}
+
+const uint8_t* MapReadback(int* width, int* height, bool shouldWait) {
+    return render.MapReadback(width, height, shouldWait);
+}
+
+void UnmapReadback() {
+    render.UnmapReadback();
+}
+
+ReservedGeometry ReserveGeometry(int vertexCount, int indexCount, Texture texture) {
+    AssertTexture(texture);
+    return render.ReserveGeometry(vertexCount, indexCount, texture.id);
+}
+
+void DrawPackedMesh(PackedMesh mesh, Texture texture) {
+    AssertTexture(texture);
+    render.DrawVertices(mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, texture.id);
+}
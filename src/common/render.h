@@ -0,0 +1,40 @@
+#ifndef render_h
+#define render_h
+
+#include "platform_setup.h"
+
+/*
+ * Reserve vertices and indices in the batch, for shape generators that write them directly.
+ * All of the reserved vertices and indices must be written before the next draw call.
+ */
+ReservedGeometry ReserveGeometry(int vertexCount, int indexCount, Texture texture);
+
+// draws into the bottom left width x height region of the target
+void UseRenderTargetRegion(RenderTarget target, int width, int height);
+// stretches the bottom left width x height region of the target over the window
+void BlitRenderTarget(RenderTarget target, int width, int height);
+
+// one timer at a time, the result is read back a few frames later without waiting
+void BeginGpuTimer();
+void EndGpuTimer();
+bool ReadGpuTimer(uint64_t* nanoseconds); // returns false if no new result is available
+
+// copies the window without waiting, returns false if too many readbacks are pending
+bool RequestReadback();
+// the oldest readback, rows bottom up, or NULL if not done yet. Unmap after a successful map.
+const uint8_t* MapReadback(int* width, int* height, bool shouldWait);
+void UnmapReadback();
+
+static inline void WriteRenderVertex(float* target, float x, float y, float z, Color color, float u, float v) {
+    target[0] = x;
+    target[1] = y;
+    target[2] = z;
+    target[3] = color.r;
+    target[4] = color.g;
+    target[5] = color.b;
+    target[6] = color.a;
+    target[7] = u;
+    target[8] = v;
+}
+
+#endif
@@ -0,0 +1,1218 @@
+/*
+ * Render capture and replay.
+ *
+ * TRACKING
+ *
+ * The backend is always wrapped by a thin layer that remembers the shaders, materials,
+ * textures, render targets, cameras and other state set through the render functions. Only calls that happen
+ * a few times per frame at most are wrapped. When a capture starts, the tracked state is written
+ * as a prologue, so that the captured frames replay correctly without the frames before them.
+ * Texture pixels are not kept, so textures created before the capture are recreated with
+ * the right size but undefined contents. Textures created or updated during the capture keep their pixels.
+ *
+ * CAPTURE
+ *
+ * A capture starts at the next frame boundary, by swapping the render functions for recording
+ * versions, which append a command to a memory buffer and forward the call to the backend.
+ * The buffer is written to the file after the last captured frame, so that the frames don't wait for the disk.
+ *
+ * GPU timers are not recorded, the replay measures its own time.
+ *
+ * Reserved geometry is filled in by the caller after the reservation returns, so it is recorded
+ * by the next recorded call (when it is complete), as vertices relative to the reservation.
+ *
+ * FILE FORMAT
+ *
+ * A header, followed by commands. A command is a 32 bit opcode followed by its payload.
+ * Everything is padded to 4 bytes, so that arrays can be passed to the backend straight from the file.
+ * Values are stored as they are in memory (little endian, with the struct layout of this build).
+ * The commands before the first frame are the prologue.
+ *
+ * REPLAY
+ *
+ * Commands are fed to the backend directly. Resource ids are mapped from the captured ids to
+ * the ids created by the replay. Resources are only created once, so a capture can be replayed
+ * over and over. The prologue runs again before each pass over the frames, to restore the state.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "assets.h"
+#include "render_capture.h"
+
+#define RENDER_CAPTURE_MAGIC 0x4352474c // "LGRC"
+#define RENDER_CAPTURE_VERSION 4
+#define INITIAL_CAPTURE_CAPACITY (1 << 20)
+#define MAX_CAPTURE_PATH 260
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t frameCount;
+    int32_t width;
+    int32_t height;
+    int32_t maxVertices;
+    int32_t maxVertexIndices;
+    uint32_t prologueSize;
+    uint64_t commandSize; // including the prologue
+} RenderCaptureHeader;
+
+typedef enum {
+    CAPTURE_CLEAR_SCREEN = 1,
+    CAPTURE_MAKE_DRAW_CALL,
+    CAPTURE_END_FRAME,
+    CAPTURE_SET_TRANSFORM,
+    CAPTURE_SET_CAMERA_2D,
+    CAPTURE_SET_CAMERA_3D,
+    CAPTURE_USE_CAMERA_SLOT,
+    CAPTURE_DRAW_TRIANGLE_2D,
+    CAPTURE_DRAW_TRIANGLE_3D,
+    CAPTURE_DRAW_QUAD_3D,
+    CAPTURE_SET_TRANSPARENCY_MODE,
+    CAPTURE_CREATE_SHADER,
+    CAPTURE_CREATE_MATERIAL,
+    CAPTURE_SET_MATERIAL_PARAMS,
+    CAPTURE_USE_MATERIAL,
+    CAPTURE_CREATE_TEXTURE,
+    CAPTURE_UPDATE_TEXTURE,
+    CAPTURE_DRAW_TEXTURED_QUAD_3D,
+    CAPTURE_DRAW_VERTICES,
+    CAPTURE_DRAW_DEBUG_LINES,
+    CAPTURE_CREATE_RENDER_TARGET,
+    CAPTURE_RESIZE_RENDER_TARGET,
+    CAPTURE_USE_RENDER_TARGET,
+    CAPTURE_BLIT_RENDER_TARGET,
+    CAPTURE_SET_TRANSPARENCY_METHOD,
+    CAPTURE_SET_DEPTH_PREPASS_MODE,
+} CaptureOp;
+
+typedef enum {
+    CaptureIdle,
+    CaptureRequested,
+    CaptureRecording,
+} CaptureState;
+
+typedef struct {
+    char* vertexSrc; // NULL if the shader was not created through the render functions
+    char* fragmentSrc;
+} TrackedShader;
+
+typedef struct {
+    bool isCreated;
+    int shaderId;
+    int paramsSize;
+    uint8_t params[LIBGAME_MAX_MATERIAL_PARAMS_SIZE];
+} TrackedMaterial;
+
+typedef struct {
+    bool isCreated;
+    int width;
+    int height;
+} TrackedTexture;
+
+typedef struct {
+    bool isCreated;
+    int textureId;
+    int width;
+    int height;
+} TrackedRenderTarget;
+
+typedef enum {
+    TrackedCameraUnset,
+    TrackedCamera2D,
+    TrackedCamera3D,
+} TrackedCameraKind;
+
+typedef struct {
+    TrackedCameraKind kind;
+    Camera2D camera2D;
+    Camera3D camera3D;
+} TrackedCamera;
+
+struct RenderCapture {
+    const uint8_t* data;
+    void* handle;
+    RenderCaptureHeader header;
+    const uint8_t* commands;
+    uint64_t offset;
+    bool isInvalid; // set when a command runs past the end or has an invalid value
+    int nextFrame;
+    // replay ids by captured id, -1 until created
+    int shaderIds[LIBGAME_MAX_SHADERS];
+    int materialIds[LIBGAME_MAX_MATERIALS];
+    int textureIds[LIBGAME_MAX_TEXTURES];
+    int renderTargetIds[LIBGAME_MAX_RENDER_TARGETS];
+    // captured sizes by captured id, to check texture updates before they reach the backend
+    int textureWidths[LIBGAME_MAX_TEXTURES];
+    int textureHeights[LIBGAME_MAX_TEXTURES];
+    int renderTargetTextureIds[LIBGAME_MAX_RENDER_TARGETS];
+};
+
+static PlatformRender backend = {0};
+static PlatformRender tracked = {0};
+static PlatformRender capturing = {0};
+
+// -- Tracking --
+
+static int trackedMaxVertices = LIBGAME_DEFAULT_MAX_VERTICES;
+static int trackedMaxVertexIndices = LIBGAME_DEFAULT_MAX_INDICES;
+static TrackedShader trackedShaders[LIBGAME_MAX_SHADERS] = {0};
+static TrackedMaterial trackedMaterials[LIBGAME_MAX_MATERIALS] = {0};
+static TrackedTexture trackedTextures[LIBGAME_MAX_TEXTURES] = {0};
+static TrackedRenderTarget trackedRenderTargets[LIBGAME_MAX_RENDER_TARGETS] = {0};
+static TrackedCamera trackedCameras[LIBGAME_MAX_CAMERAS] = {0};
+static int trackedCameraSlot = 0;
+static int trackedMaterialId = 0;
+static bool trackedTransparencyMode = false;
+static TransparencyMethod trackedTransparencyMethod = TRANSPARENCY_SORTED;
+static bool trackedDepthPrepassMode = false;
+static int trackedRenderTargetId = -1;
+static int trackedRenderTargetWidth = 0;
+static int trackedRenderTargetHeight = 0;
+
+static char* CopyString(const char* s) {
+    size_t length = strlen(s);
+    char* copy = (char*)malloc(length + 1);
+    Assert(copy != NULL, "Failed to copy a shader source for render captures");
+    memcpy(copy, s, length + 1);
+    return copy;
+}
+
+static void ConfigureTracked(RenderSettings settings) {
+    trackedMaxVertices = settings.maxVertices;
+    trackedMaxVertexIndices = settings.maxVertexIndices;
+    backend.Configure(settings);
+}
+
+static void SetCamera2DTracked(int slot, Camera2D* camera) {
+    trackedCameras[slot].kind = TrackedCamera2D;
+    trackedCameras[slot].camera2D = *camera;
+    backend.SetCamera2D(slot, camera);
+}
+
+static void SetCamera3DTracked(int slot, Camera3D* camera) {
+    trackedCameras[slot].kind = TrackedCamera3D;
+    trackedCameras[slot].camera3D = *camera;
+    backend.SetCamera3D(slot, camera);
+}
+
+static void UseCameraSlotTracked(int slot) {
+    trackedCameraSlot = slot;
+    backend.UseCameraSlot(slot);
+}
+
+static void SetTransparencyModeTracked(bool shouldEnable) {
+    trackedTransparencyMode = shouldEnable;
+    backend.SetTransparencyMode(shouldEnable);
+}
+
+static void SetTransparencyMethodTracked(TransparencyMethod method) {
+    trackedTransparencyMethod = method;
+    backend.SetTransparencyMethod(method);
+}
+
+static void SetDepthPrepassModeTracked(bool shouldEnable) {
+    trackedDepthPrepassMode = shouldEnable;
+    backend.SetDepthPrepassMode(shouldEnable);
+}
+
+static int CreateShaderTracked(const char* vertexSrc, const char* fragmentSrc) {
+    int id = backend.CreateShader(vertexSrc, fragmentSrc);
+    if (id >= 0 && id < LIBGAME_MAX_SHADERS) {
+        trackedShaders[id].vertexSrc = CopyString(vertexSrc);
+        trackedShaders[id].fragmentSrc = CopyString(fragmentSrc);
+    }
+    return id;
+}
+
+static int CreateMaterialTracked(int shaderId) {
+    int id = backend.CreateMaterial(shaderId);
+    if (id >= 0 && id < LIBGAME_MAX_MATERIALS) {
+        trackedMaterials[id].isCreated = true;
+        trackedMaterials[id].shaderId = shaderId;
+    }
+    return id;
+}
+
+static void SetMaterialParamsTracked(int materialId, const void* params, int size) {
+    TrackedMaterial* material = &trackedMaterials[materialId];
+    material->paramsSize = size;
+    memcpy(material->params, params, size);
+    backend.SetMaterialParams(materialId, params, size);
+}
+
+static void UseMaterialTracked(int materialId) {
+    trackedMaterialId = materialId;
+    backend.UseMaterial(materialId);
+}
+
+static int CreateTextureTracked(const uint8_t* pixels, int width, int height) {
+    int id = backend.CreateTexture(pixels, width, height);
+    if (id >= 0 && id < LIBGAME_MAX_TEXTURES) {
+        trackedTextures[id] = (TrackedTexture){ true, width, height };
+    }
+    return id;
+}
+
+static int CreateRenderTargetTracked(int width, int height, int* textureId) {
+    int id = backend.CreateRenderTarget(width, height, textureId);
+    if (id >= 0 && id < LIBGAME_MAX_RENDER_TARGETS) {
+        trackedRenderTargets[id] = (TrackedRenderTarget){ true, *textureId, width, height };
+    }
+    return id;
+}
+
+static void ResizeRenderTargetTracked(int targetId, int width, int height) {
+    trackedRenderTargets[targetId].width = width;
+    trackedRenderTargets[targetId].height = height;
+    backend.ResizeRenderTarget(targetId, width, height);
+}
+
+static void UseRenderTargetTracked(int targetId, int width, int height) {
+    trackedRenderTargetId = targetId;
+    trackedRenderTargetWidth = width;
+    trackedRenderTargetHeight = height;
+    backend.UseRenderTarget(targetId, width, height);
+}
+
+// -- Capture buffer --
+
+static CaptureState captureState = CaptureIdle;
+static char capturePath[MAX_CAPTURE_PATH];
+static int requestedFrameCount = 0;
+static int capturedFrameCount = 0;
+static uint32_t prologueSize = 0;
+
+static uint8_t* buffer = NULL;
+static uint64_t bufferSize = 0;
+static uint64_t bufferCapacity = 0;
+
+static uint8_t* ReserveBytes(uint64_t size) {
+    // padded to 4 bytes, see FILE FORMAT
+    uint64_t paddedSize = (size + 3) & ~(uint64_t)3;
+    if (bufferSize + paddedSize > bufferCapacity) {
+        uint64_t capacity = bufferCapacity > 0 ? bufferCapacity : INITIAL_CAPTURE_CAPACITY;
+        while (capacity < bufferSize + paddedSize) {
+            capacity *= 2;
+        }
+        buffer = (uint8_t*)realloc(buffer, capacity);
+        Assert(buffer != NULL, "Failed to grow the render capture buffer to %llu bytes", (unsigned long long)capacity);
+        bufferCapacity = capacity;
+    }
+
+    uint8_t* bytes = buffer + bufferSize;
+    memset(bytes + size, 0, paddedSize - size);
+    bufferSize += paddedSize;
+    return bytes;
+}
+
+static void WriteBytes(const void* data, uint64_t size) {
+    memcpy(ReserveBytes(size), data, size);
+}
+
+static void WriteInt(int32_t value) {
+    WriteBytes(&value, sizeof(value));
+}
+
+static void WriteOp(CaptureOp op) {
+    WriteInt((int32_t)op);
+}
+
+static void WriteString(const char* s) {
+    int32_t length = (int32_t)strlen(s);
+    WriteInt(length);
+    WriteBytes(s, length + 1);
+}
+
+// -- Capture --
+
+static bool hasPendingGeometry = false;
+static ReservedGeometry pendingGeometry = {0};
+static int pendingVertexCount = 0;
+static int pendingIndexCount = 0;
+static int pendingTextureId = 0;
+
+static void WriteDrawVertices(const float* vertices, int vertexCount, const uint32_t* indices, int indexCount,
+        int textureId, uint32_t baseVertex) {
+    WriteOp(CAPTURE_DRAW_VERTICES);
+    WriteInt(textureId);
+    WriteInt(vertexCount);
+    WriteInt(indexCount);
+    WriteBytes(vertices, (uint64_t)vertexCount * RENDER_FLOATS_PER_VERTEX * sizeof(float));
+    uint32_t* target = (uint32_t*)ReserveBytes((uint64_t)indexCount * sizeof(uint32_t));
+    for (int i = 0; i < indexCount; i++) {
+        target[i] = indices[i] - baseVertex;
+    }
+}
+
+// call at the start of every recorded call
+static void FlushPendingGeometry() {
+    if (!hasPendingGeometry) {
+        return;
+    }
+    hasPendingGeometry = false;
+    WriteDrawVertices(pendingGeometry.vertices, pendingVertexCount, pendingGeometry.indices, pendingIndexCount,
+            pendingTextureId, pendingGeometry.baseVertex);
+}
+
+static void ClearScreenCaptured(Color color) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_CLEAR_SCREEN);
+    WriteBytes(&color, sizeof(color));
+    tracked.ClearScreen(color);
+}
+
+static void MakeDrawCallCaptured() {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_MAKE_DRAW_CALL);
+    tracked.MakeDrawCall();
+}
+
+static void EndFrameCaptured() {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_END_FRAME);
+    capturedFrameCount++;
+    tracked.EndFrame();
+}
+
+static void SetTransformCaptured(Mat4 mat) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_SET_TRANSFORM);
+    WriteBytes(&mat, sizeof(mat));
+    tracked.SetTransform(mat);
+}
+
+static void WriteSetCamera2D(int slot, Camera2D* camera) {
+    WriteOp(CAPTURE_SET_CAMERA_2D);
+    WriteInt(slot);
+    WriteBytes(camera, sizeof(Camera2D));
+}
+
+static void WriteSetCamera3D(int slot, Camera3D* camera) {
+    WriteOp(CAPTURE_SET_CAMERA_3D);
+    WriteInt(slot);
+    WriteBytes(camera, sizeof(Camera3D));
+}
+
+static void SetCamera2DCaptured(int slot, Camera2D* camera) {
+    FlushPendingGeometry();
+    WriteSetCamera2D(slot, camera);
+    tracked.SetCamera2D(slot, camera);
+}
+
+static void SetCamera3DCaptured(int slot, Camera3D* camera) {
+    FlushPendingGeometry();
+    WriteSetCamera3D(slot, camera);
+    tracked.SetCamera3D(slot, camera);
+}
+
+static void UseCameraSlotCaptured(int slot) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_USE_CAMERA_SLOT);
+    WriteInt(slot);
+    tracked.UseCameraSlot(slot);
+}
+
+static void DrawTriangle2DCaptured(Vec2 a, Vec2 b, Vec2 c, Color color) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_DRAW_TRIANGLE_2D);
+    Vec2 points[3] = { a, b, c };
+    WriteBytes(points, sizeof(points));
+    WriteBytes(&color, sizeof(color));
+    tracked.DrawTriangle2D(a, b, c, color);
+}
+
+static void DrawTriangle3DCaptured(Vec3 a, Vec3 b, Vec3 c, Color color) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_DRAW_TRIANGLE_3D);
+    Vec3 points[3] = { a, b, c };
+    WriteBytes(points, sizeof(points));
+    WriteBytes(&color, sizeof(color));
+    tracked.DrawTriangle3D(a, b, c, color);
+}
+
+static void DrawQuad3DCaptured(Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color color) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_DRAW_QUAD_3D);
+    Vec3 corners[4] = { topLeft, topRight, bottomLeft, bottomRight };
+    WriteBytes(corners, sizeof(corners));
+    WriteBytes(&color, sizeof(color));
+    tracked.DrawQuad3D(topLeft, topRight, bottomLeft, bottomRight, color);
+}
+
+static void SetTransparencyModeCaptured(bool shouldEnable) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_SET_TRANSPARENCY_MODE);
+    WriteInt(shouldEnable);
+    tracked.SetTransparencyMode(shouldEnable);
+}
+
+static void SetTransparencyMethodCaptured(TransparencyMethod method) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_SET_TRANSPARENCY_METHOD);
+    WriteInt(method);
+    tracked.SetTransparencyMethod(method);
+}
+
+static void SetDepthPrepassModeCaptured(bool shouldEnable) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_SET_DEPTH_PREPASS_MODE);
+    WriteInt(shouldEnable);
+    tracked.SetDepthPrepassMode(shouldEnable);
+}
+
+static void WriteCreateShader(int id, const char* vertexSrc, const char* fragmentSrc) {
+    WriteOp(CAPTURE_CREATE_SHADER);
+    WriteInt(id);
+    WriteString(vertexSrc);
+    WriteString(fragmentSrc);
+}
+
+static int CreateShaderCaptured(const char* vertexSrc, const char* fragmentSrc) {
+    FlushPendingGeometry();
+    int id = tracked.CreateShader(vertexSrc, fragmentSrc);
+    WriteCreateShader(id, vertexSrc, fragmentSrc);
+    return id;
+}
+
+static void WriteCreateMaterial(int id, int shaderId) {
+    WriteOp(CAPTURE_CREATE_MATERIAL);
+    WriteInt(id);
+    WriteInt(shaderId);
+}
+
+static int CreateMaterialCaptured(int shaderId) {
+    FlushPendingGeometry();
+    int id = tracked.CreateMaterial(shaderId);
+    WriteCreateMaterial(id, shaderId);
+    return id;
+}
+
+static void WriteSetMaterialParams(int materialId, const void* params, int size) {
+    WriteOp(CAPTURE_SET_MATERIAL_PARAMS);
+    WriteInt(materialId);
+    WriteInt(size);
+    WriteBytes(params, size);
+}
+
+static void SetMaterialParamsCaptured(int materialId, const void* params, int size) {
+    FlushPendingGeometry();
+    WriteSetMaterialParams(materialId, params, size);
+    tracked.SetMaterialParams(materialId, params, size);
+}
+
+static void UseMaterialCaptured(int materialId) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_USE_MATERIAL);
+    WriteInt(materialId);
+    tracked.UseMaterial(materialId);
+}
+
+static void WriteCreateTexture(int id, const uint8_t* pixels, int width, int height) {
+    WriteOp(CAPTURE_CREATE_TEXTURE);
+    WriteInt(id);
+    WriteInt(width);
+    WriteInt(height);
+    WriteInt(pixels != NULL);
+    if (pixels != NULL) {
+        WriteBytes(pixels, (uint64_t)width * height * 4);
+    }
+}
+
+static int CreateTextureCaptured(const uint8_t* pixels, int width, int height) {
+    FlushPendingGeometry();
+    int id = tracked.CreateTexture(pixels, width, height);
+    WriteCreateTexture(id, pixels, width, height);
+    return id;
+}
+
+static void UpdateTextureCaptured(int textureId, int x, int y, int width, int height, const uint8_t* pixels) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_UPDATE_TEXTURE);
+    WriteInt(textureId);
+    WriteInt(x);
+    WriteInt(y);
+    WriteInt(width);
+    WriteInt(height);
+    WriteBytes(pixels, (uint64_t)width * height * 4);
+    tracked.UpdateTexture(textureId, x, y, width, height, pixels);
+}
+
+static void DrawTexturedQuad3DCaptured(int textureId, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight,
+        Vec2 uvMin, Vec2 uvMax, Color color) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_DRAW_TEXTURED_QUAD_3D);
+    WriteInt(textureId);
+    Vec3 corners[4] = { topLeft, topRight, bottomLeft, bottomRight };
+    Vec2 uvs[2] = { uvMin, uvMax };
+    WriteBytes(corners, sizeof(corners));
+    WriteBytes(uvs, sizeof(uvs));
+    WriteBytes(&color, sizeof(color));
+    tracked.DrawTexturedQuad3D(textureId, topLeft, topRight, bottomLeft, bottomRight, uvMin, uvMax, color);
+}
+
+static void DrawVerticesCaptured(const float* vertices, int vertexCount, const uint32_t* indices, int indexCount, int textureId) {
+    FlushPendingGeometry();
+    WriteDrawVertices(vertices, vertexCount, indices, indexCount, textureId, 0);
+    tracked.DrawVertices(vertices, vertexCount, indices, indexCount, textureId);
+}
+
+static ReservedGeometry ReserveGeometryCaptured(int vertexCount, int indexCount, int textureId) {
+    FlushPendingGeometry();
+    ReservedGeometry geometry = tracked.ReserveGeometry(vertexCount, indexCount, textureId);
+    hasPendingGeometry = true;
+    pendingGeometry = geometry;
+    pendingVertexCount = vertexCount;
+    pendingIndexCount = indexCount;
+    pendingTextureId = textureId;
+    return geometry;
+}
+
+static void DrawDebugLinesCaptured(const DebugLineVertex* vertices, int vertexCount, const DebugLineBatch* batches, int batchCount) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_DRAW_DEBUG_LINES);
+    WriteInt(vertexCount);
+    WriteInt(batchCount);
+    WriteBytes(vertices, (uint64_t)vertexCount * sizeof(DebugLineVertex));
+    WriteBytes(batches, (uint64_t)batchCount * sizeof(DebugLineBatch));
+    tracked.DrawDebugLines(vertices, vertexCount, batches, batchCount);
+}
+
+static void WriteCreateRenderTarget(int id, int textureId, int width, int height) {
+    WriteOp(CAPTURE_CREATE_RENDER_TARGET);
+    WriteInt(id);
+    WriteInt(textureId);
+    WriteInt(width);
+    WriteInt(height);
+}
+
+static int CreateRenderTargetCaptured(int width, int height, int* textureId) {
+    FlushPendingGeometry();
+    int id = tracked.CreateRenderTarget(width, height, textureId);
+    WriteCreateRenderTarget(id, *textureId, width, height);
+    return id;
+}
+
+static void ResizeRenderTargetCaptured(int targetId, int width, int height) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_RESIZE_RENDER_TARGET);
+    WriteInt(targetId);
+    WriteInt(width);
+    WriteInt(height);
+    tracked.ResizeRenderTarget(targetId, width, height);
+}
+
+static void WriteUseRenderTarget(int targetId, int width, int height) {
+    WriteOp(CAPTURE_USE_RENDER_TARGET);
+    WriteInt(targetId);
+    WriteInt(width);
+    WriteInt(height);
+}
+
+static void UseRenderTargetCaptured(int targetId, int width, int height) {
+    FlushPendingGeometry();
+    WriteUseRenderTarget(targetId, width, height);
+    tracked.UseRenderTarget(targetId, width, height);
+}
+
+static void BlitRenderTargetCaptured(int targetId, int width, int height) {
+    FlushPendingGeometry();
+    WriteOp(CAPTURE_BLIT_RENDER_TARGET);
+    WriteInt(targetId);
+    WriteInt(width);
+    WriteInt(height);
+    tracked.BlitRenderTarget(targetId, width, height);
+}
+
+// recreates the tracked resources and state
+static void WritePrologue() {
+    for (int i = 0; i < LIBGAME_MAX_SHADERS; i++) {
+        if (trackedShaders[i].vertexSrc != NULL) {
+            WriteCreateShader(i, trackedShaders[i].vertexSrc, trackedShaders[i].fragmentSrc);
+        }
+    }
+    for (int i = 0; i < LIBGAME_MAX_MATERIALS; i++) {
+        TrackedMaterial* material = &trackedMaterials[i];
+        if (material->isCreated) {
+            WriteCreateMaterial(i, material->shaderId);
+        }
+        if (material->paramsSize > 0) {
+            WriteSetMaterialParams(i, material->params, material->paramsSize);
+        }
+    }
+    for (int i = 0; i < LIBGAME_MAX_TEXTURES; i++) {
+        if (trackedTextures[i].isCreated) {
+            WriteCreateTexture(i, NULL, trackedTextures[i].width, trackedTextures[i].height);
+        }
+    }
+    for (int i = 0; i < LIBGAME_MAX_RENDER_TARGETS; i++) {
+        TrackedRenderTarget* target = &trackedRenderTargets[i];
+        if (target->isCreated) {
+            WriteCreateRenderTarget(i, target->textureId, target->width, target->height);
+        }
+    }
+    for (int i = 0; i < LIBGAME_MAX_CAMERAS; i++) {
+        TrackedCamera* camera = &trackedCameras[i];
+        if (camera->kind == TrackedCamera2D) {
+            WriteSetCamera2D(i, &camera->camera2D);
+        } else if (camera->kind == TrackedCamera3D) {
+            WriteSetCamera3D(i, &camera->camera3D);
+        }
+    }
+    WriteOp(CAPTURE_USE_CAMERA_SLOT);
+    WriteInt(trackedCameraSlot);
+    WriteOp(CAPTURE_USE_MATERIAL);
+    WriteInt(trackedMaterialId);
+    WriteOp(CAPTURE_SET_TRANSPARENCY_METHOD);
+    WriteInt(trackedTransparencyMethod);
+    WriteOp(CAPTURE_SET_TRANSPARENCY_MODE);
+    WriteInt(trackedTransparencyMode);
+    WriteOp(CAPTURE_SET_DEPTH_PREPASS_MODE);
+    WriteInt(trackedDepthPrepassMode);
+    WriteUseRenderTarget(trackedRenderTargetId, trackedRenderTargetWidth, trackedRenderTargetHeight);
+}
+
+static void StartCapture() {
+    bufferSize = 0;
+    capturedFrameCount = 0;
+    hasPendingGeometry = false;
+    WritePrologue();
+    prologueSize = (uint32_t)bufferSize;
+    captureState = CaptureRecording;
+}
+
+static void FinishCapture() {
+    captureState = CaptureIdle;
+
+    RenderCaptureHeader header = {0};
+    header.magic = RENDER_CAPTURE_MAGIC;
+    header.version = RENDER_CAPTURE_VERSION;
+    header.frameCount = capturedFrameCount;
+    header.width = GetClientWidth();
+    header.height = GetClientHeight();
+    header.maxVertices = trackedMaxVertices;
+    header.maxVertexIndices = trackedMaxVertexIndices;
+    header.prologueSize = prologueSize;
+    header.commandSize = bufferSize;
+
+    FILE* file = fopen(capturePath, "wb");
+    if (file == NULL) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to write render capture %s\n", capturePath);
+    } else {
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(buffer, 1, bufferSize, file);
+        fclose(file);
+        LogInfoIn(LOG_CATEGORY_RENDER, "Captured %d frames (%llu bytes) to %s\n",
+                capturedFrameCount, (unsigned long long)bufferSize, capturePath);
+    }
+
+    // captures are rare, don't hold on to the memory
+    free(buffer);
+    buffer = NULL;
+    bufferSize = 0;
+    bufferCapacity = 0;
+}
+
+PlatformRender InitRenderCapture(PlatformRender pr) {
+    backend = pr;
+
+    tracked = pr;
+    tracked.Configure = ConfigureTracked;
+    tracked.SetCamera2D = SetCamera2DTracked;
+    tracked.SetCamera3D = SetCamera3DTracked;
+    tracked.UseCameraSlot = UseCameraSlotTracked;
+    tracked.SetTransparencyMode = SetTransparencyModeTracked;
+    tracked.SetTransparencyMethod = SetTransparencyMethodTracked;
+    tracked.SetDepthPrepassMode = SetDepthPrepassModeTracked;
+    tracked.CreateShader = CreateShaderTracked;
+    tracked.CreateMaterial = CreateMaterialTracked;
+    tracked.SetMaterialParams = SetMaterialParamsTracked;
+    tracked.UseMaterial = UseMaterialTracked;
+    tracked.CreateTexture = CreateTextureTracked;
+    tracked.CreateRenderTarget = CreateRenderTargetTracked;
+    tracked.ResizeRenderTarget = ResizeRenderTargetTracked;
+    tracked.UseRenderTarget = UseRenderTargetTracked;
+
+    capturing = tracked;
+    capturing.ClearScreen = ClearScreenCaptured;
+    capturing.MakeDrawCall = MakeDrawCallCaptured;
+    capturing.EndFrame = EndFrameCaptured;
+    capturing.SetTransform = SetTransformCaptured;
+    capturing.SetCamera2D = SetCamera2DCaptured;
+    capturing.SetCamera3D = SetCamera3DCaptured;
+    capturing.UseCameraSlot = UseCameraSlotCaptured;
+    capturing.DrawTriangle2D = DrawTriangle2DCaptured;
+    capturing.DrawTriangle3D = DrawTriangle3DCaptured;
+    capturing.DrawQuad3D = DrawQuad3DCaptured;
+    capturing.SetTransparencyMode = SetTransparencyModeCaptured;
+    capturing.SetTransparencyMethod = SetTransparencyMethodCaptured;
+    capturing.SetDepthPrepassMode = SetDepthPrepassModeCaptured;
+    capturing.CreateShader = CreateShaderCaptured;
+    capturing.CreateMaterial = CreateMaterialCaptured;
+    capturing.SetMaterialParams = SetMaterialParamsCaptured;
+    capturing.UseMaterial = UseMaterialCaptured;
+    capturing.CreateTexture = CreateTextureCaptured;
+    capturing.UpdateTexture = UpdateTextureCaptured;
+    capturing.DrawTexturedQuad3D = DrawTexturedQuad3DCaptured;
+    capturing.DrawVertices = DrawVerticesCaptured;
+    capturing.ReserveGeometry = ReserveGeometryCaptured;
+    capturing.DrawDebugLines = DrawDebugLinesCaptured;
+    capturing.CreateRenderTarget = CreateRenderTargetCaptured;
+    capturing.ResizeRenderTarget = ResizeRenderTargetCaptured;
+    capturing.UseRenderTarget = UseRenderTargetCaptured;
+    capturing.BlitRenderTarget = BlitRenderTargetCaptured;
+
+    return tracked;
+}
+
+void AdvanceRenderCapture(PlatformRender* render) {
+    if (captureState == CaptureRequested) {
+        StartCapture();
+        *render = capturing;
+    } else if (captureState == CaptureRecording && capturedFrameCount >= requestedFrameCount) {
+        FinishCapture();
+        *render = tracked;
+    }
+}
+
+bool BeginRenderCapture(const char* path, int frameCount) {
+    Assert(frameCount > 0, "Invalid render capture frame count %d", frameCount);
+    Assert(strlen(path) < MAX_CAPTURE_PATH, "Render capture path is too long. Max is %d.", MAX_CAPTURE_PATH - 1);
+    if (captureState != CaptureIdle) {
+        return false;
+    }
+    strcpy(capturePath, path);
+    requestedFrameCount = frameCount;
+    captureState = CaptureRequested;
+    return true;
+}
+
+bool IsRenderCaptureActive() {
+    return captureState != CaptureIdle;
+}
+
+// -- Replay --
+
+RenderCapture* LoadRenderCapture(const char* path) {
+    uint64_t size = 0;
+    void* handle = NULL;
+    const uint8_t* data = ReadFileData(path, &size, &handle);
+    if (data == NULL) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to read render capture %s\n", path);
+        return NULL;
+    }
+
+    RenderCaptureHeader header = {0};
+    if (size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+    }
+    if (header.magic != RENDER_CAPTURE_MAGIC || header.version != RENDER_CAPTURE_VERSION
+            || header.commandSize > size - sizeof(header) || header.prologueSize > header.commandSize
+            || header.frameCount <= 0) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Invalid render capture %s\n", path);
+        FreeFileData(data, handle);
+        return NULL;
+    }
+
+    RenderCapture* capture = (RenderCapture*)calloc(1, sizeof(RenderCapture));
+    Assert(capture != NULL, "Failed to allocate a render capture");
+    capture->data = data;
+    capture->handle = handle;
+    capture->header = header;
+    capture->commands = data + sizeof(header);
+    for (int i = 0; i < LIBGAME_MAX_SHADERS; i++) {
+        capture->shaderIds[i] = i == 0 ? 0 : -1;
+    }
+    for (int i = 0; i < LIBGAME_MAX_MATERIALS; i++) {
+        capture->materialIds[i] = i == 0 ? 0 : -1;
+    }
+    for (int i = 0; i < LIBGAME_MAX_TEXTURES; i++) {
+        capture->textureIds[i] = i == 0 ? 0 : -1;
+    }
+    // the default white texture
+    capture->textureWidths[0] = 1;
+    capture->textureHeights[0] = 1;
+    for (int i = 0; i < LIBGAME_MAX_RENDER_TARGETS; i++) {
+        capture->renderTargetIds[i] = -1;
+    }
+    return capture;
+}
+
+RenderCaptureInfo GetRenderCaptureInfo(RenderCapture* capture) {
+    RenderCaptureInfo info = {0};
+    info.frameCount = capture->header.frameCount;
+    info.width = capture->header.width;
+    info.height = capture->header.height;
+    info.renderSettings.maxVertices = capture->header.maxVertices;
+    info.renderSettings.maxVertexIndices = capture->header.maxVertexIndices;
+    return info;
+}
+
+void FreeRenderCapture(RenderCapture* capture) {
+    FreeFileData(capture->data, capture->handle);
+    free(capture);
+}
+
+static const void* ReadBytes(RenderCapture* capture, uint64_t size) {
+    uint64_t paddedSize = (size + 3) & ~(uint64_t)3;
+    if (capture->isInvalid || paddedSize > capture->header.commandSize - capture->offset) {
+        capture->isInvalid = true;
+        return NULL;
+    }
+    const void* bytes = capture->commands + capture->offset;
+    capture->offset += paddedSize;
+    return bytes;
+}
+
+static int32_t ReadInt(RenderCapture* capture) {
+    int32_t value = 0;
+    const void* bytes = ReadBytes(capture, sizeof(int32_t));
+    if (bytes != NULL) {
+        memcpy(&value, bytes, sizeof(int32_t));
+    }
+    return value;
+}
+
+static int32_t ReadId(RenderCapture* capture, int maxId) {
+    int32_t id = ReadInt(capture);
+    if (id < 0 || id >= maxId) {
+        capture->isInvalid = true;
+        return 0;
+    }
+    return id;
+}
+
+// counts are read as 64 bits, so that a negative count fails the bounds check of the array that follows
+static uint64_t ReadCount(RenderCapture* capture) {
+    int32_t count = ReadInt(capture);
+    if (count < 0) {
+        capture->isInvalid = true;
+        return 0;
+    }
+    return (uint64_t)count;
+}
+
+static const char* ReadString(RenderCapture* capture) {
+    uint64_t length = ReadCount(capture);
+    const char* s = (const char*)ReadBytes(capture, length + 1);
+    if (s != NULL && s[length] != '\0') {
+        capture->isInvalid = true;
+    }
+    return s;
+}
+
+static int MapId(const int* ids, int id) {
+    return ids[id] >= 0 ? ids[id] : 0;
+}
+
+static bool IsValidTextureRegion(RenderCapture* capture, int id, int x, int y, uint64_t width, uint64_t height) {
+    return capture->textureIds[id] >= 0 && x >= 0 && y >= 0
+        && x + width <= (uint64_t)capture->textureWidths[id] && y + height <= (uint64_t)capture->textureHeights[id];
+}
+
+static bool AreValidDebugLineBatches(const DebugLineBatch* batches, uint64_t batchCount, uint64_t vertexCount) {
+    for (uint64_t i = 0; i < batchCount; i++) {
+        DebugLineBatch batch = batches[i];
+        bool isValid = batch.cameraSlot >= 0 && batch.cameraSlot < LIBGAME_MAX_CAMERAS
+            && batch.vertexStart >= 0 && batch.vertexCount >= 0
+            && (uint64_t)batch.vertexStart + batch.vertexCount <= vertexCount;
+        if (!isValid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// returns false at the end of the frame
+static bool ReplayCommand(RenderCapture* capture) {
+    CaptureOp op = (CaptureOp)ReadInt(capture);
+    if (capture->isInvalid) {
+        return false;
+    }
+
+    switch (op) {
+        case CAPTURE_CLEAR_SCREEN: {
+            const Color* color = (const Color*)ReadBytes(capture, sizeof(Color));
+            if (!capture->isInvalid) {
+                tracked.ClearScreen(*color);
+            }
+            break;
+        }
+        case CAPTURE_MAKE_DRAW_CALL:
+            tracked.MakeDrawCall();
+            break;
+        case CAPTURE_END_FRAME:
+            tracked.EndFrame();
+            return false;
+        case CAPTURE_SET_TRANSFORM: {
+            const Mat4* mat = (const Mat4*)ReadBytes(capture, sizeof(Mat4));
+            if (!capture->isInvalid) {
+                tracked.SetTransform(*mat);
+            }
+            break;
+        }
+        case CAPTURE_SET_CAMERA_2D: {
+            int slot = ReadId(capture, LIBGAME_MAX_CAMERAS);
+            const void* bytes = ReadBytes(capture, sizeof(Camera2D));
+            if (!capture->isInvalid) {
+                Camera2D camera;
+                memcpy(&camera, bytes, sizeof(Camera2D));
+                tracked.SetCamera2D(slot, &camera);
+            }
+            break;
+        }
+        case CAPTURE_SET_CAMERA_3D: {
+            int slot = ReadId(capture, LIBGAME_MAX_CAMERAS);
+            const void* bytes = ReadBytes(capture, sizeof(Camera3D));
+            if (!capture->isInvalid) {
+                Camera3D camera;
+                memcpy(&camera, bytes, sizeof(Camera3D));
+                tracked.SetCamera3D(slot, &camera);
+            }
+            break;
+        }
+        case CAPTURE_USE_CAMERA_SLOT: {
+            int slot = ReadId(capture, LIBGAME_MAX_CAMERAS);
+            if (!capture->isInvalid) {
+                tracked.UseCameraSlot(slot);
+            }
+            break;
+        }
+        case CAPTURE_DRAW_TRIANGLE_2D: {
+            const Vec2* points = (const Vec2*)ReadBytes(capture, 3 * sizeof(Vec2));
+            const Color* color = (const Color*)ReadBytes(capture, sizeof(Color));
+            if (!capture->isInvalid) {
+                tracked.DrawTriangle2D(points[0], points[1], points[2], *color);
+            }
+            break;
+        }
+        case CAPTURE_DRAW_TRIANGLE_3D: {
+            const Vec3* points = (const Vec3*)ReadBytes(capture, 3 * sizeof(Vec3));
+            const Color* color = (const Color*)ReadBytes(capture, sizeof(Color));
+            if (!capture->isInvalid) {
+                tracked.DrawTriangle3D(points[0], points[1], points[2], *color);
+            }
+            break;
+        }
+        case CAPTURE_DRAW_QUAD_3D: {
+            const Vec3* corners = (const Vec3*)ReadBytes(capture, 4 * sizeof(Vec3));
+            const Color* color = (const Color*)ReadBytes(capture, sizeof(Color));
+            if (!capture->isInvalid) {
+                tracked.DrawQuad3D(corners[0], corners[1], corners[2], corners[3], *color);
+            }
+            break;
+        }
+        case CAPTURE_SET_TRANSPARENCY_MODE: {
+            bool shouldEnable = ReadInt(capture) != 0;
+            if (!capture->isInvalid) {
+                tracked.SetTransparencyMode(shouldEnable);
+            }
+            break;
+        }
+        case CAPTURE_SET_TRANSPARENCY_METHOD: {
+            int method = ReadInt(capture);
+            if (method != TRANSPARENCY_SORTED && method != TRANSPARENCY_WEIGHTED) {
+                capture->isInvalid = true;
+            }
+            if (!capture->isInvalid) {
+                tracked.SetTransparencyMethod((TransparencyMethod)method);
+            }
+            break;
+        }
+        case CAPTURE_SET_DEPTH_PREPASS_MODE: {
+            bool shouldEnable = ReadInt(capture) != 0;
+            if (!capture->isInvalid) {
+                tracked.SetDepthPrepassMode(shouldEnable);
+            }
+            break;
+        }
+        case CAPTURE_CREATE_SHADER: {
+            int id = ReadId(capture, LIBGAME_MAX_SHADERS);
+            const char* vertexSrc = ReadString(capture);
+            const char* fragmentSrc = ReadString(capture);
+            if (!capture->isInvalid && capture->shaderIds[id] < 0) {
+                capture->shaderIds[id] = tracked.CreateShader(vertexSrc, fragmentSrc);
+            }
+            break;
+        }
+        case CAPTURE_CREATE_MATERIAL: {
+            int id = ReadId(capture, LIBGAME_MAX_MATERIALS);
+            int shaderId = ReadId(capture, LIBGAME_MAX_SHADERS);
+            if (!capture->isInvalid && capture->materialIds[id] < 0) {
+                capture->materialIds[id] = tracked.CreateMaterial(MapId(capture->shaderIds, shaderId));
+            }
+            break;
+        }
+        case CAPTURE_SET_MATERIAL_PARAMS: {
+            int id = ReadId(capture, LIBGAME_MAX_MATERIALS);
+            uint64_t size = ReadCount(capture);
+            const void* params = ReadBytes(capture, size);
+            if (!capture->isInvalid && size <= LIBGAME_MAX_MATERIAL_PARAMS_SIZE) {
+                tracked.SetMaterialParams(MapId(capture->materialIds, id), params, (int)size);
+            }
+            break;
+        }
+        case CAPTURE_USE_MATERIAL: {
+            int id = ReadId(capture, LIBGAME_MAX_MATERIALS);
+            if (!capture->isInvalid) {
+                tracked.UseMaterial(MapId(capture->materialIds, id));
+            }
+            break;
+        }
+        case CAPTURE_CREATE_TEXTURE: {
+            int id = ReadId(capture, LIBGAME_MAX_TEXTURES);
+            uint64_t width = ReadCount(capture);
+            uint64_t height = ReadCount(capture);
+            bool hasPixels = ReadInt(capture) != 0;
+            const uint8_t* pixels = hasPixels ? (const uint8_t*)ReadBytes(capture, width * height * 4) : NULL;
+            if (capture->isInvalid) {
+                break;
+            }
+            capture->textureWidths[id] = (int)width;
+            capture->textureHeights[id] = (int)height;
+            if (capture->textureIds[id] < 0) {
+                capture->textureIds[id] = tracked.CreateTexture(pixels, (int)width, (int)height);
+            } else if (pixels != NULL) {
+                // restores the initial contents on later passes
+                tracked.UpdateTexture(capture->textureIds[id], 0, 0, (int)width, (int)height, pixels);
+            }
+            break;
+        }
+        case CAPTURE_UPDATE_TEXTURE: {
+            int id = ReadId(capture, LIBGAME_MAX_TEXTURES);
+            int x = ReadInt(capture);
+            int y = ReadInt(capture);
+            uint64_t width = ReadCount(capture);
+            uint64_t height = ReadCount(capture);
+            const uint8_t* pixels = (const uint8_t*)ReadBytes(capture, width * height * 4);
+            if (!capture->isInvalid && !IsValidTextureRegion(capture, id, x, y, width, height)) {
+                capture->isInvalid = true;
+            }
+            if (!capture->isInvalid) {
+                tracked.UpdateTexture(capture->textureIds[id], x, y, (int)width, (int)height, pixels);
+            }
+            break;
+        }
+        case CAPTURE_DRAW_TEXTURED_QUAD_3D: {
+            int id = ReadId(capture, LIBGAME_MAX_TEXTURES);
+            const Vec3* corners = (const Vec3*)ReadBytes(capture, 4 * sizeof(Vec3));
+            const Vec2* uvs = (const Vec2*)ReadBytes(capture, 2 * sizeof(Vec2));
+            const Color* color = (const Color*)ReadBytes(capture, sizeof(Color));
+            if (!capture->isInvalid) {
+                tracked.DrawTexturedQuad3D(MapId(capture->textureIds, id), corners[0], corners[1], corners[2], corners[3],
+                        uvs[0], uvs[1], *color);
+            }
+            break;
+        }
+        case CAPTURE_DRAW_VERTICES: {
+            int id = ReadId(capture, LIBGAME_MAX_TEXTURES);
+            uint64_t vertexCount = ReadCount(capture);
+            uint64_t indexCount = ReadCount(capture);
+            const float* vertices = (const float*)ReadBytes(capture, vertexCount * RENDER_FLOATS_PER_VERTEX * sizeof(float));
+            const uint32_t* indices = (const uint32_t*)ReadBytes(capture, indexCount * sizeof(uint32_t));
+            if (!capture->isInvalid) {
+                tracked.DrawVertices(vertices, (int)vertexCount, indices, (int)indexCount, MapId(capture->textureIds, id));
+            }
+            break;
+        }
+        case CAPTURE_DRAW_DEBUG_LINES: {
+            uint64_t vertexCount = ReadCount(capture);
+            uint64_t batchCount = ReadCount(capture);
+            const DebugLineVertex* vertices = (const DebugLineVertex*)ReadBytes(capture, vertexCount * sizeof(DebugLineVertex));
+            const DebugLineBatch* batches = (const DebugLineBatch*)ReadBytes(capture, batchCount * sizeof(DebugLineBatch));
+            if (!capture->isInvalid && !AreValidDebugLineBatches(batches, batchCount, vertexCount)) {
+                capture->isInvalid = true;
+            }
+            if (!capture->isInvalid) {
+                tracked.DrawDebugLines(vertices, (int)vertexCount, batches, (int)batchCount);
+            }
+            break;
+        }
+        case CAPTURE_CREATE_RENDER_TARGET: {
+            int id = ReadId(capture, LIBGAME_MAX_RENDER_TARGETS);
+            int textureId = ReadId(capture, LIBGAME_MAX_TEXTURES);
+            int width = ReadInt(capture);
+            int height = ReadInt(capture);
+            if (capture->isInvalid || width <= 0 || height <= 0) {
+                capture->isInvalid = true;
+                break;
+            }
+            capture->renderTargetTextureIds[id] = textureId;
+            capture->textureWidths[textureId] = width;
+            capture->textureHeights[textureId] = height;
+            if (capture->renderTargetIds[id] < 0) {
+                int replayTextureId = 0;
+                capture->renderTargetIds[id] = tracked.CreateRenderTarget(width, height, &replayTextureId);
+                capture->textureIds[textureId] = replayTextureId;
+            } else {
+                // restores the initial size on later passes
+                tracked.ResizeRenderTarget(capture->renderTargetIds[id], width, height);
+            }
+            break;
+        }
+        case CAPTURE_RESIZE_RENDER_TARGET: {
+            int id = ReadId(capture, LIBGAME_MAX_RENDER_TARGETS);
+            int width = ReadInt(capture);
+            int height = ReadInt(capture);
+            if (capture->isInvalid || width <= 0 || height <= 0 || capture->renderTargetIds[id] < 0) {
+                capture->isInvalid = true;
+                break;
+            }
+            capture->textureWidths[capture->renderTargetTextureIds[id]] = width;
+            capture->textureHeights[capture->renderTargetTextureIds[id]] = height;
+            tracked.ResizeRenderTarget(capture->renderTargetIds[id], width, height);
+            break;
+        }
+        case CAPTURE_USE_RENDER_TARGET:
+        case CAPTURE_BLIT_RENDER_TARGET: {
+            int id = ReadInt(capture); // -1 is the window
+            int width = ReadInt(capture);
+            int height = ReadInt(capture);
+            bool isValidId = id >= -1 && id < LIBGAME_MAX_RENDER_TARGETS;
+            int replayId = isValidId && id >= 0 ? capture->renderTargetIds[id] : -1;
+            if (capture->isInvalid || !isValidId || (id >= 0 && replayId < 0) || (op == CAPTURE_BLIT_RENDER_TARGET && id < 0)) {
+                capture->isInvalid = true;
+                break;
+            }
+            if (op == CAPTURE_USE_RENDER_TARGET) {
+                tracked.UseRenderTarget(replayId, width, height);
+            } else {
+                tracked.BlitRenderTarget(replayId, width, height);
+            }
+            break;
+        }
+        default:
+            capture->isInvalid = true;
+            break;
+    }
+
+    return !capture->isInvalid;
+}
+
+int ReplayRenderCaptureFrame(RenderCapture* capture) {
+    Assert(captureState != CaptureRecording, "Unable to replay a render capture while capturing");
+
+    // the prologue runs before the first frame of each pass
+    if (capture->nextFrame == 0) {
+        capture->offset = 0;
+    }
+
+    int frame = capture->nextFrame;
+    while (ReplayCommand(capture)) {
+    }
+
+    if (capture->isInvalid) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Invalid render capture command at offset %llu in frame %d\n",
+                (unsigned long long)capture->offset, frame);
+        // still end the frame, and start over with the next pass
+        tracked.EndFrame();
+        capture->isInvalid = false;
+        capture->nextFrame = 0;
+        return frame;
+    }
+
+    capture->nextFrame = (frame + 1) % capture->header.frameCount;
+    return frame;
+}
@@ -0,0 +1,15 @@
+#ifndef render_capture_h
+#define render_capture_h
+
+#include "platform_setup.h"
+
+/*
+ * Wrap the backend, so that the resources and state it is given can be recreated at
+ * the start of a capture. Only the infrequent calls are wrapped, the draw calls go straight to the backend.
+ */
+PlatformRender InitRenderCapture(PlatformRender backend);
+
+// call after the backend ends a frame, starts and stops captures by swapping the render functions
+void AdvanceRenderCapture(PlatformRender* render);
+
+#endif
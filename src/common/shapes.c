@@ -0,0 +1,252 @@
+/*
+ * Shape generators.
+ *
+ * Each shape reserves its whole vertex and index range in the batch once, and then writes
+ * the vertices and indices directly into the batch buffers.
+ *
+ * CIRCLES
+ *
+ * A circle is a fan around a center vertex. The rim points are generated by rotating
+ * the previous point, so only one sine and cosine are computed per circle.
+ * The automatic segment count keeps the distance between each segment and the arc
+ * (the sagitta, r * (1 - cos(pi / n))) within a tolerance.
+ *
+ * POLYGONS
+ *
+ * Polygons are triangulated with ear clipping. A vertex is an ear if its corner is convex
+ * and no other remaining vertex is inside the triangle it forms with its neighbors.
+ * Clipping an ear removes the vertex, until a single triangle is left. Each triangle
+ * takes O(n) to find, so a polygon takes O(n^2) in the worst case. This is fast for
+ * the hand made shapes this is meant for.
+ */
+#include <math.h>
+#include <stddef.h>
+#include "libgame.h"
+#include "asserts.h"
+#include "render.h"
+
+#define SHAPES_PI 3.14159265358979f
+#define CIRCLE_TOLERANCE 0.5f
+#define CIRCLE_MIN_SEGMENTS 8
+#define CIRCLE_MAX_SEGMENTS 512
+
+static const Texture noTexture = {0};
+
+void DrawRect2D(Vec2 position, Vec2 size, Color color) {
+    ReservedGeometry geometry = ReserveGeometry(4, 6, noTexture);
+    float* v = geometry.vertices;
+    WriteRenderVertex(&v[0 * RENDER_FLOATS_PER_VERTEX], position.x, position.y + size.y, 0, color, 0, 0);
+    WriteRenderVertex(&v[1 * RENDER_FLOATS_PER_VERTEX], position.x + size.x, position.y + size.y, 0, color, 0, 0);
+    WriteRenderVertex(&v[2 * RENDER_FLOATS_PER_VERTEX], position.x, position.y, 0, color, 0, 0);
+    WriteRenderVertex(&v[3 * RENDER_FLOATS_PER_VERTEX], position.x + size.x, position.y, 0, color, 0, 0);
+
+    uint32_t base = geometry.baseVertex;
+    uint32_t* indices = geometry.indices;
+    indices[0] = base;
+    indices[1] = base + 1;
+    indices[2] = base + 2;
+    indices[3] = base + 2;
+    indices[4] = base + 1;
+    indices[5] = base + 3;
+}
+
+static int GetCircleSegmentCount(float radius) {
+    if (radius <= CIRCLE_TOLERANCE) {
+        return CIRCLE_MIN_SEGMENTS;
+    }
+    int segments = (int)ceilf(SHAPES_PI / acosf(1 - CIRCLE_TOLERANCE / radius));
+    segments = segments < CIRCLE_MIN_SEGMENTS ? CIRCLE_MIN_SEGMENTS : segments;
+    return segments > CIRCLE_MAX_SEGMENTS ? CIRCLE_MAX_SEGMENTS : segments;
+}
+
+void DrawCircle2D(Vec2 center, float radius, int segments, Color color) {
+    if (segments <= 0) {
+        segments = GetCircleSegmentCount(radius);
+    }
+    Assert(segments >= 3, "A circle needs at least 3 segments, got %d", segments);
+
+    ReservedGeometry geometry = ReserveGeometry(segments + 1, segments * 3, noTexture);
+    float* v = geometry.vertices;
+    WriteRenderVertex(v, center.x, center.y, 0, color, 0, 0);
+
+    float angle = 2 * SHAPES_PI / segments;
+    float cosAngle = cosf(angle);
+    float sinAngle = sinf(angle);
+    float x = radius;
+    float y = 0;
+    for (int i = 0; i < segments; i++) {
+        WriteRenderVertex(&v[(i + 1) * RENDER_FLOATS_PER_VERTEX], center.x + x, center.y + y, 0, color, 0, 0);
+        float rotatedX = x * cosAngle - y * sinAngle;
+        y = x * sinAngle + y * cosAngle;
+        x = rotatedX;
+    }
+
+    uint32_t base = geometry.baseVertex;
+    uint32_t* indices = geometry.indices;
+    for (int i = 0; i < segments; i++) {
+        indices[i * 3] = base;
+        indices[i * 3 + 1] = base + 1 + i;
+        indices[i * 3 + 2] = base + 1 + (i + 1) % segments;
+    }
+}
+
+void DrawLine2D(Vec2 a, Vec2 b, float thickness, Color color) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0) {
+        return;
+    }
+
+    // half thickness to each side
+    float nx = -dy / length * thickness / 2;
+    float ny = dx / length * thickness / 2;
+
+    ReservedGeometry geometry = ReserveGeometry(4, 6, noTexture);
+    float* v = geometry.vertices;
+    WriteRenderVertex(&v[0 * RENDER_FLOATS_PER_VERTEX], a.x + nx, a.y + ny, 0, color, 0, 0);
+    WriteRenderVertex(&v[1 * RENDER_FLOATS_PER_VERTEX], b.x + nx, b.y + ny, 0, color, 0, 0);
+    WriteRenderVertex(&v[2 * RENDER_FLOATS_PER_VERTEX], a.x - nx, a.y - ny, 0, color, 0, 0);
+    WriteRenderVertex(&v[3 * RENDER_FLOATS_PER_VERTEX], b.x - nx, b.y - ny, 0, color, 0, 0);
+
+    uint32_t base = geometry.baseVertex;
+    uint32_t* indices = geometry.indices;
+    indices[0] = base;
+    indices[1] = base + 1;
+    indices[2] = base + 2;
+    indices[3] = base + 2;
+    indices[4] = base + 1;
+    indices[5] = base + 3;
+}
+
+// -- Polygons --
+
+static inline float Cross2D(Vec2 o, Vec2 a, Vec2 b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// points on the edges count as inside, so that an ear never touches another vertex
+static bool IsInTriangle(Vec2 p, Vec2 a, Vec2 b, Vec2 c, float orientation) {
+    return Cross2D(a, b, p) * orientation >= 0
+        && Cross2D(b, c, p) * orientation >= 0
+        && Cross2D(c, a, p) * orientation >= 0;
+}
+
+static bool IsEar(const Vec2* points, const int* remaining, int count, int i, float orientation) {
+    int previous = remaining[(i + count - 1) % count];
+    int current = remaining[i];
+    int next = remaining[(i + 1) % count];
+    Vec2 a = points[previous];
+    Vec2 b = points[current];
+    Vec2 c = points[next];
+
+    if (Cross2D(a, b, c) * orientation <= 0) {
+        return false;
+    }
+
+    for (int j = 0; j < count; j++) {
+        int other = remaining[j];
+        if (other == previous || other == current || other == next) {
+            continue;
+        }
+        if (IsInTriangle(points[other], a, b, c, orientation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DrawPolygon2D(const Vec2* points, int pointCount, Color color) {
+    if (pointCount < 3) {
+        return;
+    }
+
+    ReservedGeometry geometry = ReserveGeometry(pointCount, (pointCount - 2) * 3, noTexture);
+    for (int i = 0; i < pointCount; i++) {
+        WriteRenderVertex(&geometry.vertices[i * RENDER_FLOATS_PER_VERTEX], points[i].x, points[i].y, 0, color, 0, 0);
+    }
+
+    // twice the signed area, positive for counter-clockwise
+    float area = 0;
+    for (int i = 0; i < pointCount; i++) {
+        Vec2 p = points[i];
+        Vec2 q = points[(i + 1) % pointCount];
+        area += p.x * q.y - q.x * p.y;
+    }
+    float orientation = area >= 0 ? 1 : -1;
+
+    ScratchArena scratch = BeginScratch();
+    int* remaining = (int*)ArenaAlloc(scratch.arena, pointCount * sizeof(int));
+    for (int i = 0; i < pointCount; i++) {
+        remaining[i] = i;
+    }
+
+    uint32_t base = geometry.baseVertex;
+    uint32_t* indices = geometry.indices;
+    int count = pointCount;
+    int i = 0;
+    // number of vertices checked since the last ear, to detect degenerate polygons
+    int checkedCount = 0;
+
+    while (count > 3) {
+        bool isEar = IsEar(points, remaining, count, i, orientation);
+        // a degenerate or self intersecting polygon can run out of ears, clip anyway so that the loop ends
+        if (isEar || checkedCount >= count) {
+            *indices++ = base + remaining[(i + count - 1) % count];
+            *indices++ = base + remaining[i];
+            *indices++ = base + remaining[(i + 1) % count];
+
+            for (int j = i; j < count - 1; j++) {
+                remaining[j] = remaining[j + 1];
+            }
+            count--;
+            i = i % count;
+            checkedCount = 0;
+        } else {
+            i = (i + 1) % count;
+            checkedCount++;
+        }
+    }
+
+    *indices++ = base + remaining[0];
+    *indices++ = base + remaining[1];
+    *indices++ = base + remaining[2];
+
+    EndScratch(scratch);
+}
+
+// -- Meshes --
+
+// copies the mesh into the batch, with the positions transformed unless the transform is NULL
+static void WriteMesh(Mesh mesh, const Mat4* transform) {
+    Assert(mesh.vertexCount >= 0 && mesh.indexCount >= 0, "Invalid mesh with %d vertices and %d indices",
+            mesh.vertexCount, mesh.indexCount);
+
+    ReservedGeometry geometry = ReserveGeometry(mesh.vertexCount, mesh.indexCount, mesh.texture);
+    for (int i = 0; i < mesh.vertexCount; i++) {
+        Vec3 p = mesh.positions[i];
+        if (transform != NULL) {
+            const float (*m)[4] = transform->m;
+            p = (Vec3){
+                m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3],
+            };
+        }
+        Color color = mesh.colors != NULL ? mesh.colors[i] : mesh.color;
+        Vec2 texCoord = mesh.texCoords != NULL ? mesh.texCoords[i] : (Vec2){0};
+        WriteRenderVertex(&geometry.vertices[i * RENDER_FLOATS_PER_VERTEX], p.x, p.y, p.z, color, texCoord.x, texCoord.y);
+    }
+
+    for (int i = 0; i < mesh.indexCount; i++) {
+        geometry.indices[i] = geometry.baseVertex + mesh.indices[i];
+    }
+}
+
+void DrawMeshTransformed(Mesh mesh, Mat4 transform) {
+    WriteMesh(mesh, &transform);
+}
+
+void DrawMesh(Mesh mesh) {
+    WriteMesh(mesh, NULL);
+}
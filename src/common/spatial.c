@@ -0,0 +1,797 @@
+/*
+ * Spatial indexes for culling and proximity queries.
+ *
+ * Both indexes run a query the same way: a test of the query shape against a box, first on
+ * the coarse boxes (grid cells or tree nodes) and then on the boxes of the objects in them.
+ *
+ * LOOSE GRID
+ *
+ * An object belongs to the one cell that holds the center of its box. Cells are hashed into
+ * a fixed number of buckets, each a linked list of objects, so the world is unbounded and an
+ * update is O(1): moving within the bucket only changes the box, moving to another bucket
+ * unlinks the object and links it again. An object entry keeps its box, links and query stamp
+ * together in one cache line.
+ *
+ * A box sticks out of its cell by up to the largest half extent of the objects, so queries
+ * visit the cells that overlap the query grown by that extent. The extent only grows until the
+ * grid is empty again. Cells that share a bucket are told apart by the box tests, and the stamp
+ * keeps an object from being reported twice. A query that covers more cells than there are
+ * buckets scans the buckets instead. Rays are split into cell sized segments, so a long ray
+ * only visits the cells along it.
+ *
+ * BVH
+ *
+ * The bounding volume hierarchy is built top down with the surface area heuristic, binned on
+ * the box centers along each axis. The nodes are 32 bytes in one array, with the two children
+ * of a node next to each other. A leaf is a range of the ids, and the object boxes are copied in
+ * the same order, so a leaf reads contiguous memory. Below a depth limit, nodes are split in the
+ * middle of their range instead, which bounds the traversal stack. Refitting recomputes the node
+ * boxes from the children up without changing the tree.
+ */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include "libgame.h"
+#include "asserts.h"
+
+#define GRID_MIN_BUCKETS 64
+// against rounding of the cell coordinates
+#define GRID_CELL_MARGIN 0.001f
+#define GRID_MAX_COORDINATE 16777216.0f
+
+#define BVH_BIN_COUNT 12
+#define BVH_MAX_LEAF_SIZE 4
+// relative to the cost of testing one object
+#define BVH_TRAVERSAL_COST 1.0f
+#define BVH_MAX_SAH_DEPTH 32
+#define BVH_STACK_SIZE 72
+
+typedef enum {
+    QueryKindAabb,
+    QueryKindSphere,
+    QueryKindFrustum,
+    QueryKindRay,
+} QueryKind;
+
+typedef struct {
+    QueryKind kind;
+    Aabb box; // around the query shape
+    Vec3 center;
+    float radius;
+    const Frustum* frustum;
+    Vec3 origin;
+    Vec3 direction;
+    Vec3 inverseDirection;
+    float maxDistance;
+    int* ids;
+    int maxIds;
+    int count;
+} SpatialQuery;
+
+typedef struct {
+    Aabb bounds;
+    int bucket; // -1 when not in the grid
+    int next;
+    int previous;
+    uint32_t stamp;
+} GridObject;
+
+struct SpatialGrid {
+    float cellSize;
+    int maxObjects;
+    int objectCount;
+    int bucketCount;
+    float maxHalfExtent;
+    uint32_t stamp;
+    int* buckets;
+    GridObject* objects;
+};
+
+typedef struct {
+    Aabb bounds;
+    int first; // the first child of an inner node, or the first id of a leaf
+    int count; // 0 for inner nodes
+} BvhNode;
+
+struct SpatialBvh {
+    BvhNode* nodes;
+    int nodeCount;
+    int* ids;
+    Aabb* boxes; // in the order of the ids
+    int count;
+};
+
+// -- Tests --
+
+// unlike fminf and fmaxf, these compile to single instructions
+static inline float MinFloat(float a, float b) {
+    return a < b ? a : b;
+}
+
+static inline float MaxFloat(float a, float b) {
+    return a > b ? a : b;
+}
+
+static Aabb GetEmptyAabb() {
+    return (Aabb){ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static void GrowAabb(Aabb* box, const Aabb* other) {
+    box->min.x = MinFloat(box->min.x, other->min.x);
+    box->min.y = MinFloat(box->min.y, other->min.y);
+    box->min.z = MinFloat(box->min.z, other->min.z);
+    box->max.x = MaxFloat(box->max.x, other->max.x);
+    box->max.y = MaxFloat(box->max.y, other->max.y);
+    box->max.z = MaxFloat(box->max.z, other->max.z);
+}
+
+static Vec3 GetAabbCenter(const Aabb* box) {
+    return (Vec3){ (box->min.x + box->max.x) / 2, (box->min.y + box->max.y) / 2, (box->min.z + box->max.z) / 2 };
+}
+
+// half of the surface area
+static float GetAabbArea(const Aabb* box) {
+    float x = box->max.x - box->min.x;
+    float y = box->max.y - box->min.y;
+    float z = box->max.z - box->min.z;
+    return x * y + y * z + z * x;
+}
+
+static bool AabbsOverlap(const Aabb* a, const Aabb* b) {
+    return a->min.x <= b->max.x && a->max.x >= b->min.x
+        && a->min.y <= b->max.y && a->max.y >= b->min.y
+        && a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static bool SphereOverlapsAabb(Vec3 center, float radius, const Aabb* box) {
+    float dx = center.x - MaxFloat(box->min.x, MinFloat(center.x, box->max.x));
+    float dy = center.y - MaxFloat(box->min.y, MinFloat(center.y, box->max.y));
+    float dz = center.z - MaxFloat(box->min.z, MinFloat(center.z, box->max.z));
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+// the bounds reject some of the boxes that are outside a corner but not outside a plane
+static bool FrustumOverlapsAabb(const Frustum* frustum, const Aabb* box) {
+    if (!AabbsOverlap(&frustum->bounds, box)) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        // the corner furthest inside the plane
+        Vec4 plane = frustum->planes[i];
+        float x = plane.x >= 0 ? box->max.x : box->min.x;
+        float y = plane.y >= 0 ? box->max.y : box->min.y;
+        float z = plane.z >= 0 ? box->max.z : box->min.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the distance where the ray enters the box, or -1 if it misses within maxDistance
+static float GetRayEntry(Vec3 origin, Vec3 inverseDirection, float maxDistance, const Aabb* box) {
+    float x1 = (box->min.x - origin.x) * inverseDirection.x;
+    float x2 = (box->max.x - origin.x) * inverseDirection.x;
+    float y1 = (box->min.y - origin.y) * inverseDirection.y;
+    float y2 = (box->max.y - origin.y) * inverseDirection.y;
+    float z1 = (box->min.z - origin.z) * inverseDirection.z;
+    float z2 = (box->max.z - origin.z) * inverseDirection.z;
+    float entry = MaxFloat(MaxFloat(MinFloat(x1, x2), MinFloat(y1, y2)), MaxFloat(MinFloat(z1, z2), 0));
+    float exit = MinFloat(MinFloat(MaxFloat(x1, x2), MaxFloat(y1, y2)), MinFloat(MaxFloat(z1, z2), maxDistance));
+    return entry <= exit ? entry : -1;
+}
+
+static bool QueryOverlaps(const SpatialQuery* query, const Aabb* box) {
+    switch (query->kind) {
+        case QueryKindAabb:
+            return AabbsOverlap(&query->box, box);
+        case QueryKindSphere:
+            return SphereOverlapsAabb(query->center, query->radius, box);
+        case QueryKindFrustum:
+            return FrustumOverlapsAabb(query->frustum, box);
+        case QueryKindRay:
+            return GetRayEntry(query->origin, query->inverseDirection, query->maxDistance, box) >= 0;
+    }
+    return false;
+}
+
+static void AddQueryResult(SpatialQuery* query, int id) {
+    if (query->count < query->maxIds) {
+        query->ids[query->count] = id;
+    }
+    query->count++;
+}
+
+static SpatialQuery MakeAabbQuery(Aabb box, int* ids, int maxIds) {
+    return (SpatialQuery){ .kind = QueryKindAabb, .box = box, .ids = ids, .maxIds = maxIds };
+}
+
+static SpatialQuery MakeSphereQuery(Vec3 center, float radius, int* ids, int maxIds) {
+    Aabb box = { { center.x - radius, center.y - radius, center.z - radius }, { center.x + radius, center.y + radius, center.z + radius } };
+    return (SpatialQuery){ .kind = QueryKindSphere, .box = box, .center = center, .radius = radius, .ids = ids, .maxIds = maxIds };
+}
+
+static SpatialQuery MakeFrustumQuery(const Frustum* frustum, int* ids, int maxIds) {
+    return (SpatialQuery){ .kind = QueryKindFrustum, .box = frustum->bounds, .frustum = frustum, .ids = ids, .maxIds = maxIds };
+}
+
+static SpatialQuery MakeRayQuery(Vec3 origin, Vec3 direction, float maxDistance, int* ids, int maxIds) {
+    Assert(Vec3Magnitude(direction) > 0, "The ray direction is zero");
+    direction = Vec3Normalize(direction);
+    Vec3 end = Vec3Add(origin, Vec3Scale(direction, maxDistance));
+    Aabb box = { { MinFloat(origin.x, end.x), MinFloat(origin.y, end.y), MinFloat(origin.z, end.z) },
+        { MaxFloat(origin.x, end.x), MaxFloat(origin.y, end.y), MaxFloat(origin.z, end.z) } };
+    // finite for axis aligned rays, so that the slab tests never multiply zero by infinity
+    Vec3 inverseDirection = { direction.x != 0 ? 1 / direction.x : FLT_MAX, direction.y != 0 ? 1 / direction.y : FLT_MAX,
+        direction.z != 0 ? 1 / direction.z : FLT_MAX };
+    return (SpatialQuery){ .kind = QueryKindRay, .box = box, .origin = origin, .direction = direction,
+        .inverseDirection = inverseDirection, .maxDistance = maxDistance, .ids = ids, .maxIds = maxIds };
+}
+
+// -- Loose grid --
+
+static int GetCellCoordinate(const SpatialGrid* grid, float value) {
+    return (int)MaxFloat(-GRID_MAX_COORDINATE, MinFloat(floorf(value / grid->cellSize), GRID_MAX_COORDINATE));
+}
+
+static int GetCellBucket(const SpatialGrid* grid, int x, int y, int z) {
+    uint32_t hash = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    return (int)(hash & (uint32_t)(grid->bucketCount - 1));
+}
+
+static int GetObjectBucket(const SpatialGrid* grid, const Aabb* bounds) {
+    Vec3 center = GetAabbCenter(bounds);
+    return GetCellBucket(grid, GetCellCoordinate(grid, center.x), GetCellCoordinate(grid, center.y),
+            GetCellCoordinate(grid, center.z));
+}
+
+static void LinkGridObject(SpatialGrid* grid, int id, int bucket) {
+    GridObject* object = &grid->objects[id];
+    object->bucket = bucket;
+    object->previous = -1;
+    object->next = grid->buckets[bucket];
+    if (object->next >= 0) {
+        grid->objects[object->next].previous = id;
+    }
+    grid->buckets[bucket] = id;
+}
+
+static void UnlinkGridObject(SpatialGrid* grid, int id) {
+    GridObject* object = &grid->objects[id];
+    if (object->previous >= 0) {
+        grid->objects[object->previous].next = object->next;
+    } else {
+        grid->buckets[object->bucket] = object->next;
+    }
+    if (object->next >= 0) {
+        grid->objects[object->next].previous = object->previous;
+    }
+    object->bucket = -1;
+}
+
+static void GrowMaxHalfExtent(SpatialGrid* grid, const Aabb* bounds) {
+    float extent = MaxFloat(MaxFloat(bounds->max.x - bounds->min.x, bounds->max.y - bounds->min.y), bounds->max.z - bounds->min.z) / 2;
+    grid->maxHalfExtent = MaxFloat(grid->maxHalfExtent, extent);
+}
+
+static void AssertGridId(const SpatialGrid* grid, int id) {
+    Assert(id >= 0 && id < grid->maxObjects, "Grid object id %d is out of range (%d objects)", id, grid->maxObjects);
+}
+
+SpatialGrid* CreateSpatialGrid(float cellSize, int maxObjects) {
+    Assert(cellSize > 0 && maxObjects >= 0, "Invalid grid with a cell size of %f and %d objects", cellSize, maxObjects);
+    int bucketCount = GRID_MIN_BUCKETS;
+    while (bucketCount < maxObjects) {
+        bucketCount *= 2;
+    }
+
+    SpatialGrid* grid = (SpatialGrid*)calloc(1, sizeof(SpatialGrid));
+    if (grid == NULL) {
+        return NULL;
+    }
+    grid->buckets = (int*)malloc(bucketCount * sizeof(int));
+    grid->objects = (GridObject*)calloc(maxObjects + 1, sizeof(GridObject));
+    if (grid->buckets == NULL || grid->objects == NULL) {
+        LogWarningIn(LOG_CATEGORY_GENERAL, "Unable to allocate a spatial grid of %d objects\n", maxObjects);
+        FreeSpatialGrid(grid);
+        return NULL;
+    }
+
+    grid->cellSize = cellSize;
+    grid->maxObjects = maxObjects;
+    grid->bucketCount = bucketCount;
+    for (int i = 0; i < bucketCount; i++) {
+        grid->buckets[i] = -1;
+    }
+    for (int i = 0; i < maxObjects; i++) {
+        grid->objects[i].bucket = -1;
+    }
+    return grid;
+}
+
+void FreeSpatialGrid(SpatialGrid* grid) {
+    if (grid == NULL) {
+        return;
+    }
+    free(grid->buckets);
+    free(grid->objects);
+    free(grid);
+}
+
+void InsertGridObject(SpatialGrid* grid, int id, Aabb bounds) {
+    AssertGridId(grid, id);
+    Assert(grid->objects[id].bucket < 0, "Grid object %d is already inserted", id);
+    grid->objects[id].bounds = bounds;
+    LinkGridObject(grid, id, GetObjectBucket(grid, &bounds));
+    GrowMaxHalfExtent(grid, &bounds);
+    grid->objectCount++;
+}
+
+void UpdateGridObject(SpatialGrid* grid, int id, Aabb bounds) {
+    AssertGridId(grid, id);
+    Assert(grid->objects[id].bucket >= 0, "Grid object %d is updated before it is inserted", id);
+    grid->objects[id].bounds = bounds;
+    int bucket = GetObjectBucket(grid, &bounds);
+    if (bucket != grid->objects[id].bucket) {
+        UnlinkGridObject(grid, id);
+        LinkGridObject(grid, id, bucket);
+    }
+    GrowMaxHalfExtent(grid, &bounds);
+}
+
+void RemoveGridObject(SpatialGrid* grid, int id) {
+    AssertGridId(grid, id);
+    Assert(grid->objects[id].bucket >= 0, "Grid object %d is removed but not inserted", id);
+    UnlinkGridObject(grid, id);
+    grid->objectCount--;
+    if (grid->objectCount == 0) {
+        grid->maxHalfExtent = 0;
+    }
+}
+
+static void NextGridStamp(SpatialGrid* grid) {
+    grid->stamp++;
+    if (grid->stamp == 0) {
+        for (int i = 0; i < grid->maxObjects; i++) {
+            grid->objects[i].stamp = 0;
+        }
+        grid->stamp = 1;
+    }
+}
+
+static void VisitGridBucket(SpatialGrid* grid, SpatialQuery* query, int bucket) {
+    for (int id = grid->buckets[bucket]; id >= 0; id = grid->objects[id].next) {
+        GridObject* object = &grid->objects[id];
+        if (object->stamp == grid->stamp) {
+            continue;
+        }
+        object->stamp = grid->stamp;
+        if (QueryOverlaps(query, &object->bounds)) {
+            AddQueryResult(query, id);
+        }
+    }
+}
+
+static void VisitAllGridBuckets(SpatialGrid* grid, SpatialQuery* query) {
+    for (int i = 0; i < grid->bucketCount; i++) {
+        VisitGridBucket(grid, query, i);
+    }
+}
+
+// the cells whose objects can overlap the box
+static void VisitGridCells(SpatialGrid* grid, SpatialQuery* query, Aabb box) {
+    float grow = grid->maxHalfExtent + grid->cellSize * GRID_CELL_MARGIN;
+    int minX = GetCellCoordinate(grid, box.min.x - grow);
+    int minY = GetCellCoordinate(grid, box.min.y - grow);
+    int minZ = GetCellCoordinate(grid, box.min.z - grow);
+    int maxX = GetCellCoordinate(grid, box.max.x + grow);
+    int maxY = GetCellCoordinate(grid, box.max.y + grow);
+    int maxZ = GetCellCoordinate(grid, box.max.z + grow);
+    double cellCount = ((double)maxX - minX + 1) * ((double)maxY - minY + 1) * ((double)maxZ - minZ + 1);
+    if (cellCount > grid->bucketCount) {
+        VisitAllGridBuckets(grid, query);
+        return;
+    }
+
+    float size = grid->cellSize;
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                Aabb cell = { { x * size - grow, y * size - grow, z * size - grow },
+                    { (x + 1) * size + grow, (y + 1) * size + grow, (z + 1) * size + grow } };
+                if (QueryOverlaps(query, &cell)) {
+                    VisitGridBucket(grid, query, GetCellBucket(grid, x, y, z));
+                }
+            }
+        }
+    }
+}
+
+static int RunGridQuery(SpatialGrid* grid, SpatialQuery* query) {
+    NextGridStamp(grid);
+    if (query->kind != QueryKindRay) {
+        VisitGridCells(grid, query, query->box);
+        return query->count;
+    }
+
+    float size = grid->cellSize;
+    // at least one segment, so a zero length ray still visits the cell of its origin
+    double segmentCount = MaxFloat(ceil(query->maxDistance / size), 1);
+    double cellsPerAxis = floor((size + 2 * grid->maxHalfExtent) / size) + 2;
+    if (segmentCount * cellsPerAxis * cellsPerAxis * cellsPerAxis > grid->bucketCount) {
+        VisitAllGridBuckets(grid, query);
+        return query->count;
+    }
+    for (int i = 0; i < (int)segmentCount; i++) {
+        Vec3 start = Vec3Add(query->origin, Vec3Scale(query->direction, i * size));
+        Vec3 end = Vec3Add(query->origin, Vec3Scale(query->direction, MinFloat((i + 1) * size, query->maxDistance)));
+        Aabb segment = { { MinFloat(start.x, end.x), MinFloat(start.y, end.y), MinFloat(start.z, end.z) },
+            { MaxFloat(start.x, end.x), MaxFloat(start.y, end.y), MaxFloat(start.z, end.z) } };
+        VisitGridCells(grid, query, segment);
+    }
+    return query->count;
+}
+
+int QueryGridAabb(SpatialGrid* grid, Aabb box, int* ids, int maxIds) {
+    SpatialQuery query = MakeAabbQuery(box, ids, maxIds);
+    return RunGridQuery(grid, &query);
+}
+
+int QueryGridSphere(SpatialGrid* grid, Vec3 center, float radius, int* ids, int maxIds) {
+    SpatialQuery query = MakeSphereQuery(center, radius, ids, maxIds);
+    return RunGridQuery(grid, &query);
+}
+
+int QueryGridFrustum(SpatialGrid* grid, const Frustum* frustum, int* ids, int maxIds) {
+    SpatialQuery query = MakeFrustumQuery(frustum, ids, maxIds);
+    return RunGridQuery(grid, &query);
+}
+
+int QueryGridRay(SpatialGrid* grid, Vec3 origin, Vec3 direction, float maxDistance, int* ids, int maxIds) {
+    SpatialQuery query = MakeRayQuery(origin, direction, maxDistance, ids, maxIds);
+    return RunGridQuery(grid, &query);
+}
+
+// -- BVH --
+
+typedef struct {
+    Aabb bounds;
+    int count;
+} BvhBin;
+
+static int GetBinIndex(float center, float minCenter, float scale) {
+    int bin = (int)((center - minCenter) * scale);
+    return bin < BVH_BIN_COUNT - 1 ? bin : BVH_BIN_COUNT - 1;
+}
+
+static void UpdateBvhNodeBounds(SpatialBvh* bvh, BvhNode* node) {
+    node->bounds = GetEmptyAabb();
+    for (int i = node->first; i < node->first + node->count; i++) {
+        GrowAabb(&node->bounds, &bvh->boxes[i]);
+    }
+}
+
+static void SwapBvhObjects(SpatialBvh* bvh, float* centers, int i, int j) {
+    Aabb box = bvh->boxes[i];
+    bvh->boxes[i] = bvh->boxes[j];
+    bvh->boxes[j] = box;
+    int id = bvh->ids[i];
+    bvh->ids[i] = bvh->ids[j];
+    bvh->ids[j] = id;
+    for (int axis = 0; axis < 3; axis++) {
+        float center = centers[i * 3 + axis];
+        centers[i * 3 + axis] = centers[j * 3 + axis];
+        centers[j * 3 + axis] = center;
+    }
+}
+
+/*
+ * Partitions the objects of the node, with centers holding the box centers in the same order.
+ * Returns the first object of the right child, or 0 to keep the node as a leaf.
+ */
+static int PartitionBvhNode(SpatialBvh* bvh, float* centers, const BvhNode* node, int depth) {
+    int first = node->first;
+    int count = node->count;
+    if (count <= 1) {
+        return 0;
+    }
+    if (depth >= BVH_MAX_SAH_DEPTH) {
+        return count > BVH_MAX_LEAF_SIZE ? first + count / 2 : 0;
+    }
+
+    float minCenters[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maxCenters[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int i = first; i < first + count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            minCenters[axis] = MinFloat(minCenters[axis], centers[i * 3 + axis]);
+            maxCenters[axis] = MaxFloat(maxCenters[axis], centers[i * 3 + axis]);
+        }
+    }
+    float scales[3];
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = maxCenters[axis] - minCenters[axis];
+        scales[axis] = extent > 0 ? BVH_BIN_COUNT / extent : 0;
+    }
+
+    // one pass bins the objects along all the axes
+    BvhBin bins[3][BVH_BIN_COUNT];
+    for (int axis = 0; axis < 3; axis++) {
+        for (int b = 0; b < BVH_BIN_COUNT; b++) {
+            bins[axis][b] = (BvhBin){ GetEmptyAabb(), 0 };
+        }
+    }
+    for (int i = first; i < first + count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            BvhBin* bin = &bins[axis][GetBinIndex(centers[i * 3 + axis], minCenters[axis], scales[axis])];
+            GrowAabb(&bin->bounds, &bvh->boxes[i]);
+            bin->count++;
+        }
+    }
+
+    int bestAxis = -1;
+    int bestBin = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+        if (scales[axis] == 0) {
+            continue;
+        }
+        // the right side costs of splitting after each bin, then a sweep from the left
+        float rightCosts[BVH_BIN_COUNT];
+        Aabb right = GetEmptyAabb();
+        int rightCount = 0;
+        for (int b = BVH_BIN_COUNT - 1; b > 0; b--) {
+            GrowAabb(&right, &bins[axis][b].bounds);
+            rightCount += bins[axis][b].count;
+            rightCosts[b - 1] = rightCount > 0 ? GetAabbArea(&right) * rightCount : -1;
+        }
+        Aabb left = GetEmptyAabb();
+        int leftCount = 0;
+        for (int b = 0; b < BVH_BIN_COUNT - 1; b++) {
+            GrowAabb(&left, &bins[axis][b].bounds);
+            leftCount += bins[axis][b].count;
+            if (leftCount == 0 || rightCosts[b] < 0) {
+                continue;
+            }
+            float cost = GetAabbArea(&left) * leftCount + rightCosts[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        // all the centers are at the same point
+        return count > BVH_MAX_LEAF_SIZE ? first + count / 2 : 0;
+    }
+    float splitCost = BVH_TRAVERSAL_COST + bestCost / GetAabbArea(&node->bounds);
+    if (count <= BVH_MAX_LEAF_SIZE && splitCost >= count) {
+        return 0;
+    }
+
+    int i = first;
+    int j = first + count - 1;
+    while (i <= j) {
+        if (GetBinIndex(centers[i * 3 + bestAxis], minCenters[bestAxis], scales[bestAxis]) <= bestBin) {
+            i++;
+        } else {
+            SwapBvhObjects(bvh, centers, i, j);
+            j--;
+        }
+    }
+    return i;
+}
+
+SpatialBvh* BuildSpatialBvh(const Aabb* boxes, int count) {
+    Assert(count >= 0, "Invalid BVH with %d boxes", count);
+    SpatialBvh* bvh = (SpatialBvh*)calloc(1, sizeof(SpatialBvh));
+    if (bvh == NULL) {
+        return NULL;
+    }
+    bvh->nodes = (BvhNode*)malloc((count * 2 + 1) * sizeof(BvhNode));
+    bvh->ids = (int*)malloc((count + 1) * sizeof(int));
+    bvh->boxes = (Aabb*)malloc((count + 1) * sizeof(Aabb));
+    if (bvh->nodes == NULL || bvh->ids == NULL || bvh->boxes == NULL) {
+        LogWarningIn(LOG_CATEGORY_GENERAL, "Unable to allocate a BVH of %d boxes\n", count);
+        FreeSpatialBvh(bvh);
+        return NULL;
+    }
+    bvh->count = count;
+    for (int i = 0; i < count; i++) {
+        bvh->ids[i] = i;
+        bvh->boxes[i] = boxes[i];
+    }
+    if (count == 0) {
+        return bvh;
+    }
+    float* centers = (float*)malloc(count * 3 * sizeof(float));
+    if (centers == NULL) {
+        LogWarningIn(LOG_CATEGORY_GENERAL, "Unable to allocate a BVH of %d boxes\n", count);
+        FreeSpatialBvh(bvh);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        Vec3 center = GetAabbCenter(&boxes[i]);
+        centers[i * 3 + 0] = center.x;
+        centers[i * 3 + 1] = center.y;
+        centers[i * 3 + 2] = center.z;
+    }
+
+    bvh->nodes[0] = (BvhNode){ .first = 0, .count = count };
+    bvh->nodeCount = 1;
+    UpdateBvhNodeBounds(bvh, &bvh->nodes[0]);
+
+    int stack[BVH_STACK_SIZE];
+    int depths[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    depths[stackSize++] = 0;
+    int maxDepth = 0;
+    while (stackSize > 0) {
+        stackSize--;
+        BvhNode* node = &bvh->nodes[stack[stackSize]];
+        int depth = depths[stackSize];
+        maxDepth = depth > maxDepth ? depth : maxDepth;
+        int split = PartitionBvhNode(bvh, centers, node, depth);
+        if (split == 0) {
+            continue;
+        }
+
+        int leftIndex = bvh->nodeCount;
+        bvh->nodeCount += 2;
+        BvhNode* left = &bvh->nodes[leftIndex];
+        BvhNode* right = &bvh->nodes[leftIndex + 1];
+        *left = (BvhNode){ .first = node->first, .count = split - node->first };
+        *right = (BvhNode){ .first = split, .count = node->first + node->count - split };
+        UpdateBvhNodeBounds(bvh, left);
+        UpdateBvhNodeBounds(bvh, right);
+        node->first = leftIndex;
+        node->count = 0;
+
+        stack[stackSize] = leftIndex + 1;
+        depths[stackSize++] = depth + 1;
+        stack[stackSize] = leftIndex;
+        depths[stackSize++] = depth + 1;
+    }
+
+    free(centers);
+    LogDebugIn(LOG_CATEGORY_GENERAL, "Built a BVH of %d boxes with %d nodes and a depth of %d\n", count, bvh->nodeCount, maxDepth);
+    return bvh;
+}
+
+void FreeSpatialBvh(SpatialBvh* bvh) {
+    if (bvh == NULL) {
+        return;
+    }
+    free(bvh->nodes);
+    free(bvh->ids);
+    free(bvh->boxes);
+    free(bvh);
+}
+
+void RefitSpatialBvh(SpatialBvh* bvh, const Aabb* boxes) {
+    for (int i = 0; i < bvh->count; i++) {
+        bvh->boxes[i] = boxes[bvh->ids[i]];
+    }
+    // children come after their parent
+    for (int i = bvh->nodeCount - 1; i >= 0; i--) {
+        BvhNode* node = &bvh->nodes[i];
+        if (node->count > 0) {
+            UpdateBvhNodeBounds(bvh, node);
+        } else {
+            node->bounds = bvh->nodes[node->first].bounds;
+            GrowAabb(&node->bounds, &bvh->nodes[node->first + 1].bounds);
+        }
+    }
+}
+
+static int RunBvhQuery(const SpatialBvh* bvh, SpatialQuery* query) {
+    if (bvh->nodeCount == 0) {
+        return 0;
+    }
+    int stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BvhNode* node = &bvh->nodes[stack[--stackSize]];
+        if (!QueryOverlaps(query, &node->bounds)) {
+            continue;
+        }
+        if (node->count == 0) {
+            stack[stackSize++] = node->first + 1;
+            stack[stackSize++] = node->first;
+            continue;
+        }
+        for (int i = node->first; i < node->first + node->count; i++) {
+            if (QueryOverlaps(query, &bvh->boxes[i])) {
+                AddQueryResult(query, bvh->ids[i]);
+            }
+        }
+    }
+    return query->count;
+}
+
+int QueryBvhAabb(const SpatialBvh* bvh, Aabb box, int* ids, int maxIds) {
+    SpatialQuery query = MakeAabbQuery(box, ids, maxIds);
+    return RunBvhQuery(bvh, &query);
+}
+
+int QueryBvhSphere(const SpatialBvh* bvh, Vec3 center, float radius, int* ids, int maxIds) {
+    SpatialQuery query = MakeSphereQuery(center, radius, ids, maxIds);
+    return RunBvhQuery(bvh, &query);
+}
+
+int QueryBvhFrustum(const SpatialBvh* bvh, const Frustum* frustum, int* ids, int maxIds) {
+    SpatialQuery query = MakeFrustumQuery(frustum, ids, maxIds);
+    return RunBvhQuery(bvh, &query);
+}
+
+int QueryBvhRay(const SpatialBvh* bvh, Vec3 origin, Vec3 direction, float maxDistance, int* ids, int maxIds) {
+    SpatialQuery query = MakeRayQuery(origin, direction, maxDistance, ids, maxIds);
+    return RunBvhQuery(bvh, &query);
+}
+
+int RaycastBvh(const SpatialBvh* bvh, Vec3 origin, Vec3 direction, float maxDistance, float* distance) {
+    SpatialQuery query = MakeRayQuery(origin, direction, maxDistance, NULL, 0);
+    if (bvh->nodeCount == 0) {
+        return -1;
+    }
+
+    // nodes with their entry distance, the nearer child is visited first
+    int stack[BVH_STACK_SIZE];
+    float entries[BVH_STACK_SIZE];
+    int stackSize = 0;
+    float nearest = maxDistance;
+    int hit = -1;
+    float rootEntry = GetRayEntry(query.origin, query.inverseDirection, nearest, &bvh->nodes[0].bounds);
+    if (rootEntry >= 0) {
+        stack[stackSize] = 0;
+        entries[stackSize++] = rootEntry;
+    }
+    while (stackSize > 0) {
+        stackSize--;
+        if (entries[stackSize] > nearest) {
+            continue;
+        }
+        const BvhNode* node = &bvh->nodes[stack[stackSize]];
+        if (node->count > 0) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                float entry = GetRayEntry(query.origin, query.inverseDirection, nearest, &bvh->boxes[i]);
+                if (entry >= 0 && (hit < 0 || entry < nearest)) {
+                    nearest = entry;
+                    hit = bvh->ids[i];
+                }
+            }
+            continue;
+        }
+
+        int nearChild = node->first;
+        int farChild = node->first + 1;
+        float nearEntry = GetRayEntry(query.origin, query.inverseDirection, nearest, &bvh->nodes[nearChild].bounds);
+        float farEntry = GetRayEntry(query.origin, query.inverseDirection, nearest, &bvh->nodes[farChild].bounds);
+        if (farEntry >= 0 && (nearEntry < 0 || farEntry < nearEntry)) {
+            nearChild = node->first + 1;
+            farChild = node->first;
+            float entry = nearEntry;
+            nearEntry = farEntry;
+            farEntry = entry;
+        }
+        if (farEntry >= 0) {
+            stack[stackSize] = farChild;
+            entries[stackSize++] = farEntry;
+        }
+        if (nearEntry >= 0) {
+            stack[stackSize] = nearChild;
+            entries[stackSize++] = nearEntry;
+        }
+    }
+
+    if (hit >= 0 && distance != NULL) {
+        *distance = nearest;
+    }
+    return hit;
+}
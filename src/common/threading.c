@@ -0,0 +1,52 @@
+#include "platform_setup.h"
+#include "threading.h"
+
+PlatformThreading platformThreading = {};
+
+void InitPlatformThreading(PlatformThreading pt) {
+    platformThreading = pt;
+}
+
+void* StartThread(ThreadFn fn, void* arg) {
+    return platformThreading.StartThread(fn, arg);
+}
+
+void JoinThread(void* thread) {
+    platformThreading.JoinThread(thread);
+}
+
+bool HasThreadExited(void* thread) {
+    return platformThreading.HasThreadExited(thread);
+}
+
+void* CreateSignal() {
+    return platformThreading.CreateSignal();
+}
+
+void SetSignal(void* signal) {
+    platformThreading.SetSignal(signal);
+}
+
+bool WaitSignal(void* signal, int timeoutMs) {
+    return platformThreading.WaitSignal(signal, timeoutMs);
+}
+
+void SleepThread(int ms) {
+    platformThreading.SleepThread(ms);
+}
+
+void* CreateLock() {
+    return platformThreading.CreateLock();
+}
+
+void AcquireLock(void* lock) {
+    platformThreading.AcquireLock(lock);
+}
+
+void ReleaseLock(void* lock) {
+    platformThreading.ReleaseLock(lock);
+}
+
+int GetProcessorCount() {
+    return platformThreading.GetProcessorCount();
+}
@@ -0,0 +1,24 @@
+#ifndef threading_h
+#define threading_h
+
+#include <stdbool.h>
+#include "platform_setup.h"
+
+/*
+ * Internal threading utils. These delegate to the configured platform threading functions.
+ *
+ * A signal is an auto-reset event. Waking up from WaitSignal resets it.
+ */
+void* StartThread(ThreadFn fn, void* arg);
+void JoinThread(void* thread);
+bool HasThreadExited(void* thread);
+void* CreateSignal();
+void SetSignal(void* signal);
+bool WaitSignal(void* signal, int timeoutMs); // returns false on timeout
+void SleepThread(int ms);
+void* CreateLock();
+void AcquireLock(void* lock);
+void ReleaseLock(void* lock);
+int GetProcessorCount();
+
+#endif
@@ -5,6 +5,9 @@
 PlatformTiming platformTiming = {};
 static int64_t targetFps = 60;
 static int64_t ticksStart = 0;
+static int64_t fpsWindowStart = 0;
+static int fpsFrameCount = 0;
+static int currentFps = 0;
 
 void InitPlatformTiming(PlatformTiming pt) {
    platformTiming = pt;
@@ -17,11 +20,25 @@ uint64_t GetTicks() {
 void SetTargetFps(int fps) {
     ResetFpsTimer();
     targetFps = fps;
+    LogDebugIn(LOG_CATEGORY_TIMING, "Target FPS set to %d (%lld us per frame)\n", fps, TICKS_PER_SECOND / targetFps);
 }
 
 int GetFps() {
-    AssertFail("GetFps is not implemented yet");
-    return 1337;
+    return currentFps;
+}
+
+// count the frames in windows of at least one second
+static void CountFrame(int64_t now) {
+    fpsFrameCount++;
+    int64_t ellapsed = now - fpsWindowStart;
+    if (fpsWindowStart == 0) {
+        fpsWindowStart = now;
+        fpsFrameCount = 0;
+    } else if (ellapsed >= TICKS_PER_SECOND) {
+        currentFps = (int)((fpsFrameCount * TICKS_PER_SECOND + ellapsed / 2) / ellapsed);
+        fpsWindowStart = now;
+        fpsFrameCount = 0;
+    }
 }
 
 void SleepUntilNextFrame() {
@@ -35,6 +52,7 @@ void SleepUntilNextFrame() {
     }
 
     ResetFpsTimer();
+    CountFrame(ticksStart);
 }
 
 void ResetFpsTimer() {
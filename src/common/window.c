@@ -4,6 +4,7 @@
 #include "logger.h"
 
 static PlatformWindow platformWindow = {};
+static WindowSettings windowSettings = {0};
 static bool shouldRun = true;
 static int clientWidth = 0;
 static int clientHeight = 0;
@@ -17,8 +18,12 @@ void SetResolution(int cw, int ch) {
     clientHeight = ch;
 }
 
+void ConfigureWindow(WindowSettings settings) {
+    windowSettings = settings;
+}
+
 void InitWindow(const char* title) {
-    platformWindow.InitWindow(title);
+    platformWindow.InitWindow(title, windowSettings);
 }
 
 bool IsWindowOpen() {
@@ -124,27 +124,119 @@ typedef struct {
     float aspectRatio; // set to 0 to use the entire client area
 } Camera3D;
 
+#define LIBGAME_MAX_CAMERAS 8
+
 #define LIBGAME_DEFAULT_MAX_VERTICES 10000;
 #define LIBGAME_DEFAULT_MAX_INDICES 10000;
 
 typedef struct {
     int maxVertices;
     int maxVertexIndices;
+    /*
+     * Directory for caching linked shader programs between runs. Set to NULL to disable.
+     * The directory must exist. Cached programs are invalidated when the shader source or the driver changes.
+     */
+    const char* shaderCacheDirectory;
 } RenderSettings;
 
 LIBGAME_EXPORT void ConfigureRender(RenderSettings settings);
+
+// counters for one frame of rendering
+typedef struct {
+    int drawCalls;
+    int vertexCount; // vertices uploaded to the GPU
+    int indexCount;
+    int shaderBinds;
+    int textureBinds;
+    uint64_t bytesUploaded; // vertices, indices, uniforms and textures
+    int depthPrepassDrawCalls; // included in drawCalls
+    // Samples shaded by color draws, and the same per pixel of the framebuffer regions drawn into, summed
+    // over the render targets of the frame. Measured on the GPU, so they are from the latest frame
+    // the GPU has finished, usually a couple of frames earlier.
+    uint64_t samplesShaded;
+    float overdraw;
+} RenderStats;
+
+// returns the stats of the last completed frame
+LIBGAME_EXPORT RenderStats GetRenderStats();
+
+/*
+ * Presenting frames.
+ *
+ * The swap interval decides whether EndFrame waits for the vertical blank when it presents
+ * the frame. Until it is set, the driver default is used. Vsync with SleepUntilNextFrame at a lower
+ * target FPS than the refresh rate makes each frame wait twice, so use one or the other for pacing.
+ *
+ * Drivers queue several frames ahead, which adds latency between input and the screen. The low latency mode
+ * limits the number of frames in flight by waiting on a GPU fence at the end of the frame, without glFinish.
+ * With 1 frame in flight EndFrame waits until the GPU has finished the frame it just presented
+ * (lowest latency, no overlap of CPU and GPU work). With 2 the GPU works on one frame while the
+ * CPU prepares the next. 0 lets the driver decide.
+ */
+#define LIBGAME_MAX_FRAMES_IN_FLIGHT 4
+
+typedef enum {
+    SWAP_INTERVAL_DEFAULT, // leave it to the driver
+    SWAP_INTERVAL_IMMEDIATE, // present without waiting for the vertical blank, can tear
+    SWAP_INTERVAL_VSYNC,
+    // wait for the vertical blank, but present a late frame immediately instead of waiting for the next one
+    SWAP_INTERVAL_ADAPTIVE,
+} SwapInterval;
+
+typedef struct {
+    SwapInterval swapInterval;
+    int maxFramesInFlight; // 0 to 4, see above
+} PresentSettings;
+
+/*
+ * Call after InitWindow. Returns false if the swap interval is not supported,
+ * in which case the closest supported one is used (adaptive falls back to vsync).
+ */
+LIBGAME_EXPORT bool ConfigurePresent(PresentSettings settings);
+
+typedef struct {
+    // from the end of ProcessInput until EndFrame has presented the frame, including the low latency wait
+    uint64_t inputToPresentMicros;
+    /*
+     * From the end of ProcessInput until the GPU was seen finishing the frame. This is checked
+     * at the end of each frame, so it is an upper bound, unless the low latency mode waited for the frame.
+     * It lags behind the other values by the frames in flight. 0 until known.
+     */
+    uint64_t inputToGpuDoneMicros;
+    uint64_t fenceWaitMicros; // spent waiting for the GPU in the low latency mode
+} FrameLatency;
+
+// returns the latency of the most recent frames
+LIBGAME_EXPORT FrameLatency GetFrameLatency();
 LIBGAME_EXPORT void ClearScreen(Color color);
 /*
  * Issues a draw call with all of the pending graphics.
  * Resets the current custom transform. The camera transform is not reset.
+ *
+ * The opaque graphics of a draw call are grouped by material and texture, so overlapping opaque graphics
+ * at the same depth, like 2D shapes, are drawn in an unspecified order. Give them different depths,
+ * split them into separate draw calls, or draw them in transparency mode, which keeps the draw order.
  */
 LIBGAME_EXPORT void MakeDrawCall();
 LIBGAME_EXPORT void EndFrame();
 // sets a custom transform to apply to all graphics in the next draw call
 LIBGAME_EXPORT void SetTransform(Mat4 mat);
-// set a camera to be active across draw calls
+// set a camera to be active across draw calls (in the currently used camera slot)
 LIBGAME_EXPORT void SetCamera2D(Camera2D* camera);
 LIBGAME_EXPORT void SetCamera3D(Camera3D* camera);
+/*
+ * Several cameras can be active at the same time, for example a world camera
+ * and a UI camera. Each camera is stored in a slot and the transforms of all
+ * slots are kept on the GPU. Switching between slots is cheap, and a camera
+ * that has not changed is not recalculated or uploaded again.
+ *
+ * Slot 0 is used by default. Slots that have not been set use a 2D camera at the origin.
+ */
+LIBGAME_EXPORT void SetCameraSlot2D(int slot, Camera2D* camera);
+LIBGAME_EXPORT void SetCameraSlot3D(int slot, Camera3D* camera);
+// select the camera slot for the next draw calls and for SetCamera2D/SetCamera3D
+LIBGAME_EXPORT void UseCameraSlot(int slot);
+LIBGAME_EXPORT int GetCurrentCameraSlot();
 // shapes
 LIBGAME_EXPORT void DrawTriangle2D(Vec2 a, Vec2 b, Vec2 c, Color color);
 LIBGAME_EXPORT void DrawTriangle3D(Vec3 a, Vec3 b, Vec3 c, Color color);
@@ -155,6 +247,8 @@ LIBGAME_EXPORT void RotateCameraFirstPerson(Camera3D* camera, float yaw, float p
 LIBGAME_EXPORT void MoveCameraFirstPerson(Camera3D* camera, Vec3 relativeOffset);
 LIBGAME_EXPORT void OrbitCameraAboutTarget(Camera3D* camera, float azimuth, float elevation);
 LIBGAME_EXPORT void MoveCameraTowardsTarget(Camera3D* camera, float distanceOffset);
+// projected height in pixels of a sphere in the client area, huge when the camera is inside the sphere
+LIBGAME_EXPORT float GetProjectedSize3D(const Camera3D* camera, Vec3 center, float radius);
 
 /*
  * Enable/disable color blending. This is active across multiple draw calls.
@@ -163,8 +257,405 @@ LIBGAME_EXPORT void MoveCameraTowardsTarget(Camera3D* camera, float distanceOffs
  */
 LIBGAME_EXPORT void SetTransparencyMode(bool shouldEnable);
 
+typedef enum {
+    // blended in draw order, so the graphics must be drawn back to front
+    TRANSPARENCY_SORTED,
+    // weighted blended order independent transparency, for many overlapping graphics drawn in any order.
+    // The result is an approximation: fragments are weighted by their alpha and depth instead of sorted.
+    // Custom shaders must declare "out vec4 FragColor;" as their only output to be used with it, otherwise
+    // they are drawn unweighted with a warning.
+    TRANSPARENCY_WEIGHTED,
+} TransparencyMethod;
+
+/*
+ * How the graphics are blended while transparency mode is enabled. With the weighted method, the graphics
+ * are composited over the framebuffer when transparency mode is disabled, or before anything else
+ * uses the framebuffer.
+ *
+ * TRANSPARENCY_SORTED by default.
+ */
+LIBGAME_EXPORT void SetTransparencyMethod(TransparencyMethod method);
+
+/*
+ * Enable/disable the depth prepass for opaque graphics. Each draw call first draws the depth of its graphics,
+ * then shades only the nearest fragment of each pixel, which is faster when expensive or many overlapping
+ * 3D graphics are limited by the fill rate. Overlapping graphics at the same depth are all shaded, and
+ * which one is visible is unspecified (see MakeDrawCall). Has no effect while transparency mode is enabled.
+ *
+ * Disabled by default.
+ */
+LIBGAME_EXPORT void SetDepthPrepassMode(bool shouldEnable);
+
+/*
+ * Custom shaders and materials.
+ *
+ * Shaders are written in GLSL 3.30 without the #version line, which is added by the library.
+ * The vertex shader also gets a prelude with the vertex inputs and the camera:
+ *
+ *   layout(location = 0) in vec3 position;
+ *   layout(location = 1) in vec4 color;
+ *   vec4 TransformPosition(vec3 position); // applies the custom transform and the current camera
+ *
+ * A material is a shader plus a block of parameters. Declare the parameters in the shader as
+ *
+ *   layout(std140) uniform MaterialBlock { ... };
+ *
+ * and set them with SetMaterialParams, using a C struct with the same std140 layout
+ * (for example, a vec3 takes up 16 bytes). The parameters of all materials are kept in one
+ * uniform buffer, which is updated at most once per draw call.
+ *
+ * Graphics drawn with the same material are merged when the draw call is made,
+ * unless transparency mode is enabled (blending depends on the draw order).
+ */
+#define LIBGAME_MAX_SHADERS 32
+#define LIBGAME_MAX_MATERIALS 256
+#define LIBGAME_MAX_MATERIAL_PARAMS_SIZE 256
+
+// a zero initialized handle refers to the default shader/material
+typedef struct {
+    int id;
+} Shader;
+
+typedef struct {
+    int id;
+} Material;
+
+LIBGAME_EXPORT Shader CreateShader(const char* vertexSrc, const char* fragmentSrc);
+LIBGAME_EXPORT Material CreateMaterial(Shader shader);
+LIBGAME_EXPORT void SetMaterialParams(Material material, const void* params, int size);
+// select the material for the next graphics, active across draw calls
+LIBGAME_EXPORT void UseMaterial(Material material);
+LIBGAME_EXPORT Material GetCurrentMaterial();
+
+/*
+ * Textures and sprites.
+ *
+ * Pixels are 8-bit RGBA, with the top row first. Custom shaders can sample the
+ * texture of the current sprite with the textureSampler uniform and the texCoord vertex input.
+ *
+ * Sprites are batched with the other shapes. Sprites that share a texture are
+ * drawn together, so pack small images into a texture atlas to keep the number of textures low.
+ */
+#define LIBGAME_MAX_TEXTURES 256
+
+// a zero initialized handle refers to a 1x1 white texture
+typedef struct {
+    int id;
+    int width;
+    int height;
+} Texture;
+
+// a region of a texture
+typedef struct {
+    Texture texture;
+    Vec2 uvMin; // top left
+    Vec2 uvMax; // bottom right
+    int width;
+    int height;
+} Sprite;
+
+LIBGAME_EXPORT Texture CreateTexture(const uint8_t* pixels, int width, int height); // pixels can be NULL
+LIBGAME_EXPORT void UpdateTexture(Texture texture, int x, int y, int width, int height, const uint8_t* pixels);
+LIBGAME_EXPORT Sprite GetTextureSprite(Texture texture);
+// position is the bottom left corner
+LIBGAME_EXPORT void DrawSprite2D(Sprite sprite, Vec2 position, Vec2 size, Color tint);
+LIBGAME_EXPORT void DrawSprite3D(Sprite sprite, Vec3 topLeft, Vec3 topRight, Vec3 bottomLeft, Vec3 bottomRight, Color tint);
+
+/*
+ * Offscreen render targets, with a color texture and a depth buffer.
+ *
+ * While a target is used, draw calls render into it instead of the window. Switching targets
+ * issues the pending draw call. The cameras keep using the client area of the window, so
+ * the scene is scaled to the size of the target. The color texture can be drawn like any other
+ * texture, for example with the sprite from GetRenderTargetSprite. Don't draw a target into itself.
+ */
+#define LIBGAME_MAX_RENDER_TARGETS 16
+
+typedef struct {
+    int id;
+    Texture texture; // the color texture, with the size of the target
+} RenderTarget;
+
+LIBGAME_EXPORT RenderTarget CreateRenderTarget(int width, int height);
+LIBGAME_EXPORT void ResizeRenderTarget(RenderTarget* target, int width, int height);
+LIBGAME_EXPORT void UseRenderTarget(RenderTarget target);
+LIBGAME_EXPORT void UseWindowRenderTarget();
+// the whole target, flipped since the rows of a render target are stored bottom up
+LIBGAME_EXPORT Sprite GetRenderTargetSprite(RenderTarget target);
+
+/*
+ * Dynamic resolution.
+ *
+ * The graphics between BeginDynamicResolution and EndDynamicResolution are rendered into an internal
+ * target at a fraction of the window resolution, which is then stretched over the window.
+ * The fraction (scale) is chosen from the GPU time of the scaled graphics, measured a few frames
+ * later with timer queries, so that it stays within the budget. Since the cost is roughly proportional
+ * to the pixel count, the scale moves towards sqrt(budget / time). It drops quickly and rises slowly.
+ *
+ * Clear the screen after BeginDynamicResolution to clear the internal target. Graphics after
+ * EndDynamicResolution, such as the UI, are drawn over the scaled image at the full resolution.
+ */
+typedef struct {
+    float gpuBudgetMs; // GPU time for the scaled graphics
+    float minScale;
+    float maxScale;
+} DynamicResolutionSettings;
+
+#define LIBGAME_DEFAULT_GPU_BUDGET_MS 12
+#define LIBGAME_DEFAULT_MIN_RESOLUTION_SCALE 0.5f
+#define LIBGAME_DEFAULT_MAX_RESOLUTION_SCALE 1.0f
+
+LIBGAME_EXPORT void ConfigureDynamicResolution(DynamicResolutionSettings settings); // set a field to 0 for the default
+LIBGAME_EXPORT void BeginDynamicResolution();
+LIBGAME_EXPORT void EndDynamicResolution();
+LIBGAME_EXPORT float GetResolutionScale();
+LIBGAME_EXPORT float GetDynamicResolutionGpuMs(); // the latest measured GPU time, 0 until known
+
+/*
+ * Shape generators. Each shape reserves its vertices and indices in the batch once
+ * and writes them directly, so complex shapes cost the same as their triangles.
+ */
+// position is the bottom left corner
+LIBGAME_EXPORT void DrawRect2D(Vec2 position, Vec2 size, Color color);
+/*
+ * Draw a circle with the given number of segments. Set segments to 0 to pick the count from the radius,
+ * so that the edge is within half a world unit of a true circle.
+ */
+LIBGAME_EXPORT void DrawCircle2D(Vec2 center, float radius, int segments, Color color);
+LIBGAME_EXPORT void DrawLine2D(Vec2 a, Vec2 b, float thickness, Color color);
+// a simple polygon (no holes or self intersections) in either winding order, triangulated with ear clipping
+LIBGAME_EXPORT void DrawPolygon2D(const Vec2* points, int pointCount, Color color);
+
+// indexed triangles
+typedef struct {
+    const Vec3* positions;
+    const Color* colors; // optional, uses color if NULL
+    Color color;
+    const Vec2* texCoords; // optional
+    Texture texture;
+    int vertexCount;
+    const uint32_t* indices;
+    int indexCount;
+} Mesh;
+
+LIBGAME_EXPORT void DrawMesh(Mesh mesh);
+// the positions are transformed while they are copied into the batch, so meshes with different transforms share draw calls
+LIBGAME_EXPORT void DrawMeshTransformed(Mesh mesh, Mat4 transform);
+
+/*
+ * Optimize a mesh for drawing many times, once at load time. Vertices with the same attributes are merged,
+ * triangles are reordered so that the GPU reuses more transformed vertices, and vertices are reordered in
+ * the order the triangles use them. Unused vertices are dropped. The result draws the same triangles.
+ *
+ * The returned mesh owns its arrays, free it with FreeOptimizedMesh. It has no vertices if the allocation fails.
+ */
+LIBGAME_EXPORT Mesh OptimizeMesh(Mesh mesh);
+LIBGAME_EXPORT void FreeOptimizedMesh(Mesh mesh);
+// vertices transformed per triangle with a 16 vertex FIFO cache, from 3 down to about 0.6 for a well ordered mesh
+LIBGAME_EXPORT float GetMeshCacheMissRatio(Mesh mesh);
+
+/*
+ * Level of detail. A LOD group has up to LIBGAME_MAX_LOD_LEVELS meshes for the same object, most detailed first.
+ * The level of an object is picked from the projected height of its bounding sphere, so it adapts to the field
+ * of view and the client height. Level i + 1 is used below screenHeights[i] pixels, with hysteresis:
+ * an object only switches once its size is past the threshold by the hysteresis fraction, so objects near
+ * a threshold don't pop between levels every frame.
+ *
+ * Select the levels of the visible objects once per frame, then draw them. The levels are drawn into
+ * the batch with their transform applied, so objects that share a texture share draw calls.
+ */
+#define LIBGAME_MAX_LOD_LEVELS 4
+#define LIBGAME_DEFAULT_LOD_HYSTERESIS 0.1f
+#define LIBGAME_LOD_UNSELECTED -1
+
+typedef struct {
+    Mesh levels[LIBGAME_MAX_LOD_LEVELS];
+    int levelCount;
+    float screenHeights[LIBGAME_MAX_LOD_LEVELS - 1]; // decreasing, in pixels
+    float cullScreenHeight; // not drawn below this height, 0 to always draw
+    float radius; // bounding sphere of the levels around their origin
+    float hysteresis; // 0 for LIBGAME_DEFAULT_LOD_HYSTERESIS
+} LodGroup;
+
+typedef struct {
+    const LodGroup* group;
+    Mat4 transform;
+    // levelCount when culled, initialize to LIBGAME_LOD_UNSELECTED. Kept between frames for the hysteresis.
+    int level;
+} LodObject;
+
+LIBGAME_EXPORT void SelectLodLevels(const Camera3D* camera, LodObject* objects, int objectCount);
+LIBGAME_EXPORT void DrawLodObjects(const LodObject* objects, int objectCount);
+
+/*
+ * A texture atlas packs images into pages, which are large textures.
+ * A new page is created when an image does not fit in any existing page.
+ *
+ * Images are packed with a skyline packer. Each image gets a 1 pixel border
+ * with its edge pixels repeated, so that filtering does not bleed in neighboring images.
+ */
+#define LIBGAME_MAX_ATLAS_PAGES 16
+
+typedef struct TextureAtlas TextureAtlas;
+
+LIBGAME_EXPORT TextureAtlas* CreateTextureAtlas(int pageWidth, int pageHeight);
+// returns false if the image is larger than a page or the max number of pages is reached
+LIBGAME_EXPORT bool AddAtlasImage(TextureAtlas* atlas, const uint8_t* pixels, int width, int height, Sprite* sprite);
+LIBGAME_EXPORT int GetAtlasPageCount(TextureAtlas* atlas);
+// frees the packing state, the page textures and sprites stay valid
+LIBGAME_EXPORT void DestroyTextureAtlas(TextureAtlas* atlas);
+
+/*
+ * Text rendered with signed distance field (SDF) fonts.
+ *
+ * Glyphs are rasterized once at rasterSize pixels and stored as distance fields
+ * in a texture atlas, which stay sharp when scaled. The fields are cached on disk,
+ * so later runs skip the rasterization.
+ *
+ * Text is batched with the other graphics, using the material of the font.
+ * Enable transparency mode for smooth glyph edges.
+ */
+#define LIBGAME_DEFAULT_FONT_RASTER_SIZE 48
+
+typedef struct Font Font;
+
+typedef struct {
+    const char* faceName; // an installed font, for example "Arial"
+    int rasterSize; // set to 0 to use the default
+    // range of glyphs to load, set both to 0 for printable ASCII and Latin-1
+    int firstCodepoint;
+    int lastCodepoint;
+    // directory for caching the distance fields between runs, set to NULL to disable. The directory must exist.
+    const char* cacheDirectory;
+} FontSettings;
+
+// requires a window. Returns NULL if the font is not found.
+LIBGAME_EXPORT Font* LoadFont(FontSettings settings);
+LIBGAME_EXPORT void FreeFont(Font* font);
+/*
+ * Draw UTF-8 text with the baseline of the first line starting at position.
+ * The size is the font size in world units, which maps to rasterSize pixels. Lines are separated by \n.
+ */
+LIBGAME_EXPORT void DrawText2D(Font* font, const char* text, Vec2 position, float size, Color color);
+LIBGAME_EXPORT Vec2 MeasureText(Font* font, const char* text, float size);
+
+/*
+ * Immediate mode debug drawing.
+ *
+ * Debug lines are kept in their own compact line buffer and drawn with GL_LINES at the end
+ * of the frame, so they don't use up the vertex buffer or split the batches of the regular graphics.
+ * Each primitive uses the camera slot that is active when it is added.
+ *
+ * Depth tested lines are hidden behind other graphics, while overlay lines are drawn on top.
+ * A primitive is drawn for the given number of frames, where 0 and 1 both mean only the current frame.
+ * Lines beyond the max are dropped.
+ *
+ * Define LIBGAME_NO_DEBUG_DRAW before including this header to remove the calls entirely,
+ * including the evaluation of their arguments.
+ */
+#define LIBGAME_DEFAULT_MAX_DEBUG_LINES 65536
+
+typedef enum {
+    DEBUG_DRAW_DEPTH_TESTED,
+    DEBUG_DRAW_OVERLAY,
+} DebugDrawMode;
+
+typedef struct {
+    int maxLines; // set to 0 to use the default
+} DebugDrawSettings;
+
+LIBGAME_EXPORT void ConfigureDebugDraw(DebugDrawSettings settings);
+LIBGAME_EXPORT void DebugDrawLine(Vec3 a, Vec3 b, Color color, DebugDrawMode mode, int frames);
+LIBGAME_EXPORT void DebugDrawBox(Vec3 min, Vec3 max, Color color, DebugDrawMode mode, int frames);
+LIBGAME_EXPORT void DebugDrawSphere(Vec3 center, float radius, Color color, DebugDrawMode mode, int frames);
+
+#ifdef LIBGAME_NO_DEBUG_DRAW
+    #define ConfigureDebugDraw(...) ((void)0)
+    #define DebugDrawLine(...) ((void)0)
+    #define DebugDrawBox(...) ((void)0)
+    #define DebugDrawSphere(...) ((void)0)
+#endif
+
+/*
+ * Render capture and replay.
+ *
+ * A capture records every call into the render backend for a number of frames, starting
+ * with the next frame, and writes them to a binary file after the last one. Replaying the file
+ * feeds the same calls into the render backend without the game, for example with the
+ * render_replay tool, so a slow frame can be profiled and bisected on another machine.
+ *
+ * The shaders, materials, cameras and other state that exist when the capture starts are
+ * recreated before the first captured frame. Textures created before the capture keep their size,
+ * but not their pixels. Resources created by a replay are never freed.
+ */
+typedef struct RenderCapture RenderCapture;
+
+typedef struct {
+    int frameCount;
+    int width; // client area of the captured window
+    int height;
+    RenderSettings renderSettings; // without a shader cache directory
+} RenderCaptureInfo;
+
+// returns false if a capture is already in progress
+LIBGAME_EXPORT bool BeginRenderCapture(const char* path, int frameCount);
+LIBGAME_EXPORT bool IsRenderCaptureActive();
+LIBGAME_EXPORT RenderCapture* LoadRenderCapture(const char* path); // returns NULL on failure
+LIBGAME_EXPORT RenderCaptureInfo GetRenderCaptureInfo(RenderCapture* capture);
+/*
+ * Replays the next captured frame, including its EndFrame. Requires a window.
+ * Starts over after the last frame. Returns the index of the replayed frame.
+ */
+LIBGAME_EXPORT int ReplayRenderCaptureFrame(RenderCapture* capture);
+LIBGAME_EXPORT void FreeRenderCapture(RenderCapture* capture);
+
+/*
+ * Frame readback, for screenshots, recordings and automated visual tests.
+ *
+ * At the end of a frame, the render target in use is copied into a GPU buffer without waiting for the GPU.
+ * That is the window, unless a render target is still used at EndFrame, for example to read back
+ * a scene that is drawn into a render target of a hidden window.
+ * The pixels are picked up a couple of frames later, once the copy is done, and handed to
+ * a background thread, which encodes and writes them or calls the callback. Pixels are RGBA,
+ * with the top row first. Frames are numbered from 1, counting every EndFrame.
+ */
+#define LIBGAME_MAX_READBACK_PATH 260
+
+typedef enum {
+    FRAME_RECORDING_PNG, // one PNG file per frame, the path is a prefix: path_000000.png
+    FRAME_RECORDING_RAW, // every frame appended to one file, for example for ffmpeg -f rawvideo -pix_fmt rgba
+} FrameRecordingFormat;
+
+// called on the background thread, the pixels are freed after it returns
+typedef void (*FrameReadbackFn)(const uint8_t* pixels, int width, int height, uint64_t frame, void* userData);
+
+// reads back the current frame, once per frame
+LIBGAME_EXPORT void ReadbackFrame(FrameReadbackFn fn, void* userData);
+// writes the current frame to a PNG file, once per frame
+LIBGAME_EXPORT void SaveScreenshot(const char* path);
+// records every frame from the current one, returns false if a recording is active or the file can't be opened
+LIBGAME_EXPORT bool BeginFrameRecording(const char* path, FrameRecordingFormat format);
+// the current frame is the last one recorded. Its EndFrame waits for the recorded frames to be written.
+LIBGAME_EXPORT void EndFrameRecording();
+LIBGAME_EXPORT bool IsFrameRecordingActive();
+// waits until the frames requested before the current one are written or handed to their callbacks
+LIBGAME_EXPORT void FlushFrameReadbacks();
+
 // -- Window --
 
+typedef struct {
+    // client area size, set both to 0 to let the platform decide
+    int width;
+    int height;
+    /*
+     * Create the window without showing it, for example for benchmarks. Rendering works as usual,
+     * but some drivers skip rasterization for pixels that are not visible.
+     */
+    bool isHidden;
+} WindowSettings;
+
+// call before InitWindow
+LIBGAME_EXPORT void ConfigureWindow(WindowSettings settings);
 LIBGAME_EXPORT void InitWindow(const char* title);
 LIBGAME_EXPORT bool IsWindowOpen();
 LIBGAME_EXPORT void CloseCurrentWindow();
@@ -184,12 +675,135 @@ typedef enum {
     LOG_ERROR,
 } LogLevel;
 
-LIBGAME_EXPORT void SetLogLevel(LogLevel level); // minimum level to log
+// subsystems with their own minimum log level
+typedef enum {
+    LOG_CATEGORY_GENERAL,
+    LOG_CATEGORY_RENDER,
+    LOG_CATEGORY_INPUT,
+    LOG_CATEGORY_TIMING,
+    LOG_CATEGORY_LOADER,
+    // checking number of categories
+    LOG_CATEGORY_COUNT,
+} LogCategory;
+
+LIBGAME_EXPORT void SetLogLevel(LogLevel level); // minimum level to log, for all categories
+LIBGAME_EXPORT void SetLogCategoryLevel(LogCategory category, LogLevel level); // override a single category
+LIBGAME_EXPORT bool IsLogEnabled(LogCategory category, LogLevel level);
 LIBGAME_EXPORT void Log(LogLevel level, const char* format, ...);
 LIBGAME_EXPORT void LogDebug(const char* format, ...);
 LIBGAME_EXPORT void LogInfo(const char* format, ...);
 LIBGAME_EXPORT void LogWarning(const char* format, ...);
 LIBGAME_EXPORT void LogError(const char* format, ...);
+// usually use the LogDebugIn/LogInfoIn/... macros below instead
+LIBGAME_EXPORT void LogCategorized(LogCategory category, LogLevel level, const char* format, ...);
+
+/*
+ * Build time log level stripping.
+ *
+ * Define LIBGAME_LOG_MIN_LEVEL before including this header to remove calls
+ * below that level entirely, including the evaluation of their arguments.
+ * For example -DLIBGAME_LOG_MIN_LEVEL=LIBGAME_LOG_LEVEL_WARNING strips debug and info logs.
+ */
+#define LIBGAME_LOG_LEVEL_DEBUG 0
+#define LIBGAME_LOG_LEVEL_INFO 1
+#define LIBGAME_LOG_LEVEL_WARNING 2
+#define LIBGAME_LOG_LEVEL_ERROR 3
+
+#ifndef LIBGAME_LOG_MIN_LEVEL
+    #define LIBGAME_LOG_MIN_LEVEL LIBGAME_LOG_LEVEL_DEBUG
+#endif
+
+/*
+ * Categorized logging. The runtime level check happens before the arguments are evaluated,
+ * so a disabled category only costs a single branch.
+ */
+#define LIBGAME_LOG_IN(category, level, numericLevel, ...) \
+    do { \
+        if ((numericLevel) >= LIBGAME_LOG_MIN_LEVEL && IsLogEnabled(category, level)) { \
+            LogCategorized(category, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LogDebugIn(category, ...) LIBGAME_LOG_IN(category, LOG_DEBUG, LIBGAME_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LogInfoIn(category, ...) LIBGAME_LOG_IN(category, LOG_INFO, LIBGAME_LOG_LEVEL_INFO, __VA_ARGS__)
+#define LogWarningIn(category, ...) LIBGAME_LOG_IN(category, LOG_WARNING, LIBGAME_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LogErrorIn(category, ...) LIBGAME_LOG_IN(category, LOG_ERROR, LIBGAME_LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#if LIBGAME_LOG_MIN_LEVEL > LIBGAME_LOG_LEVEL_DEBUG
+    #define LogDebug(...) ((void)0)
+    #define Log(level, ...) \
+        do { \
+            if ((int)(level) >= LIBGAME_LOG_MIN_LEVEL) { \
+                (Log)(level, __VA_ARGS__); \
+            } \
+        } while (0)
+#endif
+#if LIBGAME_LOG_MIN_LEVEL > LIBGAME_LOG_LEVEL_INFO
+    #define LogInfo(...) ((void)0)
+#endif
+#if LIBGAME_LOG_MIN_LEVEL > LIBGAME_LOG_LEVEL_WARNING
+    #define LogWarning(...) ((void)0)
+#endif
+#if LIBGAME_LOG_MIN_LEVEL > LIBGAME_LOG_LEVEL_ERROR
+    #define LogError(...) ((void)0)
+#endif
+
+typedef enum {
+    LOG_SINK_CONSOLE, // errors to stderr, everything else to stdout
+    LOG_SINK_STDOUT,
+    LOG_SINK_STDERR,
+    LOG_SINK_FILE,
+} LogSink;
+
+// what to do when logging faster than the background thread can write
+typedef enum {
+    LOG_OVERFLOW_DROP, // discard the record and report the number of dropped records later
+    LOG_OVERFLOW_BLOCK, // wait for the background thread to free up space
+} LogOverflowPolicy;
+
+typedef struct {
+    /*
+     * In async mode the logging calls only format a record into a lock-free queue.
+     * A background thread writes the records to the sink.
+     */
+    bool isAsync;
+    LogOverflowPolicy overflowPolicy;
+    LogSink sink;
+    const char* filePath; // used with LOG_SINK_FILE
+    const char* binaryFilePath; // destination for LogDeferred records, see below
+} LogSettings;
+
+/*
+ * Defaults to synchronous logging to the console.
+ *
+ * Pending records are flushed at exit and before an assert message is printed.
+ */
+LIBGAME_EXPORT void ConfigureLogger(LogSettings settings);
+// block until all pending records have been written
+LIBGAME_EXPORT void FlushLog();
+
+/*
+ * Deferred logging for hot code paths.
+ *
+ * When a binary log file is configured, no formatting happens on the calling thread.
+ * The call site registers its format string once and then only records the format id,
+ * a timestamp and the raw arguments. Use tools/log_decode.c to turn the binary log into text.
+ *
+ * Without a binary log file the message is formatted and logged as usual.
+ *
+ * Supported arguments are integers, floating point numbers, strings and pointers.
+ * Width and precision can not be passed as arguments (%*d). Strings are truncated to 128 characters.
+ */
+#define LogDeferred(level, ...) \
+    do { \
+        static int libgameLogFormatId = 0; \
+        if ((int)(level) >= LIBGAME_LOG_MIN_LEVEL) { \
+            LogDeferredWithId(&libgameLogFormatId, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// used by LogDeferred - the format id is set on the first call
+LIBGAME_EXPORT void LogDeferredWithId(int* formatId, LogLevel level, const char* format, ...);
 
 // -- Timing --
 
@@ -198,6 +812,7 @@ LIBGAME_EXPORT void LogError(const char* format, ...);
 
 LIBGAME_EXPORT uint64_t GetTicks(); // microseconds
 LIBGAME_EXPORT void SetTargetFps(int fps);
+// frames per second, counted over the last full second of SleepUntilNextFrame calls
 LIBGAME_EXPORT int GetFps();
 LIBGAME_EXPORT void SleepUntilNextFrame();
 LIBGAME_EXPORT void ResetFpsTimer();
@@ -209,6 +824,10 @@ typedef struct {
     // internal fields - do not edit manually
     void* handle;
     uint64_t lastWrite;
+    void* watcher;
+    // read-only stats
+    int version; // incremented on every load
+    uint64_t reloadTicks; // time from detecting a change to finishing the reload
 } DynamicLibrary;
 
 typedef enum {
@@ -223,10 +842,204 @@ LIBGAME_EXPORT void ResolvePath(char* fileBaseName, FileExtensionType extension,
 /*
  * Load or reload a library if it has changed. Returns true if a loading or reload was done.
  * Resolve to an absolute path before calling this.
+ *
+ * Changes are detected with file change notifications, so it is cheap to call this every frame.
+ * Function pointers from the previous version must be loaded again after a reload.
  */
 LIBGAME_EXPORT bool LoadDynamicLibrary(char* libraryPath, DynamicLibrary* lib);
 LIBGAME_EXPORT void* LoadLibraryFunction(char* functionName, DynamicLibrary* lib);
 
+// -- Assets --
+
+/*
+ * Asynchronous asset loading.
+ *
+ * Files are read (memory-mapped where possible) and decoded on a pool of worker threads.
+ * Decoded assets are then queued for upload on the main thread, for example to create a texture.
+ * The upload queue is drained in EndFrame, within a time budget per frame, so that
+ * loading many assets does not cause frame spikes.
+ *
+ * The decode function runs on a worker thread and must be thread safe. It gets the
+ * file contents, which are only valid during the call, and returns the decoded asset.
+ * The upload function runs on the main thread and takes ownership of the decoded asset.
+ *
+ * Call these functions from the main thread.
+ */
+
+#define LIBGAME_MAX_ASSETS 1024
+#define LIBGAME_MAX_ASSET_PATH 260
+#define LIBGAME_DEFAULT_ASSET_UPLOAD_BUDGET_MICROS 2000
+
+typedef struct {
+    int workerCount; // set to 0 to use one worker per processor, except for the main thread
+    int uploadBudgetMicros; // at least one upload is done per frame
+} AssetSettings;
+
+typedef enum {
+    ASSET_LOADING,
+    ASSET_READY,
+    ASSET_FAILED,
+} AssetState;
+
+typedef struct {
+    int id;
+} AssetHandle;
+
+// returns false if the data could not be decoded
+typedef bool (*AssetDecodeFn)(const uint8_t* data, uint64_t size, void* userData, void** decoded);
+typedef void (*AssetUploadFn)(void* decoded, void* userData);
+
+// configure before the first asset is loaded
+LIBGAME_EXPORT void ConfigureAssets(AssetSettings settings);
+LIBGAME_EXPORT AssetHandle LoadAssetAsync(const char* path, AssetDecodeFn decode, AssetUploadFn upload, void* userData);
+LIBGAME_EXPORT AssetState GetAssetState(AssetHandle asset);
+// count of assets that have not been uploaded yet
+LIBGAME_EXPORT int GetPendingAssetCount();
+/*
+ * Load an uncompressed or run-length encoded TGA image (24 or 32 bits per pixel) into a texture.
+ * The texture pointer must stay valid until the asset is ready.
+ */
+LIBGAME_EXPORT AssetHandle LoadTextureAsync(const char* path, Texture* texture);
+
+// -- Asset packs --
+
+/*
+ * An asset pack is a single file with meshes, textures and shader sources, built
+ * offline with the asset_pack tool. The file is memory-mapped and used without parsing.
+ * Uncompressed mesh data is drawn straight from the mapping.
+ *
+ * Packed mesh vertices have a position, a color and texture coordinates (9 floats).
+ * The mesh data stays valid until the pack is closed.
+ */
+
+typedef struct AssetPack AssetPack;
+
+typedef struct {
+    const float* vertices;
+    int vertexCount;
+    const uint32_t* indices;
+    int indexCount;
+} PackedMesh;
+
+LIBGAME_EXPORT AssetPack* OpenAssetPack(const char* path); // returns NULL on failure
+LIBGAME_EXPORT void CloseAssetPack(AssetPack* pack);
+LIBGAME_EXPORT bool LoadPackedTexture(AssetPack* pack, const char* name, Texture* texture);
+LIBGAME_EXPORT bool LoadPackedShader(AssetPack* pack, const char* name, Shader* shader);
+LIBGAME_EXPORT bool GetPackedMesh(AssetPack* pack, const char* name, PackedMesh* mesh);
+LIBGAME_EXPORT void DrawPackedMesh(PackedMesh mesh, Texture texture);
+
+// -- Memory --
+
+typedef struct {
+    void* memory;
+    uint64_t size;
+    // true if the memory was allocated or cleared by this call, meaning that the game state needs to be initialized
+    bool isFresh;
+} PersistentMemory;
+
+/*
+ * Memory owned by the library that survives reloads of the game library.
+ *
+ * Keep the game state in here instead of in globals. After a reload, call this again
+ * to get the same memory back, with the state intact. No serialization is needed.
+ *
+ * The layout version describes the structure of the game state. If it differs from
+ * the previous call, the old contents no longer match and the memory is cleared.
+ * LIBGAME_LAYOUT_VERSION helps with catching changes in the struct size.
+ *
+ * The memory is allocated at LIBGAME_PERSISTENT_MEMORY_BASE if possible, so that
+ * pointers into it are valid across runs, for example when saving a snapshot to disk.
+ * The size can not grow after the first call.
+ */
+LIBGAME_EXPORT PersistentMemory GetPersistentMemory(uint64_t size, uint32_t layoutVersion);
+
+#define LIBGAME_PERSISTENT_MEMORY_BASE ((void*)0x0000020000000000ULL)
+// combine a manual revision number with the struct size
+#define LIBGAME_LAYOUT_VERSION(type, revision) ((uint32_t)sizeof(type) ^ ((uint32_t)(revision) << 24))
+
+/*
+ * Allocators for avoiding malloc/free in the frame loop.
+ *
+ * An arena is a linear allocator. Allocations are made by bumping an offset and are all freed at once with ResetArena.
+ * The frame arena is reset automatically in EndFrame, so use it for anything that only needs to live for one frame.
+ * The scratch arena is a stack for temporary memory within a function. Everything allocated after BeginScratch
+ * is freed by the matching EndScratch.
+ *
+ * A pool hands out fixed-size blocks that can be freed individually.
+ *
+ * Arena allocations are 16-byte aligned and not zeroed. Running out of arena memory is an assert.
+ */
+
+#define LIBGAME_DEFAULT_FRAME_ARENA_SIZE (8 * 1024 * 1024)
+#define LIBGAME_DEFAULT_SCRATCH_ARENA_SIZE (8 * 1024 * 1024)
+
+typedef struct {
+    uint64_t frameArenaSize;
+    uint64_t scratchArenaSize;
+} MemorySettings;
+
+typedef struct {
+    // internal fields - do not edit manually
+    uint8_t* base;
+    uint64_t capacity;
+    uint64_t used;
+    bool isOwned;
+    // read-only stats
+    const char* name;
+    uint64_t highWaterMark; // max bytes used
+    uint64_t allocationCount; // since creation
+} Arena;
+
+typedef struct {
+    // internal fields - do not edit manually
+    uint8_t* base;
+    uint64_t blockSize;
+    int blockCount;
+    void* freeList;
+    // read-only stats
+    const char* name;
+    int usedCount;
+    int highWaterMark; // max blocks used
+    uint64_t allocationCount; // since creation
+} Pool;
+
+typedef struct {
+    Arena* arena;
+    uint64_t mark;
+    int depth;
+} ScratchArena;
+
+typedef enum {
+    ALLOCATION_ALLOC,
+    ALLOCATION_FREE,
+    ALLOCATION_RESET,
+} AllocationEvent;
+
+// called for every allocator event, for example to track allocations in a profiler
+typedef void (*AllocationHook)(AllocationEvent event, const char* allocatorName, void* memory, uint64_t size);
+
+// configure before the first allocation from the frame or scratch arenas
+LIBGAME_EXPORT void ConfigureMemory(MemorySettings settings);
+LIBGAME_EXPORT void SetAllocationHook(AllocationHook hook);
+
+LIBGAME_EXPORT Arena CreateArena(const char* name, uint64_t capacity);
+LIBGAME_EXPORT Arena CreateArenaFromMemory(const char* name, void* memory, uint64_t capacity); // for example in persistent memory
+LIBGAME_EXPORT void DestroyArena(Arena* arena);
+LIBGAME_EXPORT void* ArenaAlloc(Arena* arena, uint64_t size);
+LIBGAME_EXPORT void* ArenaAllocAligned(Arena* arena, uint64_t size, uint64_t alignment);
+LIBGAME_EXPORT void ResetArena(Arena* arena);
+
+LIBGAME_EXPORT void* FrameAlloc(uint64_t size); // freed at EndFrame
+LIBGAME_EXPORT Arena* GetFrameArena();
+
+LIBGAME_EXPORT ScratchArena BeginScratch();
+LIBGAME_EXPORT void EndScratch(ScratchArena scratch); // must be called in reverse order of BeginScratch
+
+LIBGAME_EXPORT Pool CreatePool(const char* name, uint64_t blockSize, int blockCount);
+LIBGAME_EXPORT void DestroyPool(Pool* pool);
+LIBGAME_EXPORT void* PoolAlloc(Pool* pool); // returns NULL if all blocks are used
+LIBGAME_EXPORT void PoolFree(Pool* pool, void* block);
+
 // -- Math utilities --
 
 /*
@@ -293,6 +1106,65 @@ LIBGAME_EXPORT Vec2 Vec2RotateAboutOrigin(Vec2 vec, Vec2 origin, float angle);
 
 LIBGAME_EXPORT Vec3 Vec3RotateAboutAxis(Vec3 vec, Vec3 axis, float angle);
 
+// -- Spatial queries --
+
+/*
+ * Spatial indexes find the objects in view or near a point without testing every object.
+ * Objects are axis aligned boxes with integer ids. A query writes up to maxIds matching ids
+ * and returns the number of matches, which is larger than maxIds when the array was too small.
+ *
+ * The loose grid is for dynamic objects: inserting, moving and removing an object are O(1).
+ * Pick a cell size around the size of the typical query. Objects much larger than the cells
+ * make every query visit more cells.
+ *
+ * The BVH is for static geometry. It is built once from an array of boxes, whose indices are
+ * the ids, and refitted when the boxes move a little.
+ *
+ * Frustum queries are conservative: boxes just outside a corner of the frustum can be reported.
+ */
+
+typedef struct {
+    Vec3 min;
+    Vec3 max;
+} Aabb;
+
+typedef struct {
+    // xyz is the normal pointing inside, a point p is inside a plane when dot(xyz, p) + w >= 0
+    Vec4 planes[6];
+    Aabb bounds; // around the corners
+} Frustum;
+
+// uses the client area for the aspect ratio when the camera has none
+LIBGAME_EXPORT Frustum GetCameraFrustum(const Camera3D* camera);
+
+typedef struct SpatialGrid SpatialGrid;
+
+// ids go from 0 to maxObjects - 1, returns NULL on failure
+LIBGAME_EXPORT SpatialGrid* CreateSpatialGrid(float cellSize, int maxObjects);
+LIBGAME_EXPORT void FreeSpatialGrid(SpatialGrid* grid);
+LIBGAME_EXPORT void InsertGridObject(SpatialGrid* grid, int id, Aabb bounds);
+LIBGAME_EXPORT void UpdateGridObject(SpatialGrid* grid, int id, Aabb bounds);
+LIBGAME_EXPORT void RemoveGridObject(SpatialGrid* grid, int id);
+LIBGAME_EXPORT int QueryGridAabb(SpatialGrid* grid, Aabb box, int* ids, int maxIds);
+LIBGAME_EXPORT int QueryGridSphere(SpatialGrid* grid, Vec3 center, float radius, int* ids, int maxIds);
+LIBGAME_EXPORT int QueryGridFrustum(SpatialGrid* grid, const Frustum* frustum, int* ids, int maxIds);
+// the objects whose box the ray hits within maxDistance, in no particular order
+LIBGAME_EXPORT int QueryGridRay(SpatialGrid* grid, Vec3 origin, Vec3 direction, float maxDistance, int* ids, int maxIds);
+
+typedef struct SpatialBvh SpatialBvh;
+
+// returns NULL on failure
+LIBGAME_EXPORT SpatialBvh* BuildSpatialBvh(const Aabb* boxes, int count);
+LIBGAME_EXPORT void FreeSpatialBvh(SpatialBvh* bvh);
+// takes the same number of boxes as the build and keeps the tree, rebuild when the boxes moved far
+LIBGAME_EXPORT void RefitSpatialBvh(SpatialBvh* bvh, const Aabb* boxes);
+LIBGAME_EXPORT int QueryBvhAabb(const SpatialBvh* bvh, Aabb box, int* ids, int maxIds);
+LIBGAME_EXPORT int QueryBvhSphere(const SpatialBvh* bvh, Vec3 center, float radius, int* ids, int maxIds);
+LIBGAME_EXPORT int QueryBvhFrustum(const SpatialBvh* bvh, const Frustum* frustum, int* ids, int maxIds);
+LIBGAME_EXPORT int QueryBvhRay(const SpatialBvh* bvh, Vec3 origin, Vec3 direction, float maxDistance, int* ids, int maxIds);
+// the nearest box that the ray hits within maxDistance, or -1. The distance is set on a hit.
+LIBGAME_EXPORT int RaycastBvh(const SpatialBvh* bvh, Vec3 origin, Vec3 direction, float maxDistance, float* distance);
+
 // -- Platform initialization --
 
 LIBGAME_EXPORT void InitPlatform();
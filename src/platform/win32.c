@@ -17,7 +17,9 @@
 #include <windows.h>
 
 #include <timeapi.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define LIBGAME_WITH_OPENGL_330
 #include "opengl_render.h"
@@ -39,6 +41,10 @@ static void InitPlatformWindowWin32();
 static void InitInputWin32();
 static void InitRenderGlWin32();
 static void InitTimingWin32();
+static void InitThreadingWin32();
+static void InitMemoryWin32();
+static void InitFilesWin32();
+static void InitFontsWin32();
 static void InitLibraryLoaderWin32();
 
 // Public API - Called in WinMain to set up win32 for usage. See libgame.h.
@@ -51,12 +57,16 @@ void InitPlatform() {
     InitInputWin32();
     InitRenderGlWin32();
     InitTimingWin32();
+    InitThreadingWin32();
+    InitMemoryWin32();
+    InitFilesWin32();
+    InitFontsWin32();
     InitLibraryLoaderWin32();
 }
 
 // -- Window --
 
-static void InitWindowWin32(const char* windowTitle);
+static void InitWindowWin32(const char* windowTitle, WindowSettings settings);
 
 static void InitPlatformWindowWin32() {
     PlatformWindow platformWindow = {};
@@ -68,7 +78,7 @@ LRESULT CALLBACK WindProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 HGLRC InitOpenGl(HDC windowHdc);
 wchar_t* ConvertToWide(const char* input);
 
-static void InitWindowWin32(const char* windowTitle) {
+static void InitWindowWin32(const char* windowTitle, WindowSettings settings) {
     const wchar_t className[] = L"WindowClassName";
     WNDCLASS wc = {};
     wc.lpfnWndProc = WindProc;
@@ -76,12 +86,22 @@ static void InitWindowWin32(const char* windowTitle) {
     wc.lpszClassName = className;
     RegisterClass(&wc);
 
+    // the settings have the client area size, while CreateWindowEx takes the outer size
+    int width = CW_USEDEFAULT;
+    int height = CW_USEDEFAULT;
+    if (settings.width > 0 && settings.height > 0) {
+        RECT rect = { 0, 0, settings.width, settings.height };
+        AdjustWindowRect(&rect, WS_OVERLAPPEDWINDOW, FALSE);
+        width = rect.right - rect.left;
+        height = rect.bottom - rect.top;
+    }
+
     windowHwnd = CreateWindowEx(
             0,
             className,
             ConvertToWide(windowTitle),
             WS_OVERLAPPEDWINDOW,
-            CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
+            CW_USEDEFAULT, CW_USEDEFAULT, width, height,
             NULL,
             NULL,
             windowHInstance,
@@ -90,7 +110,15 @@ static void InitWindowWin32(const char* windowTitle) {
     windowHdc = GetDC(windowHwnd);
     HGLRC hglrc = InitOpenGl(windowHdc);
 
-    ShowWindow(windowHwnd, windowNCmdShow);
+    if (settings.isHidden) {
+        // a window that is never shown doesn't get WM_SIZE, so set the resolution directly
+        RECT clientRect = {};
+        GetClientRect(windowHwnd, &clientRect);
+        SetResolution(clientRect.right, clientRect.bottom);
+        SetResolutionGl(clientRect.right, clientRect.bottom);
+    } else {
+        ShowWindow(windowHwnd, windowNCmdShow);
+    }
 }
 
 wchar_t* ConvertToWide(const char* input) {
@@ -161,8 +189,14 @@ static LRESULT CALLBACK WindProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPa
 
 typedef struct {
     PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
+    // optional, NULL if unsupported
+    PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
+    PFNWGLGETSWAPINTERVALEXTPROC wglGetSwapIntervalEXT;
+    PFNWGLGETEXTENSIONSSTRINGEXTPROC wglGetExtensionsStringEXT;
 } WglExt;
 WglExt wglExt = {};
+// queried once the context is created, to restore it for SWAP_INTERVAL_DEFAULT
+static int driverSwapInterval = 1;
 
 #define LOAD_OPENGL_EXTENSION_INTO(name, type, target) \
     do { \
@@ -171,7 +205,18 @@ WglExt wglExt = {};
     } while(false)
 
 #define LOAD_OPENGL_EXTENSION(name, type) LOAD_OPENGL_EXTENSION_INTO(name, type, openGlExt->name)
+
+// some drivers return small non-NULL values for unsupported functions
+#define LOAD_OPTIONAL_OPENGL_EXTENSION_INTO(name, type, target) \
+    do { \
+        PROC proc = wglGetProcAddress(#name); \
+        intptr_t procValue = (intptr_t)proc; \
+        target = (procValue == 0 || procValue == 1 || procValue == 2 || procValue == 3 || procValue == -1) ? NULL : (type)proc; \
+    } while(false)
+
+#define LOAD_OPTIONAL_OPENGL_EXTENSION(name, type) LOAD_OPTIONAL_OPENGL_EXTENSION_INTO(name, type, openGlExt->name)
 #define LOAD_WGL_EXTENSION(name, type) LOAD_OPENGL_EXTENSION_INTO(name, type, wglExt.name)
+#define LOAD_OPTIONAL_WGL_EXTENSION(name, type) LOAD_OPTIONAL_OPENGL_EXTENSION_INTO(name, type, wglExt.name)
 
 static void LoadOpenGlExtensions(OpenGlExt* openGlExt) {
     LOAD_OPENGL_EXTENSION(glBindBuffer, PFNGLBINDBUFFERPROC);
@@ -180,6 +225,7 @@ static void LoadOpenGlExtensions(OpenGlExt* openGlExt) {
     LOAD_OPENGL_EXTENSION(glAttachShader, PFNGLATTACHSHADERPROC);
     LOAD_OPENGL_EXTENSION(glCompileShader, PFNGLCOMPILESHADERPROC);
     LOAD_OPENGL_EXTENSION(glCreateProgram, PFNGLCREATEPROGRAMPROC);
+    LOAD_OPENGL_EXTENSION(glDeleteProgram, PFNGLDELETEPROGRAMPROC);
     LOAD_OPENGL_EXTENSION(glCreateShader, PFNGLCREATESHADERPROC);
     LOAD_OPENGL_EXTENSION(glDeleteShader, PFNGLDELETESHADERPROC);
     LOAD_OPENGL_EXTENSION(glEnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC);
@@ -196,12 +242,52 @@ static void LoadOpenGlExtensions(OpenGlExt* openGlExt) {
     LOAD_OPENGL_EXTENSION(glBufferSubData, PFNGLBUFFERSUBDATAPROC);
     LOAD_OPENGL_EXTENSION(glGetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC);
     LOAD_OPENGL_EXTENSION(glUniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC);
+    LOAD_OPENGL_EXTENSION(glUniform1i, PFNGLUNIFORM1IPROC);
+    LOAD_OPENGL_EXTENSION(glGetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC);
+    LOAD_OPENGL_EXTENSION(glUniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC);
+    LOAD_OPENGL_EXTENSION(glBindBufferBase, PFNGLBINDBUFFERBASEPROC);
+    LOAD_OPENGL_EXTENSION(glBindBufferRange, PFNGLBINDBUFFERRANGEPROC);
+    LOAD_OPENGL_EXTENSION(glFenceSync, PFNGLFENCESYNCPROC);
+    LOAD_OPENGL_EXTENSION(glClientWaitSync, PFNGLCLIENTWAITSYNCPROC);
+    LOAD_OPENGL_EXTENSION(glDeleteSync, PFNGLDELETESYNCPROC);
+    LOAD_OPENGL_EXTENSION(glGenFramebuffers, PFNGLGENFRAMEBUFFERSPROC);
+    LOAD_OPENGL_EXTENSION(glBindFramebuffer, PFNGLBINDFRAMEBUFFERPROC);
+    LOAD_OPENGL_EXTENSION(glFramebufferTexture2D, PFNGLFRAMEBUFFERTEXTURE2DPROC);
+    LOAD_OPENGL_EXTENSION(glCheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC);
+    LOAD_OPENGL_EXTENSION(glBlitFramebuffer, PFNGLBLITFRAMEBUFFERPROC);
+    LOAD_OPENGL_EXTENSION(glGenRenderbuffers, PFNGLGENRENDERBUFFERSPROC);
+    LOAD_OPENGL_EXTENSION(glBindRenderbuffer, PFNGLBINDRENDERBUFFERPROC);
+    LOAD_OPENGL_EXTENSION(glRenderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC);
+    LOAD_OPENGL_EXTENSION(glFramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC);
+    LOAD_OPENGL_EXTENSION(glGenQueries, PFNGLGENQUERIESPROC);
+    LOAD_OPENGL_EXTENSION(glBeginQuery, PFNGLBEGINQUERYPROC);
+    LOAD_OPENGL_EXTENSION(glEndQuery, PFNGLENDQUERYPROC);
+    LOAD_OPENGL_EXTENSION(glGetQueryObjectiv, PFNGLGETQUERYOBJECTIVPROC);
+    LOAD_OPENGL_EXTENSION(glGetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC);
+    LOAD_OPENGL_EXTENSION(glMapBufferRange, PFNGLMAPBUFFERRANGEPROC);
+    LOAD_OPENGL_EXTENSION(glUnmapBuffer, PFNGLUNMAPBUFFERPROC);
+    LOAD_OPENGL_EXTENSION(glDrawBuffers, PFNGLDRAWBUFFERSPROC);
+    LOAD_OPENGL_EXTENSION(glClearBufferfv, PFNGLCLEARBUFFERFVPROC);
+    LOAD_OPENGL_EXTENSION(glBlendFuncSeparate, PFNGLBLENDFUNCSEPARATEPROC);
+    LOAD_OPENGL_EXTENSION(glActiveTexture, PFNGLACTIVETEXTUREPROC);
+    LOAD_OPENGL_EXTENSION(glGetFramebufferAttachmentParameteriv, PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC);
+
+    LOAD_OPTIONAL_OPENGL_EXTENSION(glGetProgramBinary, PFNGLGETPROGRAMBINARYPROC);
+    LOAD_OPTIONAL_OPENGL_EXTENSION(glProgramBinary, PFNGLPROGRAMBINARYPROC);
+    LOAD_OPTIONAL_OPENGL_EXTENSION(glProgramParameteri, PFNGLPROGRAMPARAMETERIPROC);
 }
 
 static void LoadWglExtensions() {
     LOAD_WGL_EXTENSION(wglCreateContextAttribsARB, PFNWGLCREATECONTEXTATTRIBSARBPROC);
 }
 
+// loaded with the actual context
+static void LoadOptionalWglExtensions() {
+    LOAD_OPTIONAL_WGL_EXTENSION(wglSwapIntervalEXT, PFNWGLSWAPINTERVALEXTPROC);
+    LOAD_OPTIONAL_WGL_EXTENSION(wglGetSwapIntervalEXT, PFNWGLGETSWAPINTERVALEXTPROC);
+    LOAD_OPTIONAL_WGL_EXTENSION(wglGetExtensionsStringEXT, PFNWGLGETEXTENSIONSSTRINGEXTPROC);
+}
+
 static HGLRC InitOpenGl(HDC windowHdc) {
     PIXELFORMATDESCRIPTOR pfd = {};
     pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
@@ -235,6 +321,11 @@ static HGLRC InitOpenGl(HDC windowHdc) {
     wglMakeCurrent(windowHdc, actualContext);
     wglDeleteContext(dummyContext);
 
+    LoadOptionalWglExtensions();
+    if (wglExt.wglGetSwapIntervalEXT != NULL) {
+        driverSwapInterval = wglExt.wglGetSwapIntervalEXT();
+    }
+
     // -- Load the OpenGL 3.3 extensions --
 
     OpenGlExt openGlExt = {};
@@ -337,7 +428,9 @@ static InputKey MapKeyCode(WPARAM wParam, LPARAM lParam) {
         case 0x08: return KeyBackspace;
         case 0x09: return KeyTab;
         case 0x1B: return KeyEsc;
-        default: return KeyUnknown;
+        default:
+            LogDebugIn(LOG_CATEGORY_INPUT, "Unmapped virtual key code 0x%.2x\n", vk);
+            return KeyUnknown;
     }
 }
 
@@ -392,6 +485,56 @@ static void InitInputWin32() {
 static void EndFrameGlWin32() {
     EndFrameGl();
     SwapBuffers(windowHdc);
+    EndPresentGl();
+}
+
+static bool HasWglExtension(const char* name) {
+    if (wglExt.wglGetExtensionsStringEXT == NULL) {
+        return false;
+    }
+    // the names are separated by spaces, so match whole names only
+    const char* extensions = wglExt.wglGetExtensionsStringEXT();
+    size_t length = strlen(name);
+    for (const char* s = strstr(extensions, name); s != NULL; s = strstr(s + length, name)) {
+        bool isStart = s == extensions || s[-1] == ' ';
+        bool isEnd = s[length] == ' ' || s[length] == '\0';
+        if (isStart && isEnd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// see WGL_EXT_swap_control and WGL_EXT_swap_control_tear, where a negative interval is adaptive
+static bool SetSwapIntervalWin32(SwapInterval interval) {
+    if (wglExt.wglSwapIntervalEXT == NULL) {
+        // without the extension the interval is never changed, so it is still the default
+        if (interval == SWAP_INTERVAL_DEFAULT) {
+            return true;
+        }
+        LogWarningIn(LOG_CATEGORY_RENDER, "Unable to set the swap interval. WGL_EXT_swap_control is not supported.\n");
+        return false;
+    }
+
+    bool isSupported = true;
+    int swapInterval = interval == SWAP_INTERVAL_IMMEDIATE ? 0 : 1;
+    if (interval == SWAP_INTERVAL_DEFAULT) {
+        swapInterval = driverSwapInterval;
+    }
+    if (interval == SWAP_INTERVAL_ADAPTIVE) {
+        isSupported = HasWglExtension("WGL_EXT_swap_control_tear");
+        swapInterval = isSupported ? -1 : 1;
+        if (!isSupported) {
+            LogWarningIn(LOG_CATEGORY_RENDER, "Adaptive vsync is not supported. Using vsync instead.\n");
+        }
+    }
+
+    if (!wglExt.wglSwapIntervalEXT(swapInterval)) {
+        LogWarningIn(LOG_CATEGORY_RENDER, "Failed to set the swap interval to %d. Error = %d\n", swapInterval, GetLastError());
+        return false;
+    }
+    LogDebugIn(LOG_CATEGORY_RENDER, "Swap interval set to %d\n", swapInterval);
+    return isSupported;
 }
 
 static void InitRenderGlWin32() {
@@ -406,7 +549,34 @@ static void InitRenderGlWin32() {
     render.EndFrame = EndFrameGlWin32;
     render.SetCamera2D = SetCamera2DGl;
     render.SetCamera3D = SetCamera3DGl;
+    render.UseCameraSlot = UseCameraSlotGl;
     render.SetTransparencyMode = SetTransparencyModeGl;
+    render.SetTransparencyMethod = SetTransparencyMethodGl;
+    render.SetDepthPrepassMode = SetDepthPrepassModeGl;
+    render.CreateShader = CreateShaderGl;
+    render.CreateMaterial = CreateMaterialGl;
+    render.SetMaterialParams = SetMaterialParamsGl;
+    render.UseMaterial = UseMaterialGl;
+    render.CreateTexture = CreateTextureGl;
+    render.UpdateTexture = UpdateTextureGl;
+    render.DrawTexturedQuad3D = DrawTexturedQuad3DGl;
+    render.DrawVertices = DrawVerticesGl;
+    render.ReserveGeometry = ReserveGeometryGl;
+    render.GetStats = GetRenderStatsGl;
+    render.DrawDebugLines = DrawDebugLinesGl;
+    render.SetSwapInterval = SetSwapIntervalWin32;
+    render.SetMaxFramesInFlight = SetMaxFramesInFlightGl;
+    render.GetPresentInfo = GetPresentInfoGl;
+    render.CreateRenderTarget = CreateRenderTargetGl;
+    render.ResizeRenderTarget = ResizeRenderTargetGl;
+    render.UseRenderTarget = UseRenderTargetGl;
+    render.BlitRenderTarget = BlitRenderTargetGl;
+    render.BeginGpuTimer = BeginGpuTimerGl;
+    render.EndGpuTimer = EndGpuTimerGl;
+    render.ReadGpuTimer = ReadGpuTimerGl;
+    render.RequestReadback = RequestReadbackGl;
+    render.MapReadback = MapReadbackGl;
+    render.UnmapReadback = UnmapReadbackGl;
     InitPlatformRender(render);
 }
 
@@ -467,6 +637,298 @@ static void InitTimingWin32() {
     InitPlatformTiming(platformTiming);
 }
 
+// -- Threading --
+
+typedef struct {
+    ThreadFn fn;
+    void* arg;
+} ThreadStartWin32;
+
+static DWORD WINAPI RunThreadWin32(LPVOID param) {
+    ThreadStartWin32 start = *(ThreadStartWin32*)param;
+    free(param);
+
+    start.fn(start.arg);
+    return 0;
+}
+
+static void* StartThreadWin32(ThreadFn fn, void* arg) {
+    ThreadStartWin32* start = (ThreadStartWin32*)malloc(sizeof(ThreadStartWin32));
+    Assert(start != NULL, "Failed to allocate thread start parameters");
+    start->fn = fn;
+    start->arg = arg;
+
+    HANDLE thread = CreateThread(NULL, 0, RunThreadWin32, start, 0, NULL);
+    Assert(thread != NULL, "Failed to create thread. Error = %d", GetLastError());
+
+    return thread;
+}
+
+static void JoinThreadWin32(void* thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+static bool HasThreadExitedWin32(void* thread) {
+    return WaitForSingleObject(thread, 0) == WAIT_OBJECT_0;
+}
+
+static void* CreateSignalWin32() {
+    HANDLE event = CreateEventA(NULL, false, false, NULL);
+    Assert(event != NULL, "Failed to create event. Error = %d", GetLastError());
+    return event;
+}
+
+static void SetSignalWin32(void* signal) {
+    SetEvent(signal);
+}
+
+static bool WaitSignalWin32(void* signal, int timeoutMs) {
+    DWORD timeout = timeoutMs < 0 ? INFINITE : timeoutMs;
+    return WaitForSingleObject(signal, timeout) == WAIT_OBJECT_0;
+}
+
+static void SleepThreadWin32(int ms) {
+    Sleep(ms);
+}
+
+static void* CreateLockWin32() {
+    SRWLOCK* lock = (SRWLOCK*)malloc(sizeof(SRWLOCK));
+    Assert(lock != NULL, "Failed to allocate lock");
+    InitializeSRWLock(lock);
+    return lock;
+}
+
+static void AcquireLockWin32(void* lock) {
+    AcquireSRWLockExclusive((SRWLOCK*)lock);
+}
+
+static void ReleaseLockWin32(void* lock) {
+    ReleaseSRWLockExclusive((SRWLOCK*)lock);
+}
+
+static int GetProcessorCountWin32() {
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+static void InitThreadingWin32() {
+    PlatformThreading threading = {};
+    threading.StartThread = StartThreadWin32;
+    threading.JoinThread = JoinThreadWin32;
+    threading.HasThreadExited = HasThreadExitedWin32;
+    threading.CreateSignal = CreateSignalWin32;
+    threading.SetSignal = SetSignalWin32;
+    threading.WaitSignal = WaitSignalWin32;
+    threading.SleepThread = SleepThreadWin32;
+    threading.CreateLock = CreateLockWin32;
+    threading.AcquireLock = AcquireLockWin32;
+    threading.ReleaseLock = ReleaseLockWin32;
+    threading.GetProcessorCount = GetProcessorCountWin32;
+    InitPlatformThreading(threading);
+}
+
+// -- Files --
+
+static void* MapFileWin32(const char* path, uint64_t* size, void** mapping) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    // empty files can't be mapped
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // the mapping keeps the file open
+    HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (fileMapping == NULL) {
+        return NULL;
+    }
+
+    void* data = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(fileMapping);
+        return NULL;
+    }
+
+    *size = fileSize.QuadPart;
+    *mapping = fileMapping;
+    return data;
+}
+
+static void UnmapFileWin32(void* data, void* mapping) {
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+}
+
+static void InitFilesWin32() {
+    PlatformFiles files = {};
+    files.MapFile = MapFileWin32;
+    files.UnmapFile = UnmapFileWin32;
+    InitPlatformFiles(files);
+}
+
+// -- Fonts --
+
+typedef struct {
+    HDC hdc;
+    HFONT font;
+} FontWin32;
+
+static void* LoadFontWin32(const char* faceName, int pixelHeight) {
+    HDC hdc = CreateCompatibleDC(NULL);
+    if (hdc == NULL) {
+        return NULL;
+    }
+
+    // a negative height selects by character height rather than cell height
+    HFONT font = CreateFontA(-pixelHeight, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+            OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH, faceName);
+    if (font == NULL) {
+        DeleteDC(hdc);
+        return NULL;
+    }
+    SelectObject(hdc, font);
+
+    FontWin32* result = (FontWin32*)malloc(sizeof(FontWin32));
+    Assert(result != NULL, "Failed to allocate font");
+    result->hdc = hdc;
+    result->font = font;
+    return result;
+}
+
+static void FreeFontWin32(void* font) {
+    FontWin32* fontWin32 = (FontWin32*)font;
+    DeleteDC(fontWin32->hdc);
+    DeleteObject(fontWin32->font);
+    free(fontWin32);
+}
+
+static void GetFontMetricsWin32(void* font, int* ascent, int* descent, int* lineGap) {
+    TEXTMETRICW metrics = {};
+    GetTextMetricsW(((FontWin32*)font)->hdc, &metrics);
+    *ascent = metrics.tmAscent;
+    *descent = metrics.tmDescent;
+    *lineGap = metrics.tmExternalLeading;
+}
+
+static bool RasterizeGlyphWin32(void* font, int codepoint, GlyphBitmap* glyph) {
+    // GDI glyph functions take UTF-16 code units
+    if (codepoint > 0xffff) {
+        return false;
+    }
+
+    HDC hdc = ((FontWin32*)font)->hdc;
+    GLYPHMETRICS metrics = {};
+    MAT2 identity = { {0, 1}, {0, 0}, {0, 0}, {0, 1} };
+
+    WORD glyphIndex = 0;
+    WCHAR character = (WCHAR)codepoint;
+    if (GetGlyphIndicesW(hdc, &character, 1, &glyphIndex, GGI_MARK_NONEXISTING_GLYPHS) == GDI_ERROR || glyphIndex == 0xffff) {
+        return false;
+    }
+
+    DWORD size = GetGlyphOutlineW(hdc, codepoint, GGO_GRAY8_BITMAP, &metrics, 0, NULL, &identity);
+    if (size == GDI_ERROR) {
+        return false;
+    }
+
+    glyph->advance = metrics.gmCellIncX;
+    glyph->xOffset = metrics.gmptGlyphOrigin.x;
+    glyph->yOffset = metrics.gmptGlyphOrigin.y;
+    glyph->coverage = NULL;
+
+    // glyphs without pixels, like space
+    if (size == 0) {
+        glyph->width = 0;
+        glyph->height = 0;
+        return true;
+    }
+
+    glyph->width = metrics.gmBlackBoxX;
+    glyph->height = metrics.gmBlackBoxY;
+
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    Assert(buffer != NULL, "Failed to allocate glyph bitmap");
+    GetGlyphOutlineW(hdc, codepoint, GGO_GRAY8_BITMAP, &metrics, size, buffer, &identity);
+
+    // rows are DWORD aligned and the levels go from 0 to 64
+    int pitch = (glyph->width + 3) & ~3;
+    glyph->coverage = (uint8_t*)malloc(glyph->width * glyph->height);
+    Assert(glyph->coverage != NULL, "Failed to allocate glyph bitmap");
+    for (int y = 0; y < glyph->height; y++) {
+        for (int x = 0; x < glyph->width; x++) {
+            int level = buffer[y * pitch + x];
+            glyph->coverage[y * glyph->width + x] = (uint8_t)(level >= 64 ? 255 : level * 4);
+        }
+    }
+    free(buffer);
+
+    return true;
+}
+
+static int GetKerningPairsWin32(void* font, KerningPair* pairs, int maxPairs) {
+    HDC hdc = ((FontWin32*)font)->hdc;
+    int count = GetKerningPairsW(hdc, 0, NULL);
+    if (pairs == NULL || count == 0) {
+        return count;
+    }
+
+    KERNINGPAIR* kerningPairs = (KERNINGPAIR*)malloc(count * sizeof(KERNINGPAIR));
+    Assert(kerningPairs != NULL, "Failed to allocate kerning pairs");
+    count = GetKerningPairsW(hdc, count, kerningPairs);
+    count = count < maxPairs ? count : maxPairs;
+
+    for (int i = 0; i < count; i++) {
+        pairs[i].first = kerningPairs[i].wFirst;
+        pairs[i].second = kerningPairs[i].wSecond;
+        pairs[i].amount = kerningPairs[i].iKernAmount;
+    }
+    free(kerningPairs);
+
+    return count;
+}
+
+static void InitFontsWin32() {
+    PlatformFonts fonts = {};
+    fonts.LoadFont = LoadFontWin32;
+    fonts.FreeFont = FreeFontWin32;
+    fonts.GetFontMetrics = GetFontMetricsWin32;
+    fonts.RasterizeGlyph = RasterizeGlyphWin32;
+    fonts.GetKerningPairs = GetKerningPairsWin32;
+    InitPlatformFonts(fonts);
+}
+
+// -- Memory --
+
+static void* AllocatePagesWin32(void* baseAddress, uint64_t size) {
+    void* memory = VirtualAlloc(baseAddress, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    // the base address is only a hint
+    if (memory == NULL && baseAddress != NULL) {
+        memory = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    return memory;
+}
+
+static void FreePagesWin32(void* memory, uint64_t size) {
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+static void InitMemoryWin32() {
+    PlatformMemory memory = {};
+    memory.AllocatePages = AllocatePagesWin32;
+    memory.FreePages = FreePagesWin32;
+    InitPlatformMemory(memory);
+}
+
 // -- Dynamic loading --
 
 static void ResolvePathWin32(char* name, FileExtensionType extension, char* out, int outSize);
@@ -546,6 +1008,111 @@ static bool IsFileLocked(char* path) {
     }
 }
 
+/*
+ * Change notifications for the directory of a library.
+ *
+ * ReadDirectoryChangesW is issued as overlapped I/O. Polling only checks
+ * whether the I/O has completed, which is a memory read without a system call.
+ * The file itself is only inspected once a change to it has been reported.
+ */
+typedef struct {
+    HANDLE directory;
+    OVERLAPPED overlapped;
+    DWORD notifications[1024]; // FILE_NOTIFY_INFORMATION records must be DWORD aligned
+    wchar_t fileName[MAX_PATH];
+    bool isChangePending;
+    int64_t changeTicks;
+} LibraryWatcherWin32;
+
+static bool WatchDirectoryWin32(LibraryWatcherWin32* watcher) {
+    memset(&watcher->overlapped, 0, sizeof(OVERLAPPED));
+
+    return ReadDirectoryChangesW(
+        watcher->directory,
+        watcher->notifications,
+        sizeof(watcher->notifications),
+        false,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+        NULL,
+        &watcher->overlapped,
+        NULL
+    );
+}
+
+static LibraryWatcherWin32* CreateLibraryWatcherWin32(char* path) {
+    char directoryPath[MAX_PATH];
+    strncpy(directoryPath, path, MAX_PATH - 1);
+    directoryPath[MAX_PATH - 1] = '\0';
+
+    char* lastSlash = strrchr(directoryPath, '\\');
+    if (lastSlash == NULL) {
+        return NULL;
+    }
+    *lastSlash = '\0';
+    char* fileName = path + (lastSlash - directoryPath) + 1;
+
+    HANDLE directory = CreateFileA(
+        directoryPath,
+        FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        NULL
+    );
+    if (directory == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LibraryWatcherWin32* watcher = (LibraryWatcherWin32*)calloc(1, sizeof(LibraryWatcherWin32));
+    Assert(watcher != NULL, "Failed to allocate library watcher");
+    watcher->directory = directory;
+    MultiByteToWideChar(CP_ACP, 0, fileName, -1, watcher->fileName, MAX_PATH);
+
+    if (!WatchDirectoryWin32(watcher)) {
+        CloseHandle(directory);
+        free(watcher);
+        return NULL;
+    }
+
+    return watcher;
+}
+
+static bool DidLibraryChangeWin32(LibraryWatcherWin32* watcher) {
+    if (!HasOverlappedIoCompleted(&watcher->overlapped)) {
+        return false;
+    }
+
+    DWORD bytes = 0;
+    bool didRead = GetOverlappedResult(watcher->directory, &watcher->overlapped, &bytes, false);
+
+    // assume a change if the notification buffer overflowed
+    bool didChange = !didRead || bytes == 0;
+
+    size_t offset = 0;
+    while (!didChange && offset < bytes) {
+        FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*)((char*)watcher->notifications + offset);
+        int length = info->FileNameLength / sizeof(wchar_t);
+        didChange = (int)wcslen(watcher->fileName) == length
+            && _wcsnicmp(info->FileName, watcher->fileName, length) == 0;
+
+        if (info->NextEntryOffset == 0) {
+            break;
+        }
+        offset += info->NextEntryOffset;
+    }
+
+    bool didWatch = WatchDirectoryWin32(watcher);
+    Assert(didWatch, "Unable to keep watching library directory. Error = %d", GetLastError());
+
+    return didChange;
+}
+
+static void MakeVersionedTempPath(char* path, int version, char* out, int outSize) {
+    int len = strlen(path);
+    snprintf(out, outSize, "%.*s_temp_%d.dll", len - 4, path, version);
+}
+
 /*
  * Loads or reloads a library if it has changed.
  *
@@ -553,32 +1120,53 @@ static bool IsFileLocked(char* path) {
  * the DLL is copied to a temp file and that temp file
  * is the DLL actually being loaded.
  *
+ * Each version gets its own temp file, so the new version can be loaded
+ * while the old one is still mapped. The old version is freed after the swap.
+ * The copy only happens when a change has been detected, and the time from
+ * detection to a finished reload is reported in DynamicLibrary.reloadTicks.
+ *
  * Reloading is mainly for debug builds and quick iteration,
  * but for now the copy step is always enabled.
  */
 static bool LoadDynamicLibraryWin32(char* path, DynamicLibrary* lib) {
-    char tempName[MAX_PATH];
-
     bool isFirstLoad = lib->lastWrite == 0;
+    LibraryWatcherWin32* watcher = (LibraryWatcherWin32*)lib->watcher;
+
+    if (isFirstLoad && watcher == NULL) {
+        watcher = CreateLibraryWatcherWin32(path);
+        lib->watcher = watcher;
+        if (watcher == NULL) {
+            LogWarningIn(LOG_CATEGORY_LOADER, "Unable to watch %s for changes. Falling back to polling.\n", path);
+        }
+    }
+
+    if (watcher != NULL && !isFirstLoad) {
+        if (!watcher->isChangePending) {
+            if (!DidLibraryChangeWin32(watcher)) {
+                return false;
+            }
+            watcher->isChangePending = true;
+            watcher->changeTicks = GetMicroTicksWin32();
+        }
+    }
 
     uint64_t lastWrite = LastFileWrite(path);
     if (lastWrite == 0 || lib->lastWrite == lastWrite) {
+        if (watcher != NULL && lastWrite != 0) {
+            watcher->isChangePending = false; // the change was not a new build
+        }
         return false;
     }
 
+    // the build may still be writing to the file
     if (IsFileLocked(path)) {
         return false;
     }
 
-    if (!isFirstLoad) {
-        bool didFree = FreeLibrary(lib->handle);
-        Assert(didFree, "Unable to free DLL when reloading");
-    }
+    int64_t startTicks = watcher != NULL && watcher->isChangePending ? watcher->changeTicks : GetMicroTicksWin32();
 
-    int len = strlen(path);
-    strncpy(tempName, path, len - 4);
-    tempName[len - 4] = '\0';
-    strcat(tempName, "_temp.dll");
+    char tempName[MAX_PATH];
+    MakeVersionedTempPath(path, lib->version + 1, tempName, MAX_PATH);
 
     bool didCopy = CopyFileA(path, tempName, false);
     if (!didCopy) {
@@ -589,8 +1177,29 @@ static bool LoadDynamicLibraryWin32(char* path, DynamicLibrary* lib) {
     HMODULE handle = LoadLibraryA(tempName);
     Assert(handle != NULL, "Unable to load DLL %s", tempName);
 
+    if (!isFirstLoad) {
+        bool didFree = FreeLibrary(lib->handle);
+        Assert(didFree, "Unable to free DLL when reloading");
+        // the temp copy of the previous version, with or without a watcher
+        char loadedName[MAX_PATH];
+        MakeVersionedTempPath(path, lib->version, loadedName, MAX_PATH);
+        DeleteFileA(loadedName);
+    }
+
     lib->handle = handle;
     lib->lastWrite = lastWrite;
+    lib->version++;
+    lib->reloadTicks = GetMicroTicksWin32() - startTicks;
+
+    if (watcher != NULL) {
+        watcher->isChangePending = false;
+    }
+
+    if (isFirstLoad) {
+        LogDebugIn(LOG_CATEGORY_LOADER, "Loaded library %s\n", path);
+    } else {
+        LogInfoIn(LOG_CATEGORY_LOADER, "Reloaded library %s (version %d) in %.2f ms\n", path, lib->version, lib->reloadTicks / 1000.0f);
+    }
 
     return true;
 }
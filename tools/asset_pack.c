@@ -0,0 +1,517 @@
+/*
+ * Build an asset pack from source assets.
+ *
+ * Usage: asset_pack output.pack [--lz4] asset...
+ *
+ * where each asset is one of
+ *   texture name image.tga
+ *   mesh name model.obj
+ *   shader name vertex.glsl fragment.glsl
+ *
+ * With --lz4, blobs are LZ4 compressed when that makes them smaller.
+ *
+ * Meshes are read from Wavefront OBJ files (positions, texture coordinates and faces).
+ * Faces are triangulated as fans, vertices are white and shared by faces where
+ * the position and texture coordinate indices are the same. The triangles are then reordered
+ * for the vertex cache, and the vertices in the order the triangles use them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/asset_pack.h"
+#include "common/image_tga.h"
+#include "common/lz4.h"
+#include "common/mesh_optimize.h"
+
+#define MAX_ASSETS 4096
+
+typedef struct {
+    AssetPackEntry entry;
+    uint8_t* blob;
+} PackedAsset;
+
+static PackedAsset assets[MAX_ASSETS];
+static int assetCount = 0;
+
+static uint8_t* ReadWholeFile(const char* path, uint64_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // null terminated, for text files
+    uint8_t* data = (uint8_t*)malloc(fileSize + 1);
+    if (data == NULL || fread(data, 1, fileSize, file) != (size_t)fileSize) {
+        fprintf(stderr, "Unable to read %s\n", path);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    data[fileSize] = '\0';
+    fclose(file);
+
+    *size = fileSize;
+    return data;
+}
+
+static PackedAsset* AddAsset(const char* name, AssetPackType type, uint8_t* blob, uint64_t size) {
+    if (assetCount == MAX_ASSETS) {
+        fprintf(stderr, "Too many assets. Max is %d.\n", MAX_ASSETS);
+        exit(1);
+    }
+    if (strlen(name) >= ASSET_PACK_MAX_NAME) {
+        fprintf(stderr, "Asset name %s is too long. Max is %d characters.\n", name, ASSET_PACK_MAX_NAME - 1);
+        exit(1);
+    }
+
+    PackedAsset* asset = &assets[assetCount++];
+    memset(asset, 0, sizeof(PackedAsset));
+    strcpy(asset->entry.name, name);
+    asset->entry.type = type;
+    asset->entry.rawSize = size;
+    asset->entry.size = size;
+    asset->blob = blob;
+    return asset;
+}
+
+// -- Textures --
+
+static bool PackTexture(const char* name, const char* path) {
+    uint64_t size = 0;
+    uint8_t* data = ReadWholeFile(path, &size);
+    if (data == NULL) {
+        return false;
+    }
+
+    int width;
+    int height;
+    if (!ParseTgaHeader(data, size, &width, &height)) {
+        fprintf(stderr, "Unsupported image %s. Expected a 24 or 32-bit TGA of at most %d by %d pixels.\n",
+                path, TGA_MAX_DIMENSION, TGA_MAX_DIMENSION);
+        free(data);
+        return false;
+    }
+
+    uint64_t blobSize = sizeof(AssetPackTextureHeader) + GetTgaPixelsSize(width, height);
+    uint8_t* blob = (uint8_t*)calloc(1, blobSize);
+    if (blob == NULL) {
+        fprintf(stderr, "Unable to allocate the pixels of %s\n", path);
+        free(data);
+        return false;
+    }
+    AssetPackTextureHeader* header = (AssetPackTextureHeader*)blob;
+    header->width = width;
+    header->height = height;
+
+    bool isDecoded = DecodeTgaPixels(data, size, blob + sizeof(AssetPackTextureHeader));
+    free(data);
+    if (!isDecoded) {
+        fprintf(stderr, "Unable to decode %s\n", path);
+        free(blob);
+        return false;
+    }
+
+    AddAsset(name, AssetPackTexture, blob, blobSize);
+    return true;
+}
+
+// -- Shaders --
+
+static bool PackShader(const char* name, const char* vertexPath, const char* fragmentPath) {
+    uint64_t vertexSize = 0;
+    uint64_t fragmentSize = 0;
+    uint8_t* vertexSrc = ReadWholeFile(vertexPath, &vertexSize);
+    uint8_t* fragmentSrc = ReadWholeFile(fragmentPath, &fragmentSize);
+    if (vertexSrc == NULL || fragmentSrc == NULL) {
+        free(vertexSrc);
+        free(fragmentSrc);
+        return false;
+    }
+
+    uint64_t blobSize = sizeof(AssetPackShaderHeader) + vertexSize + 1 + fragmentSize + 1;
+    uint8_t* blob = (uint8_t*)calloc(1, blobSize);
+    AssetPackShaderHeader* header = (AssetPackShaderHeader*)blob;
+    header->vertexLength = vertexSize + 1;
+    header->fragmentLength = fragmentSize + 1;
+    memcpy(blob + sizeof(AssetPackShaderHeader), vertexSrc, vertexSize + 1);
+    memcpy(blob + sizeof(AssetPackShaderHeader) + vertexSize + 1, fragmentSrc, fragmentSize + 1);
+
+    free(vertexSrc);
+    free(fragmentSrc);
+
+    AddAsset(name, AssetPackShader, blob, blobSize);
+    return true;
+}
+
+// -- Meshes --
+
+typedef struct {
+    float* items;
+    int count;
+    int capacity;
+} FloatList;
+
+typedef struct {
+    uint32_t* items;
+    int count;
+    int capacity;
+} IndexList;
+
+static void PushFloat(FloatList* list, float value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+        list->items = (float*)realloc(list->items, list->capacity * sizeof(float));
+    }
+    list->items[list->count++] = value;
+}
+
+static void PushIndex(IndexList* list, uint32_t value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+        list->items = (uint32_t*)realloc(list->items, list->capacity * sizeof(uint32_t));
+    }
+    list->items[list->count++] = value;
+}
+
+// open addressing map from (position index, texture coordinate index) to a vertex index
+typedef struct {
+    int64_t* keys;
+    uint32_t* values;
+    int capacity;
+    int count;
+} VertexMap;
+
+static void PutVertex(VertexMap* map, int64_t key, uint32_t value);
+
+static void GrowVertexMap(VertexMap* map) {
+    VertexMap old = *map;
+    map->capacity = old.capacity == 0 ? 4096 : old.capacity * 2;
+    map->count = 0;
+    map->keys = (int64_t*)malloc(map->capacity * sizeof(int64_t));
+    map->values = (uint32_t*)malloc(map->capacity * sizeof(uint32_t));
+    memset(map->keys, 0xff, map->capacity * sizeof(int64_t));
+
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.keys[i] != -1) {
+            PutVertex(map, old.keys[i], old.values[i]);
+        }
+    }
+    free(old.keys);
+    free(old.values);
+}
+
+static int FindVertexSlot(VertexMap* map, int64_t key) {
+    uint64_t hash = (uint64_t)key * 0x9e3779b97f4a7c15ULL;
+    int slot = (int)(hash >> 32) & (map->capacity - 1);
+    while (map->keys[slot] != -1 && map->keys[slot] != key) {
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return slot;
+}
+
+static void PutVertex(VertexMap* map, int64_t key, uint32_t value) {
+    if ((map->count + 1) * 2 > map->capacity) {
+        GrowVertexMap(map);
+    }
+    int slot = FindVertexSlot(map, key);
+    map->count += map->keys[slot] == -1;
+    map->keys[slot] = key;
+    map->values[slot] = value;
+}
+
+// resolve a 1-based or negative (relative) OBJ index to a 0-based index, -1 if invalid
+static int ResolveObjIndex(int index, int count) {
+    int resolved = index > 0 ? index - 1 : count + index;
+    return resolved >= 0 && resolved < count ? resolved : -1;
+}
+
+static bool OptimizePackedMesh(FloatList* vertices, IndexList* indices) {
+    int vertexCount = vertices->count / ASSET_PACK_FLOATS_PER_VERTEX;
+    int stride = ASSET_PACK_FLOATS_PER_VERTEX * sizeof(float);
+    uint32_t* cacheIndices = (uint32_t*)malloc((indices->count + 1) * sizeof(uint32_t));
+    uint32_t* remap = (uint32_t*)malloc((vertexCount + 1) * sizeof(uint32_t));
+    float* fetchVertices = (float*)malloc((vertices->count + 1) * sizeof(float));
+    if (cacheIndices == NULL || remap == NULL || fetchVertices == NULL
+            || !OptimizeVertexCache(cacheIndices, indices->items, indices->count, vertexCount)) {
+        free(cacheIndices);
+        free(remap);
+        free(fetchVertices);
+        return false;
+    }
+
+    float missRatio = GetVertexCacheMissRatio(indices->items, indices->count, vertexCount, MESH_VERTEX_CACHE_SIZE);
+    float optimizedMissRatio = GetVertexCacheMissRatio(cacheIndices, indices->count, vertexCount, MESH_VERTEX_CACHE_SIZE);
+    printf("Vertex cache misses per triangle: %.2f -> %.2f\n", missRatio, optimizedMissRatio);
+
+    // drops the vertices of faces with less than 3 vertices
+    int usedCount = OptimizeVertexFetch(remap, cacheIndices, indices->count, vertexCount);
+    RemapVertices((uint8_t*)fetchVertices, (const uint8_t*)vertices->items, vertexCount, stride, remap);
+    RemapIndices(cacheIndices, indices->count, remap);
+
+    free(vertices->items);
+    free(indices->items);
+    free(remap);
+    vertices->items = fetchVertices;
+    vertices->capacity = vertices->count + 1;
+    vertices->count = usedCount * ASSET_PACK_FLOATS_PER_VERTEX;
+    indices->items = cacheIndices;
+    indices->capacity = indices->count + 1;
+    return true;
+}
+
+static bool PackMesh(const char* name, const char* path) {
+    uint64_t size = 0;
+    char* text = (char*)ReadWholeFile(path, &size);
+    if (text == NULL) {
+        return false;
+    }
+
+    FloatList positions = {0};
+    FloatList texCoords = {0};
+    FloatList vertices = {0};
+    IndexList indices = {0};
+    VertexMap vertexMap = {0};
+    GrowVertexMap(&vertexMap);
+    bool isValid = true;
+
+    for (char* line = strtok(text, "\n"); line != NULL && isValid; line = strtok(NULL, "\n")) {
+        float x = 0;
+        float y = 0;
+        float z = 0;
+        if (strncmp(line, "v ", 2) == 0 && sscanf(line + 2, "%f %f %f", &x, &y, &z) == 3) {
+            PushFloat(&positions, x);
+            PushFloat(&positions, y);
+            PushFloat(&positions, z);
+        } else if (strncmp(line, "vt ", 3) == 0 && sscanf(line + 3, "%f %f", &x, &y) == 2) {
+            PushFloat(&texCoords, x);
+            PushFloat(&texCoords, y);
+        } else if (strncmp(line, "f ", 2) == 0) {
+            uint32_t faceVertices[64];
+            int faceVertexCount = 0;
+
+            char* cursor = line + 2;
+            while (*cursor != '\0' && faceVertexCount < 64) {
+                while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+                    cursor++;
+                }
+                if (*cursor == '\0') {
+                    break;
+                }
+
+                // v, v/vt, v//vn or v/vt/vn
+                int positionIndex = (int)strtol(cursor, &cursor, 10);
+                int texCoordIndex = 0;
+                if (*cursor == '/') {
+                    cursor++;
+                    if (*cursor != '/') {
+                        texCoordIndex = (int)strtol(cursor, &cursor, 10);
+                    }
+                    if (*cursor == '/') {
+                        cursor++;
+                        strtol(cursor, &cursor, 10);
+                    }
+                }
+                while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') {
+                    cursor++;
+                }
+
+                int position = ResolveObjIndex(positionIndex, positions.count / 3);
+                int texCoord = texCoordIndex != 0 ? ResolveObjIndex(texCoordIndex, texCoords.count / 2) : -1;
+                if (position < 0) {
+                    fprintf(stderr, "Invalid face in %s: %s\n", path, line);
+                    isValid = false;
+                    break;
+                }
+
+                int64_t key = ((int64_t)position << 32) | (uint32_t)(texCoord + 1);
+                int slot = FindVertexSlot(&vertexMap, key);
+                uint32_t vertexIndex;
+                if (vertexMap.keys[slot] == key) {
+                    vertexIndex = vertexMap.values[slot];
+                } else {
+                    vertexIndex = vertices.count / ASSET_PACK_FLOATS_PER_VERTEX;
+                    PushFloat(&vertices, positions.items[position * 3]);
+                    PushFloat(&vertices, positions.items[position * 3 + 1]);
+                    PushFloat(&vertices, positions.items[position * 3 + 2]);
+                    for (int i = 0; i < 4; i++) {
+                        PushFloat(&vertices, 1);
+                    }
+                    // OBJ texture coordinates start at the bottom, textures start at the top row
+                    PushFloat(&vertices, texCoord >= 0 ? texCoords.items[texCoord * 2] : 0);
+                    PushFloat(&vertices, texCoord >= 0 ? 1 - texCoords.items[texCoord * 2 + 1] : 0);
+                    PutVertex(&vertexMap, key, vertexIndex);
+                }
+                faceVertices[faceVertexCount++] = vertexIndex;
+            }
+
+            for (int i = 1; i + 1 < faceVertexCount; i++) {
+                PushIndex(&indices, faceVertices[0]);
+                PushIndex(&indices, faceVertices[i]);
+                PushIndex(&indices, faceVertices[i + 1]);
+            }
+        }
+    }
+
+    if (isValid && !OptimizePackedMesh(&vertices, &indices)) {
+        fprintf(stderr, "Unable to optimize %s\n", path);
+        isValid = false;
+    }
+
+    if (isValid) {
+        uint64_t vertexSize = vertices.count * sizeof(float);
+        uint64_t indexSize = indices.count * sizeof(uint32_t);
+        uint64_t blobSize = sizeof(AssetPackMeshHeader) + vertexSize + indexSize;
+        uint8_t* blob = (uint8_t*)calloc(1, blobSize);
+        AssetPackMeshHeader* header = (AssetPackMeshHeader*)blob;
+        header->vertexCount = vertices.count / ASSET_PACK_FLOATS_PER_VERTEX;
+        header->indexCount = indices.count;
+        header->floatsPerVertex = ASSET_PACK_FLOATS_PER_VERTEX;
+        if (vertexSize > 0) {
+            memcpy(blob + sizeof(AssetPackMeshHeader), vertices.items, vertexSize);
+        }
+        if (indexSize > 0) {
+            memcpy(blob + sizeof(AssetPackMeshHeader) + vertexSize, indices.items, indexSize);
+        }
+
+        AddAsset(name, AssetPackMesh, blob, blobSize);
+        printf("Mesh %s: %d vertices, %d triangles\n", name, header->vertexCount, header->indexCount / 3);
+    }
+
+    free(text);
+    free(positions.items);
+    free(texCoords.items);
+    free(vertices.items);
+    free(indices.items);
+    free(vertexMap.keys);
+    free(vertexMap.values);
+    return isValid;
+}
+
+// -- Writing --
+
+static void CompressAsset(PackedAsset* asset) {
+    if (asset->entry.rawSize > ASSET_PACK_MAX_COMPRESSED_SIZE) {
+        return;
+    }
+    int capacity = Lz4CompressBound((int)asset->entry.rawSize);
+    uint8_t* compressed = (uint8_t*)malloc(capacity);
+    int size = Lz4Compress(asset->blob, (int)asset->entry.rawSize, compressed, capacity);
+
+    if (size > 0 && (uint64_t)size < asset->entry.rawSize) {
+        free(asset->blob);
+        asset->blob = compressed;
+        asset->entry.size = size;
+        asset->entry.compression = AssetPackLz4;
+    } else {
+        free(compressed);
+    }
+}
+
+static int CompareAssets(const void* a, const void* b) {
+    return strcmp(((const PackedAsset*)a)->entry.name, ((const PackedAsset*)b)->entry.name);
+}
+
+static void WritePadding(FILE* file, uint64_t* offset) {
+    static const uint8_t zeros[ASSET_PACK_ALIGNMENT] = {0};
+    uint64_t padding = (ASSET_PACK_ALIGNMENT - *offset % ASSET_PACK_ALIGNMENT) % ASSET_PACK_ALIGNMENT;
+    fwrite(zeros, 1, padding, file);
+    *offset += padding;
+}
+
+static bool WritePack(const char* path) {
+    qsort(assets, assetCount, sizeof(PackedAsset), CompareAssets);
+    for (int i = 1; i < assetCount; i++) {
+        if (strcmp(assets[i - 1].entry.name, assets[i].entry.name) == 0) {
+            fprintf(stderr, "Duplicate asset name %s\n", assets[i].entry.name);
+            return false;
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return false;
+    }
+
+    AssetPackHeader header = {0};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = assetCount;
+    fwrite(&header, sizeof(header), 1, file);
+    uint64_t offset = sizeof(header);
+
+    for (int i = 0; i < assetCount; i++) {
+        WritePadding(file, &offset);
+        assets[i].entry.offset = offset;
+        fwrite(assets[i].blob, 1, assets[i].entry.size, file);
+        offset += assets[i].entry.size;
+    }
+
+    WritePadding(file, &offset);
+    header.indexOffset = offset;
+    for (int i = 0; i < assetCount; i++) {
+        fwrite(&assets[i].entry, sizeof(AssetPackEntry), 1, file);
+        offset += sizeof(AssetPackEntry);
+    }
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+
+    printf("Wrote %d assets to %s (%llu bytes)\n", assetCount, path, (unsigned long long)offset);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: asset_pack output.pack [--lz4] asset...\n");
+        printf("  texture name image.tga\n");
+        printf("  mesh name model.obj\n");
+        printf("  shader name vertex.glsl fragment.glsl\n");
+        return 1;
+    }
+
+    const char* outputPath = argv[1];
+    bool shouldCompress = false;
+
+    int i = 2;
+    while (i < argc) {
+        const char* kind = argv[i];
+        bool isPacked = false;
+        if (strcmp(kind, "--lz4") == 0) {
+            shouldCompress = true;
+            i++;
+            continue;
+        } else if (strcmp(kind, "texture") == 0 && i + 2 < argc) {
+            isPacked = PackTexture(argv[i + 1], argv[i + 2]);
+            i += 3;
+        } else if (strcmp(kind, "mesh") == 0 && i + 2 < argc) {
+            isPacked = PackMesh(argv[i + 1], argv[i + 2]);
+            i += 3;
+        } else if (strcmp(kind, "shader") == 0 && i + 3 < argc) {
+            isPacked = PackShader(argv[i + 1], argv[i + 2], argv[i + 3]);
+            i += 4;
+        } else {
+            fprintf(stderr, "Unknown or incomplete asset argument %s\n", kind);
+            return 1;
+        }
+
+        if (!isPacked) {
+            return 1;
+        }
+    }
+
+    if (shouldCompress) {
+        for (int j = 0; j < assetCount; j++) {
+            CompressAsset(&assets[j]);
+        }
+    }
+
+    return WritePack(outputPath) ? 0 : 1;
+}
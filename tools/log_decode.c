@@ -0,0 +1,238 @@
+/*
+ * Decode a binary log written with LogDeferred into text.
+ *
+ * Usage: log_decode input.bin [output.txt]
+ *
+ * Each record is printed with a timestamp in seconds and the log level prefix,
+ * for example "[12.345678] INFO: hello 42".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/log_binary.h"
+
+#define MAX_FORMATS 65536
+#define MAX_SPEC_LENGTH 64
+
+typedef struct {
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t argTypes[LOG_BINARY_MAX_ARGS];
+    char* format;
+} DecodedFormat;
+
+static DecodedFormat formats[MAX_FORMATS];
+
+static const char* MapLevelToString(uint8_t level) {
+    // keep in sync with LogLevel in libgame.h
+    switch (level) {
+        case 0: return "DEBUG";
+        case 1: return "INFO";
+        case 2: return "WARNING";
+        case 3: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+static void ReadFormat(int formatId, const uint8_t* payload, int size) {
+    DecodedFormat* format = &formats[formatId];
+    free(format->format);
+    format->format = NULL;
+
+    if (size < 2 || payload[1] > LOG_BINARY_MAX_ARGS || 2 + payload[1] > size) {
+        fprintf(stderr, "Invalid format entry %d\n", formatId);
+        return;
+    }
+    format->level = payload[0];
+    format->argCount = payload[1];
+    memcpy(format->argTypes, payload + 2, format->argCount);
+
+    int offset = 2 + format->argCount;
+    int length = size - offset;
+    format->format = (char*)malloc(length + 1);
+    memcpy(format->format, payload + offset, length);
+    format->format[length] = '\0';
+}
+
+/*
+ * Rewrite the length modifiers of a conversion specification so that
+ * it matches the type that the argument was stored as.
+ */
+static void NormalizeSpec(const char* spec, LogFormatSpec* parsed, char* out) {
+    int i = 0;
+    int o = 0;
+    // copy % and flags/width/precision
+    out[o++] = spec[i++];
+    while (strchr("-+ #0123456789.", spec[i]) != NULL) {
+        out[o++] = spec[i++];
+    }
+    if (parsed->argType == LogArgInt64) {
+        out[o++] = 'l';
+        out[o++] = 'l';
+    }
+    out[o++] = parsed->conversion;
+    out[o] = '\0';
+}
+
+static const uint8_t* PrintArg(FILE* out, const char* spec, LogFormatSpec* parsed, const uint8_t* arg) {
+    char normalized[MAX_SPEC_LENGTH];
+    NormalizeSpec(spec, parsed, normalized);
+
+    switch (parsed->argType) {
+        case LogArgInt32: {
+            int32_t value;
+            memcpy(&value, arg, sizeof(value));
+            fprintf(out, normalized, value);
+            return arg + sizeof(value);
+        }
+        case LogArgInt64: {
+            int64_t value;
+            memcpy(&value, arg, sizeof(value));
+            fprintf(out, normalized, (long long)value);
+            return arg + sizeof(value);
+        }
+        case LogArgDouble: {
+            double value;
+            memcpy(&value, arg, sizeof(value));
+            fprintf(out, normalized, value);
+            return arg + sizeof(value);
+        }
+        case LogArgPointer: {
+            uint64_t value;
+            memcpy(&value, arg, sizeof(value));
+            fprintf(out, normalized, (void*)(uintptr_t)value);
+            return arg + sizeof(value);
+        }
+        case LogArgString: {
+            uint16_t length;
+            memcpy(&length, arg, sizeof(length));
+            char str[LOG_BINARY_MAX_STRING + 1];
+            memcpy(str, arg + sizeof(length), length);
+            str[length] = '\0';
+            fprintf(out, normalized, str);
+            return arg + sizeof(length) + length;
+        }
+        default:
+            return arg;
+    }
+}
+
+// integers may be stored with a different size than on this machine, the other kinds must match
+static bool IsSameArgKind(LogArgType parsed, uint8_t stored) {
+    bool isParsedInteger = parsed == LogArgInt32 || parsed == LogArgInt64;
+    bool isStoredInteger = stored == LogArgInt32 || stored == LogArgInt64;
+    return isParsedInteger ? isStoredInteger : stored == parsed;
+}
+
+static void PrintRecord(FILE* out, int formatId, const uint8_t* payload) {
+    DecodedFormat* format = &formats[formatId];
+    if (format->format == NULL) {
+        fprintf(out, "<unknown format %d>\n", formatId);
+        return;
+    }
+
+    uint64_t ticks;
+    memcpy(&ticks, payload, sizeof(ticks));
+    const uint8_t* arg = payload + sizeof(ticks);
+
+    // ticks are in microseconds, see TICKS_PER_SECOND in libgame.h
+    fprintf(out, "[%.6f] %s: ", ticks / 1000000.0, MapLevelToString(format->level));
+
+    /*
+     * The argument types stored with the format decide the payload sizes, since they were
+     * parsed on the machine that wrote the log. On the decoding machine %ld can be a different size.
+     */
+    int argIndex = 0;
+    const char* s = format->format;
+    while (*s != '\0') {
+        if (*s != '%') {
+            fputc(*s++, out);
+            continue;
+        }
+
+        LogFormatSpec parsed;
+        if (!ParseLogFormatSpec(s, &parsed) || parsed.length >= MAX_SPEC_LENGTH) {
+            fputs(s, out);
+            break;
+        }
+
+        if (parsed.argType == 0) {
+            fputc('%', out);
+        } else if (argIndex >= format->argCount || !IsSameArgKind(parsed.argType, format->argTypes[argIndex])) {
+            fputs(s, out);
+            break;
+        } else {
+            parsed.argType = (LogArgType)format->argTypes[argIndex++];
+            char spec[MAX_SPEC_LENGTH];
+            memcpy(spec, s, parsed.length);
+            spec[parsed.length] = '\0';
+            arg = PrintArg(out, spec, &parsed, arg);
+        }
+        s += parsed.length;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: log_decode input.bin [output.txt]\n");
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (argc >= 3) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            fprintf(stderr, "Unable to open %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    LogBinaryHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != LOG_BINARY_MAGIC) {
+        fprintf(stderr, "%s is not a binary log\n", argv[1]);
+        return 1;
+    }
+    if (header.version != LOG_BINARY_VERSION) {
+        fprintf(stderr, "Unsupported binary log version %u. Expected %u.\n", header.version, LOG_BINARY_VERSION);
+        return 1;
+    }
+
+    LogBinaryEntryHeader entry;
+    uint8_t payload[UINT16_MAX];
+    int recordCount = 0;
+
+    while (fread(&entry, sizeof(entry), 1, in) == 1) {
+        if (fread(payload, 1, entry.payloadSize, in) != entry.payloadSize) {
+            fprintf(stderr, "Truncated entry at the end of the log\n");
+            break;
+        }
+
+        switch (entry.type) {
+            case LogEntryFormat:
+                ReadFormat(entry.formatId, payload, entry.payloadSize);
+                break;
+            case LogEntryRecord:
+                PrintRecord(out, entry.formatId, payload);
+                recordCount++;
+                break;
+            default:
+                fprintf(stderr, "Unknown entry type %d\n", entry.type);
+                break;
+        }
+    }
+
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+        printf("Decoded %d records\n", recordCount);
+    }
+
+    return 0;
+}
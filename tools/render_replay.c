@@ -0,0 +1,131 @@
+/*
+ * Replay a render capture written with BeginRenderCapture, and time it.
+ *
+ * Usage: render_replay capture.bin [output.json] [passes]
+ *
+ * The captured frames are replayed in a hidden window with the size and render settings
+ * of the capture. After one warmup pass, every frame is replayed once per pass and the
+ * CPU time of each frame (including EndFrame) is written as JSON, so that the slowest
+ * frames stand out and the results can be compared before and after a change.
+ *
+ * Build with the windows subsystem: .\scripts\tool_build_win32.bat tools\render_replay.c windows
+ */
+
+#define LIBGAME_WITH_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include "libgame.h"
+
+#define DEFAULT_PASSES 10
+#define MAX_PASSES 1000
+
+typedef struct {
+    double mean;
+    double min;
+    double max;
+    RenderStats stats; // of the last pass
+} FrameTiming;
+
+// writes a quoted JSON string, so that Windows paths with backslashes stay valid
+static void WriteJsonString(FILE* file, const char* str) {
+    fputc('"', file);
+    for (const char* c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        LogError("Usage: render_replay capture.bin [output.json] [passes]\n");
+        return 1;
+    }
+    const char* capturePath = argv[1];
+    const char* outputPath = argc > 2 ? argv[2] : "render_replay.json";
+    int passCount = argc > 3 ? atoi(argv[3]) : DEFAULT_PASSES;
+    passCount = passCount < 1 ? 1 : (passCount > MAX_PASSES ? MAX_PASSES : passCount);
+
+    RenderCapture* capture = LoadRenderCapture(capturePath);
+    if (capture == NULL) {
+        LogError("Unable to load render capture %s\n", capturePath);
+        return 1;
+    }
+    RenderCaptureInfo info = GetRenderCaptureInfo(capture);
+
+    ConfigureWindow((WindowSettings){ .width = info.width, .height = info.height, .isHidden = true });
+    ConfigureRender(info.renderSettings);
+    InitWindow("render replay");
+
+    FILE* file = fopen(outputPath, "w");
+    if (file == NULL) {
+        LogError("Unable to open %s\n", outputPath);
+        return 1;
+    }
+
+    FrameTiming* timings = (FrameTiming*)calloc(info.frameCount, sizeof(FrameTiming));
+
+    // the warmup pass creates the resources
+    for (int i = 0; i < info.frameCount && IsWindowOpen(); i++) {
+        ProcessInput();
+        ReplayRenderCaptureFrame(capture);
+    }
+
+    int completedPasses = 0;
+    for (int pass = 0; pass < passCount && IsWindowOpen(); pass++) {
+        for (int i = 0; i < info.frameCount; i++) {
+            ProcessInput();
+            uint64_t ticksStart = GetTicks();
+            int frame = ReplayRenderCaptureFrame(capture);
+            double micros = (double)(GetTicks() - ticksStart);
+
+            FrameTiming* timing = &timings[frame];
+            timing->mean += micros;
+            timing->min = pass == 0 || micros < timing->min ? micros : timing->min;
+            timing->max = micros > timing->max ? micros : timing->max;
+            timing->stats = GetRenderStats();
+        }
+        completedPasses++;
+    }
+
+    double totalMicros = 0;
+    int slowestFrame = 0;
+    for (int i = 0; i < info.frameCount; i++) {
+        timings[i].mean /= completedPasses > 0 ? completedPasses : 1;
+        totalMicros += timings[i].mean;
+        slowestFrame = timings[i].mean > timings[slowestFrame].mean ? i : slowestFrame;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"capture\": ");
+    WriteJsonString(file, capturePath);
+    fprintf(file, ",\n");
+    fprintf(file, "  \"passes\": %d,\n", completedPasses);
+    fprintf(file, "  \"width\": %d,\n", GetClientWidth());
+    fprintf(file, "  \"height\": %d,\n", GetClientHeight());
+    fprintf(file, "  \"meanCpuMicrosPerFrame\": %.2f,\n", totalMicros / info.frameCount);
+    fprintf(file, "  \"slowestFrame\": %d,\n", slowestFrame);
+    fprintf(file, "  \"frames\": [\n");
+    for (int i = 0; i < info.frameCount; i++) {
+        FrameTiming timing = timings[i];
+        fprintf(file, "    { \"frame\": %d, \"cpuMicros\": { \"mean\": %.2f, \"min\": %.2f, \"max\": %.2f }, "
+                "\"drawCalls\": %d, \"vertices\": %d, \"indices\": %d, \"bytesUploaded\": %llu }%s\n",
+                i, timing.mean, timing.min, timing.max, timing.stats.drawCalls, timing.stats.vertexCount,
+                timing.stats.indexCount, (unsigned long long)timing.stats.bytesUploaded,
+                i == info.frameCount - 1 ? "" : ",");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    fclose(file);
+    free(timings);
+    FreeRenderCapture(capture);
+
+    LogInfo("Replayed %d frames %d times, %.2f us per frame\n", info.frameCount, completedPasses, totalMicros / info.frameCount);
+    return 0;
+}